@@ -0,0 +1,111 @@
+#include <gflags/gflags.h>
+#include <mkl.h>
+
+#include <iostream>
+
+#define ARMA_DONT_PRINT_ERRORS
+#include "approx_zf.h"
+#include "armadillo"
+#include "timer.h"
+
+DEFINE_uint64(n_ants, 64, "Number of matrix rows");
+DEFINE_uint64(n_users, 16, "Number of matrix columns");
+DEFINE_uint64(n_reps, 1000, "Number of timed repetitions per measurement");
+DEFINE_uint64(max_approx_iters, 6, "Largest approximation iteration count");
+DEFINE_double(frame_drift, 0.05,
+              "Relative channel change between frames for warm starts");
+
+/// Check a condition at runtime. If the condition is false, throw exception.
+static inline void rt_assert(bool condition, const char* throw_str) {
+  if (!condition) throw std::runtime_error(throw_str);
+}
+
+// Generate a matrix with condition number approxately equal to cond_num
+arma::cx_fmat gen_matrix_with_condition(double cond_num) {
+  rt_assert(cond_num >= 1.0,
+            "Condition number too small for gen_matrix_with_condition()");
+  auto mat = arma::randn<arma::cx_fmat>(FLAGS_n_ants, FLAGS_n_users);
+  arma::cx_fmat U;
+  arma::cx_fmat V;
+  arma::fvec s;
+  arma::svd(U, s, V, mat);
+
+  // Set the singular values to evenly spaced between {cond_num, ..., 1.0}
+  auto s_mat = arma::cx_fmat(FLAGS_n_ants, FLAGS_n_users, arma::fill::zeros);
+  for (size_t i = 0; i < s.size(); i++) {
+    s_mat(i, i) = cond_num - i * ((cond_num - 1) / (s.size() - 1));
+  }
+  return U * s_mat * V.t();
+}
+
+/// Time [func] over FLAGS_n_reps runs and return the average cycles per run
+template <typename Func>
+static double avg_cycles(Func func) {
+  const size_t start_tsc = rdtsc();
+  for (size_t i = 0; i < FLAGS_n_reps; i++) {
+    func();
+  }
+  return static_cast<double>(rdtsc() - start_tsc) / FLAGS_n_reps;
+}
+
+static float rel_error(const arma::cx_fmat& approx,
+                       const arma::cx_fmat& exact) {
+  return arma::norm(approx - exact, "fro") / arma::norm(exact, "fro");
+}
+
+int main(int argc, char** argv) {
+  mkl_set_num_threads(1);
+  arma::arma_rng::set_seed_random();
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  rt_assert(FLAGS_n_ants >= FLAGS_n_users && FLAGS_n_users > 1,
+            "Need n_ants >= n_users > 1");
+
+  std::printf("Channel %zux%zu, %zu reps per measurement\n", FLAGS_n_ants,
+              FLAGS_n_users, FLAGS_n_reps);
+  std::printf("cond method iters rel_error cycles\n");  // Print the header
+
+  // Condition 0 stands for an i.i.d. Rayleigh channel
+  for (double cond : {0.0, 1.5, 2.0, 4.0, 8.0, 16.0, 32.0}) {
+    // The previous frame's channel and this frame's slightly drifted channel
+    const arma::cx_fmat prev_csi =
+        (cond == 0.0)
+            ? arma::randn<arma::cx_fmat>(FLAGS_n_ants, FLAGS_n_users)
+            : gen_matrix_with_condition(cond);
+    const arma::cx_fmat csi =
+        prev_csi + FLAGS_frame_drift * arma::norm(prev_csi, "fro") /
+                       std::sqrt(prev_csi.n_elem) *
+                       arma::randn<arma::cx_fmat>(arma::size(prev_csi));
+    const double actual_cond = arma::cond(csi);
+
+    arma::cx_fmat exact;
+    double cycles = avg_cycles(
+        [&]() { exact = arma::inv_sympd(csi.t() * csi) * csi.t(); });
+    std::printf("%.1f exact 0 0 %.0f\n", actual_cond, cycles);
+
+    const arma::cx_fmat prev_beam =
+        arma::inv_sympd(prev_csi.t() * prev_csi) * prev_csi.t();
+    for (size_t iters = 1; iters <= FLAGS_max_approx_iters; iters++) {
+      arma::cx_fmat approx;
+      cycles = avg_cycles([&]() {
+        approx = ApproxZf::NeumannInverse(csi.t() * csi, iters) * csi.t();
+      });
+      std::printf("%.1f neumann %zu %.2e %.0f\n", actual_cond, iters,
+                  rel_error(approx, exact), cycles);
+
+      cycles = avg_cycles([&]() {
+        const arma::cx_fmat gram = csi.t() * csi;
+        approx = ApproxZf::JacobiGuess(gram, csi.t());
+        ApproxZf::ConjugateGradient(gram, csi.t(), approx, iters);
+      });
+      std::printf("%.1f cg_cold %zu %.2e %.0f\n", actual_cond, iters,
+                  rel_error(approx, exact), cycles);
+
+      cycles = avg_cycles([&]() {
+        approx = prev_beam;
+        ApproxZf::ConjugateGradient(csi.t() * csi, csi.t(), approx, iters);
+      });
+      std::printf("%.1f cg_warm %zu %.2e %.0f\n", actual_cond, iters,
+                  rel_error(approx, exact), cycles);
+    }
+  }
+}
@@ -0,0 +1,192 @@
+#include <gflags/gflags.h>
+#include <mkl.h>
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "datatype_conversion.h"
+#include "precode_ifft.h"
+#include "timer.h"
+
+DEFINE_uint64(n_ants, 8, "Number of base station antennas");
+DEFINE_uint64(n_users, 4, "Number of users");
+DEFINE_uint64(fft_size, 2048, "OFDM IFFT size");
+DEFINE_uint64(n_data_scs, 1200, "Number of data subcarriers");
+DEFINE_uint64(n_symbols, 14, "Downlink symbols per frame");
+DEFINE_uint64(sc_block_size, 48, "Subcarriers per unfused precode task");
+DEFINE_uint64(ant_block_size, 4, "Antennas per fused precode + IFFT task");
+DEFINE_uint64(n_reps, 100, "Number of timed frames per measurement");
+
+/// Check a condition at runtime. If the condition is false, throw exception.
+static inline void rt_assert(bool condition, const char* throw_str) {
+  if (!condition) throw std::runtime_error(throw_str);
+}
+
+template <typename T>
+static T* alloc_zeroed(size_t n) {
+  auto* ptr = static_cast<T*>(mkl_malloc(n * sizeof(T), 64));
+  std::memset(ptr, 0, n * sizeof(T));
+  return ptr;
+}
+
+/// Time [func] over FLAGS_n_reps runs and return the average cycles per run
+template <typename Func>
+static double avg_cycles(Func func) {
+  const size_t start_tsc = rdtsc();
+  for (size_t i = 0; i < FLAGS_n_reps; i++) {
+    func();
+  }
+  return static_cast<double>(rdtsc() - start_tsc) / FLAGS_n_reps;
+}
+
+int main(int argc, char** argv) {
+  mkl_set_num_threads(1);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  const size_t n_ants = FLAGS_n_ants;
+  const size_t n_users = FLAGS_n_users;
+  const size_t fft_size = FLAGS_fft_size;
+  const size_t n_scs = FLAGS_n_data_scs;
+  const size_t data_start = (fft_size - n_scs) / 2;
+  rt_assert(n_scs % FLAGS_sc_block_size == 0 && FLAGS_sc_block_size % 4 == 0,
+            "n_data_scs must be a multiple of sc_block_size, itself a "
+            "multiple of 4");
+  rt_assert(n_ants % FLAGS_ant_block_size == 0,
+            "n_ants must be a multiple of ant_block_size");
+
+  // Per-subcarrier column-major precoders and subcarrier-major data
+  std::vector<complex_float> beams(n_scs * n_ants * n_users);
+  std::vector<complex_float> data(FLAGS_n_symbols * n_scs * n_users);
+  std::mt19937 gen(0);
+  std::normal_distribution<float> dist(0.0f, 0.01f);
+  for (auto& v : beams) v = {dist(gen), dist(gen)};
+  for (auto& v : data) v = {dist(gen), dist(gen)};
+
+  DFTI_DESCRIPTOR_HANDLE in_place;
+  DftiCreateDescriptor(&in_place, DFTI_SINGLE, DFTI_COMPLEX, 1, fft_size);
+  DftiCommitDescriptor(in_place);
+  DFTI_DESCRIPTOR_HANDLE out_of_place;
+  DftiCreateDescriptor(&out_of_place, DFTI_SINGLE, DFTI_COMPLEX, 1, fft_size);
+  DftiSetValue(out_of_place, DFTI_PLACEMENT, DFTI_NOT_INPLACE);
+  DftiCommitDescriptor(out_of_place);
+
+  const size_t cp_len = fft_size / 8;
+  const size_t n_samps = fft_size + cp_len;
+  auto* socket_unfused =
+      alloc_zeroed<short>(FLAGS_n_symbols * n_ants * 2 * n_samps);
+  auto* socket_fused =
+      alloc_zeroed<short>(FLAGS_n_symbols * n_ants * 2 * n_samps);
+  auto* ifft_buffer =
+      alloc_zeroed<complex_float>(FLAGS_n_symbols * n_ants * fft_size);
+  auto* precoded_tmp =
+      alloc_zeroed<complex_float>(FLAGS_sc_block_size * n_ants);
+  auto* shift_tmp = alloc_zeroed<complex_float>(fft_size);
+  auto* ifft_out = alloc_zeroed<float>(2 * fft_size);
+  auto* precoded_rows =
+      alloc_zeroed<complex_float>(FLAGS_ant_block_size * fft_size);
+
+  // DoPrecode (batched cgemm, gather transpose into the IFFT buffer) followed
+  // by DoIFFT
+  auto unfused = [&]() {
+    const MKL_Complex8 alpha = {1, 0};
+    const MKL_Complex8 beta = {0, 0};
+    const __m256i index = _mm256_setr_epi64x(0, n_ants, n_ants * 2, n_ants * 3);
+    for (size_t sym = 0; sym < FLAGS_n_symbols; sym++) {
+      for (size_t base_sc = 0; base_sc < n_scs;
+           base_sc += FLAGS_sc_block_size) {
+        cblas_cgemm_batch_strided(
+            CblasColMajor, CblasNoTrans, CblasNoTrans, n_ants, 1, n_users,
+            &alpha, &beams[base_sc * n_ants * n_users], n_ants,
+            n_ants * n_users, &data[(sym * n_scs + base_sc) * n_users],
+            n_users, n_users, &beta, precoded_tmp, n_ants, n_ants,
+            FLAGS_sc_block_size);
+        for (size_t ant = 0; ant < n_ants; ant++) {
+          auto* ifft_ptr = reinterpret_cast<float*>(
+              &ifft_buffer[(sym * n_ants + ant) * fft_size + data_start +
+                           base_sc]);
+          for (size_t i = 0; i < FLAGS_sc_block_size / 4; i++) {
+            const __m256d t_data = _mm256_i64gather_pd(
+                reinterpret_cast<double*>(precoded_tmp + 4 * i * n_ants + ant),
+                index, 8);
+            _mm256_stream_pd(reinterpret_cast<double*>(ifft_ptr + i * 8),
+                             t_data);
+          }
+        }
+      }
+      for (size_t ant = 0; ant < n_ants; ant++) {
+        complex_float* in = &ifft_buffer[(sym * n_ants + ant) * fft_size];
+        std::memset(in, 0, sizeof(complex_float) * data_start);
+        std::memset(in + data_start + n_scs, 0,
+                    sizeof(complex_float) * (fft_size - data_start - n_scs));
+        std::memcpy(shift_tmp, in + fft_size / 2,
+                    sizeof(complex_float) * fft_size / 2);
+        std::memcpy(in + fft_size / 2, in,
+                    sizeof(complex_float) * fft_size / 2);
+        std::memcpy(in, shift_tmp, sizeof(complex_float) * fft_size / 2);
+        std::memcpy(ifft_out, in, sizeof(complex_float) * fft_size);
+        DftiComputeBackward(in_place, ifft_out);
+        SimdConvertFloatToShort(
+            ifft_out, &socket_unfused[(sym * n_ants + ant) * 2 * n_samps],
+            2 * fft_size, 2 * cp_len, fft_size);
+      }
+    }
+  };
+
+  // DoPrecodeIFFT: one antenna block over all subcarriers per task
+  auto fused = [&]() {
+    for (size_t sym = 0; sym < FLAGS_n_symbols; sym++) {
+      for (size_t ant_start = 0; ant_start < n_ants;
+           ant_start += FLAGS_ant_block_size) {
+        for (size_t sc = 0; sc < n_scs; sc++) {
+          PrecodeAntennaBlock(
+              &beams[sc * n_ants * n_users] + ant_start,
+              &data[(sym * n_scs + sc) * n_users], n_ants, n_users,
+              FLAGS_ant_block_size,
+              precoded_rows +
+                  PrecodeIfftShiftedIndex(data_start + sc, fft_size),
+              fft_size);
+        }
+        for (size_t i = 0; i < FLAGS_ant_block_size; i++) {
+          DftiComputeBackward(out_of_place, precoded_rows + (i * fft_size),
+                              ifft_out);
+          SimdConvertFloatToShort(
+              ifft_out,
+              &socket_fused[(sym * n_ants + ant_start + i) * 2 * n_samps],
+              2 * fft_size, 2 * cp_len, fft_size);
+        }
+      }
+    }
+  };
+
+  unfused();
+  fused();
+  size_t max_diff = 0;
+  for (size_t i = 0; i < FLAGS_n_symbols * n_ants * 2 * n_samps; i++) {
+    max_diff = std::max(
+        max_diff, static_cast<size_t>(std::abs(socket_fused[i] -
+                                               socket_unfused[i])));
+  }
+  std::printf("Max int16 difference between fused and unfused: %zu\n",
+              max_diff);
+
+  const double freq_ghz = measure_rdtsc_freq();
+  const double unfused_cycles = avg_cycles(unfused);
+  const double fused_cycles = avg_cycles(fused);
+  std::printf("%zu antennas, %zu users, %zu symbols per frame\n", n_ants,
+              n_users, FLAGS_n_symbols);
+  std::printf("unfused: %.1f us per frame\n",
+              unfused_cycles / (freq_ghz * 1000));
+  std::printf("fused: %.1f us per frame (%.2fx)\n",
+              fused_cycles / (freq_ghz * 1000), unfused_cycles / fused_cycles);
+
+  DftiFreeDescriptor(&in_place);
+  DftiFreeDescriptor(&out_of_place);
+  for (void* ptr : {static_cast<void*>(socket_unfused),
+                    static_cast<void*>(socket_fused),
+                    static_cast<void*>(ifft_buffer),
+                    static_cast<void*>(precoded_tmp),
+                    static_cast<void*>(shift_tmp), static_cast<void*>(ifft_out),
+                    static_cast<void*>(precoded_rows)}) {
+    mkl_free(ptr);
+  }
+}
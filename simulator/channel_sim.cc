@@ -82,24 +82,24 @@ ChannelSim::ChannelSim(const Config* const config, size_t bs_thread_num,
       cfg_->Frame().NumULSyms() + cfg_->Frame().NumPilotSyms();
 
   rx_buffer_bs_ = std::make_unique<ChSimRxBuffer>(
-      ChSimRxBuffer::ChSimRxType::kRxTypeBeaconDl, cfg_, kFrameWnd,
+      ChSimRxBuffer::ChSimRxType::kRxTypeBeaconDl, cfg_, cfg_->FrameWnd(),
       dl_data_plus_beacon_symbols_, cfg_->BsAntNum(), cfg_->PacketLength());
 
   rx_buffer_ue_ = std::make_unique<ChSimRxBuffer>(
-      ChSimRxBuffer::ChSimRxType::kRxTypePilotUl, cfg_, kFrameWnd,
+      ChSimRxBuffer::ChSimRxType::kRxTypePilotUl, cfg_, cfg_->FrameWnd(),
       ul_data_plus_pilot_symbols_, cfg_->UeAntNum(), cfg_->PacketLength());
 
   bs_comm_.resize(bs_socket_num_);
   ue_comm_.resize(user_socket_num_);
 
   task_queue_bs_ = moodycamel::ConcurrentQueue<EventData>(
-      kFrameWnd * dl_data_plus_beacon_symbols_ * cfg_->BsAntNum() *
+      cfg_->FrameWnd() * dl_data_plus_beacon_symbols_ * cfg_->BsAntNum() *
       kDefaultQueueSize);
   task_queue_user_ = moodycamel::ConcurrentQueue<EventData>(
-      kFrameWnd * ul_data_plus_pilot_symbols_ * cfg_->UeAntNum() *
+      cfg_->FrameWnd() * ul_data_plus_pilot_symbols_ * cfg_->UeAntNum() *
       kDefaultQueueSize);
   message_queue_ = moodycamel::ConcurrentQueue<EventData>(
-      kFrameWnd * cfg_->Frame().NumTotalSyms() *
+      cfg_->FrameWnd() * cfg_->Frame().NumTotalSyms() *
       (cfg_->BsAntNum() + cfg_->UeAntNum()) * kDefaultQueueSize);
   payload_length_ = cfg_->PacketLength() - Packet::kOffsetOfData;
 
@@ -117,10 +117,14 @@ ChannelSim::ChannelSim(const Config* const config, size_t bs_thread_num,
     task_threads_.at(i) = std::thread(&ChannelSim::TaskThread, this, i);
   }
 
-  ue_rx_.Init(ul_data_plus_pilot_symbols_, cfg_->UeAntNum());
-  ue_tx_.Init(dl_data_plus_beacon_symbols_);
-  bs_rx_.Init(dl_data_plus_beacon_symbols_, cfg_->BsAntNum());
-  bs_tx_.Init(ul_data_plus_pilot_symbols_);
+  const size_t frame_wnd = cfg_->FrameWnd();
+  const size_t num_symbols = cfg_->Frame().NumTotalSyms();
+  ue_rx_.Init(frame_wnd, num_symbols, ul_data_plus_pilot_symbols_,
+              cfg_->UeAntNum());
+  ue_tx_.Init(frame_wnd, num_symbols, dl_data_plus_beacon_symbols_);
+  bs_rx_.Init(frame_wnd, num_symbols, dl_data_plus_beacon_symbols_,
+              cfg_->BsAntNum());
+  bs_tx_.Init(frame_wnd, num_symbols, ul_data_plus_pilot_symbols_);
 }
 
 ChannelSim::~ChannelSim() {
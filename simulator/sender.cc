@@ -70,6 +70,7 @@ Sender::Sender(Config* cfg, size_t socket_thread_num, size_t core_offset,
       enable_slow_start == 1 ? "yes" : "no");
 
   unused(server_mac_addr_str);
+  packet_count_per_symbol_.resize(cfg->FrameWnd());
   for (auto& i : packet_count_per_symbol_) {
     i = new size_t[cfg->Frame().NumTotalSyms()]();
   }
@@ -251,7 +252,7 @@ void* Sender::MasterThread(int /*unused*/) {
     gen_tag_t ctag(0);  // The completion tag
     int ret = static_cast<int>(completion_queue_.try_dequeue(ctag.tag_));
     if (ret > 0) {
-      const size_t comp_frame_slot = (ctag.frame_id_ % kFrameWnd);
+      const size_t comp_frame_slot = cfg_->FrameSlot(ctag.frame_id_);
       packet_count_per_symbol_[comp_frame_slot][ctag.symbol_id_]++;
 
       if (kDebugPrintSender == true) {
@@ -539,9 +540,9 @@ void* Sender::WorkerThread(int tid) {
 uint64_t Sender::GetTicksForFrame(size_t frame_id) const {
   if (enable_slow_start_ == 0) {
     return ticks_all_;
-  } else if (frame_id < kFrameWnd) {
+  } else if (frame_id < cfg_->FrameWnd()) {
     return ticks_wnd1_;
-  } else if (frame_id < (kFrameWnd * 4)) {
+  } else if (frame_id < (cfg_->FrameWnd() * 4)) {
     return ticks_wnd2_;
   } else {
     return ticks_all_;
@@ -138,7 +138,7 @@ class Sender {
   Table<short> iq_data_short_;
 
   // Number of packets transmitted for each symbol in a frame
-  size_t* packet_count_per_symbol_[kFrameWnd];
+  std::vector<size_t*> packet_count_per_symbol_;
 
   double* frame_start_;
   double* frame_end_;
@@ -28,10 +28,6 @@
 
 class Simulator {
  public:
-  /* optimization parameters for block transpose (see the slides for more
-   * details) */
-  static constexpr size_t kTransposeBlockSize = 8;
-  static constexpr size_t kTransposeBlockNum = 256;
   /* dequeue bulk size, used to reduce the overhead of dequeue in main thread
    */
   static constexpr size_t kDequeueBulkSize = 32;
@@ -67,10 +63,10 @@ class Simulator {
    *
    * First dimension: SOCKET_THREAD_NUM
    *
-   * Second dimension of socket_buffer: kFrameWnd * BS_ANT_NUM *
+   * Second dimension of socket_buffer: FrameWnd() * BS_ANT_NUM *
    * symbol_num_perframe * packet_length
    *
-   * Second dimension of buffer status: kFrameWnd * BS_ANT_NUM *
+   * Second dimension of buffer status: FrameWnd() * BS_ANT_NUM *
    * symbol_num_perframe
    */
   Table<char> socket_buffer_;
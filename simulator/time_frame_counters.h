@@ -5,8 +5,9 @@
 #ifndef TIME_FRAME_COUNTERS_H_
 #define TIME_FRAME_COUNTERS_H_
 
-#include <array>
 #include <cstddef>
+#include <utility>
+#include <vector>
 
 #include "gettime.h"
 #include "message.h"
@@ -16,83 +17,94 @@ class TimeFrameCounters {
  public:
   TimeFrameCounters() = default;
 
-  inline void Init(size_t max_symbol_count, size_t max_task_count = 0) {
-    counter_.Init(max_symbol_count, max_task_count);
+  inline void Init(size_t frame_wnd, size_t num_symbols,
+                   size_t max_symbol_count, size_t max_task_count = 0) {
+    counter_.Init(frame_wnd, num_symbols, max_symbol_count, max_task_count);
+    frame_wnd_mask_ = frame_wnd - 1;
+    num_symbols_ = num_symbols;
+    task_times_.assign(frame_wnd * num_symbols, {0, 0});
+    symbol_times_.assign(frame_wnd, {0, 0});
   }
   inline void Reset(size_t frame_id) { counter_.Reset(frame_id); }
   inline bool CompleteSymbol(size_t frame_id) {
     if (counter_.GetSymbolCount(frame_id) == 0) {
-      const size_t frame_idx = frame_id % kFrameWnd;
+      const size_t frame_idx = frame_id & frame_wnd_mask_;
       symbol_times_.at(frame_idx).first = GetTime::GetTimeUs();
     }
     const bool complete = counter_.CompleteSymbol(frame_id);
     if (complete) {
-      const size_t frame_idx = frame_id % kFrameWnd;
+      const size_t frame_idx = frame_id & frame_wnd_mask_;
       symbol_times_.at(frame_idx).second = GetTime::GetTimeUs();
     }
     return complete;
   }
   inline bool CompleteTask(size_t frame_id, size_t symbol_id) {
     if (counter_.GetTaskCount(frame_id, symbol_id) == 0) {
-      const size_t frame_idx = frame_id % kFrameWnd;
-      task_times_.at(frame_idx).at(symbol_id).first = GetTime::GetTimeUs();
+      task_times_.at(TaskSlot(frame_id, symbol_id)).first =
+          GetTime::GetTimeUs();
     }
     const bool complete = counter_.CompleteTask(frame_id, symbol_id);
     if (complete) {
-      const size_t frame_idx = frame_id % kFrameWnd;
-      task_times_.at(frame_idx).at(symbol_id).second = GetTime::GetTimeUs();
+      task_times_.at(TaskSlot(frame_id, symbol_id)).second =
+          GetTime::GetTimeUs();
     }
     return complete;
   }
   inline bool CompleteTask(size_t frame_id) {
     if (counter_.GetTaskCount(frame_id) == 0) {
-      const size_t frame_idx = frame_id % kFrameWnd;
+      const size_t frame_idx = frame_id & frame_wnd_mask_;
       symbol_times_.at(frame_idx).first = GetTime::GetTimeUs();
     }
     const bool complete = counter_.CompleteTask(frame_id);
     if (complete) {
-      const size_t frame_idx = frame_id % kFrameWnd;
+      const size_t frame_idx = frame_id & frame_wnd_mask_;
       symbol_times_.at(frame_idx).second = GetTime::GetTimeUs();
     }
     return complete;
   }
   inline double GetTaskTotalTimeMs(size_t frame_id, size_t symbol_id) const {
-    const size_t frame_idx = frame_id % kFrameWnd;
-    return (task_times_.at(frame_idx).at(symbol_id).second -
-            task_times_.at(frame_idx).at(symbol_id).first) /
+    const size_t task_slot = TaskSlot(frame_id, symbol_id);
+    return (task_times_.at(task_slot).second -
+            task_times_.at(task_slot).first) /
            1000.0f;
   }
   inline double GetTaskTotalTimeMs(size_t frame_id) const {
-    const size_t frame_idx = frame_id % kFrameWnd;
+    const size_t frame_idx = frame_id & frame_wnd_mask_;
     return (symbol_times_.at(frame_idx).second -
             symbol_times_.at(frame_idx).first) /
            1000.0f;
   };
 
   inline double GetTaskStartTimeUs(size_t frame_id, size_t symbol_id) const {
-    const size_t frame_idx = frame_id % kFrameWnd;
-    return task_times_.at(frame_idx).at(symbol_id).first;
+    const size_t task_slot = TaskSlot(frame_id, symbol_id);
+    return task_times_.at(task_slot).first;
   }
   inline double GetTaskStartTimeUs(size_t frame_id) const {
-    const size_t frame_idx = frame_id % kFrameWnd;
+    const size_t frame_idx = frame_id & frame_wnd_mask_;
     return symbol_times_.at(frame_idx).first;
   };
 
   inline double GetTaskEndTimeUs(size_t frame_id, size_t symbol_id) const {
-    const size_t frame_idx = frame_id % kFrameWnd;
-    return task_times_.at(frame_idx).at(symbol_id).second;
+    const size_t task_slot = TaskSlot(frame_id, symbol_id);
+    return task_times_.at(task_slot).second;
   }
   inline double GetTaskEndTimeUs(size_t frame_id) const {
-    const size_t frame_idx = frame_id % kFrameWnd;
+    const size_t frame_idx = frame_id & frame_wnd_mask_;
     return symbol_times_.at(frame_idx).second;
   };
 
  private:
+  inline size_t TaskSlot(size_t frame_id, size_t symbol_id) const {
+    return ((frame_id & frame_wnd_mask_) * num_symbols_) + symbol_id;
+  }
+
   FrameCounters counter_;
   //First = Start, Second = End
-  std::array<std::array<std::pair<double, double>, kMaxSymbols>, kFrameWnd>
-      task_times_;
-  std::array<std::pair<double, double>, kMaxSymbols> symbol_times_;
+  std::vector<std::pair<double, double>> task_times_;
+  std::vector<std::pair<double, double>> symbol_times_;
+  // Frame window size minus one, the frame slot mask
+  size_t frame_wnd_mask_{0};
+  size_t num_symbols_{0};
 };
 
 #endif  // TIME_FRAME_COUNTERS_H_
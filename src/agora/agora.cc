@@ -5,8 +5,10 @@
 
 #include "agora.h"
 
+#include <algorithm>
 #include <cmath>
 #include <memory>
+#include <numeric>
 
 #if defined(USE_DPDK)
 #include "packet_txrx_dpdk.h"
@@ -16,7 +18,9 @@
 #include "modulation.h"
 #include "packet_txrx_radio.h"
 #include "packet_txrx_sim.h"
+#include "partial_transpose.h"
 #include "signal_handler.h"
+#include "utils_ldpc.h"
 
 static const bool kDebugPrintPacketsFromMac = false;
 static const bool kDebugDeferral = true;
@@ -54,9 +58,18 @@ Agora::Agora(Config* const cfg)
       agora_memory_(std::make_unique<AgoraBuffer>(cfg)) {
   AGORA_LOG_INFO("Agora: project directory [%s], RDTSC frequency = %.2f GHz\n",
                  kProjectDirectory.c_str(), cfg->FreqGhz());
+  if (cfg->HugePageSize() != Agora_memory::HugePageSize::kNone) {
+    AGORA_LOG_INFO("Agora: %s\n", Agora_memory::HugePageSummary().c_str());
+  }
 
   PinToCoreWithOffset(ThreadType::kMaster, cfg->CoreOffset(), 0,
                       kEnableCoreReuse, false /* quiet */);
+  // The Doers created below specialize for the transpose block size
+  Agora_transpose::ResolveBlockSize(cfg);
+  if (cfg->BlockSizeTuning()) {
+    block_size_tuner_ = std::make_unique<BlockSizeTuner>(
+        cfg, stats_.get(), cfg->BlockSizeTuningFrames());
+  }
   CheckIncrementScheduleFrame(0, ScheduleProcessingFlags::kProcessingComplete);
   // Important to set frame_tracking_.cur_sche_frame_id_ after the call to
   // CheckIncrementScheduleFrame because it will be incremented however,
@@ -74,8 +87,8 @@ Agora::Agora(Config* const cfg)
         config_, 0,
         cfg->CoreOffset() + config_->WorkerThreadNum() +
             config_->SocketThreadNum() + 1,
-        kFrameWnd * config_->Frame().NumTotalSyms() * config_->BsAntNum() *
-            kDefaultQueueSize,
+        config_->FrameWnd() * config_->Frame().NumTotalSyms() *
+            config_->BsAntNum() * kDefaultQueueSize,
         0, config_->BsAntNum(), kRecordFrameInterval, Direction::kUplink,
         kRecorderTypes, true);
     recorder_->Start();
@@ -120,13 +133,19 @@ void Agora::SendSnrReport(EventType event_type, size_t frame_id,
   }
 }
 
+void Agora::UpdateDecodeUeOrder() {
+  LdpcDecodeOrder(decode_ue_order_, [this](size_t ue_id) {
+    return phy_stats_->GetLatestEvmSnr(ue_id);
+  });
+}
+
 void Agora::ScheduleDownlinkProcessing(size_t frame_id) {
   size_t num_pilot_symbols = config_->Frame().ClientDlPilotSymbols();
+  block_counters_->StartFrames(frame_id);
 
   for (size_t i = 0; i < num_pilot_symbols; i++) {
     if (beam_last_frame_ == frame_id) {
-      ScheduleSubcarriers(EventType::kPrecode, frame_id,
-                          config_->Frame().GetDLSymbol(i));
+      SchedulePrecodeSymbol(frame_id, config_->Frame().GetDLSymbol(i));
     } else {
       encode_cur_frame_for_symbol_.at(i) = frame_id;
     }
@@ -143,25 +162,28 @@ void Agora::ScheduleAntennas(EventType event_type, size_t frame_id,
   assert(event_type == EventType::kFFT or event_type == EventType::kIFFT);
   auto base_tag = gen_tag_t::FrmSymAnt(frame_id, symbol_id, 0);
 
-  size_t num_blocks = config_->BsAntNum() / config_->FftBlockSize();
-  size_t num_remainder = config_->BsAntNum() % config_->FftBlockSize();
+  const size_t fft_block_size = block_counters_->Sizes(frame_id).fft_;
+  size_t num_blocks = config_->BsAntNum() / fft_block_size;
+  size_t num_remainder = config_->BsAntNum() % fft_block_size;
   if (num_remainder > 0) {
     num_blocks++;
   }
   EventData event;
-  event.num_tags_ = config_->FftBlockSize();
+  event.num_tags_ = fft_block_size;
   event.event_type_ = event_type;
   size_t qid = frame_id & 0x1;
   for (size_t i = 0; i < num_blocks; i++) {
     if ((i == num_blocks - 1) && num_remainder > 0) {
       event.num_tags_ = num_remainder;
     }
+    // Workers on the NUMA node holding the block's antennas take the task
+    const size_t node = agora_memory_->GetNumaPlan().AntNode(base_tag.ant_id_);
     for (size_t j = 0; j < event.num_tags_; j++) {
       event.tags_[j] = base_tag.tag_;
       base_tag.ant_id_++;
     }
-    TryEnqueueFallback(message_->GetConq(event_type, qid),
-                       message_->GetPtok(event_type, qid), event);
+    TryEnqueueFallback(message_->GetConq(event_type, qid, node),
+                       message_->GetPtok(event_type, qid, node), event);
   }
 }
 
@@ -206,21 +228,18 @@ void Agora::ScheduleAntennasTX(size_t frame_id, size_t symbol_id) {
 void Agora::ScheduleSubcarriers(EventType event_type, size_t frame_id,
                                 size_t symbol_id) {
   gen_tag_t base_tag(0);
-  size_t num_events;
   size_t block_size;
 
   switch (event_type) {
     case EventType::kDemul:
     case EventType::kPrecode: {
       base_tag = gen_tag_t::FrmSymSc(frame_id, symbol_id, 0);
-      num_events = config_->DemulEventsPerSymbol();
-      block_size = config_->DemulBlockSize();
+      block_size = block_counters_->Sizes(frame_id).demul_;
       break;
     }
     case EventType::kBeam: {
       base_tag = gen_tag_t::FrmSc(frame_id, 0);
-      num_events = config_->BeamEventsPerSymbol();
-      block_size = config_->BeamBlockSize();
+      block_size = block_counters_->Sizes(frame_id).beam_;
       break;
     }
     default: {
@@ -228,27 +247,52 @@ void Agora::ScheduleSubcarriers(EventType event_type, size_t frame_id,
     }
   }
 
+  const size_t num_events = 1 + (config_->OfdmDataNum() - 1) / block_size;
   const size_t qid = (frame_id & 0x1);
   for (size_t i = 0; i < num_events; i++) {
-    TryEnqueueFallback(message_->GetConq(event_type, qid),
-                       message_->GetPtok(event_type, qid),
+    // Workers on the NUMA node holding the block's subcarriers take the task
+    const size_t node = agora_memory_->GetNumaPlan().ScNode(base_tag.sc_id_);
+    TryEnqueueFallback(message_->GetConq(event_type, qid, node),
+                       message_->GetPtok(event_type, qid, node),
                        EventData(event_type, base_tag.tag_));
     base_tag.sc_id_ += block_size;
   }
 }
 
+void Agora::SchedulePrecodeSymbol(size_t frame_id, size_t symbol_id) {
+  if (config_->FusedPrecodeIfft()) {
+    ScheduleAntennas(EventType::kIFFT, frame_id, symbol_id);
+  } else {
+    ScheduleSubcarriers(EventType::kPrecode, frame_id, symbol_id);
+  }
+}
+
+void Agora::ScheduleSubcarrierBlock(EventType event_type, size_t frame_id,
+                                    size_t symbol_id, size_t block_id) {
+  assert(event_type == EventType::kDemul or
+         event_type == EventType::kPrecode);
+  const auto tag = gen_tag_t::FrmSymSc(
+      frame_id, symbol_id, block_id * block_counters_->Sizes(frame_id).demul_);
+  const size_t qid = (frame_id & 0x1);
+  const size_t node = agora_memory_->GetNumaPlan().ScNode(tag.sc_id_);
+  TryEnqueueFallback(message_->GetConq(event_type, qid, node),
+                     message_->GetPtok(event_type, qid, node),
+                     EventData(event_type, tag.tag_));
+}
+
 void Agora::ScheduleCodeblocks(EventType event_type, Direction dir,
                                size_t frame_id, size_t symbol_idx) {
   auto base_tag = gen_tag_t::FrmSymCb(frame_id, symbol_idx, 0);
   const size_t num_tasks =
       config_->UeAntNum() * config_->LdpcConfig(dir).NumBlocksInSymbol();
-  size_t num_blocks = num_tasks / config_->EncodeBlockSize();
-  const size_t num_remainder = num_tasks % config_->EncodeBlockSize();
+  const size_t encode_block_size = block_counters_->Sizes(frame_id).encode_;
+  size_t num_blocks = num_tasks / encode_block_size;
+  const size_t num_remainder = num_tasks % encode_block_size;
   if (num_remainder > 0) {
     num_blocks++;
   }
   EventData event;
-  event.num_tags_ = config_->EncodeBlockSize();
+  event.num_tags_ = encode_block_size;
   event.event_type_ = event_type;
   size_t qid = frame_id & 0x1;
   for (size_t i = 0; i < num_blocks; i++) {
@@ -264,6 +308,34 @@ void Agora::ScheduleCodeblocks(EventType event_type, Direction dir,
   }
 }
 
+void Agora::ScheduleCodeblocks(EventType event_type, Direction dir,
+                               size_t frame_id, size_t symbol_idx,
+                               size_t cb_in_symbol) {
+  const size_t num_blocks_in_symbol =
+      config_->LdpcConfig(dir).NumBlocksInSymbol();
+  const size_t encode_block_size = block_counters_->Sizes(frame_id).encode_;
+  EventData event;
+  event.num_tags_ = 0;
+  event.event_type_ = event_type;
+  const size_t qid = frame_id & 0x1;
+  for (size_t i = 0; i < config_->UeAntNum(); i++) {
+    // Uplink codeblocks of the UEs least likely to converge go first
+    const size_t ue_id =
+        (event_type == EventType::kDecode) ? decode_ue_order_.at(i) : i;
+    event.tags_[event.num_tags_] =
+        gen_tag_t::FrmSymCb(frame_id, symbol_idx,
+                            (ue_id * num_blocks_in_symbol) + cb_in_symbol)
+            .tag_;
+    event.num_tags_++;
+    if ((event.num_tags_ == encode_block_size) ||
+        (i == config_->UeAntNum() - 1)) {
+      TryEnqueueFallback(message_->GetConq(event_type, qid),
+                         message_->GetPtok(event_type, qid), event);
+      event.num_tags_ = 0;
+    }
+  }
+}
+
 void Agora::ScheduleUsers(EventType event_type, size_t frame_id,
                           size_t symbol_id) {
   assert(event_type == EventType::kPacketToMac);
@@ -362,18 +434,19 @@ void Agora::Start() {
           }
 
           if (pkt->frame_id_ >=
-              ((frame_tracking_.cur_sche_frame_id_ + kFrameWnd))) {
+              ((frame_tracking_.cur_sche_frame_id_ + cfg->FrameWnd()))) {
             AGORA_LOG_ERROR(
                 "Error: Received packet for future frame %u beyond "
                 "frame window (= %zu + %zu). This can happen if "
                 "Agora is running slowly, e.g., in debug mode\n",
-                pkt->frame_id_, frame_tracking_.cur_sche_frame_id_, kFrameWnd);
+                pkt->frame_id_, frame_tracking_.cur_sche_frame_id_,
+                cfg->FrameWnd());
             cfg->Running(false);
             break;
           }
 
           UpdateRxCounters(pkt->frame_id_, pkt->symbol_id_);
-          fft_queue_arr_.at(pkt->frame_id_ % kFrameWnd)
+          fft_queue_arr_.at(cfg->FrameSlot(pkt->frame_id_))
               .push(fft_req_tag_t(event.tags_[0]));
         } break;
 
@@ -386,15 +459,16 @@ void Agora::Start() {
         case EventType::kBeam: {
           for (size_t tag_id = 0; (tag_id < event.num_tags_); tag_id++) {
             const size_t frame_id = gen_tag_t(event.tags_[tag_id]).frame_id_;
+            BlockCounters& counters = block_counters_->Counters(frame_id);
             stats_->PrintPerTaskDone(PrintType::kBeam, frame_id, 0,
-                                     beam_counters_.GetTaskCount(frame_id), 0);
-            const bool last_beam_task =
-                this->beam_counters_.CompleteTask(frame_id);
+                                     counters.beam_.GetTaskCount(frame_id), 0);
+            const bool last_beam_task = counters.beam_.CompleteTask(frame_id);
             if (last_beam_task == true) {
               this->stats_->MasterSetTsc(TsType::kBeamDone, frame_id);
+              agora_memory_->GetBeamCompletion().MarkComplete(frame_id);
               beam_last_frame_ = frame_id;
               stats_->PrintPerFrameDone(PrintType::kBeam, frame_id);
-              this->beam_counters_.Reset(frame_id);
+              counters.beam_.Reset(frame_id);
               if (kPrintBeamStats) {
                 this->phy_stats_->PrintBeamStats(frame_id);
               }
@@ -405,17 +479,34 @@ void Agora::Start() {
                                       cfg->Frame().GetULSymbol(i));
                 }
               }
-              // Schedule precoding for downlink symbols
-              for (size_t i = 0; i < cfg->Frame().NumDLSyms(); i++) {
+              // Schedule precoding for downlink pilot symbols, and for all
+              // encoded symbols of the fused precode and IFFT tasks
+              const size_t num_symbol_precode =
+                  cfg->FusedPrecodeIfft() ? cfg->Frame().NumDLSyms()
+                                          : cfg->Frame().ClientDlPilotSymbols();
+              for (size_t i = 0; i < num_symbol_precode; i++) {
                 const size_t last_encoded_frame =
                     this->encode_cur_frame_for_symbol_.at(i);
                 if ((last_encoded_frame != SIZE_MAX) &&
                     (last_encoded_frame >= frame_id)) {
-                  ScheduleSubcarriers(EventType::kPrecode, frame_id,
-                                      cfg->Frame().GetDLSymbol(i));
+                  SchedulePrecodeSymbol(frame_id, cfg->Frame().GetDLSymbol(i));
                 }
               }
-            }  // end if (beam_counters_.last_task(frame_id) == true)
+              // and for the data subcarrier blocks already encoded
+              for (size_t i = num_symbol_precode;
+                   i < cfg->Frame().NumDLSyms(); i++) {
+                const size_t symbol_id = cfg->Frame().GetDLSymbol(i);
+                for (size_t block_id = 0;
+                     block_id < counters.precode_sc_block_.NumBlocks();
+                     block_id++) {
+                  if (counters.precode_sc_block_.IsReady(frame_id, symbol_id,
+                                                         block_id)) {
+                    ScheduleSubcarrierBlock(EventType::kPrecode, frame_id,
+                                            symbol_id, block_id);
+                  }
+                }
+              }
+            }  // end if (counters.beam_.last_task(frame_id) == true)
           }
         } break;
 
@@ -423,24 +514,32 @@ void Agora::Start() {
           const size_t frame_id = gen_tag_t(event.tags_[0]).frame_id_;
           const size_t symbol_id = gen_tag_t(event.tags_[0]).symbol_id_;
           const size_t base_sc_id = gen_tag_t(event.tags_[0]).sc_id_;
+          BlockCounters& counters = block_counters_->Counters(frame_id);
 
           stats_->PrintPerTaskDone(
               PrintType::kDemul, frame_id, symbol_id, base_sc_id,
-              demul_counters_.GetTaskCount(frame_id, symbol_id));
+              counters.demul_.GetTaskCount(frame_id, symbol_id));
+
+          if (kUplinkHardDemod == false) {
+            // Decode each codeblock as soon as all of its LLRs are ready
+            decode_ready_cbs_.clear();
+            counters.demul_cb_.CompleteScBlock(frame_id, symbol_id, base_sc_id,
+                                               decode_ready_cbs_);
+            for (const size_t cb_id : decode_ready_cbs_) {
+              ScheduleCodeblocks(EventType::kDecode, Direction::kUplink,
+                                 frame_id, symbol_id, cb_id);
+            }
+          }
 
           const bool last_demul_task =
-              this->demul_counters_.CompleteTask(frame_id, symbol_id);
+              counters.demul_.CompleteTask(frame_id, symbol_id);
 
           if (last_demul_task == true) {
-            if (kUplinkHardDemod == false) {
-              ScheduleCodeblocks(EventType::kDecode, Direction::kUplink,
-                                 frame_id, symbol_id);
-            }
             stats_->PrintPerSymbolDone(
                 PrintType::kDemul, frame_id, symbol_id,
-                demul_counters_.GetSymbolCount(frame_id) + 1);
+                counters.demul_.GetSymbolCount(frame_id) + 1);
             const bool last_demul_symbol =
-                this->demul_counters_.CompleteSymbol(frame_id);
+                counters.demul_.CompleteSymbol(frame_id);
             if (last_demul_symbol == true) {
               max_equaled_frame_ = frame_id;
               this->stats_->MasterSetTsc(TsType::kDemulDone, frame_id);
@@ -451,6 +550,9 @@ void Agora::Start() {
               this->phy_stats_->RecordCsiCond(frame_id, config_->LogScNum());
               this->phy_stats_->RecordEvm(frame_id, config_->LogScNum());
               this->phy_stats_->RecordEvmSnr(frame_id);
+              if (config_->AdaptiveDecoderIter()) {
+                UpdateDecodeUeOrder();
+              }
               if (kUplinkHardDemod) {
                 this->phy_stats_->RecordBer(frame_id);
                 this->phy_stats_->RecordSer(frame_id);
@@ -466,7 +568,7 @@ void Agora::Start() {
                   goto finish;
                 }
               } else {
-                this->demul_counters_.Reset(frame_id);
+                counters.demul_.Reset(frame_id);
                 if (cfg->BigstationMode() == false) {
                   assert(frame_tracking_.cur_sche_frame_id_ == frame_id);
                   CheckIncrementScheduleFrame(frame_id, kUplinkComplete);
@@ -497,6 +599,7 @@ void Agora::Start() {
             if (last_decode_symbol == true) {
               this->stats_->MasterSetTsc(TsType::kDecodeDone, frame_id);
               stats_->PrintPerFrameDone(PrintType::kDecode, frame_id);
+              this->phy_stats_->ClearDecodeCycles(frame_id);
               this->phy_stats_->RecordBer(frame_id);
               this->phy_stats_->RecordSer(frame_id);
               if (kEnableMac == false) {
@@ -510,6 +613,12 @@ void Agora::Start() {
           }
         } break;
 
+        case EventType::kRC: {
+          const size_t frame_id = gen_tag_t(event.tags_[0]).frame_id_;
+          stats_->PrintPerTaskDone(PrintType::kRC, frame_id, 0, 0, 0);
+          CompleteRecipCal(frame_id);
+        } break;
+
         case EventType::kRANUpdate: {
           RanConfig rc;
           rc.n_antennas_ = event.tags_[0];
@@ -603,15 +712,34 @@ void Agora::Start() {
           for (size_t i = 0u; i < event.num_tags_; i++) {
             const size_t frame_id = gen_tag_t(event.tags_[i]).frame_id_;
             const size_t symbol_id = gen_tag_t(event.tags_[i]).symbol_id_;
+            const size_t cb_in_symbol =
+                gen_tag_t(event.tags_[i]).cb_id_ %
+                cfg->LdpcConfig(Direction::kDownlink).NumBlocksInSymbol();
+
+            // Precode the subcarrier blocks whose codeblocks are all encoded,
+            // if the precoder of the current frame exists
+            if (cfg->FusedPrecodeIfft() == false) {
+              precode_ready_blocks_.clear();
+              block_counters_->Counters(frame_id)
+                  .precode_sc_block_.CompleteCodeblock(
+                      frame_id, symbol_id, cb_in_symbol,
+                      precode_ready_blocks_);
+              if (beam_last_frame_ == frame_id) {
+                for (const size_t block_id : precode_ready_blocks_) {
+                  ScheduleSubcarrierBlock(EventType::kPrecode, frame_id,
+                                          symbol_id, block_id);
+                }
+              }
+            }
 
             const bool last_encode_task =
                 encode_counters_.CompleteTask(frame_id, symbol_id);
             if (last_encode_task == true) {
               this->encode_cur_frame_for_symbol_.at(
                   cfg->Frame().GetDLSymbolIdx(symbol_id)) = frame_id;
-              // If precoder of the current frame exists
-              if (beam_last_frame_ == frame_id) {
-                ScheduleSubcarriers(EventType::kPrecode, frame_id, symbol_id);
+              // Fused tasks need every subcarrier of the symbol
+              if (cfg->FusedPrecodeIfft() && (beam_last_frame_ == frame_id)) {
+                SchedulePrecodeSymbol(frame_id, symbol_id);
               }
               stats_->PrintPerSymbolDone(
                   PrintType::kEncode, frame_id, symbol_id,
@@ -633,24 +761,26 @@ void Agora::Start() {
           const size_t sc_id = gen_tag_t(event.tags_[0]).sc_id_;
           const size_t frame_id = gen_tag_t(event.tags_[0]).frame_id_;
           const size_t symbol_id = gen_tag_t(event.tags_[0]).symbol_id_;
+          BlockCounters& counters = block_counters_->Counters(frame_id);
           stats_->PrintPerTaskDone(
               PrintType::kPrecode, frame_id, symbol_id, sc_id,
-              precode_counters_.GetTaskCount(frame_id, symbol_id));
+              counters.precode_.GetTaskCount(frame_id, symbol_id));
           const bool last_precode_task =
-              this->precode_counters_.CompleteTask(frame_id, symbol_id);
+              counters.precode_.CompleteTask(frame_id, symbol_id);
 
           if (last_precode_task == true) {
+            counters.precode_sc_block_.Reset(frame_id, symbol_id);
             // precode_cur_frame_for_symbol_.at(
             //    this->config_->Frame().GetDLSymbolIdx(symbol_id)) = frame_id;
             ScheduleAntennas(EventType::kIFFT, frame_id, symbol_id);
             stats_->PrintPerSymbolDone(
                 PrintType::kPrecode, frame_id, symbol_id,
-                precode_counters_.GetSymbolCount(frame_id) + 1);
+                counters.precode_.GetSymbolCount(frame_id) + 1);
 
             const bool last_precode_symbol =
-                this->precode_counters_.CompleteSymbol(frame_id);
+                counters.precode_.CompleteSymbol(frame_id);
             if (last_precode_symbol == true) {
-              this->precode_counters_.Reset(frame_id);
+              counters.precode_.Reset(frame_id);
               this->stats_->MasterSetTsc(TsType::kPrecodeDone, frame_id);
               stats_->PrintPerFrameDone(PrintType::kPrecode, frame_id);
             }
@@ -697,8 +827,12 @@ void Agora::Start() {
                   this->ifft_counters_.CompleteSymbol(frame_id);
               if (last_ifft_symbol == true) {
                 ifft_next_symbol_ = 0;
+                if (cfg->FusedPrecodeIfft()) {
+                  this->stats_->MasterSetTsc(TsType::kPrecodeDone, frame_id);
+                }
                 this->stats_->MasterSetTsc(TsType::kIFFTDone, frame_id);
                 stats_->PrintPerFrameDone(PrintType::kIFFT, frame_id);
+                this->phy_stats_->PrintIfftClipping(frame_id);
                 assert(frame_id == frame_tracking_.cur_proc_frame_id_);
                 this->CheckIncrementScheduleFrame(frame_id, kDownlinkComplete);
                 const bool work_finished = this->CheckFrameComplete(frame_id);
@@ -771,17 +905,19 @@ void Agora::Start() {
       // We schedule FFT processing if the event handling above results in
       // either (a) sufficient packets received for the current frame,
       // or (b) the current frame being updated.
-      std::queue<fft_req_tag_t>& cur_fftq =
-          fft_queue_arr_.at(frame_tracking_.cur_sche_frame_id_ % kFrameWnd);
+      std::queue<fft_req_tag_t>& cur_fftq = fft_queue_arr_.at(
+          cfg->FrameSlot(frame_tracking_.cur_sche_frame_id_));
       const size_t qid = frame_tracking_.cur_sche_frame_id_ & 0x1;
-      if (cur_fftq.size() >= config_->FftBlockSize()) {
-        const size_t num_fft_blocks = cur_fftq.size() / config_->FftBlockSize();
+      const size_t fft_block_size =
+          block_counters_->Sizes(frame_tracking_.cur_sche_frame_id_).fft_;
+      if (cur_fftq.size() >= fft_block_size) {
+        const size_t num_fft_blocks = cur_fftq.size() / fft_block_size;
         for (size_t i = 0; i < num_fft_blocks; i++) {
           EventData do_fft_task;
-          do_fft_task.num_tags_ = config_->FftBlockSize();
+          do_fft_task.num_tags_ = fft_block_size;
           do_fft_task.event_type_ = EventType::kFFT;
 
-          for (size_t j = 0; j < config_->FftBlockSize(); j++) {
+          for (size_t j = 0; j < fft_block_size; j++) {
             RtAssert(!cur_fftq.empty(),
                      "Using front element cur_fftq when it is empty");
             do_fft_task.tags_[j] = cur_fftq.front().tag_;
@@ -807,6 +943,10 @@ void Agora::Start() {
         }
       }
     } /* End of for */
+    if (num_events > 0) {
+      // Wake the workers sleeping on the tasks scheduled above
+      worker_set_->Notify();
+    }
   }   /* End of while */
 
 finish:
@@ -840,23 +980,23 @@ void Agora::HandleEventFft(size_t tag) {
           PrintType::kFFTPilots, frame_id, symbol_id,
           pilot_fft_counters_.GetSymbolCount(frame_id) + 1);
 
-      if ((config_->Frame().IsRecCalEnabled() == false) ||
-          ((config_->Frame().IsRecCalEnabled() == true) &&
-           (this->rc_last_frame_ == frame_id))) {
-        // If CSI of all UEs is ready, schedule Beam/prediction
-        const bool last_pilot_fft =
-            pilot_fft_counters_.CompleteSymbol(frame_id);
-        if (last_pilot_fft == true) {
-          this->stats_->MasterSetTsc(TsType::kFFTPilotsDone, frame_id);
-          stats_->PrintPerFrameDone(PrintType::kFFTPilots, frame_id);
-          this->pilot_fft_counters_.Reset(frame_id);
-          if (kPrintPhyStats == true) {
-            this->phy_stats_->PrintUlSnrStats(frame_id);
-          }
-          this->phy_stats_->RecordPilotSnr(frame_id);
-          if (kEnableMac == true) {
-            SendSnrReport(EventType::kSNRReport, frame_id, symbol_id);
-          }
+      // If CSI of all UEs is ready, schedule Beam/prediction
+      const bool last_pilot_fft = pilot_fft_counters_.CompleteSymbol(frame_id);
+      if (last_pilot_fft == true) {
+        this->stats_->MasterSetTsc(TsType::kFFTPilotsDone, frame_id);
+        stats_->PrintPerFrameDone(PrintType::kFFTPilots, frame_id);
+        this->pilot_fft_counters_.Reset(frame_id);
+        if (kPrintPhyStats == true) {
+          this->phy_stats_->PrintUlSnrStats(frame_id);
+        }
+        this->phy_stats_->RecordPilotSnr(frame_id);
+        if (kEnableMac == true) {
+          SendSnrReport(EventType::kSNRReport, frame_id, symbol_id);
+        }
+        this->pilot_fft_last_frame_ = frame_id;
+        // Otherwise CompleteRecipCal() schedules the beamweights
+        if ((config_->Frame().IsRecCalEnabled() == false) ||
+            (this->rc_last_frame_ == frame_id)) {
           ScheduleSubcarriers(EventType::kBeam, frame_id, 0);
         }
       }
@@ -892,22 +1032,43 @@ void Agora::HandleEventFft(size_t tag) {
     if (last_rc_task == true) {
       stats_->PrintPerFrameDone(PrintType::kFFTCal, frame_id);
       this->rc_counters_.Reset(frame_id);
-      this->stats_->MasterSetTsc(TsType::kRCDone, frame_id);
-      this->rc_last_frame_ = frame_id;
-
-      // See if the calibration has completed
-      if (kPrintPhyStats) {
-        const size_t frames_for_cal = config_->RecipCalFrameCnt();
-
-        if ((frame_id % frames_for_cal) == 0 && (frame_id > 0)) {
-          const size_t previous_cal_slot =
-              config_->ModifyRecCalIndex(config_->RecipCalIndex(frame_id), -1);
-          //Print the previous index
-          phy_stats_->PrintCalibSnrStats(previous_cal_slot);
-        }
-      }  // kPrintPhyStats
-    }    // last_rc_task
-  }      // kCaLDL || kCalUl
+
+      const size_t frames_for_cal = config_->RecipCalFrameCnt();
+      if ((config_->Frame().NumDLSyms() > 0) && (frame_id >= frames_for_cal) &&
+          ((frame_id % frames_for_cal) == 0)) {
+        // A calibration window completed, refresh the calibration vectors
+        // of all subcarriers before the beamweights of this frame
+        const size_t qid = (frame_id & 0x1);
+        TryEnqueueFallback(
+            message_->GetConq(EventType::kRC, qid),
+            message_->GetPtok(EventType::kRC, qid),
+            EventData(EventType::kRC, gen_tag_t::FrmSc(frame_id, 0).tag_));
+      } else {
+        CompleteRecipCal(frame_id);
+      }
+    }  // last_rc_task
+  }    // kCaLDL || kCalUl
+}
+
+void Agora::CompleteRecipCal(size_t frame_id) {
+  this->stats_->MasterSetTsc(TsType::kRCDone, frame_id);
+  this->rc_last_frame_ = frame_id;
+
+  // See if the calibration has completed
+  if (kPrintPhyStats) {
+    const size_t frames_for_cal = config_->RecipCalFrameCnt();
+
+    if ((frame_id % frames_for_cal) == 0 && (frame_id > 0)) {
+      const size_t previous_cal_slot =
+          config_->ModifyRecCalIndex(config_->RecipCalIndex(frame_id), -1);
+      //Print the previous index
+      phy_stats_->PrintCalibSnrStats(previous_cal_slot);
+    }
+  }  // kPrintPhyStats
+
+  if (this->pilot_fft_last_frame_ == frame_id) {
+    ScheduleSubcarriers(EventType::kBeam, frame_id, 0);
+  }
 }
 
 void Agora::UpdateRanConfig(RanConfig rc) {
@@ -917,7 +1078,7 @@ void Agora::UpdateRanConfig(RanConfig rc) {
 }
 
 void Agora::UpdateRxCounters(size_t frame_id, size_t symbol_id) {
-  const size_t frame_slot = frame_id % kFrameWnd;
+  const size_t frame_slot = config_->FrameSlot(frame_id);
   if (config_->IsPilot(frame_id, symbol_id)) {
     rx_counters_.num_pilot_pkts_[frame_slot]++;
     if (rx_counters_.num_pilot_pkts_.at(frame_slot) ==
@@ -937,6 +1098,7 @@ void Agora::UpdateRxCounters(size_t frame_id, size_t symbol_id) {
   }
   // Receive first packet in a frame
   if (rx_counters_.num_pkts_.at(frame_slot) == 0) {
+    block_counters_->StartFrames(frame_id);
     if (kEnableMac == false) {
       // schedule this frame's encoding
       // Defer the schedule.  If frames are already deferred or the current
@@ -954,7 +1116,7 @@ void Agora::UpdateRxCounters(size_t frame_id, size_t symbol_id) {
     }
     this->stats_->MasterSetTsc(TsType::kFirstSymbolRX, frame_id);
     if (kDebugPrintPerFrameStart) {
-      const size_t prev_frame_slot = (frame_slot + kFrameWnd - 1) % kFrameWnd;
+      const size_t prev_frame_slot = config_->FrameSlot(frame_id - 1);
       AGORA_LOG_INFO(
           "Main [frame %zu + %.2f ms since last frame]: Received "
           "first packet. Remaining packets in prev frame: %zu\n",
@@ -979,10 +1141,12 @@ void Agora::InitializeQueues() {
   const int data_symbol_num_perframe = config_->Frame().NumDataSyms();
   message_queue_ = moodycamel::ConcurrentQueue<EventData>(
       kDefaultMessageQueueSize * data_symbol_num_perframe);
+  fft_queue_arr_.resize(config_->FrameWnd());
 
   // Create concurrent queues for each Doer
-  message_ = std::make_unique<MessageInfo>(kDefaultWorkerQueueSize *
-                                           data_symbol_num_perframe);
+  message_ = std::make_unique<MessageInfo>(
+      kDefaultWorkerQueueSize * data_symbol_num_perframe,
+      agora_memory_->GetNumaPlan().NumNodes());
 
   for (size_t i = 0; i < config_->SocketThreadNum(); i++) {
     rx_ptoks_ptr_[i] = new moodycamel::ProducerToken(message_queue_);
@@ -1006,7 +1170,11 @@ void Agora::FreeQueues() {
 
 void Agora::InitializeCounters() {
   const auto& cfg = config_;
+  // Counters of the frame window, indexed by symbol id within the frame
+  const size_t frame_wnd = cfg->FrameWnd();
+  const size_t num_symbols = cfg->Frame().NumTotalSyms();
 
+  rx_counters_.Init(frame_wnd);
   rx_counters_.num_pilot_pkts_per_frame_ =
       cfg->BsAntNum() * cfg->Frame().NumPilotSyms();
   // BfAntNum() for each 'L' symbol (no ref node)
@@ -1029,43 +1197,46 @@ void Agora::InitializeCounters() {
       (cfg->BsAntNum() * cfg->Frame().NumULSyms());
 
   fft_created_count_ = 0;
-  pilot_fft_counters_.Init(cfg->Frame().NumPilotSyms(), cfg->BsAntNum());
-  uplink_fft_counters_.Init(cfg->Frame().NumULSyms(), cfg->BsAntNum());
+  pilot_fft_counters_.Init(frame_wnd, num_symbols, cfg->Frame().NumPilotSyms(),
+                           cfg->BsAntNum());
+  uplink_fft_counters_.Init(frame_wnd, num_symbols, cfg->Frame().NumULSyms(),
+                            cfg->BsAntNum());
   fft_cur_frame_for_symbol_ =
       std::vector<size_t>(cfg->Frame().NumULSyms(), SIZE_MAX);
 
-  rc_counters_.Init(cfg->BsAntNum());
-
-  beam_counters_.Init(cfg->BeamEventsPerSymbol());
-
-  demul_counters_.Init(cfg->Frame().NumULSyms(), cfg->DemulEventsPerSymbol());
+  rc_counters_.Init(frame_wnd, num_symbols, cfg->BsAntNum());
+  block_counters_ = std::make_unique<FrameBlockCounters>(
+      cfg, agora_memory_->GetBlockSizes());
 
   decode_counters_.Init(
-      cfg->Frame().NumULSyms(),
+      frame_wnd, num_symbols, cfg->Frame().NumULSyms(),
       cfg->LdpcConfig(Direction::kUplink).NumBlocksInSymbol() *
           cfg->UeAntNum());
+  decode_ue_order_.resize(cfg->UeAntNum());
+  std::iota(decode_ue_order_.begin(), decode_ue_order_.end(), 0);
 
-  tomac_counters_.Init(cfg->Frame().NumULSyms(), cfg->UeAntNum());
+  tomac_counters_.Init(frame_wnd, num_symbols, cfg->Frame().NumULSyms(),
+                       cfg->UeAntNum());
 
   if (config_->Frame().NumDLSyms() > 0) {
     AGORA_LOG_TRACE("Agora: Initializing downlink buffers\n");
 
     encode_counters_.Init(
-        config_->Frame().NumDlDataSyms(),
+        frame_wnd, num_symbols, config_->Frame().NumDlDataSyms(),
         config_->LdpcConfig(Direction::kDownlink).NumBlocksInSymbol() *
             config_->UeAntNum());
     encode_cur_frame_for_symbol_ =
         std::vector<size_t>(config_->Frame().NumDLSyms(), SIZE_MAX);
     ifft_cur_frame_for_symbol_ =
         std::vector<size_t>(config_->Frame().NumDLSyms(), SIZE_MAX);
-    precode_counters_.Init(config_->Frame().NumDLSyms(),
-                           config_->DemulEventsPerSymbol());
     // precode_cur_frame_for_symbol_ =
     //    std::vector<size_t>(config_->Frame().NumDLSyms(), SIZE_MAX);
-    ifft_counters_.Init(config_->Frame().NumDLSyms(), config_->BsAntNum());
-    tx_counters_.Init(config_->Frame().NumDLSyms(), config_->BsAntNum());
+    ifft_counters_.Init(frame_wnd, num_symbols, config_->Frame().NumDLSyms(),
+                        config_->BsAntNum());
+    tx_counters_.Init(frame_wnd, num_symbols, config_->Frame().NumDLSyms(),
+                      config_->BsAntNum());
     // mac data is sent per frame, so we set max symbol to 1
-    mac_to_phy_counters_.Init(1, config_->UeAntNum());
+    mac_to_phy_counters_.Init(frame_wnd, num_symbols, 1, config_->UeAntNum());
   }
 }
 
@@ -1139,7 +1310,7 @@ void Agora::SaveDecodeDataToFile(int frame_id) {
     for (size_t i = 0; i < cfg->Frame().NumULSyms(); i++) {
       for (size_t j = 0; j < cfg->UeAntNum(); j++) {
         const int8_t* ptr =
-            agora_memory_->GetDecod()[(frame_id % kFrameWnd)][i][j];
+            agora_memory_->GetDecod()[cfg->FrameSlot(frame_id)][i][j];
         const auto write_status =
             std::fwrite(ptr, sizeof(uint8_t), num_decoded_bytes, fp);
         if (write_status != num_decoded_bytes) {
@@ -1231,13 +1402,14 @@ bool Agora::CheckFrameComplete(size_t frame_id) {
       (((false == kEnableMac) &&
         (true == this->decode_counters_.IsLastSymbol(frame_id))) ||
        ((true == kUplinkHardDemod) &&
-        (true == this->demul_counters_.IsLastSymbol(frame_id))) ||
+        (true ==
+         block_counters_->Counters(frame_id).demul_.IsLastSymbol(frame_id))) ||
        ((true == kEnableMac) &&
         (true == this->tomac_counters_.IsLastSymbol(frame_id))))) {
     this->stats_->UpdateStats(frame_id);
     assert(frame_id == frame_tracking_.cur_proc_frame_id_);
     if (true == kUplinkHardDemod) {
-      this->demul_counters_.Reset(frame_id);
+      block_counters_->Counters(frame_id).demul_.Reset(frame_id);
     }
     this->decode_counters_.Reset(frame_id);
     this->tomac_counters_.Reset(frame_id);
@@ -1245,11 +1417,29 @@ bool Agora::CheckFrameComplete(size_t frame_id) {
     this->tx_counters_.Reset(frame_id);
     if (config_->Frame().NumDLSyms() > 0) {
       for (size_t ue_id = 0; ue_id < config_->UeAntNum(); ue_id++) {
-        this->agora_memory_->GetDlBitsStatus()[ue_id][frame_id % kFrameWnd] = 0;
+        this->agora_memory_
+            ->GetDlBitsStatus()[ue_id][config_->FrameSlot(frame_id)] = 0;
       }
     }
     frame_tracking_.cur_proc_frame_id_++;
 
+    const double latency_us =
+        stats_->MasterGetUsSince(TsType::kFirstSymbolRX, frame_id);
+    worker_set_->FrameDone(latency_us);
+    if ((block_size_tuner_ != nullptr) &&
+        block_size_tuner_->FrameDone(frame_id, latency_us)) {
+      // Frames in flight keep their sizes, so the next frame to start
+      // takes the new ones
+      const BlockSizes& sizes = block_size_tuner_->Pending();
+      AGORA_LOG_INFO(
+          "Agora: block sizes from frame %zu: demul %zu, beam %zu, fft %zu, "
+          "encode %zu\n",
+          block_counters_->StartedEnd(), sizes.demul_, sizes.beam_,
+          sizes.fft_, sizes.encode_);
+      block_counters_->SetNext(sizes);
+      block_size_tuner_->Applied(block_counters_->StartedEnd());
+    }
+
     if (frame_id == (this->config_->FramesToTest() - 1)) {
       finished = true;
     } else {
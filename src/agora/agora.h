@@ -16,7 +16,9 @@
 
 #include "agora_buffer.h"
 #include "agora_worker.h"
+#include "block_size_tuner.h"
 #include "concurrentqueue.h"
+#include "frame_block_counters.h"
 #include "mac_thread_basestation.h"
 #include "message.h"
 #include "packet_txrx.h"
@@ -79,6 +81,9 @@ class Agora {
   void SaveTxDataToFile(int frame_id);
 
   void HandleEventFft(size_t tag);
+  /// Mark the calibration vectors of frame_id ready and schedule the
+  /// beamweights if the pilots are also done
+  void CompleteRecipCal(size_t frame_id);
   void UpdateRxCounters(size_t frame_id, size_t symbol_id);
 
   /// Update Agora's RAN config parameters
@@ -86,6 +91,12 @@ class Agora {
 
   void ScheduleSubcarriers(EventType event_type, size_t frame_id,
                            size_t symbol_id);
+  /// Schedule precoding of a whole downlink symbol, or its fused precode and
+  /// IFFT tasks if fused_precode_ifft is set
+  void SchedulePrecodeSymbol(size_t frame_id, size_t symbol_id);
+  /// Schedule one subcarrier block of a demul or precode symbol
+  void ScheduleSubcarrierBlock(EventType event_type, size_t frame_id,
+                               size_t symbol_id, size_t block_id);
   void ScheduleAntennas(EventType event_type, size_t frame_id,
                         size_t symbol_id);
   void ScheduleAntennasTX(size_t frame_id, size_t symbol_id);
@@ -100,11 +111,16 @@ class Agora {
    */
   void ScheduleCodeblocks(EventType event_type, Direction dir, size_t frame_id,
                           size_t symbol_idx);
+  /// Schedule codeblock cb_in_symbol of every UE in one symbol
+  void ScheduleCodeblocks(EventType event_type, Direction dir, size_t frame_id,
+                          size_t symbol_idx, size_t cb_in_symbol);
 
   void ScheduleUsers(EventType event_type, size_t frame_id, size_t symbol_id);
 
   // Send current frame's SNR measurements from PHY to MAC
   void SendSnrReport(EventType event_type, size_t frame_id, size_t symbol_id);
+  // Order decode_ue_order_ by decreasing latest post-equalization SNR
+  void UpdateDecodeUeOrder();
 
   // Worker thread i runs on core base_worker_core_offset + i
   const size_t base_worker_core_offset_;
@@ -122,6 +138,8 @@ class Agora {
   std::unique_ptr<Stats> stats_;
   std::unique_ptr<PhyStats> phy_stats_;
   std::unique_ptr<AgoraWorker> worker_set_;
+  // Set if block_size_tuning is enabled
+  std::unique_ptr<BlockSizeTuner> block_size_tuner_;
 
   //Agora Buffer containment
   std::unique_ptr<AgoraBuffer> agora_memory_;
@@ -129,11 +147,14 @@ class Agora {
   // Counters related to various modules
   FrameCounters pilot_fft_counters_;
   FrameCounters uplink_fft_counters_;
-  FrameCounters beam_counters_;
-  FrameCounters demul_counters_;
+  // Block sizes of each frame, and the counters that depend on them
+  std::unique_ptr<FrameBlockCounters> block_counters_;
+  std::vector<size_t> decode_ready_cbs_;
+  // Order in which the codeblocks of the UEs are scheduled for decoding
+  std::vector<size_t> decode_ue_order_;
   FrameCounters decode_counters_;
   FrameCounters encode_counters_;
-  FrameCounters precode_counters_;
+  std::vector<size_t> precode_ready_blocks_;
   FrameCounters ifft_counters_;
   FrameCounters tx_counters_;
   FrameCounters tomac_counters_;
@@ -142,6 +163,7 @@ class Agora {
   RxCounters rx_counters_;
   size_t beam_last_frame_ = SIZE_MAX;
   size_t rc_last_frame_ = SIZE_MAX;
+  size_t pilot_fft_last_frame_ = SIZE_MAX;
   size_t ifft_next_symbol_ = 0;
 
   // Agora schedules and processes a frame in FIFO order
@@ -164,7 +186,7 @@ class Agora {
 
   // Per-frame queues of delayed FFT tasks. The queue contains offsets into
   // TX/RX buffers.
-  std::array<std::queue<fft_req_tag_t>, kFrameWnd> fft_queue_arr_;
+  std::vector<std::queue<fft_req_tag_t>> fft_queue_arr_;
 
   // Master thread's message queue for receiving packets
   moodycamel::ConcurrentQueue<EventData> message_queue_;
@@ -4,22 +4,52 @@
  */
 #include "agora_buffer.h"
 
+#include <cerrno>
+#include <cstring>
+
+#include "logger.h"
+
+/// System NUMA node of each worker thread, all 0 unless numa_aware is set
+static std::vector<size_t> WorkerNumaNodes(const Config* cfg) {
+  std::vector<size_t> worker_nodes(cfg->WorkerThreadNum(), 0);
+  if (cfg->NumaAware()) {
+    // Same core offset as AgoraWorker
+    const size_t base_worker_core_offset =
+        cfg->CoreOffset() + 1 + cfg->SocketThreadNum();
+    for (size_t tid = 0; tid < worker_nodes.size(); tid++) {
+      worker_nodes.at(tid) = GetCoreNumaNode(base_worker_core_offset, tid);
+    }
+  }
+  return worker_nodes;
+}
+
 AgoraBuffer::AgoraBuffer(Config* const cfg)
     : config_(cfg),
-      ul_socket_buf_size_(cfg->PacketLength() * cfg->BsAntNum() * kFrameWnd *
-                          cfg->Frame().NumTotalSyms()),
-      csi_buffer_(kFrameWnd, cfg->UeAntNum(),
+      ul_socket_buf_size_(cfg->PacketLength() * cfg->BsAntNum() *
+                          cfg->FrameWnd() * cfg->Frame().NumTotalSyms()),
+      numa_plan_(WorkerNumaNodes(cfg), cfg->OfdmDataNum(),
+                 cfg->DemulBlockSize(), cfg->BsAntNum(), cfg->FftBlockSize()),
+      csi_buffer_(cfg->FrameWnd(), cfg->UeAntNum(),
                   cfg->BsAntNum() * cfg->OfdmDataNum()),
-      ul_beam_matrix_(kFrameWnd, cfg->OfdmDataNum(),
+      ul_beam_matrix_(cfg->FrameWnd(), cfg->OfdmDataNum(),
                       cfg->BsAntNum() * cfg->UeAntNum()),
-      dl_beam_matrix_(kFrameWnd, cfg->OfdmDataNum(),
+      dl_beam_matrix_(cfg->FrameWnd(), cfg->OfdmDataNum(),
                       cfg->UeAntNum() * cfg->BsAntNum()),
-      demod_buffer_(kFrameWnd, cfg->Frame().NumULSyms(), cfg->UeAntNum(),
+      demod_buffer_(cfg->FrameWnd(), cfg->Frame().NumULSyms(), cfg->UeAntNum(),
                     kMaxModType * cfg->OfdmDataNum()),
-      decoded_buffer_(kFrameWnd, cfg->Frame().NumULSyms(), cfg->UeAntNum(),
+      decoded_buffer_(cfg->FrameWnd(), cfg->Frame().NumULSyms(),
+                      cfg->UeAntNum(),
                       cfg->LdpcConfig(Direction::kUplink).NumBlocksInSymbol() *
-                          Roundup<64>(cfg->NumBytesPerCb(Direction::kUplink))) {
+                          Roundup<64>(cfg->NumBytesPerCb(Direction::kUplink))),
+      block_sizes_(cfg) {
   AllocateTables();
+  beam_completion_.Init(cfg->FrameWnd());
+  if (numa_plan_.NumNodes() > 1) {
+    PlaceOnNumaNodes();
+  }
+  AGORA_LOG_INFO("AgoraBuffer: %.1f MiB of buffers for a %zu frame window\n",
+                 static_cast<double>(MemoryBytes()) / (1 << 20),
+                 cfg->FrameWnd());
 }
 
 AgoraBuffer::~AgoraBuffer() { FreeTables(); }
@@ -27,7 +57,7 @@ AgoraBuffer::~AgoraBuffer() { FreeTables(); }
 void AgoraBuffer::AllocateTables() {
   // Uplink
   const size_t task_buffer_symbol_num_ul =
-      config_->Frame().NumULSyms() * kFrameWnd;
+      config_->Frame().NumULSyms() * config_->FrameWnd();
 
   ul_socket_buffer_.Malloc(config_->SocketThreadNum() /* RX */,
                            ul_socket_buf_size_,
@@ -37,54 +67,69 @@ void AgoraBuffer::AllocateTables() {
                      config_->OfdmDataNum() * config_->BsAntNum(),
                      Agora_memory::Alignment_t::kAlign64);
 
+  if (config_->UlFixedPoint()) {
+    fft_buffer_fixed_.Malloc(task_buffer_symbol_num_ul,
+                             2 * config_->OfdmDataNum() * config_->BsAntNum(),
+                             Agora_memory::Alignment_t::kAlign64);
+    fft_exp_buffer_.Calloc(task_buffer_symbol_num_ul, config_->BsAntNum(),
+                           Agora_memory::Alignment_t::kAlign64);
+    ul_beam_matrix_fixed_.Alloc(
+        config_->FrameWnd(), config_->OfdmDataNum(),
+        4 * config_->BsAntNum() * config_->UeAntNum());
+    ul_beam_exp_buffer_.Calloc(config_->FrameWnd(), config_->OfdmDataNum(),
+                               Agora_memory::Alignment_t::kAlign64);
+  }
+
   equal_buffer_.Malloc(task_buffer_symbol_num_ul,
                        config_->OfdmDataNum() * config_->UeAntNum(),
                        Agora_memory::Alignment_t::kAlign64);
   ue_spec_pilot_buffer_.Calloc(
-      kFrameWnd, config_->Frame().ClientUlPilotSymbols() * config_->UeAntNum(),
+      config_->FrameWnd(),
+      config_->Frame().ClientUlPilotSymbols() * config_->UeAntNum(),
       Agora_memory::Alignment_t::kAlign64);
 
   // Downlink
   if (config_->Frame().NumDLSyms() > 0) {
     const size_t task_buffer_symbol_num =
-        config_->Frame().NumDLSyms() * kFrameWnd;
+        config_->Frame().NumDLSyms() * config_->FrameWnd();
 
     size_t dl_socket_buffer_status_size =
         config_->BsAntNum() * task_buffer_symbol_num;
-    size_t dl_socket_buffer_size =
+    dl_socket_buf_size_ =
         config_->DlPacketLength() * dl_socket_buffer_status_size;
-    AllocBuffer1d(&dl_socket_buffer_, dl_socket_buffer_size,
+    AllocBuffer1d(&dl_socket_buffer_, dl_socket_buf_size_,
                   Agora_memory::Alignment_t::kAlign64, 1);
 
     size_t dl_bits_buffer_size =
-        kFrameWnd * config_->MacBytesNumPerframe(Direction::kDownlink);
+        config_->FrameWnd() *
+        config_->MacBytesNumPerframe(Direction::kDownlink);
     dl_bits_buffer_.Calloc(config_->UeAntNum(), dl_bits_buffer_size,
                            Agora_memory::Alignment_t::kAlign64);
-    dl_bits_buffer_status_.Calloc(config_->UeAntNum(), kFrameWnd,
+    dl_bits_buffer_status_.Calloc(config_->UeAntNum(), config_->FrameWnd(),
                                   Agora_memory::Alignment_t::kAlign64);
 
     dl_ifft_buffer_.Calloc(config_->BsAntNum() * task_buffer_symbol_num,
                            config_->OfdmCaNum(),
                            Agora_memory::Alignment_t::kAlign64);
-    calib_dl_buffer_.Malloc(kFrameWnd,
+    calib_dl_buffer_.Malloc(config_->FrameWnd(),
                             config_->BfAntNum() * config_->OfdmDataNum(),
                             Agora_memory::Alignment_t::kAlign64);
-    calib_ul_buffer_.Malloc(kFrameWnd,
+    calib_ul_buffer_.Malloc(config_->FrameWnd(),
                             config_->BfAntNum() * config_->OfdmDataNum(),
                             Agora_memory::Alignment_t::kAlign64);
-    calib_dl_msum_buffer_.Malloc(kFrameWnd,
+    calib_dl_msum_buffer_.Malloc(config_->FrameWnd(),
                                  config_->BfAntNum() * config_->OfdmDataNum(),
                                  Agora_memory::Alignment_t::kAlign64);
-    calib_ul_msum_buffer_.Malloc(kFrameWnd,
+    calib_ul_msum_buffer_.Malloc(config_->FrameWnd(),
                                  config_->BfAntNum() * config_->OfdmDataNum(),
                                  Agora_memory::Alignment_t::kAlign64);
-    calib_buffer_.Malloc(kFrameWnd,
+    calib_buffer_.Malloc(config_->FrameWnd(),
                          config_->BfAntNum() * config_->OfdmDataNum(),
                          Agora_memory::Alignment_t::kAlign64);
     //initialize the calib buffers
     const complex_float complex_init = {0.0f, 0.0f};
     //const complex_float complex_init = {1.0f, 0.0f};
-    for (size_t frame = 0u; frame < kFrameWnd; frame++) {
+    for (size_t frame = 0u; frame < config_->FrameWnd(); frame++) {
       for (size_t i = 0; i < (config_->OfdmDataNum() * config_->BfAntNum());
            i++) {
         calib_dl_buffer_[frame][i] = complex_init;
@@ -105,6 +150,9 @@ void AgoraBuffer::FreeTables() {
   // Uplink
   ul_socket_buffer_.Free();
   fft_buffer_.Free();
+  fft_buffer_fixed_.Free();
+  fft_exp_buffer_.Free();
+  ul_beam_exp_buffer_.Free();
   equal_buffer_.Free();
   ue_spec_pilot_buffer_.Free();
 
@@ -122,3 +170,92 @@ void AgoraBuffer::FreeTables() {
     dl_bits_buffer_status_.Free();
   }
 }
+
+template <typename T>
+static size_t TableBytes(const Table<T>& table) {
+  return table.Dim1() * table.Dim2() * sizeof(T);
+}
+
+size_t AgoraBuffer::MemoryBytes() const {
+  return csi_buffer_.Bytes() + ul_beam_matrix_.Bytes() +
+         dl_beam_matrix_.Bytes() + demod_buffer_.Bytes() +
+         decoded_buffer_.Bytes() + TableBytes(fft_buffer_) +
+         TableBytes(fft_buffer_fixed_) + TableBytes(fft_exp_buffer_) +
+         ul_beam_matrix_fixed_.Bytes() + TableBytes(ul_beam_exp_buffer_) +
+         TableBytes(equal_buffer_) + TableBytes(ue_spec_pilot_buffer_) +
+         TableBytes(dl_ifft_buffer_) + TableBytes(calib_ul_msum_buffer_) +
+         TableBytes(calib_dl_msum_buffer_) + TableBytes(calib_buffer_) +
+         TableBytes(dl_mod_bits_buffer_) + TableBytes(dl_bits_buffer_) +
+         TableBytes(dl_bits_buffer_status_) + TableBytes(ul_socket_buffer_) +
+         dl_socket_buf_size_ + TableBytes(calib_ul_buffer_) +
+         TableBytes(calib_dl_buffer_);
+}
+
+void AgoraBuffer::PlaceOnNumaNodes() {
+  size_t failed_binds = 0;
+  int bind_errno = 0;
+  const auto bind = [&](void* start, void* stop, size_t node) {
+    const size_t size = static_cast<char*>(stop) - static_cast<char*>(start);
+    if (Agora_memory::BindToNumaNode(start, size, numa_plan_.NodeId(node)) !=
+        0) {
+      failed_binds++;
+      bind_errno = errno;
+    }
+  };
+  const size_t bs_ant_num = config_->BsAntNum();
+  const size_t ue_ant_num = config_->UeAntNum();
+  // CSI and FFT output are subcarrier block major with the partial transpose
+  const bool sc_major_fft =
+      config_->PartialTranspose() && (config_->HalfPrecisionStorage() == false);
+  const size_t task_buffer_symbol_num_ul =
+      config_->Frame().NumULSyms() * config_->FrameWnd();
+  const size_t task_buffer_symbol_num_dl =
+      config_->Frame().NumDLSyms() * config_->FrameWnd();
+
+  for (size_t node = 0; node < numa_plan_.NumNodes(); node++) {
+    const size_t sc_start = numa_plan_.ScStart(node);
+    const size_t sc_stop = numa_plan_.ScStop(node);
+    if (sc_start < sc_stop) {
+      for (size_t frame = 0; frame < config_->FrameWnd(); frame++) {
+        // One beam matrix per subcarrier, contiguous within a frame
+        bind(ul_beam_matrix_[frame][sc_start],
+             ul_beam_matrix_[frame][sc_stop - 1] + (bs_ant_num * ue_ant_num),
+             node);
+        bind(dl_beam_matrix_[frame][sc_start],
+             dl_beam_matrix_[frame][sc_stop - 1] + (ue_ant_num * bs_ant_num),
+             node);
+        for (size_t ue = 0; sc_major_fft && (ue < ue_ant_num); ue++) {
+          bind(csi_buffer_[frame][ue] + (sc_start * bs_ant_num),
+               csi_buffer_[frame][ue] + (sc_stop * bs_ant_num), node);
+        }
+      }
+      for (size_t sym = 0; sym < task_buffer_symbol_num_ul; sym++) {
+        if (sc_major_fft) {
+          bind(fft_buffer_[sym] + (sc_start * bs_ant_num),
+               fft_buffer_[sym] + (sc_stop * bs_ant_num), node);
+        }
+        bind(equal_buffer_[sym] + (sc_start * ue_ant_num),
+             equal_buffer_[sym] + (sc_stop * ue_ant_num), node);
+      }
+    }
+
+    // IFFT input rows are antenna major within a symbol
+    const size_t ant_start = numa_plan_.AntStart(node);
+    const size_t ant_stop = numa_plan_.AntStop(node);
+    if (ant_start < ant_stop) {
+      for (size_t sym = 0; sym < task_buffer_symbol_num_dl; sym++) {
+        bind(dl_ifft_buffer_[(sym * bs_ant_num) + ant_start],
+             dl_ifft_buffer_[(sym * bs_ant_num) + ant_stop - 1] +
+                 config_->OfdmCaNum(),
+             node);
+      }
+    }
+  }
+
+  if (failed_binds > 0) {
+    AGORA_LOG_WARN("AgoraBuffer: %zu NUMA placements failed (%s)\n",
+                   failed_binds, std::strerror(bind_errno));
+  }
+  AGORA_LOG_INFO("AgoraBuffer: buffers placed on %zu NUMA nodes\n",
+                 numa_plan_.NumNodes());
+}
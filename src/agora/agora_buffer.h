@@ -8,12 +8,15 @@
 
 #include <array>
 #include <cstddef>
+#include <vector>
 
 #include "common_typedef_sdk.h"
 #include "concurrentqueue.h"
 #include "config.h"
+#include "frame_block_sizes.h"
 #include "memory_manage.h"
 #include "message.h"
+#include "numa_plan.h"
 #include "symbols.h"
 #include "utils.h"
 
@@ -25,22 +28,28 @@ class AgoraBuffer {
   AgoraBuffer& operator=(AgoraBuffer const&) = delete;
   ~AgoraBuffer();
 
-  inline PtrGrid<kFrameWnd, kMaxUEs, complex_float>& GetCsi() {
+  inline PtrGrid<complex_float>& GetCsi() {
     return csi_buffer_;
   }
-  inline PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& GetUlBeamMatrix() {
+  inline PtrGrid<complex_float>& GetUlBeamMatrix() {
     return ul_beam_matrix_;
   }
-  inline PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& GetDlBeamMatrix() {
+  inline PtrGrid<complex_float>& GetDlBeamMatrix() {
     return dl_beam_matrix_;
   }
-  inline PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& GetDemod() {
+  inline PtrCube<int8_t>& GetDemod() {
     return demod_buffer_;
   }
-  inline PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& GetDecod() {
+  inline PtrCube<int8_t>& GetDecod() {
     return decoded_buffer_;
   }
   inline Table<complex_float>& GetFft() { return fft_buffer_; }
+  inline Table<short>& GetFftFixed() { return fft_buffer_fixed_; }
+  inline Table<int8_t>& GetFftExp() { return fft_exp_buffer_; }
+  inline PtrGrid<short>& GetUlBeamMatrixFixed() {
+    return ul_beam_matrix_fixed_;
+  }
+  inline Table<int8_t>& GetUlBeamExp() { return ul_beam_exp_buffer_; }
   inline Table<complex_float>& GetEqual() { return equal_buffer_; }
   inline Table<complex_float>& GetUeSpecPilot() {
     return ue_spec_pilot_buffer_;
@@ -62,20 +71,38 @@ class AgoraBuffer {
   inline Table<complex_float>& GetCalibUl() { return calib_ul_buffer_; }
   inline Table<complex_float>& GetCalibDl() { return calib_dl_buffer_; }
   inline Table<complex_float>& GetCalib() { return calib_buffer_; }
+  inline const NumaPlan& GetNumaPlan() const { return numa_plan_; }
+  /// Frames whose uplink beamformers are all written
+  inline FrameCompletion& GetBeamCompletion() { return beam_completion_; }
+  /// Block sizes of each frame, stamped by the master as frames start
+  inline FrameBlockSizes& GetBlockSizes() { return block_sizes_; }
+  /// Total size of the buffers, which scales with the frame window
+  size_t MemoryBytes() const;
 
  private:
   void AllocateTables();
   void FreeTables();
+  /// Move the subcarrier and antenna ranges of the big buffers to the NUMA
+  /// nodes that numa_plan_ assigns them to
+  void PlaceOnNumaNodes();
 
   Config* const config_;
   const size_t ul_socket_buf_size_;
-
-  PtrGrid<kFrameWnd, kMaxUEs, complex_float> csi_buffer_;
-  PtrGrid<kFrameWnd, kMaxDataSCs, complex_float> ul_beam_matrix_;
-  PtrGrid<kFrameWnd, kMaxDataSCs, complex_float> dl_beam_matrix_;
-  PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t> demod_buffer_;
-  PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t> decoded_buffer_;
+  const NumaPlan numa_plan_;
+
+  PtrGrid<complex_float> csi_buffer_;
+  PtrGrid<complex_float> ul_beam_matrix_;
+  PtrGrid<complex_float> dl_beam_matrix_;
+  PtrCube<int8_t> demod_buffer_;
+  PtrCube<int8_t> decoded_buffer_;
+  FrameCompletion beam_completion_;
+  FrameBlockSizes block_sizes_;
   Table<complex_float> fft_buffer_;
+  // Block floating point copies used when UlFixedPoint() is enabled
+  Table<short> fft_buffer_fixed_;
+  Table<int8_t> fft_exp_buffer_;
+  PtrGrid<short> ul_beam_matrix_fixed_;
+  Table<int8_t> ul_beam_exp_buffer_;
   Table<complex_float> equal_buffer_;
   Table<complex_float> ue_spec_pilot_buffer_;
   Table<complex_float> dl_ifft_buffer_;
@@ -88,6 +115,7 @@ class AgoraBuffer {
 
   Table<char> ul_socket_buffer_;
   char* dl_socket_buffer_;
+  size_t dl_socket_buf_size_{0};
   Table<complex_float> calib_ul_buffer_;
   Table<complex_float> calib_dl_buffer_;
 };
@@ -101,16 +129,28 @@ struct SchedInfo {
 //Needs to manage its own memory
 class MessageInfo {
  public:
-  explicit MessageInfo(size_t queue_size) { Alloc(queue_size); }
+  /// Each of [num_nodes] NUMA nodes has its own set of task queues
+  explicit MessageInfo(size_t queue_size, size_t num_nodes = 1)
+      : sched_info_arr_(num_nodes) {
+    Alloc(queue_size);
+  }
   ~MessageInfo() { Free(); }
 
-  inline moodycamel::ProducerToken* GetPtok(EventType event_type, size_t qid) {
-    return sched_info_arr_.at(qid).at(static_cast<size_t>(event_type)).ptok_;
+  inline size_t NumNodes() const { return sched_info_arr_.size(); }
+
+  inline moodycamel::ProducerToken* GetPtok(EventType event_type, size_t qid,
+                                            size_t node = 0) {
+    return sched_info_arr_.at(node)
+        .at(qid)
+        .at(static_cast<size_t>(event_type))
+        .ptok_;
   }
 
   inline moodycamel::ConcurrentQueue<EventData>* GetConq(EventType event_type,
-                                                         size_t qid) {
-    return &sched_info_arr_.at(qid)
+                                                         size_t qid,
+                                                         size_t node = 0) {
+    return &sched_info_arr_.at(node)
+                .at(qid)
                 .at(static_cast<size_t>(event_type))
                 .concurrent_q_;
   }
@@ -129,11 +169,13 @@ class MessageInfo {
     for (auto& queue : complete_task_queue_) {
       queue = moodycamel::ConcurrentQueue<EventData>(queue_size);
     }
-    for (auto& queue : sched_info_arr_) {
-      for (auto& event : queue) {
-        event.concurrent_q_ =
-            moodycamel::ConcurrentQueue<EventData>(queue_size);
-        event.ptok_ = new moodycamel::ProducerToken(event.concurrent_q_);
+    for (auto& node : sched_info_arr_) {
+      for (auto& queue : node) {
+        for (auto& event : queue) {
+          event.concurrent_q_ =
+              moodycamel::ConcurrentQueue<EventData>(queue_size);
+          event.ptok_ = new moodycamel::ProducerToken(event.concurrent_q_);
+        }
       }
     }
 
@@ -148,10 +190,12 @@ class MessageInfo {
   }
 
   inline void Free() {
-    for (auto& queue : sched_info_arr_) {
-      for (auto& event : queue) {
-        delete event.ptok_;
-        event.ptok_ = nullptr;
+    for (auto& node : sched_info_arr_) {
+      for (auto& queue : node) {
+        for (auto& event : queue) {
+          delete event.ptok_;
+          event.ptok_ = nullptr;
+        }
       }
     }
     for (auto& queue : worker_ptoks_ptr_) {
@@ -167,7 +211,8 @@ class MessageInfo {
   std::array<std::array<moodycamel::ProducerToken*, kMaxThreads>,
              kScheduleQueues>
       worker_ptoks_ptr_;
-  std::array<std::array<SchedInfo, kNumEventTypes>, kScheduleQueues>
+  std::vector<
+      std::array<std::array<SchedInfo, kNumEventTypes>, kScheduleQueues>>
       sched_info_arr_;
 };
 
@@ -5,6 +5,9 @@
 
 #include "agora_worker.h"
 
+#include <algorithm>
+#include <cmath>
+
 #include "concurrent_queue_wrapper.h"
 #include "csv_logger.h"
 #include "dobeamweights.h"
@@ -14,8 +17,19 @@
 #include "dofft.h"
 #include "doifft.h"
 #include "doprecode.h"
+#include "doprecodeifft.h"
+#include "dorecipcal.h"
+#include "gettime.h"
 #include "logger.h"
 
+// Frames per scaling decision of the elastic worker pool
+static constexpr size_t kScaleFrames = 8;
+// Active workers grow above this utilization and shrink below the low one
+static constexpr double kHighUtilization = 0.75;
+static constexpr double kLowUtilization = 0.35;
+// Utilization the active workers are sized for when they grow
+static constexpr double kTargetUtilization = 0.6;
+
 AgoraWorker::AgoraWorker(Config* cfg, Stats* stats, PhyStats* phy_stats,
                          MessageInfo* message, AgoraBuffer* buffer,
                          FrameInfo* frame)
@@ -25,11 +39,16 @@ AgoraWorker::AgoraWorker(Config* cfg, Stats* stats, PhyStats* phy_stats,
       phy_stats_(phy_stats),
       message_(message),
       buffer_(buffer),
-      frame_(frame) {
+      frame_(frame),
+      gate_(cfg->WorkerThreadNum(),
+            WorkerGate::ParseIdleWait(cfg->WorkerIdleWait()),
+            GetTime::UsToCycles(cfg->WorkerSpinUs(), cfg->FreqGhz())) {
+  window_start_tsc_ = GetTime::Rdtsc();
   CreateThreads();
 }
 
 AgoraWorker::~AgoraWorker() {
+  gate_.Release();
   for (auto& worker_thread : workers_) {
     AGORA_LOG_SYMBOL("Agora: Joining worker thread\n");
     if (worker_thread.joinable()) {
@@ -51,28 +70,40 @@ void AgoraWorker::WorkerThread(int tid) {
 
   /* Initialize operators */
   auto compute_beam = std::make_unique<DoBeamWeights>(
-      config_, tid, buffer_->GetCsi(), buffer_->GetCalibDl(),
-      buffer_->GetCalibUl(), buffer_->GetCalibDlMsum(),
-      buffer_->GetCalibUlMsum(), buffer_->GetCalib(),
-      buffer_->GetUlBeamMatrix(), buffer_->GetDlBeamMatrix(), phy_stats_,
+      config_, tid, buffer_->GetCsi(), buffer_->GetCalib(),
+      buffer_->GetUlBeamMatrix(), buffer_->GetDlBeamMatrix(),
+      buffer_->GetUlBeamMatrixFixed(), buffer_->GetUlBeamExp(),
+      buffer_->GetBeamCompletion(), buffer_->GetBlockSizes(), phy_stats_,
       stats_);
 
+  auto compute_recip_cal = std::make_unique<DoRecipCal>(
+      config_, tid, buffer_->GetCalibDl(), buffer_->GetCalibUl(),
+      buffer_->GetCalibDlMsum(), buffer_->GetCalibUlMsum(),
+      buffer_->GetCalib(), phy_stats_, stats_);
+
   auto compute_fft = std::make_unique<DoFFT>(
-      config_, tid, buffer_->GetFft(), buffer_->GetCsi(), buffer_->GetCalibDl(),
+      config_, tid, buffer_->GetFft(), buffer_->GetFftFixed(),
+      buffer_->GetFftExp(), buffer_->GetCsi(), buffer_->GetCalibDl(),
       buffer_->GetCalibUl(), phy_stats_, stats_);
 
   // Downlink workers
-  auto compute_ifft = std::make_unique<DoIFFT>(config_, tid, buffer_->GetIfft(),
-                                               buffer_->GetDlSocket(), stats_);
+  auto compute_ifft =
+      std::make_unique<DoIFFT>(config_, tid, buffer_->GetIfft(),
+                               buffer_->GetDlSocket(), phy_stats_, stats_);
 
   auto compute_precode = std::make_unique<DoPrecode>(
       config_, tid, buffer_->GetDlBeamMatrix(), buffer_->GetIfft(),
-      buffer_->GetDlModBits(), stats_);
+      buffer_->GetDlModBits(), buffer_->GetBlockSizes(), stats_);
+
+  auto compute_precode_ifft = std::make_unique<DoPrecodeIFFT>(
+      config_, tid, buffer_->GetDlBeamMatrix(), buffer_->GetDlModBits(),
+      buffer_->GetDlSocket(), buffer_->GetBlockSizes(), phy_stats_, stats_);
 
   auto compute_encoding = std::make_unique<DoEncode>(
       config_, tid, Direction::kDownlink,
       (kEnableMac == true) ? buffer_->GetDlBits() : config_->DlBits(),
-      (kEnableMac == true) ? kFrameWnd : 1, buffer_->GetDlModBits(), stats_);
+      (kEnableMac == true) ? config_->FrameWnd() : 1, buffer_->GetDlModBits(),
+      stats_);
 
   // Uplink workers
   auto compute_decoding =
@@ -81,8 +112,10 @@ void AgoraWorker::WorkerThread(int tid) {
 
   auto compute_demul = std::make_unique<DoDemul>(
       config_, tid, buffer_->GetFft(), buffer_->GetUlBeamMatrix(),
+      buffer_->GetFftFixed(), buffer_->GetFftExp(),
+      buffer_->GetUlBeamMatrixFixed(), buffer_->GetUlBeamExp(),
       buffer_->GetUeSpecPilot(), buffer_->GetEqual(), buffer_->GetDemod(),
-      phy_stats_, stats_);
+      buffer_->GetBlockSizes(), phy_stats_, stats_);
 
   std::vector<Doer*> computers_vec;
   std::vector<EventType> events_vec;
@@ -92,6 +125,11 @@ void AgoraWorker::WorkerThread(int tid) {
   events_vec.push_back(EventType::kBeam);
   events_vec.push_back(EventType::kFFT);
 
+  if (config_->Frame().IsRecCalEnabled()) {
+    computers_vec.push_back(compute_recip_cal.get());
+    events_vec.push_back(EventType::kRC);
+  }
+
   if (config_->Frame().NumULSyms() > 0) {
     computers_vec.push_back(compute_decoding.get());
     computers_vec.push_back(compute_demul.get());
@@ -100,30 +138,59 @@ void AgoraWorker::WorkerThread(int tid) {
   }
 
   if (config_->Frame().NumDLSyms() > 0) {
-    computers_vec.push_back(compute_ifft.get());
-    computers_vec.push_back(compute_precode.get());
+    if (config_->FusedPrecodeIfft()) {
+      // Precoding runs inside the kIFFT tasks
+      computers_vec.push_back(compute_precode_ifft.get());
+      events_vec.push_back(EventType::kIFFT);
+    } else {
+      computers_vec.push_back(compute_ifft.get());
+      computers_vec.push_back(compute_precode.get());
+      events_vec.push_back(EventType::kIFFT);
+      events_vec.push_back(EventType::kPrecode);
+    }
     computers_vec.push_back(compute_encoding.get());
-    events_vec.push_back(EventType::kIFFT);
-    events_vec.push_back(EventType::kPrecode);
     events_vec.push_back(EventType::kEncode);
   }
 
+  const NumaPlan& numa_plan = buffer_->GetNumaPlan();
+  const size_t node = numa_plan.WorkerNode(tid);
+  NumaTaskStat* numa_stat = stats_->GetNumaTaskStat(tid);
+  numa_stat->node_ = numa_plan.NodeId(node);
+
   size_t cur_qid = 0;
   size_t empty_queue_itrs = 0;
   bool empty_queue = true;
+  WorkerGate::IdleState idle_state;
   while (config_->Running() == true) {
-    for (size_t i = 0; i < computers_vec.size(); i++) {
-      if (computers_vec.at(i)->TryLaunch(
-              *message_->GetConq(events_vec.at(i), cur_qid),
-              message_->GetCompQueue(cur_qid),
-              message_->GetWorkerPtok(cur_qid, tid))) {
-        empty_queue = false;
-        break;
+    if (static_cast<size_t>(tid) >= gate_.Active()) {
+      gate_.Busy(idle_state);
+      gate_.WaitActive(tid);
+      continue;
+    }
+    // Tasks of this worker's NUMA node first, then help the other nodes
+    for (size_t n = 0; (n < message_->NumNodes()) && empty_queue; n++) {
+      const size_t queue_node = (node + n) % message_->NumNodes();
+      for (size_t i = 0; i < computers_vec.size(); i++) {
+        if (computers_vec.at(i)->TryLaunch(
+                *message_->GetConq(events_vec.at(i), cur_qid, queue_node),
+                message_->GetCompQueue(cur_qid),
+                message_->GetWorkerPtok(cur_qid, tid))) {
+          empty_queue = false;
+          // The master reads the busy cycles while this worker runs
+          stats_->PublishTaskStats(tid);
+          if (queue_node == node) {
+            numa_stat->local_tasks_++;
+          } else {
+            numa_stat->remote_tasks_++;
+          }
+          break;
+        }
       }
     }
     // If all queues in this set are empty for 5 iterations,
     // check the other set of queues
     if (empty_queue == true) {
+      gate_.Idle(idle_state);
       empty_queue_itrs++;
       if (empty_queue_itrs == 5) {
         if (frame_->cur_sche_frame_id_ != frame_->cur_proc_frame_id_) {
@@ -134,8 +201,69 @@ void AgoraWorker::WorkerThread(int tid) {
         empty_queue_itrs = 0;
       }
     } else {
+      gate_.Busy(idle_state);
       empty_queue = true;
     }
   }
   AGORA_LOG_SYMBOL("Agora worker %d exit\n", tid);
 }
+
+size_t AgoraWorker::BusyCycles() const {
+  size_t cycles = 0;
+  for (size_t tid = 0; tid < config_->WorkerThreadNum(); tid++) {
+    for (const DoerType doer_type : kAllDoerTypes) {
+      size_t task_count;
+      size_t task_cycles;
+      stats_->PublishedTaskStats(doer_type, tid, task_count, task_cycles);
+      cycles += task_cycles;
+    }
+  }
+  return cycles;
+}
+
+void AgoraWorker::FrameDone(double latency_us) {
+  if (config_->WorkerElastic() == false) {
+    return;
+  }
+  window_max_latency_us_ = std::max(window_max_latency_us_, latency_us);
+  window_frames_++;
+  if (window_frames_ < kScaleFrames) {
+    return;
+  }
+
+  const size_t now_tsc = GetTime::Rdtsc();
+  const size_t busy_cycles = BusyCycles();
+  const size_t active = gate_.Active();
+  const double utilization =
+      static_cast<double>(busy_cycles - window_busy_cycles_) /
+      static_cast<double>((now_tsc - window_start_tsc_) * active);
+  const double budget_us = config_->WorkerLatencyBudgetUs();
+  const bool over_budget =
+      (budget_us > 0) && (window_max_latency_us_ > budget_us);
+
+  size_t target = active;
+  if (over_budget) {
+    // Bursts get all the help at once, the utilization catches up later
+    target = config_->WorkerThreadNum();
+  } else if (utilization > kHighUtilization) {
+    target = static_cast<size_t>(
+        std::ceil(active * utilization / kTargetUtilization));
+  } else if ((utilization < kLowUtilization) &&
+             ((budget_us <= 0) || (window_max_latency_us_ < 0.8 * budget_us))) {
+    target = active - 1;
+  }
+  target = std::clamp(target, config_->WorkerMinActive(),
+                      config_->WorkerThreadNum());
+  if (target != active) {
+    AGORA_LOG_INFO(
+        "AgoraWorker: %zu -> %zu active workers (utilization %.2f, max frame "
+        "latency %.1f us)\n",
+        active, target, utilization, window_max_latency_us_);
+    gate_.SetActive(target);
+  }
+
+  window_frames_ = 0;
+  window_max_latency_us_ = 0;
+  window_start_tsc_ = now_tsc;
+  window_busy_cycles_ = busy_cycles;
+}
@@ -16,6 +16,7 @@
 #include "mat_logger.h"
 #include "phy_stats.h"
 #include "stats.h"
+#include "worker_gate.h"
 
 class AgoraWorker {
  public:
@@ -24,9 +25,21 @@ class AgoraWorker {
                        FrameInfo* frame);
   ~AgoraWorker();
 
+  /// Wake idle workers. Called by the master after scheduling tasks.
+  inline void Notify() { gate_.Notify(); }
+
+  /// Account a completed frame of [latency_us]. With worker_elastic, every
+  /// kScaleFrames frames the number of active workers follows the worker
+  /// utilization from Stats and the latency budget.
+  void FrameDone(double latency_us);
+
+  inline size_t ActiveWorkers() const { return gate_.Active(); }
+
  private:
   void WorkerThread(int tid);
   void CreateThreads();
+  /// Sum of the busy cycles of all Doers of all workers
+  size_t BusyCycles() const;
 
   const size_t base_worker_core_offset_;
 
@@ -38,6 +51,13 @@ class AgoraWorker {
   MessageInfo* message_;
   AgoraBuffer* buffer_;
   FrameInfo* frame_;
+
+  WorkerGate gate_;
+  // State of the current scaling window, owned by the master thread
+  size_t window_frames_{0};
+  double window_max_latency_us_{0};
+  size_t window_start_tsc_{0};
+  size_t window_busy_cycles_{0};
 };
 
 #endif  // AGORA_WORKER_H_
\ No newline at end of file
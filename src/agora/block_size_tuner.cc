@@ -0,0 +1,202 @@
+/**
+ * @file block_size_tuner.cc
+ * @brief Implementation file for the BlockSizeTuner class
+ */
+#include "block_size_tuner.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "gettime.h"
+#include "logger.h"
+
+// Doer whose task timings are logged for each knob
+static constexpr std::array<DoerType, BlockSizeTuner::kNumKnobs> kKnobDoers = {
+    DoerType::kDemul, DoerType::kBeam, DoerType::kFFT, DoerType::kEncode};
+
+BlockSizeTuner::BlockSizeTuner(const Config* cfg, Stats* stats,
+                               size_t frames_per_trial)
+    : cfg_(cfg),
+      stats_(stats),
+      frames_per_trial_(frames_per_trial),
+      best_(BlockSizes::Configured(cfg)),
+      best_latency_us_(std::numeric_limits<double>::max()),
+      pending_(best_) {
+  for (size_t size = cfg->DemulBlockSize();
+       (size >= kSCsPerCacheline) && (size % kSCsPerCacheline == 0) &&
+       (size % cfg->TransposeBlockSize() == 0);
+       size /= 2) {
+    candidates_.at(static_cast<size_t>(Knob::kDemul)).push_back(size);
+  }
+  for (size_t size = cfg->BeamBlockSize();
+       (size >= 1) && (!cfg->FreqOrthogonalPilot() ||
+                       (size % cfg->PilotScGroupSize() == 0));
+       size /= 2) {
+    candidates_.at(static_cast<size_t>(Knob::kBeam)).push_back(size);
+  }
+  for (size_t size = cfg->FftBlockSize();
+       (size >= cfg->NumChannels()) && (cfg->BsAntNum() % size == 0);
+       size /= 2) {
+    candidates_.at(static_cast<size_t>(Knob::kFft)).push_back(size);
+  }
+  for (size_t size = cfg->EncodeBlockSize(); size >= 1; size /= 2) {
+    candidates_.at(static_cast<size_t>(Knob::kEncode)).push_back(size);
+  }
+
+  // The first trial measures the configured sizes
+  knob_ = Knob::kDemul;
+  StartTrial();
+}
+
+const char* BlockSizeTuner::KnobName(Knob knob) {
+  switch (knob) {
+    case Knob::kDemul:
+      return "demul";
+    case Knob::kBeam:
+      return "beam";
+    case Knob::kFft:
+      return "fft";
+    case Knob::kEncode:
+      return "encode";
+  }
+  return "unknown";
+}
+
+bool BlockSizeTuner::FrameDone(size_t frame_id, double latency_us) {
+  if (done_ || apply_pending_) {
+    return apply_pending_;
+  }
+  if (frame_id < first_frame_ + kSettleFrames) {
+    // Measure from here, after the frames still running with the previous
+    // sizes and the settle frames
+    if (frame_id + 1 == first_frame_ + kSettleFrames) {
+      StartTrial();
+    }
+    return false;
+  }
+  latency_sum_us_ += latency_us;
+  frames_++;
+  if (frames_ == frames_per_trial_) {
+    EndTrial();
+  }
+  return apply_pending_;
+}
+
+void BlockSizeTuner::Applied(size_t frame_id) {
+  apply_pending_ = false;
+  first_frame_ = frame_id;
+}
+
+void BlockSizeTuner::DoerTotals(DoerType doer_type, size_t& count,
+                                size_t& cycles) const {
+  count = 0;
+  cycles = 0;
+  for (size_t tid = 0; tid < cfg_->WorkerThreadNum(); tid++) {
+    size_t task_count;
+    size_t task_cycles;
+    stats_->PublishedTaskStats(doer_type, tid, task_count, task_cycles);
+    count += task_count;
+    cycles += task_cycles;
+  }
+}
+
+void BlockSizeTuner::StartTrial() {
+  frames_ = 0;
+  latency_sum_us_ = 0;
+  DoerTotals(kKnobDoers.at(static_cast<size_t>(knob_)), start_task_count_,
+             start_task_cycles_);
+  start_busy_cycles_ = 0;
+  for (const DoerType doer_type : kAllDoerTypes) {
+    size_t count;
+    size_t cycles;
+    DoerTotals(doer_type, count, cycles);
+    start_busy_cycles_ += cycles;
+  }
+}
+
+void BlockSizeTuner::EndTrial() {
+  size_t task_count;
+  size_t task_cycles;
+  DoerTotals(kKnobDoers.at(static_cast<size_t>(knob_)), task_count,
+             task_cycles);
+  size_t busy_cycles = 0;
+  for (const DoerType doer_type : kAllDoerTypes) {
+    size_t count;
+    size_t cycles;
+    DoerTotals(doer_type, count, cycles);
+    busy_cycles += cycles;
+  }
+  task_count -= start_task_count_;
+  task_cycles -= start_task_cycles_;
+  busy_cycles -= start_busy_cycles_;
+
+  Trial trial;
+  trial.knob_ = knob_;
+  trial.block_size_ = KnobSize(pending_, knob_);
+  trial.latency_us_ = latency_sum_us_ / frames_;
+  trial.task_us_ =
+      (task_count == 0)
+          ? 0
+          : GetTime::CyclesToUs(task_cycles / task_count, cfg_->FreqGhz());
+  // Worker time per frame, spread over the workers, is the part of the
+  // latency spent computing. The rest is spent waiting in queues.
+  const double busy_us = GetTime::CyclesToUs(busy_cycles, cfg_->FreqGhz()) /
+                         (frames_ * cfg_->WorkerThreadNum());
+  trial.wait_us_ = std::max(trial.latency_us_ - busy_us, 0.0);
+  trace_.push_back(trial);
+  AGORA_LOG_INFO(
+      "BlockSizeTuner: %s block size %zu: frame latency %.1f us, task %.2f "
+      "us, wait %.1f us\n",
+      KnobName(knob_), trial.block_size_, trial.latency_us_, trial.task_us_,
+      trial.wait_us_);
+
+  if (trial.latency_us_ < best_latency_us_) {
+    best_latency_us_ = trial.latency_us_;
+    best_ = pending_;
+  }
+
+  // The first candidate of the next knob is its configured size, which the
+  // best sizes already run with
+  candidate_idx_++;
+  while (candidate_idx_ >= Candidates(knob_).size()) {
+    if (knob_ == Knob::kEncode) {
+      done_ = true;
+      break;
+    }
+    knob_ = static_cast<Knob>(static_cast<size_t>(knob_) + 1);
+    candidate_idx_ = 1;
+  }
+
+  const BlockSizes running = pending_;
+  pending_ = best_;
+  if (done_) {
+    AGORA_LOG_INFO(
+        "BlockSizeTuner: settled on demul %zu, beam %zu, fft %zu, encode %zu "
+        "(frame latency %.1f us) after %zu trials\n",
+        best_.demul_, best_.beam_, best_.fft_, best_.encode_,
+        best_latency_us_, trace_.size());
+  } else {
+    KnobSize(pending_, knob_) = Candidates(knob_).at(candidate_idx_);
+  }
+  apply_pending_ = (pending_.demul_ != running.demul_) ||
+                   (pending_.beam_ != running.beam_) ||
+                   (pending_.fft_ != running.fft_) ||
+                   (pending_.encode_ != running.encode_);
+  if ((apply_pending_ == false) && (done_ == false)) {
+    StartTrial();
+  }
+}
+
+size_t& BlockSizeTuner::KnobSize(BlockSizes& sizes, Knob knob) const {
+  switch (knob) {
+    case Knob::kDemul:
+      return sizes.demul_;
+    case Knob::kBeam:
+      return sizes.beam_;
+    case Knob::kFft:
+      return sizes.fft_;
+    case Knob::kEncode:
+      break;
+  }
+  return sizes.encode_;
+}
@@ -0,0 +1,99 @@
+/**
+ * @file block_size_tuner.h
+ * @brief Declaration file for the BlockSizeTuner class, which searches the
+ * Doer block sizes online from the frame latencies and Stats task timings
+ */
+#ifndef BLOCK_SIZE_TUNER_H_
+#define BLOCK_SIZE_TUNER_H_
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "config.h"
+#include "frame_block_sizes.h"
+#include "stats.h"
+#include "symbols.h"
+
+class BlockSizeTuner {
+ public:
+  // The block sizes searched, one after the other
+  enum class Knob : size_t { kDemul, kBeam, kFft, kEncode };
+  static constexpr size_t kNumKnobs = 4;
+  // Frames discarded after every change, while queues refill
+  static constexpr size_t kSettleFrames = 2;
+
+  /// Measurements of one block size
+  struct Trial {
+    Knob knob_;
+    size_t block_size_;
+    double latency_us_;  // Mean frame latency
+    double task_us_;     // Mean duration of one task of the knob's Doer
+    double wait_us_;     // Mean frame latency not spent in worker tasks
+  };
+
+  /// Candidates of every knob are the configured size and its halves that
+  /// the Config accepts. The Doers size their buffers from the configured
+  /// sizes, so the tuner never goes above them.
+  BlockSizeTuner(const Config* cfg, Stats* stats, size_t frames_per_trial);
+
+  /// Account frame [frame_id], completed [latency_us] after its first
+  /// packet. Returns true while Pending() waits to be applied.
+  bool FrameDone(size_t frame_id, double latency_us);
+
+  /// The block sizes the next trial, or the final result, runs with
+  inline const BlockSizes& Pending() const { return this->pending_; }
+
+  /// Agora runs the frames from [frame_id] on with Pending(). Earlier
+  /// frames may still be in flight with the previous sizes.
+  void Applied(size_t frame_id);
+
+  /// The search is over and the best block sizes have been applied
+  inline bool Done() const { return this->done_ && !this->apply_pending_; }
+
+  /// Every trial so far, in the order they ran
+  inline const std::vector<Trial>& Trace() const { return this->trace_; }
+
+  /// Block sizes tried for [knob], the configured size first
+  inline const std::vector<size_t>& Candidates(Knob knob) const {
+    return this->candidates_.at(static_cast<size_t>(knob));
+  }
+
+  static const char* KnobName(Knob knob);
+
+ private:
+  /// Sum of the task count and duration of [doer_type], over all workers
+  void DoerTotals(DoerType doer_type, size_t& count, size_t& cycles) const;
+  void StartTrial();
+  void EndTrial();
+  size_t& KnobSize(BlockSizes& sizes, Knob knob) const;
+
+  const Config* const cfg_;
+  Stats* const stats_;
+  const size_t frames_per_trial_;
+
+  std::array<std::vector<size_t>, kNumKnobs> candidates_;
+  Knob knob_{Knob::kDemul};
+  size_t candidate_idx_{0};
+  // Best block sizes found so far, and their latency for the current knob
+  BlockSizes best_;
+  double best_latency_us_;
+  BlockSizes pending_;
+  bool apply_pending_{false};
+  bool done_{false};
+
+  // First frame that runs with the sizes of the current trial. The trial
+  // measures from kSettleFrames later.
+  size_t first_frame_{0};
+  size_t frames_{0};
+  double latency_sum_us_{0};
+  // Task count and cycles of the knob's Doer, and cycles of all Doers, when
+  // the current trial started
+  size_t start_task_count_{0};
+  size_t start_task_cycles_{0};
+  size_t start_busy_cycles_{0};
+
+  std::vector<Trial> trace_;
+};
+
+#endif  // BLOCK_SIZE_TUNER_H_
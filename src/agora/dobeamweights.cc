@@ -5,50 +5,136 @@
  */
 #include "dobeamweights.h"
 
+#include <algorithm>
+
+#include "approx_zf.h"
 #include "comms-lib.h"
 #include "concurrent_queue_wrapper.h"
+#include "datatype_conversion.h"
 #include "doer.h"
+#include "fixed_point.h"
 #include "logger.h"
 
-static constexpr bool kUseSIMDGather = true;
 // Calculate the zeroforcing receiver using the formula W_zf = inv(H' * H) * H'.
-// This is faster but less accurate than using an SVD-based pseudoinverse.
+// This is faster but less accurate than using an SVD-based pseudoinverse,
+// which also allocates inside LAPACK on every subcarrier.
 static constexpr bool kUseInverseForZF = true;
+// Ridge added to a singular Gram matrix in place of pinv(). Singular values
+// well below its square root are suppressed, like pinv() with tolerance 1e-2.
+static constexpr float kSingularZfRidge = 1e-4f;
 static constexpr bool kUseUlZfForDownlink = true;
 
+/// [out] = inv(H' * H + noise * I) * H' for the channel [csi], with the Gram
+/// matrix and its inverse in [arena]. Throws std::runtime_error if the Gram
+/// matrix is not positive definite.
+static void RegularizedZf(MemoryArena& arena, const arma::cx_fmat& csi,
+                          float noise, arma::cx_fmat& out) {
+  const size_t num_ue = csi.n_cols;
+  arma::cx_fmat mat_gram(arena.Alloc<arma::cx_float>(num_ue * num_ue),
+                         num_ue, num_ue, false, false);
+  arma::cx_fmat mat_gram_inv(arena.Alloc<arma::cx_float>(num_ue * num_ue),
+                             num_ue, num_ue, false, false);
+  mat_gram = csi.t() * csi;
+  if (noise != 0) {
+    mat_gram.diag() += noise;
+  }
+  if (arma::inv_sympd(mat_gram_inv, mat_gram) == false) {
+    throw std::runtime_error("inv_sympd(): matrix is singular");
+  }
+  out = mat_gram_inv * csi.t();
+}
+
+/// Zero-forcing beamformer of [csi] in [out]. A singular Gram matrix is
+/// regularized with kSingularZfRidge, all-zero if that fails too.
+static void SafeZf(MemoryArena& arena, const arma::cx_fmat& csi,
+                   arma::cx_fmat& out) {
+  try {
+    RegularizedZf(arena, csi, 0, out);
+    return;
+  } catch (std::runtime_error&) {
+    AGORA_LOG_WARN("Failed to invert channel matrix, regularizing it\n");
+  }
+  try {
+    RegularizedZf(arena, csi, kSingularZfRidge, out);
+  } catch (std::runtime_error&) {
+    out.zeros();
+  }
+}
+
+/// [out] = NeumannInverse(H' * H) * H' for the channel [csi]
+static void NeumannZf(MemoryArena& arena, const arma::cx_fmat& csi,
+                      size_t num_iterations, arma::cx_fmat& out) {
+  const size_t num_ue = csi.n_cols;
+  arma::cx_fmat mat_gram(arena.Alloc<arma::cx_float>(num_ue * num_ue),
+                         num_ue, num_ue, false, false);
+  arma::cx_fmat mat_gram_inv(arena.Alloc<arma::cx_float>(num_ue * num_ue),
+                             num_ue, num_ue, false, false);
+  mat_gram = csi.t() * csi;
+  ApproxZf::NeumannInverse(arena, mat_gram, num_iterations, mat_gram_inv);
+  out = mat_gram_inv * csi.t();
+}
+
+/// Conjugate gradient solution of (H' * H) * out = H' for the channel
+/// [csi], starting from [out] if [warm_start] and from the Jacobi guess
+/// otherwise
+static void CgZf(MemoryArena& arena, const arma::cx_fmat& csi,
+                 size_t num_iterations, bool warm_start, arma::cx_fmat& out) {
+  const size_t num_ue = csi.n_cols;
+  const size_t num_ant = csi.n_rows;
+  arma::cx_fmat mat_gram(arena.Alloc<arma::cx_float>(num_ue * num_ue),
+                         num_ue, num_ue, false, false);
+  arma::cx_fmat mat_csi_h(arena.Alloc<arma::cx_float>(num_ue * num_ant),
+                          num_ue, num_ant, false, false);
+  mat_gram = csi.t() * csi;
+  mat_csi_h = csi.t();
+  if (warm_start == false) {
+    ApproxZf::JacobiGuess(mat_gram, mat_csi_h, out);
+  }
+  ApproxZf::ConjugateGradient(arena, mat_gram, mat_csi_h, out,
+                              num_iterations);
+}
+
 DoBeamWeights::DoBeamWeights(
     Config* config, int tid,
-    PtrGrid<kFrameWnd, kMaxUEs, complex_float>& csi_buffers,
-    Table<complex_float>& calib_dl_buffer,
-    Table<complex_float>& calib_ul_buffer,
-    Table<complex_float>& calib_dl_msum_buffer,
-    Table<complex_float>& calib_ul_msum_buffer,
+    PtrGrid<complex_float>& csi_buffers,
     Table<complex_float>& calib_buffer,
-    PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& ul_beam_matrices,
-    PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& dl_beam_matrices,
-    PhyStats* in_phy_stats, Stats* stats_manager)
+    PtrGrid<complex_float>& ul_beam_matrices,
+    PtrGrid<complex_float>& dl_beam_matrices,
+    PtrGrid<short>& ul_beam_matrices_fixed,
+    Table<int8_t>& ul_beam_exp_buffer,
+    const FrameCompletion& beam_completion,
+    const FrameBlockSizes& block_sizes, PhyStats* in_phy_stats,
+    Stats* stats_manager)
     : Doer(config, tid),
       csi_buffers_(csi_buffers),
-      calib_dl_buffer_(calib_dl_buffer),
-      calib_ul_buffer_(calib_ul_buffer),
-      calib_dl_msum_buffer_(calib_dl_msum_buffer),
-      calib_ul_msum_buffer_(calib_ul_msum_buffer),
       calib_buffer_(calib_buffer),
       ul_beam_matrices_(ul_beam_matrices),
       dl_beam_matrices_(dl_beam_matrices),
+      ul_beam_matrices_fixed_(ul_beam_matrices_fixed),
+      ul_beam_exp_buffer_(ul_beam_exp_buffer),
+      beam_completion_(beam_completion),
+      block_sizes_(block_sizes),
       phy_stats_(in_phy_stats) {
   duration_stat_ = stats_manager->GetDurationStat(DoerType::kBeam, tid);
+  scratch_stat_ = stats_manager->GetScratchAllocStat(tid);
+  partial_transpose_ = cfg_->PartialTranspose();
+  transpose_block_size_ = cfg_->TransposeBlockSize();
+  gather_sc_ = Agora_transpose::SelectGatherSc(transpose_block_size_);
   pred_csi_buffer_ =
       static_cast<complex_float*>(Agora_memory::PaddedAlignedAlloc(
           Agora_memory::Alignment_t::kAlign64,
-          kMaxAntennas * kMaxUEs * sizeof(complex_float)));
+          cfg_->BsAntNum() * cfg_->UeAntNum() * sizeof(complex_float)));
   csi_gather_buffer_ =
       static_cast<complex_float*>(Agora_memory::PaddedAlignedAlloc(
           Agora_memory::Alignment_t::kAlign64,
-          kMaxAntennas * kMaxUEs * sizeof(complex_float)));
-  calib_gather_buffer_ = static_cast<complex_float*>(
-      Agora_memory::PaddedAlignedAlloc(Agora_memory::Alignment_t::kAlign64,
-                                       kMaxAntennas * sizeof(complex_float)));
+          cfg_->BsAntNum() * cfg_->UeAntNum() * sizeof(complex_float)));
+  calib_gather_buffer_ =
+      static_cast<complex_float*>(Agora_memory::PaddedAlignedAlloc(
+          Agora_memory::Alignment_t::kAlign64,
+          cfg_->BsAntNum() * sizeof(complex_float)));
+  beam_quant_buffer_ = static_cast<float*>(Agora_memory::PaddedAlignedAlloc(
+      Agora_memory::Alignment_t::kAlign64,
+      cfg_->BsAntNum() * sizeof(complex_float)));
 
   calib_sc_vec_ptr_ = std::make_unique<arma::cx_fvec>(
       reinterpret_cast<arma::cx_float*>(calib_gather_buffer_), cfg_->BfAntNum(),
@@ -83,6 +169,7 @@ DoBeamWeights::~DoBeamWeights() {
   std::free(csi_gather_buffer_);
   calib_sc_vec_ptr_.reset();
   std::free(calib_gather_buffer_);
+  std::free(beam_quant_buffer_);
 }
 
 EventData DoBeamWeights::Launch(size_t tag) {
@@ -101,76 +188,106 @@ void DoBeamWeights::ComputePrecoder(size_t frame_id, size_t cur_sc_id,
   }
   arma::cx_fmat mat_ul_beam(reinterpret_cast<arma::cx_float*>(ul_beam_mem),
                             cfg_->UeAntNum(), cfg_->BsAntNum(), false);
-  arma::cx_fmat mat_ul_beam_tmp;
+  // Scratch matrices live in the worker's arena. Results of the same size
+  // are written in place, without a heap allocation per subcarrier.
+  MemoryArena& arena = Arena();
+  const size_t num_ue = mat_csi.n_cols;
+  const size_t num_ant = mat_csi.n_rows;
+  arma::cx_fmat mat_ul_beam_tmp(arena.Alloc<arma::cx_float>(num_ue * num_ant),
+                                num_ue, num_ant, false, false);
   switch (cfg_->BeamformingAlgo()) {
     case CommsLib::BeamformingAlgorithm::kZF:
       if (kUseInverseForZF) {
-        try {
-          mat_ul_beam_tmp =
-              arma::inv_sympd(mat_csi.t() * mat_csi) * mat_csi.t();
-        } catch (std::runtime_error&) {
-          AGORA_LOG_WARN(
-              "Failed to invert channel matrix, falling back to pinv()\n");
-          arma::pinv(mat_ul_beam_tmp, mat_csi, 1e-2, "dc");
-        }
+        SafeZf(arena, mat_csi, mat_ul_beam_tmp);
       } else {
         arma::pinv(mat_ul_beam_tmp, mat_csi, 1e-2, "dc");
       }
       break;
     case CommsLib::BeamformingAlgorithm::kMMSE:
-      mat_ul_beam_tmp =
-          arma::inv_sympd(mat_csi.t() * mat_csi +
-                          noise * arma::eye<arma::cx_fmat>(cfg_->UeAntNum(),
-                                                           cfg_->UeAntNum())) *
-          mat_csi.t();
+      RegularizedZf(arena, mat_csi, noise, mat_ul_beam_tmp);
       break;
     case CommsLib::BeamformingAlgorithm::kMRC:
       mat_ul_beam_tmp = mat_csi.t();
       break;
+    case CommsLib::BeamformingAlgorithm::kNeumann:
+      NeumannZf(arena, mat_csi, cfg_->ApproxZfIterations(), mat_ul_beam_tmp);
+      break;
+    case CommsLib::BeamformingAlgorithm::kCG: {
+      // Warm start from the previous frame's beamformer of this subcarrier,
+      // once all of that frame's beam tasks wrote theirs. With frequency
+      // orthogonal pilots only the first subcarrier of a group is written.
+      bool warm_start = false;
+      if ((frame_id > 0) && (num_ext_ref_ == 0) &&
+          (cfg_->HalfPrecisionStorage() == false) &&
+          ((cfg_->FreqOrthogonalPilot() == false) ||
+           (cur_sc_id % cfg_->PilotScGroupSize() == 0)) &&
+          beam_completion_.IsComplete(frame_id - 1)) {
+        const arma::cx_fmat mat_prev_beam(
+            reinterpret_cast<arma::cx_float*>(
+                ul_beam_matrices_[cfg_->FrameSlot(frame_id - 1)][cur_sc_id]),
+            cfg_->UeAntNum(), cfg_->BsAntNum(), false);
+        if (mat_prev_beam.is_finite()) {
+          mat_ul_beam_tmp = mat_prev_beam;
+          warm_start = true;
+        }
+      }
+      CgZf(arena, mat_csi, cfg_->ApproxZfIterations(), warm_start,
+           mat_ul_beam_tmp);
+      break;
+    }
     default:
       AGORA_LOG_ERROR("Beamforming algorithm is not implemented!");
   }
 
   if (cfg_->Frame().NumDLSyms() > 0) {
-    arma::cx_fmat mat_dl_beam_tmp;
+    arma::cx_fmat mat_dl_beam_tmp(
+        arena.Alloc<arma::cx_float>(num_ue * num_ant), num_ue, num_ant, false,
+        false);
     if (kUseUlZfForDownlink == true) {
       // With orthonormal calib matrix:
       // pinv(calib * csi) = pinv(csi)*inv(calib)
       // This probably causes a performance hit since we are throwing
       // magnitude info away by taking the sign of the calibration matrix
       // Inv is already acheived by UL over DL division outside this function
-      arma::cx_fmat inv_calib_mat = arma::diagmat(arma::sign(calib_sc_vec));
-      mat_dl_beam_tmp = mat_ul_beam_tmp * inv_calib_mat;
+      // diagmat() scales the columns, the diagonal matrix is never formed
+      arma::cx_fvec calib_sign(
+          arena.Alloc<arma::cx_float>(calib_sc_vec.n_elem), calib_sc_vec.n_elem,
+          false, false);
+      calib_sign = arma::sign(calib_sc_vec);
+      mat_dl_beam_tmp = mat_ul_beam_tmp * arma::diagmat(calib_sign);
     } else {
-      arma::cx_fmat mat_dl_csi = inv(arma::diagmat(calib_sc_vec)) * mat_csi;
+      arma::cx_fmat mat_dl_csi(arena.Alloc<arma::cx_float>(num_ant * num_ue),
+                               num_ant, num_ue, false, false);
+      arma::cx_fvec calib_inv(
+          arena.Alloc<arma::cx_float>(calib_sc_vec.n_elem), calib_sc_vec.n_elem,
+          false, false);
+      calib_inv = arma::cx_float(1.0f) / calib_sc_vec;
+      mat_dl_csi = arma::diagmat(calib_inv) * mat_csi;
       if (kEnableMatLog) {
         phy_stats_->UpdateDlCsi(frame_id, cur_sc_id, mat_dl_csi);
       }
       switch (cfg_->BeamformingAlgo()) {
         case CommsLib::BeamformingAlgorithm::kZF:
           if (kUseInverseForZF) {
-            try {
-              mat_dl_beam_tmp =
-                  arma::inv_sympd(mat_dl_csi.t() * mat_dl_csi) * mat_dl_csi.t();
-            } catch (std::runtime_error&) {
-              AGORA_LOG_WARN(
-                  "Failed to invert channel matrix, falling back to pinv()\n");
-              arma::pinv(mat_dl_beam_tmp, mat_csi, 1e-2, "dc");
-            }
+            SafeZf(arena, mat_dl_csi, mat_dl_beam_tmp);
           } else {
-            arma::pinv(mat_dl_beam_tmp, mat_csi, 1e-2, "dc");
+            arma::pinv(mat_dl_beam_tmp, mat_dl_csi, 1e-2, "dc");
           }
           break;
         case CommsLib::BeamformingAlgorithm::kMMSE:
-          mat_dl_beam_tmp =
-              arma::inv_sympd(mat_dl_csi.t() * mat_dl_csi +
-                              noise * arma::eye<arma::cx_fmat>(
-                                          cfg_->UeAntNum(), cfg_->UeAntNum())) *
-              mat_dl_csi.t();
+          RegularizedZf(arena, mat_dl_csi, noise, mat_dl_beam_tmp);
           break;
         case CommsLib::BeamformingAlgorithm::kMRC:
           mat_dl_beam_tmp = mat_dl_csi.t();
           break;
+        case CommsLib::BeamformingAlgorithm::kNeumann:
+          NeumannZf(arena, mat_dl_csi, cfg_->ApproxZfIterations(),
+                    mat_dl_beam_tmp);
+          break;
+        case CommsLib::BeamformingAlgorithm::kCG:
+          CgZf(arena, mat_dl_csi, cfg_->ApproxZfIterations(), false,
+               mat_dl_beam_tmp);
+          break;
         default:
           AGORA_LOG_ERROR("Beamforming algorithm is not implemented!");
       }
@@ -178,8 +295,11 @@ void DoBeamWeights::ComputePrecoder(size_t frame_id, size_t cur_sc_id,
     // We should be scaling the beamforming matrix, so the IFFT
     // output can be scaled with OfdmCaNum() across all antennas.
     // See Argos paper (Mobicom 2012) Sec. 3.4 for details.
-    const float scale = 1 / (abs(mat_dl_beam_tmp).max());
-    mat_dl_beam_tmp = mat_dl_beam_tmp * scale;
+    float max_abs = 0;
+    for (const arma::cx_float& beam : mat_dl_beam_tmp) {
+      max_abs = std::max(max_abs, std::abs(beam));
+    }
+    mat_dl_beam_tmp *= (1 / max_abs);
 
     for (size_t i = 0; i < cfg_->NumCells(); i++) {
       if (cfg_->ExternalRefNode(i)) {
@@ -216,166 +336,22 @@ void DoBeamWeights::ComputePrecoder(size_t frame_id, size_t cur_sc_id,
 }
 
 // Called for each frame_id / sc_id
-// Updates calib_sc_vec
+// Updates calib_sc_vec from the vectors written by DoRecipCal
 void DoBeamWeights::ComputeCalib(size_t frame_id, size_t sc_id,
                                  arma::cx_fvec& calib_sc_vec) {
   const size_t frames_to_complete = cfg_->RecipCalFrameCnt();
   if (cfg_->Frame().IsRecCalEnabled() && (frame_id >= frames_to_complete)) {
-    const size_t cal_slot_current = cfg_->RecipCalIndex(frame_id);
-    const bool frame_update = ((frame_id % frames_to_complete) == 0);
-
     // Use the previous window which has a full set of calibration results
     const size_t cal_slot_complete =
-        cfg_->ModifyRecCalIndex(cal_slot_current, -1);
-
-    // update moving sum
-    arma::cx_fmat cur_calib_dl_msum_mat(
-        reinterpret_cast<arma::cx_float*>(
-            calib_dl_msum_buffer_[cal_slot_complete]),
-        cfg_->BfAntNum(), cfg_->OfdmDataNum(), false);
-    arma::cx_fmat cur_calib_ul_msum_mat(
-        reinterpret_cast<arma::cx_float*>(
-            calib_ul_msum_buffer_[cal_slot_complete]),
-        cfg_->BfAntNum(), cfg_->OfdmDataNum(), false);
-
-    arma::cx_fmat calib_mat(
+        cfg_->ModifyRecCalIndex(cfg_->RecipCalIndex(frame_id), -1);
+    const arma::cx_fmat calib_mat(
         reinterpret_cast<arma::cx_float*>(calib_buffer_[cal_slot_complete]),
         cfg_->BfAntNum(), cfg_->OfdmDataNum(), false);
-
-    // Update the moving sum
-    if (frame_update) {
-      if (sc_id == 0) {
-        AGORA_LOG_TRACE(
-            "DoBeamWeights[%d]: (Frame %zu, sc_id %zu), ComputeCalib "
-            "updating "
-            "calib at slot %zu : prev %zu, old %zu\n",
-            tid_, frame_id, sc_id, cal_slot_complete, cal_slot_prev,
-            cal_slot_old);
-      }
-      // Add the most recently completed value
-      const arma::cx_fmat cur_calib_dl_mat(
-          reinterpret_cast<arma::cx_float*>(
-              calib_dl_buffer_[cal_slot_complete]),
-          cfg_->OfdmDataNum(), cfg_->BfAntNum(), false);
-      const arma::cx_fmat cur_calib_ul_mat(
-          reinterpret_cast<arma::cx_float*>(
-              calib_ul_buffer_[cal_slot_complete]),
-          cfg_->OfdmDataNum(), cfg_->BfAntNum(), false);
-
-      if (cfg_->SmoothCalib()) {
-        // oldest frame data in buffer but could be partially written with newest values
-        // using the second oldest....
-        const size_t cal_slot_old =
-            cfg_->ModifyRecCalIndex(cal_slot_current, +1);
-
-        const arma::cx_fmat old_calib_dl_mat(
-            reinterpret_cast<arma::cx_float*>(calib_dl_buffer_[cal_slot_old]),
-            cfg_->OfdmDataNum(), cfg_->BfAntNum(), false);
-        const arma::cx_fmat old_calib_ul_mat(
-            reinterpret_cast<arma::cx_float*>(calib_ul_buffer_[cal_slot_old]),
-            cfg_->OfdmDataNum(), cfg_->BfAntNum(), false);
-
-        const size_t cal_slot_prev =
-            cfg_->ModifyRecCalIndex(cal_slot_complete, -1);
-        const arma::cx_fmat prev_calib_dl_msum_mat(
-            reinterpret_cast<arma::cx_float*>(
-                calib_dl_msum_buffer_[cal_slot_prev]),
-            cfg_->BfAntNum(), cfg_->OfdmDataNum(), false);
-        const arma::cx_fmat prev_calib_ul_msum_mat(
-            reinterpret_cast<arma::cx_float*>(
-                calib_ul_msum_buffer_[cal_slot_prev]),
-            cfg_->BfAntNum(), cfg_->OfdmDataNum(), false);
-
-        // Add new value to old rolling sum.  Then subtract out the oldest.
-
-        cur_calib_dl_msum_mat.col(sc_id) =
-            prev_calib_dl_msum_mat.col(sc_id) +
-            (cur_calib_dl_mat.row(sc_id) - old_calib_dl_mat.row(sc_id)).st();
-        cur_calib_ul_msum_mat.col(sc_id) =
-            prev_calib_ul_msum_mat.col(sc_id) +
-            (cur_calib_ul_mat.row(sc_id) - old_calib_ul_mat.row(sc_id)).st();
-        calib_mat.col(sc_id) =
-            cur_calib_ul_msum_mat.col(sc_id) / cur_calib_dl_msum_mat.col(sc_id);
-      } else {
-        calib_mat.col(sc_id) =
-            (cur_calib_ul_mat.row(sc_id) / cur_calib_dl_mat.row(sc_id)).st();
-      }
-      if (kEnableMatLog) {
-        phy_stats_->UpdateCalibMat(frame_id, sc_id, calib_mat.col(sc_id));
-      }
-    }
     calib_sc_vec = calib_mat.col(sc_id);
   }
   // Otherwise calib_sc_vec = identity from init
 }
 
-// Gather data of one symbol from partially-transposed buffer
-// produced by dofft
-static inline void PartialTransposeGather(size_t cur_sc_id, float* src,
-                                          float*& dst, size_t bs_ant_num) {
-  // The SIMD and non-SIMD methods are equivalent.
-
-#ifdef __AVX512F__
-  static constexpr size_t kAntNumPerSimd = 8;
-#else
-  static constexpr size_t kAntNumPerSimd = 4;
-#endif
-
-  size_t ant_start = 0;
-  if (kUseSIMDGather && (bs_ant_num >= kAntNumPerSimd)) {
-    const size_t transpose_block_id = cur_sc_id / kTransposeBlockSize;
-    const size_t sc_inblock_idx = cur_sc_id % kTransposeBlockSize;
-    const size_t offset_in_src_buffer =
-        transpose_block_id * bs_ant_num * kTransposeBlockSize + sc_inblock_idx;
-
-    src = src + offset_in_src_buffer * 2;
-#ifdef __AVX512F__
-    __m512i index = _mm512_setr_epi32(
-        0, 1, kTransposeBlockSize * 2, kTransposeBlockSize * 2 + 1,
-        kTransposeBlockSize * 4, kTransposeBlockSize * 4 + 1,
-        kTransposeBlockSize * 6, kTransposeBlockSize * 6 + 1,
-        kTransposeBlockSize * 8, kTransposeBlockSize * 8 + 1,
-        kTransposeBlockSize * 10, kTransposeBlockSize * 10 + 1,
-        kTransposeBlockSize * 12, kTransposeBlockSize * 12 + 1,
-        kTransposeBlockSize * 14, kTransposeBlockSize * 14 + 1);
-    for (size_t ant_idx = 0; ant_idx < bs_ant_num; ant_idx += kAntNumPerSimd) {
-      // fetch 4 complex floats for 4 ants
-      __m512 t = (kTransposeBlockSize == 1)
-                     ? _mm512_load_ps(src)
-                     : _mm512_i32gather_ps(index, src, 4);
-      _mm512_storeu_ps(dst, t);
-      src += kAntNumPerSimd * kTransposeBlockSize * 2;
-      dst += kAntNumPerSimd * 2;
-    }
-#else
-    __m256i index = _mm256_setr_epi32(
-        0, 1, kTransposeBlockSize * 2, kTransposeBlockSize * 2 + 1,
-        kTransposeBlockSize * 4, kTransposeBlockSize * 4 + 1,
-        kTransposeBlockSize * 6, kTransposeBlockSize * 6 + 1);
-    for (size_t ant_idx = 0; ant_idx < bs_ant_num; ant_idx += kAntNumPerSimd) {
-      // fetch 4 complex floats for 4 ants
-      __m256 t = _mm256_i32gather_ps(src, index, 4);
-      _mm256_storeu_ps(dst, t);
-      src += kAntNumPerSimd * kTransposeBlockSize * 2;
-      dst += kAntNumPerSimd * 2;
-    }
-#endif
-    // Set the of the remaining antennas to use non-SIMD gather
-    ant_start = bs_ant_num - (bs_ant_num % kAntNumPerSimd);
-  }
-  if (ant_start < bs_ant_num) {
-    const size_t pt_base_offset =
-        (cur_sc_id / kTransposeBlockSize) * (kTransposeBlockSize * bs_ant_num);
-    auto* cx_src = reinterpret_cast<complex_float*>(src);
-    complex_float* cx_dst = (complex_float*)dst + ant_start;
-    for (size_t ant_i = ant_start; ant_i < bs_ant_num; ant_i++) {
-      *cx_dst = cx_src[pt_base_offset + (ant_i * kTransposeBlockSize) +
-                       (cur_sc_id % kTransposeBlockSize)];
-      cx_dst++;
-    }
-  }
-}
-
 // Gather data of one symbol from partially-transposed buffer
 // produced by dofft
 static inline void TransposeGather(size_t cur_sc_id, float* src, float*& dst,
@@ -392,18 +368,18 @@ void DoBeamWeights::ComputeBeams(size_t tag) {
   //Request was generated from gen_tag_t::FrmSc
   const size_t frame_id = gen_tag_t(tag).frame_id_;
   const size_t base_sc_id = gen_tag_t(tag).sc_id_;
-  const size_t frame_slot = frame_id % kFrameWnd;
+  const size_t frame_slot = cfg_->FrameSlot(frame_id);
   if (kDebugPrintInTask) {
     std::printf("In doZF thread %d: frame: %zu, base subcarrier: %zu\n", tid_,
                 frame_id, base_sc_id);
   }
 
-  // Process BeamBlockSize (or less) number of carriers
+  // Process the frame's beam block size (or less) number of carriers
   // cfg_->OfdmDataNum() is the total number of usable subcarriers
   // First sc in the next block
   const size_t last_sc_id =
-      base_sc_id +
-      std::min(cfg_->BeamBlockSize(), cfg_->OfdmDataNum() - base_sc_id);
+      base_sc_id + std::min(block_sizes_.Get(frame_id).beam_,
+                            cfg_->OfdmDataNum() - base_sc_id);
 
   // Default: Handle each subcarrier one by one
   size_t sc_inc = 1;
@@ -424,16 +400,25 @@ void DoBeamWeights::ComputeBeams(size_t tag) {
        cur_sc_id = cur_sc_id + sc_inc) {
     arma::cx_fvec& cal_sc_vec = *calib_sc_vec_ptr_;
     const size_t start_tsc1 = GetTime::WorkerRdtsc();
+    scratch_stat_->BeginTask();
 
     // Gather CSI matrices of each pilot from partially-transposed CSIs.
     for (size_t ue_idx = 0; ue_idx < cfg_->UeAntNum(); ue_idx++) {
       auto* dst_csi_ptr = reinterpret_cast<float*>(csi_gather_buffer_ +
                                                    cfg_->BsAntNum() * ue_idx);
-      if (kUsePartialTrans) {
-        PartialTransposeGather(
-            cur_sc_id,
-            reinterpret_cast<float*>(csi_buffers_[frame_slot][ue_idx]),
-            dst_csi_ptr, cfg_->BsAntNum());
+      if (cfg_->HalfPrecisionStorage()) {
+        // Antennas of one subcarrier are transpose_block_size_ values apart
+        const size_t offset_in_src_buffer = Agora_transpose::Offset(
+            transpose_block_size_, cfg_->BsAntNum(), cur_sc_id, 0);
+        const auto* csi_half =
+            reinterpret_cast<const uint16_t*>(csi_buffers_[frame_slot][ue_idx]);
+        SimdGatherCxHalfToCxFloat(csi_half + 2 * offset_in_src_buffer,
+                                  transpose_block_size_, dst_csi_ptr,
+                                  cfg_->BsAntNum());
+      } else if (partial_transpose_) {
+        gather_sc_(csi_buffers_[frame_slot][ue_idx], cur_sc_id,
+                   cfg_->BsAntNum(),
+                   reinterpret_cast<complex_float*>(dst_csi_ptr));
       } else {
         TransposeGather(
             cur_sc_id,
@@ -465,7 +450,29 @@ void DoBeamWeights::ComputeBeams(size_t tag) {
     ComputePrecoder(frame_id, cur_sc_id, mat_csi, cal_sc_vec, noise,
                     ul_beam_matrices_[frame_slot][cur_sc_id],
                     dl_beam_matrices_[frame_slot][cur_sc_id]);
+    if (cfg_->UlFixedPoint()) {
+      ul_beam_exp_buffer_[frame_slot][cur_sc_id] = FixedPointPackBeam(
+          reinterpret_cast<const float*>(
+              ul_beam_matrices_[frame_slot][cur_sc_id]),
+          cfg_->UeAntNum(), cfg_->BsAntNum(),
+          ul_beam_matrices_fixed_[frame_slot][cur_sc_id], beam_quant_buffer_);
+    }
+    if (cfg_->HalfPrecisionStorage()) {
+      const size_t beam_size = cfg_->BsAntNum() * cfg_->UeAntNum();
+      if (kCollectPhyStats) {
+        phy_stats_->UpdateHalfPrecisionBeamError(
+            frame_id, cur_sc_id, ul_beam_matrices_[frame_slot][cur_sc_id],
+            beam_size);
+      }
+      for (complex_float* beam : {ul_beam_matrices_[frame_slot][cur_sc_id],
+                                  dl_beam_matrices_[frame_slot][cur_sc_id]}) {
+        SimdConvertFloatToHalf(reinterpret_cast<const float*>(beam),
+                               reinterpret_cast<uint16_t*>(beam),
+                               2 * beam_size);
+      }
+    }
 
+    scratch_stat_->EndTask(Arena());
     duration_stat_->task_duration_[3] += GetTime::WorkerRdtsc() - start_tsc3;
     duration_stat_->task_count_++;
     duration_stat_->task_duration_[0] += GetTime::WorkerRdtsc() - start_tsc1;
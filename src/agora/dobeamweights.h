@@ -11,9 +11,11 @@
 #include "common_typedef_sdk.h"
 #include "config.h"
 #include "doer.h"
+#include "frame_block_sizes.h"
 #include "mat_logger.h"
 #include "memory_manage.h"
 #include "message.h"
+#include "partial_transpose.h"
 #include "phy_stats.h"
 #include "stats.h"
 
@@ -21,15 +23,15 @@ class DoBeamWeights : public Doer {
  public:
   DoBeamWeights(
       Config* in_config, int tid,
-      PtrGrid<kFrameWnd, kMaxUEs, complex_float>& csi_buffers,
-      Table<complex_float>& calib_dl_buffer,
-      Table<complex_float>& calib_ul_buffer,
-      Table<complex_float>& calib_dl_msum_buffer,
-      Table<complex_float>& calib_ul_msum_buffer,
+      PtrGrid<complex_float>& csi_buffers,
       Table<complex_float>& calib_buffer,
-      PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& ul_beam_matrices_,
-      PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& dl_beam_matrices_,
-      PhyStats* in_phy_stats, Stats* stats_manager);
+      PtrGrid<complex_float>& ul_beam_matrices_,
+      PtrGrid<complex_float>& dl_beam_matrices_,
+      PtrGrid<short>& ul_beam_matrices_fixed,
+      Table<int8_t>& ul_beam_exp_buffer,
+      const FrameCompletion& beam_completion,
+      const FrameBlockSizes& block_sizes, PhyStats* in_phy_stats,
+      Stats* stats_manager);
   ~DoBeamWeights() override;
 
   /**
@@ -59,24 +61,33 @@ class DoBeamWeights : public Doer {
   void ComputeCalib(size_t frame_id, size_t sc_id, arma::cx_fvec& calib_sc_vec);
   void ComputeBeams(size_t tag);
 
-  PtrGrid<kFrameWnd, kMaxUEs, complex_float>& csi_buffers_;
+  PtrGrid<complex_float>& csi_buffers_;
   complex_float* pred_csi_buffer_;
 
-  //Should be read only (Set by FFT and read by Zf)
-  Table<complex_float>& calib_dl_buffer_;
-  Table<complex_float>& calib_ul_buffer_;
-
-  //Shared by all doZf objects
-  Table<complex_float>& calib_dl_msum_buffer_;
-  Table<complex_float>& calib_ul_msum_buffer_;
+  //Should be read only (Set by DoRecipCal)
   Table<complex_float>& calib_buffer_;
-  PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& ul_beam_matrices_;
-  PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& dl_beam_matrices_;
+  PtrGrid<complex_float>& ul_beam_matrices_;
+  PtrGrid<complex_float>& dl_beam_matrices_;
+  // Quantized uplink beam matrices, written when UlFixedPoint() is enabled
+  PtrGrid<short>& ul_beam_matrices_fixed_;
+  Table<int8_t>& ul_beam_exp_buffer_;
+  // The CG warm start reads only the beamformers of completed frames
+  const FrameCompletion& beam_completion_;
+  const FrameBlockSizes& block_sizes_;
   DurationStat* duration_stat_;
+  ScratchAllocStat* scratch_stat_;
+
+  // Layout and partial transpose block size of the CSI buffers and the
+  // gather kernel specialized for it
+  bool partial_transpose_;
+  size_t transpose_block_size_;
+  Agora_transpose::GatherScFn gather_sc_;
 
   complex_float* csi_gather_buffer_;  // Intermediate buffer to gather CSI
   // Intermediate buffer to gather reciprical calibration data vector
   complex_float* calib_gather_buffer_;
+  // Scratch row used while quantizing the uplink beam matrix
+  float* beam_quant_buffer_;
   std::unique_ptr<arma::cx_fvec> calib_sc_vec_ptr_;
 
   PhyStats* phy_stats_;
@@ -7,6 +7,7 @@
 
 #include "concurrent_queue_wrapper.h"
 #include "phy_ldpc_decoder_5gnr.h"
+#include "utils_ldpc.h"
 
 static constexpr bool kPrintLLRData = false;
 static constexpr bool kPrintDecodedData = false;
@@ -15,8 +16,8 @@ static constexpr size_t kVarNodesSize = 1024 * 1024 * sizeof(int16_t);
 
 DoDecode::DoDecode(
     Config* in_config, int in_tid,
-    PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& demod_buffers,
-    PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& decoded_buffers,
+    PtrCube<int8_t>& demod_buffers,
+    PtrCube<int8_t>& decoded_buffers,
     PhyStats* in_phy_stats, Stats* in_stats_manager)
     : Doer(in_config, in_tid),
       demod_buffers_(demod_buffers),
@@ -26,10 +27,32 @@ DoDecode::DoDecode(
   duration_stat_ = in_stats_manager->GetDurationStat(DoerType::kDecode, in_tid);
   resp_var_nodes_ = static_cast<int16_t*>(Agora_memory::PaddedAlignedAlloc(
       Agora_memory::Alignment_t::kAlign64, kVarNodesSize));
+  decode_budget_cycles_ = static_cast<size_t>(cfg_->DecodeFrameBudgetUs() *
+                                              cfg_->FreqGhz() * 1000);
 }
 
 DoDecode::~DoDecode() { std::free(resp_var_nodes_); }
 
+size_t DoDecode::DecoderIterationCap(size_t frame_id, size_t ue_id) const {
+  const LDPCconfig& ldpc_config = cfg_->LdpcConfig(Direction::kUplink);
+  const size_t max_iter = ldpc_config.MaxDecoderIter();
+  if (cfg_->AdaptiveDecoderIter() == false) {
+    return max_iter;
+  }
+  // Once the frame has used its time budget, skip the remaining codeblocks
+  const bool budget_spent =
+      (decode_budget_cycles_ > 0) &&
+      (phy_stats_->GetDecodeCycles(frame_id) >= decode_budget_cycles_);
+  const float code_rate = static_cast<float>(ldpc_config.NumCbLen()) /
+                          ldpc_config.NumCbCodewLen();
+  const float required_snr =
+      LdpcRequiredSnrDb(code_rate, cfg_->ModOrderBits(Direction::kUplink),
+                        cfg_->DecoderSnrGapDb());
+  return LdpcFrameIterationCap(
+      phy_stats_->GetLatestEvmSnr(ue_id) - required_snr, max_iter,
+      cfg_->DecoderAbandonMarginDb(), budget_spent);
+}
+
 EventData DoDecode::Launch(size_t tag) {
   const LDPCconfig& ldpc_config = cfg_->LdpcConfig(Direction::kUplink);
   const size_t frame_id = gen_tag_t(tag).frame_id_;
@@ -40,7 +63,7 @@ EventData DoDecode::Launch(size_t tag) {
       cfg_->GetTotalDataSymbolIdxUl(frame_id, symbol_idx_ul);
   const size_t cur_cb_id = (cb_id % ldpc_config.NumBlocksInSymbol());
   const size_t ue_id = (cb_id / ldpc_config.NumBlocksInSymbol());
-  const size_t frame_slot = (frame_id % kFrameWnd);
+  const size_t frame_slot = cfg_->FrameSlot(frame_id);
   const size_t num_bytes_per_cb = cfg_->NumBytesPerCb(Direction::kUplink);
   if (kDebugPrintInTask == true) {
     std::printf(
@@ -60,7 +83,10 @@ EventData DoDecode::Launch(size_t tag) {
 
   ldpc_decoder_5gnr_request.numChannelLlrs = num_channel_llrs;
   ldpc_decoder_5gnr_request.numFillerBits = num_filler_bits;
-  ldpc_decoder_5gnr_request.maxIterations = ldpc_config.MaxDecoderIter();
+  // Abandoned codeblocks still run one iteration to fill the output buffer
+  const size_t iteration_cap = DecoderIterationCap(frame_id, ue_id);
+  ldpc_decoder_5gnr_request.maxIterations =
+      std::max<size_t>(iteration_cap, 1);
   ldpc_decoder_5gnr_request.enableEarlyTermination =
       ldpc_config.EarlyTermination();
   ldpc_decoder_5gnr_request.Zc = ldpc_config.ExpansionFactor();
@@ -87,6 +113,9 @@ EventData DoDecode::Launch(size_t tag) {
 
   bblib_ldpc_decoder_5gnr(&ldpc_decoder_5gnr_request,
                           &ldpc_decoder_5gnr_response);
+  phy_stats_->UpdateDecoderIterations(
+      tid_, frame_id, ldpc_decoder_5gnr_response.iterationAtTermination,
+      GetTime::WorkerRdtsc() - start_tsc1, iteration_cap == 0);
 
   if (cfg_->ScrambleEnabled()) {
     scrambler_->Descramble(decoded_buffer_ptr, num_bytes_per_cb);
@@ -111,25 +140,21 @@ EventData DoDecode::Launch(size_t tag) {
     std::printf("\n");
   }
 
+  // Check every BerSampleInterval()-th codeblock of each UE
   if ((kEnableMac == false) && (kPrintPhyStats == true) &&
-      (symbol_idx_ul >= cfg_->Frame().ClientUlPilotSymbols())) {
-    phy_stats_->UpdateDecodedBits(ue_id, symbol_offset, frame_slot,
+      (symbol_idx_ul >= cfg_->Frame().ClientUlPilotSymbols()) &&
+      ((symbol_offset * ldpc_config.NumBlocksInSymbol() + cur_cb_id) %
+           cfg_->BerSampleInterval() ==
+       0)) {
+    phy_stats_->UpdateDecodedBits(tid_, ue_id, frame_slot,
                                   num_bytes_per_cb * 8);
-    phy_stats_->IncrementDecodedBlocks(ue_id, symbol_offset, frame_slot);
-    size_t block_error(0);
-    for (size_t i = 0; i < num_bytes_per_cb; i++) {
-      uint8_t rx_byte = decoded_buffer_ptr[i];
-      auto tx_byte = static_cast<uint8_t>(
-          cfg_->GetInfoBits(cfg_->UlBits(), Direction::kUplink, symbol_idx_ul,
-                            ue_id, cur_cb_id)[i]);
-      phy_stats_->UpdateBitErrors(ue_id, symbol_offset, frame_slot, tx_byte,
-                                  rx_byte);
-      if (rx_byte != tx_byte) {
-        block_error++;
-      }
-    }
-    phy_stats_->UpdateBlockErrors(ue_id, symbol_offset, frame_slot,
-                                  block_error);
+    phy_stats_->IncrementDecodedBlocks(tid_, ue_id, frame_slot);
+    phy_stats_->UpdateBlockBitErrors(
+        tid_, ue_id, frame_slot,
+        reinterpret_cast<const uint8_t*>(
+            cfg_->GetInfoBits(cfg_->UlBits(), Direction::kUplink,
+                              symbol_idx_ul, ue_id, cur_cb_id)),
+        decoded_buffer_ptr, num_bytes_per_cb);
   }
 
   size_t duration = GetTime::WorkerRdtsc() - start_tsc;
@@ -20,20 +20,25 @@
 class DoDecode : public Doer {
  public:
   DoDecode(Config* in_config, int in_tid,
-           PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& demod_buffers,
-           PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& decoded_buffers,
+           PtrCube<int8_t>& demod_buffers,
+           PtrCube<int8_t>& decoded_buffers,
            PhyStats* in_phy_stats, Stats* in_stats_manager);
   ~DoDecode() override;
 
   EventData Launch(size_t tag) override;
 
  private:
+  // Iteration cap of a codeblock of [ue_id] in [frame_id], 0 to abandon it
+  size_t DecoderIterationCap(size_t frame_id, size_t ue_id) const;
+
   int16_t* resp_var_nodes_;
-  PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& demod_buffers_;
-  PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& decoded_buffers_;
+  PtrCube<int8_t>& demod_buffers_;
+  PtrCube<int8_t>& decoded_buffers_;
   PhyStats* phy_stats_;
   DurationStat* duration_stat_;
   std::unique_ptr<AgoraScrambler::Scrambler> scrambler_;
+  // decode_frame_budget_us in cycles, 0 for no limit
+  size_t decode_budget_cycles_;
 };
 
 #endif  // DODECODE_H_
@@ -6,38 +6,64 @@
 
 #include "comms-lib.h"
 #include "concurrent_queue_wrapper.h"
+#include "datatype_conversion.h"
+#include "fixed_point.h"
 #include "modulation.h"
 
-static constexpr bool kUseSIMDGather = true;
-
 DoDemul::DoDemul(
     Config* config, int tid, Table<complex_float>& data_buffer,
-    PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& ul_beam_matrices,
+    PtrGrid<complex_float>& ul_beam_matrices,
+    Table<short>& data_buffer_fixed, Table<int8_t>& data_exp_buffer,
+    PtrGrid<short>& ul_beam_matrices_fixed,
+    Table<int8_t>& ul_beam_exp_buffer,
     Table<complex_float>& ue_spec_pilot_buffer,
     Table<complex_float>& equal_buffer,
-    PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& demod_buffers,
+    PtrCube<int8_t>& demod_buffers, const FrameBlockSizes& block_sizes,
     PhyStats* in_phy_stats, Stats* stats_manager)
     : Doer(config, tid),
       data_buffer_(data_buffer),
       ul_beam_matrices_(ul_beam_matrices),
+      data_buffer_fixed_(data_buffer_fixed),
+      data_exp_buffer_(data_exp_buffer),
+      ul_beam_matrices_fixed_(ul_beam_matrices_fixed),
+      ul_beam_exp_buffer_(ul_beam_exp_buffer),
       ue_spec_pilot_buffer_(ue_spec_pilot_buffer),
       equal_buffer_(equal_buffer),
       demod_buffers_(demod_buffers),
+      block_sizes_(block_sizes),
       phy_stats_(in_phy_stats) {
   duration_stat_ = stats_manager->GetDurationStat(DoerType::kDemul, tid);
+  scratch_stat_ = stats_manager->GetScratchAllocStat(tid);
+  partial_transpose_ = cfg_->PartialTranspose();
+  transpose_block_size_ = cfg_->TransposeBlockSize();
+  gather_sc_ = Agora_transpose::SelectGatherSc(transpose_block_size_);
 
+  // The batched path gathers a whole block before equalizing it
+  const size_t gather_sc_num =
+      cfg_->BatchedGemm() ? cfg_->DemulBlockSize() : kSCsPerCacheline;
   data_gather_buffer_ =
       static_cast<complex_float*>(Agora_memory::PaddedAlignedAlloc(
           Agora_memory::Alignment_t::kAlign64,
-          kSCsPerCacheline * kMaxAntennas * sizeof(complex_float)));
+          gather_sc_num * cfg_->BsAntNum() * sizeof(complex_float)));
+  batch_beam_ptrs_.resize(cfg_->DemulBlockSize());
+  batch_data_ptrs_.resize(cfg_->DemulBlockSize());
+  batch_equal_ptrs_.resize(cfg_->DemulBlockSize());
+  data_gather_buffer_fixed_ = static_cast<short*>(
+      Agora_memory::PaddedAlignedAlloc(Agora_memory::Alignment_t::kAlign64,
+                                       cfg_->BsAntNum() * 2 * sizeof(short)));
+  fixed_point_shifts_.resize(cfg_->BsAntNum());
+  ul_beam_half_buffer_ =
+      static_cast<complex_float*>(Agora_memory::PaddedAlignedAlloc(
+          Agora_memory::Alignment_t::kAlign64,
+          cfg_->BsAntNum() * cfg_->UeAntNum() * sizeof(complex_float)));
   equaled_buffer_temp_ =
       static_cast<complex_float*>(Agora_memory::PaddedAlignedAlloc(
           Agora_memory::Alignment_t::kAlign64,
-          cfg_->DemulBlockSize() * kMaxUEs * sizeof(complex_float)));
+          cfg_->DemulBlockSize() * cfg_->UeAntNum() * sizeof(complex_float)));
   equaled_buffer_temp_transposed_ =
       static_cast<complex_float*>(Agora_memory::PaddedAlignedAlloc(
           Agora_memory::Alignment_t::kAlign64,
-          cfg_->DemulBlockSize() * kMaxUEs * sizeof(complex_float)));
+          cfg_->DemulBlockSize() * cfg_->UeAntNum() * sizeof(complex_float)));
 
   // phase offset calibration data
   arma::cx_float* ue_pilot_ptr =
@@ -67,6 +93,8 @@ DoDemul::DoDemul(
 
 DoDemul::~DoDemul() {
   std::free(data_gather_buffer_);
+  std::free(data_gather_buffer_fixed_);
+  std::free(ul_beam_half_buffer_);
   std::free(equaled_buffer_temp_);
   std::free(equaled_buffer_temp_transposed_);
 
@@ -90,8 +118,9 @@ EventData DoDemul::Launch(size_t tag) {
       cfg_->GetTotalDataSymbolIdxUl(frame_id, symbol_idx_ul);
   const complex_float* data_buf = data_buffer_[total_data_symbol_idx_ul];
 
-  const size_t frame_slot = frame_id % kFrameWnd;
+  const size_t frame_slot = cfg_->FrameSlot(frame_id);
   size_t start_tsc = GetTime::WorkerRdtsc();
+  scratch_stat_->BeginTask();
 
   if (kDebugPrintInTask == true) {
     std::printf(
@@ -101,114 +130,90 @@ EventData DoDemul::Launch(size_t tag) {
         total_data_symbol_idx_ul);
   }
 
-  size_t max_sc_ite =
-      std::min(cfg_->DemulBlockSize(), cfg_->OfdmDataNum() - base_sc_id);
+  size_t max_sc_ite = std::min(block_sizes_.Get(frame_id).demul_,
+                               cfg_->OfdmDataNum() - base_sc_id);
   assert(max_sc_ite % kSCsPerCacheline == 0);
+  const bool batched_gemm = cfg_->BatchedGemm();
+  const bool fixed_point = cfg_->UlFixedPoint();
+  const bool half_precision = cfg_->HalfPrecisionStorage();
+  // Whole cachelines ahead, so that each prefetch covers a full gather
+  const size_t prefetch_distance =
+      Roundup<kSCsPerCacheline>(cfg_->PrefetchDistance());
+  // Beam matrix last converted to ul_beam_half_buffer_
+  size_t half_beam_sc_id = SIZE_MAX;
+  int data_exp = 0;
+  if (fixed_point) {
+    // Align every antenna to the largest block exponent of this symbol
+    const int8_t* exps = data_exp_buffer_[total_data_symbol_idx_ul];
+    data_exp = *std::max_element(exps, exps + cfg_->BsAntNum());
+    for (size_t ant = 0; ant < cfg_->BsAntNum(); ant++) {
+      fixed_point_shifts_[ant] = static_cast<uint8_t>(
+          std::min(data_exp - exps[ant], kFixedPointDataFracBits + 2));
+    }
+  }
   // Iterate through cache lines
   for (size_t i = 0; i < max_sc_ite; i += kSCsPerCacheline) {
     size_t start_tsc0 = GetTime::WorkerRdtsc();
+    if (fixed_point) {
+      for (size_t j = 0; j < kSCsPerCacheline; j++) {
+        const size_t cur_sc_id = base_sc_id + i + j;
+        complex_float* equal_ptr =
+            EqualPtr(total_data_symbol_idx_ul, base_sc_id, cur_sc_id);
+        EqualizeScFixedPoint(frame_slot, total_data_symbol_idx_ul, cur_sc_id,
+                             data_exp, equal_ptr);
+        arma::cx_fmat mat_equaled(reinterpret_cast<arma::cx_float*>(equal_ptr),
+                                  cfg_->UeAntNum(), 1, false);
+        PhaseCorrection(frame_id, symbol_idx_ul, data_symbol_idx_ul, cur_sc_id,
+                        mat_equaled);
+      }
+      duration_stat_->task_duration_[2] += GetTime::WorkerRdtsc() - start_tsc0;
+      duration_stat_->task_count_ += kSCsPerCacheline;
+      continue;
+    }
+    if ((prefetch_distance > 0) && (i + prefetch_distance < max_sc_ite)) {
+      // The batched cgemm streams its beam matrices itself
+      PrefetchScGroup(data_buf, frame_slot, base_sc_id + i + prefetch_distance,
+                      !batched_gemm);
+    }
+    // In the batched path each cacheline keeps its own gather rows
+    complex_float* gather_buf =
+        batched_gemm ? data_gather_buffer_ + (i * cfg_->BsAntNum())
+                     : data_gather_buffer_;
 
     // Step 1: Populate data_gather_buffer as a row-major matrix with
     // kSCsPerCacheline rows and BsAntNum() columns
-
-    // Since kSCsPerCacheline divides demul_block_size and
-    // kTransposeBlockSize, all subcarriers (base_sc_id + i) lie in the
-    // same partial transpose block.
-    const size_t partial_transpose_block_base =
-        ((base_sc_id + i) / kTransposeBlockSize) *
-        (kTransposeBlockSize * cfg_->BsAntNum());
-
-#ifdef __AVX512F__
-    static constexpr size_t kAntNumPerSimd = 8;
-#else
-    static constexpr size_t kAntNumPerSimd = 4;
-#endif
-
-    size_t ant_start = 0;
-    if (kUseSIMDGather && kUsePartialTrans &&
-        (cfg_->BsAntNum() % kAntNumPerSimd) == 0) {
-      // Gather data for all antennas and 8 subcarriers in the same cache
-      // line, 1 subcarrier and 4 (AVX2) or 8 (AVX512) ants per iteration
-      size_t cur_sc_offset =
-          partial_transpose_block_base + (base_sc_id + i) % kTransposeBlockSize;
-      const float* src =
-          reinterpret_cast<const float*>(&data_buf[cur_sc_offset]);
-      float* dst = reinterpret_cast<float*>(data_gather_buffer_);
-#ifdef __AVX512F__
-      __m512i index = _mm512_setr_epi32(
-          0, 1, kTransposeBlockSize * 2, kTransposeBlockSize * 2 + 1,
-          kTransposeBlockSize * 4, kTransposeBlockSize * 4 + 1,
-          kTransposeBlockSize * 6, kTransposeBlockSize * 6 + 1,
-          kTransposeBlockSize * 8, kTransposeBlockSize * 8 + 1,
-          kTransposeBlockSize * 10, kTransposeBlockSize * 10 + 1,
-          kTransposeBlockSize * 12, kTransposeBlockSize * 12 + 1,
-          kTransposeBlockSize * 14, kTransposeBlockSize * 14 + 1);
-      for (size_t ant_i = 0; ant_i < cfg_->BsAntNum();
-           ant_i += kAntNumPerSimd) {
-        for (size_t j = 0; j < kSCsPerCacheline; j++) {
-          __m512 data_rx = kTransposeBlockSize == 1
-                               ? _mm512_load_ps(&src[j * cfg_->BsAntNum() * 2])
-                               : _mm512_i32gather_ps(index, &src[j * 2], 4);
-
-          assert((reinterpret_cast<intptr_t>(&dst[j * cfg_->BsAntNum() * 2]) %
-                  (kAntNumPerSimd * sizeof(float) * 2)) == 0);
-          assert((reinterpret_cast<intptr_t>(&src[j * cfg_->BsAntNum() * 2]) %
-                  (kAntNumPerSimd * sizeof(float) * 2)) == 0);
-          _mm512_store_ps(&dst[j * cfg_->BsAntNum() * 2], data_rx);
-        }
-        src += kAntNumPerSimd * kTransposeBlockSize * 2;
-        dst += kAntNumPerSimd * 2;
-      }
-#else
-      __m256i index = _mm256_setr_epi32(
-          0, 1, kTransposeBlockSize * 2, kTransposeBlockSize * 2 + 1,
-          kTransposeBlockSize * 4, kTransposeBlockSize * 4 + 1,
-          kTransposeBlockSize * 6, kTransposeBlockSize * 6 + 1);
-      for (size_t ant_i = 0; ant_i < cfg_->BsAntNum();
-           ant_i += kAntNumPerSimd) {
-        for (size_t j = 0; j < kSCsPerCacheline; j++) {
-          assert((reinterpret_cast<intptr_t>(&dst[j * cfg_->BsAntNum() * 2]) %
-                  (kAntNumPerSimd * sizeof(float) * 2)) == 0);
-          __m256 data_rx = _mm256_i32gather_ps(&src[j * 2], index, 4);
-          _mm256_store_ps(&dst[j * cfg_->BsAntNum() * 2], data_rx);
-        }
-        src += kAntNumPerSimd * kTransposeBlockSize * 2;
-        dst += kAntNumPerSimd * 2;
-      }
-#endif
-      // Set the remaining number of antennas for non-SIMD gather
-      ant_start = cfg_->BsAntNum() - (cfg_->BsAntNum() % kAntNumPerSimd);
-    }
-    if (ant_start < cfg_->BsAntNum()) {
-      complex_float* dst = data_gather_buffer_ + ant_start;
-      for (size_t j = 0; j < kSCsPerCacheline; j++) {
-        for (size_t ant_i = ant_start; ant_i < cfg_->BsAntNum(); ant_i++) {
-          *dst++ =
-              kUsePartialTrans
-                  ? data_buf[partial_transpose_block_base +
-                             (ant_i * kTransposeBlockSize) +
-                             ((base_sc_id + i + j) % kTransposeBlockSize)]
-                  : data_buf[ant_i * cfg_->OfdmDataNum() + base_sc_id + i + j];
+    for (size_t j = 0; j < kSCsPerCacheline; j++) {
+      const size_t cur_sc_id = base_sc_id + i + j;
+      complex_float* dst = gather_buf + (j * cfg_->BsAntNum());
+      if (half_precision) {
+        // Antennas of one subcarrier are transpose_block_size_ values apart
+        SimdGatherCxHalfToCxFloat(
+            reinterpret_cast<const uint16_t*>(data_buf) +
+                2 * Agora_transpose::Offset(transpose_block_size_,
+                                            cfg_->BsAntNum(), cur_sc_id, 0),
+            transpose_block_size_, reinterpret_cast<float*>(dst),
+            cfg_->BsAntNum());
+      } else if (partial_transpose_) {
+        gather_sc_(data_buf, cur_sc_id, cfg_->BsAntNum(), dst);
+      } else {
+        for (size_t ant_i = 0; ant_i < cfg_->BsAntNum(); ant_i++) {
+          dst[ant_i] = data_buf[ant_i * cfg_->OfdmDataNum() + cur_sc_id];
         }
       }
     }
     duration_stat_->task_duration_[1] += GetTime::WorkerRdtsc() - start_tsc0;
 
+    if (batched_gemm) {
+      continue;
+    }
+
     // Step 2: For each subcarrier, perform equalization by multiplying the
     // subcarrier's data from each antenna with the subcarrier's precoder
     for (size_t j = 0; j < kSCsPerCacheline; j++) {
       const size_t cur_sc_id = base_sc_id + i + j;
 
-      arma::cx_float* equal_ptr = nullptr;
-      if (kExportConstellation) {
-        equal_ptr =
-            (arma::cx_float*)(&equal_buffer_[total_data_symbol_idx_ul]
-                                            [cur_sc_id * cfg_->UeAntNum()]);
-      } else {
-        equal_ptr =
-            (arma::cx_float*)(&equaled_buffer_temp_[(cur_sc_id - base_sc_id) *
-                                                    cfg_->UeAntNum()]);
-      }
+      arma::cx_float* equal_ptr = reinterpret_cast<arma::cx_float*>(
+          EqualPtr(total_data_symbol_idx_ul, base_sc_id, cur_sc_id));
       arma::cx_fmat mat_equaled(equal_ptr, cfg_->UeAntNum(), 1, false);
 
       arma::cx_float* data_ptr = reinterpret_cast<arma::cx_float*>(
@@ -216,6 +221,16 @@ EventData DoDemul::Launch(size_t tag) {
       // size_t start_tsc2 = worker_rdtsc();
       arma::cx_float* ul_beam_ptr = reinterpret_cast<arma::cx_float*>(
           ul_beam_matrices_[frame_slot][cfg_->GetBeamScId(cur_sc_id)]);
+      if (half_precision) {
+        if (half_beam_sc_id != cfg_->GetBeamScId(cur_sc_id)) {
+          half_beam_sc_id = cfg_->GetBeamScId(cur_sc_id);
+          SimdConvertHalfToFloat(
+              reinterpret_cast<const uint16_t*>(ul_beam_ptr),
+              reinterpret_cast<float*>(ul_beam_half_buffer_),
+              2 * cfg_->BsAntNum() * cfg_->UeAntNum());
+        }
+        ul_beam_ptr = reinterpret_cast<arma::cx_float*>(ul_beam_half_buffer_);
+      }
 
       size_t start_tsc2 = GetTime::WorkerRdtsc();
 #if defined(USE_MKL_JIT)
@@ -229,60 +244,34 @@ EventData DoDemul::Launch(size_t tag) {
       mat_equaled = mat_ul_beam * mat_data;
 #endif
 
-      if (symbol_idx_ul <
-          cfg_->Frame().ClientUlPilotSymbols()) {  // Calc new phase shift
-        if (symbol_idx_ul == 0 && cur_sc_id == 0) {
-          // Reset previous frame
-          arma::cx_float* phase_shift_ptr = reinterpret_cast<arma::cx_float*>(
-              ue_spec_pilot_buffer_[(frame_id - 1) % kFrameWnd]);
-          arma::cx_fmat mat_phase_shift(phase_shift_ptr, cfg_->UeAntNum(),
-                                        cfg_->Frame().ClientUlPilotSymbols(),
-                                        false);
-          mat_phase_shift.fill(0);
-        }
-        arma::cx_float* phase_shift_ptr = reinterpret_cast<arma::cx_float*>(
-            &ue_spec_pilot_buffer_[frame_id % kFrameWnd]
-                                  [symbol_idx_ul * cfg_->UeAntNum()]);
-        arma::cx_fmat mat_phase_shift(phase_shift_ptr, cfg_->UeAntNum(), 1,
-                                      false);
-        arma::cx_fmat shift_sc =
-            sign(mat_equaled % conj(ue_pilot_data_.col(cur_sc_id)));
-        mat_phase_shift += shift_sc;
-      }
-      // apply previously calc'ed phase shift to data
-      else if (cfg_->Frame().ClientUlPilotSymbols() > 0) {
-        arma::cx_float* pilot_corr_ptr = reinterpret_cast<arma::cx_float*>(
-            ue_spec_pilot_buffer_[frame_id % kFrameWnd]);
-        arma::cx_fmat pilot_corr_mat(pilot_corr_ptr, cfg_->UeAntNum(),
-                                     cfg_->Frame().ClientUlPilotSymbols(),
-                                     false);
-        arma::fmat theta_mat = arg(pilot_corr_mat);
-        arma::fmat theta_inc = arma::zeros<arma::fmat>(cfg_->UeAntNum(), 1);
-        for (size_t s = 1; s < cfg_->Frame().ClientUlPilotSymbols(); s++) {
-          arma::fmat theta_diff = theta_mat.col(s) - theta_mat.col(s - 1);
-          theta_inc += theta_diff;
-        }
-        theta_inc /= (float)std::max(
-            1, static_cast<int>(cfg_->Frame().ClientUlPilotSymbols() - 1));
-        arma::fmat cur_theta = theta_mat.col(0) + (symbol_idx_ul * theta_inc);
-        arma::cx_fmat mat_phase_correct =
-            arma::zeros<arma::cx_fmat>(size(cur_theta));
-        mat_phase_correct.set_real(cos(-cur_theta));
-        mat_phase_correct.set_imag(sin(-cur_theta));
-        mat_equaled %= mat_phase_correct;
-
-        // Measure EVM from ground truth
-        if (symbol_idx_ul >= cfg_->Frame().ClientUlPilotSymbols()) {
-          phy_stats_->UpdateEvm(frame_id, data_symbol_idx_ul, cur_sc_id,
-                                mat_equaled.col(0));
-        }
-      }
+      PhaseCorrection(frame_id, symbol_idx_ul, data_symbol_idx_ul, cur_sc_id,
+                      mat_equaled);
       size_t start_tsc3 = GetTime::WorkerRdtsc();
       duration_stat_->task_duration_[2] += start_tsc3 - start_tsc2;
       duration_stat_->task_count_++;
     }
   }
 
+  if (batched_gemm) {
+    // Step 2 (batched): equalize every subcarrier of the block with a single
+    // cgemm batch call, then apply the per-subcarrier phase correction
+    size_t start_tsc2 = GetTime::WorkerRdtsc();
+    EqualizeBlockBatched(frame_slot, base_sc_id, max_sc_ite,
+                         EqualPtr(total_data_symbol_idx_ul, base_sc_id,
+                                  base_sc_id));
+    for (size_t i = 0; i < max_sc_ite; i++) {
+      const size_t cur_sc_id = base_sc_id + i;
+      arma::cx_fmat mat_equaled(
+          reinterpret_cast<arma::cx_float*>(
+              EqualPtr(total_data_symbol_idx_ul, base_sc_id, cur_sc_id)),
+          cfg_->UeAntNum(), 1, false);
+      PhaseCorrection(frame_id, symbol_idx_ul, data_symbol_idx_ul, cur_sc_id,
+                      mat_equaled);
+    }
+    duration_stat_->task_duration_[2] += GetTime::WorkerRdtsc() - start_tsc2;
+    duration_stat_->task_count_ += max_sc_ite;
+  }
+
   size_t start_tsc3 = GetTime::WorkerRdtsc();
   __m256i index2 =
       _mm256_setr_epi32(0, 1, cfg_->UeAntNum() * 2, cfg_->UeAntNum() * 2 + 1,
@@ -347,26 +336,17 @@ EventData DoDemul::Launch(size_t tag) {
         kUplinkHardDemod) &&
         (symbol_idx_ul >= cfg_->Frame().ClientUlPilotSymbols())) {
       phy_stats_->UpdateDecodedBits(
-          ue_id, total_data_symbol_idx_ul, frame_slot,
+          tid_, ue_id, frame_slot,
           max_sc_ite * cfg_->ModOrderBits(Direction::kUplink));
       // Each block here is max_sc_ite
-      phy_stats_->IncrementDecodedBlocks(ue_id, total_data_symbol_idx_ul,
-                                         frame_slot);
-      size_t block_error(0);
+      phy_stats_->IncrementDecodedBlocks(tid_, ue_id, frame_slot);
       int8_t* tx_bytes =
           cfg_->GetModBitsBuf(cfg_->UlModBits(), Direction::kUplink, 0,
                               symbol_idx_ul, ue_id, base_sc_id);
-      for (size_t i = 0; i < max_sc_ite; i++) {
-        uint8_t rx_byte = static_cast<uint8_t>(demod_ptr[i]);
-        uint8_t tx_byte = static_cast<uint8_t>(tx_bytes[i]);
-        phy_stats_->UpdateBitErrors(ue_id, total_data_symbol_idx_ul, frame_slot,
-                                    tx_byte, rx_byte);
-        if (rx_byte != tx_byte) {
-          block_error++;
-        }
-      }
-      phy_stats_->UpdateBlockErrors(ue_id, total_data_symbol_idx_ul, frame_slot,
-                                    block_error);
+      phy_stats_->UpdateBlockBitErrors(
+          tid_, ue_id, frame_slot,
+          reinterpret_cast<const uint8_t*>(tx_bytes),
+          reinterpret_cast<const uint8_t*>(demod_ptr), max_sc_ite);
     }
 
     // std::printf("In doDemul thread %d: frame: %d, symbol: %d, sc_id: %d \n",
@@ -378,7 +358,169 @@ EventData DoDemul::Launch(size_t tag) {
     // cout << endl;
   }
 
+  scratch_stat_->EndTask(Arena());
   duration_stat_->task_duration_[3] += GetTime::WorkerRdtsc() - start_tsc3;
   duration_stat_->task_duration_[0] += GetTime::WorkerRdtsc() - start_tsc;
   return EventData(EventType::kDemul, tag);
 }
+
+complex_float* DoDemul::EqualPtr(size_t total_data_symbol_idx_ul,
+                                 size_t base_sc_id, size_t sc_id) {
+  if (kExportConstellation) {
+    return &equal_buffer_[total_data_symbol_idx_ul][sc_id * cfg_->UeAntNum()];
+  }
+  return &equaled_buffer_temp_[(sc_id - base_sc_id) * cfg_->UeAntNum()];
+}
+
+void DoDemul::PhaseCorrection(size_t frame_id, size_t symbol_idx_ul,
+                              size_t data_symbol_idx_ul, size_t sc_id,
+                              arma::cx_fmat& mat_equaled) {
+  if (symbol_idx_ul <
+      cfg_->Frame().ClientUlPilotSymbols()) {  // Calc new phase shift
+    if (symbol_idx_ul == 0 && sc_id == 0) {
+      // Reset previous frame
+      arma::cx_float* phase_shift_ptr = reinterpret_cast<arma::cx_float*>(
+          ue_spec_pilot_buffer_[cfg_->FrameSlot(frame_id - 1)]);
+      arma::cx_fmat mat_phase_shift(phase_shift_ptr, cfg_->UeAntNum(),
+                                    cfg_->Frame().ClientUlPilotSymbols(),
+                                    false);
+      mat_phase_shift.fill(0);
+    }
+    arma::cx_float* phase_shift_ptr = reinterpret_cast<arma::cx_float*>(
+        &ue_spec_pilot_buffer_[cfg_->FrameSlot(frame_id)]
+                              [symbol_idx_ul * cfg_->UeAntNum()]);
+    arma::cx_fmat mat_phase_shift(phase_shift_ptr, cfg_->UeAntNum(), 1, false);
+    mat_phase_shift += sign(mat_equaled % conj(ue_pilot_data_.col(sc_id)));
+  }
+  // apply previously calc'ed phase shift to data
+  else if (cfg_->Frame().ClientUlPilotSymbols() > 0) {
+    arma::cx_float* pilot_corr_ptr = reinterpret_cast<arma::cx_float*>(
+        ue_spec_pilot_buffer_[cfg_->FrameSlot(frame_id)]);
+    arma::cx_fmat pilot_corr_mat(pilot_corr_ptr, cfg_->UeAntNum(),
+                                 cfg_->Frame().ClientUlPilotSymbols(), false);
+    // Scratch matrices come from the worker's arena, reset after the task
+    MemoryArena& arena = Arena();
+    const size_t num_ue = cfg_->UeAntNum();
+    const size_t num_pilots = cfg_->Frame().ClientUlPilotSymbols();
+    arma::fmat theta_mat(arena.Alloc<float>(num_ue * num_pilots), num_ue,
+                         num_pilots, false, false);
+    theta_mat = arg(pilot_corr_mat);
+    arma::fmat theta_inc(arena.Alloc<float>(num_ue), num_ue, 1, false, false);
+    theta_inc.zeros();
+    for (size_t s = 1; s < num_pilots; s++) {
+      theta_inc += theta_mat.col(s) - theta_mat.col(s - 1);
+    }
+    theta_inc /= (float)std::max(1, static_cast<int>(num_pilots - 1));
+    for (size_t i = 0; i < num_ue; i++) {
+      const float cur_theta =
+          theta_mat(i, 0) + (static_cast<float>(symbol_idx_ul) * theta_inc(i));
+      mat_equaled(i) *= std::polar(1.0f, -cur_theta);
+    }
+
+    // Measure EVM from ground truth
+    if (symbol_idx_ul >= cfg_->Frame().ClientUlPilotSymbols()) {
+      phy_stats_->UpdateEvm(tid_, frame_id, data_symbol_idx_ul, sc_id,
+                            mat_equaled.col(0));
+    }
+  }
+}
+
+void DoDemul::EqualizeBlockBatched(size_t frame_slot, size_t base_sc_id,
+                                   size_t num_sc, complex_float* equal_ptr) {
+  const MKL_INT m = cfg_->UeAntNum();
+  const MKL_INT k = cfg_->BsAntNum();
+  const MKL_Complex8 alpha = {1, 0};
+  const MKL_Complex8 beta = {0, 0};
+
+  if (cfg_->FreqOrthogonalPilot() == false) {
+    // Every subcarrier has its own beam matrix, and these are laid out with a
+    // constant stride in the PtrGrid backing buffer
+    const complex_float* ul_beam_ptr =
+        ul_beam_matrices_[frame_slot][base_sc_id];
+    const MKL_INT beam_stride =
+        (num_sc > 1) ? static_cast<MKL_INT>(
+                           ul_beam_matrices_[frame_slot][base_sc_id + 1] -
+                           ul_beam_ptr)
+                     : 0;
+    cblas_cgemm_batch_strided(CblasColMajor, CblasNoTrans, CblasNoTrans, m, 1,
+                              k, &alpha, ul_beam_ptr, m, beam_stride,
+                              data_gather_buffer_, k, k, &beta, equal_ptr, m, m,
+                              num_sc);
+  } else {
+    // Subcarriers share beam matrices (e.g., frequency-orthogonal pilots), so
+    // fall back to the pointer-array interface
+    for (size_t i = 0; i < num_sc; i++) {
+      batch_beam_ptrs_[i] =
+          ul_beam_matrices_[frame_slot][cfg_->GetBeamScId(base_sc_id + i)];
+      batch_data_ptrs_[i] = data_gather_buffer_ + (i * k);
+      batch_equal_ptrs_[i] = equal_ptr + (i * m);
+    }
+    const CBLAS_TRANSPOSE trans = CblasNoTrans;
+    const MKL_INT n = 1;
+    const auto group_size = static_cast<MKL_INT>(num_sc);
+    cblas_cgemm_batch(CblasColMajor, &trans, &trans, &m, &n, &k, &alpha,
+                      batch_beam_ptrs_.data(), &m, batch_data_ptrs_.data(), &k,
+                      &beta, batch_equal_ptrs_.data(), &m, 1, &group_size);
+  }
+}
+
+void DoDemul::PrefetchScGroup(const complex_float* data_buf,
+                              size_t frame_slot, size_t sc_id,
+                              bool prefetch_beams) {
+  // Half precision samples and beam matrices take half the bytes
+  const size_t elem_bytes = cfg_->HalfPrecisionStorage()
+                                ? sizeof(complex_float) / 2
+                                : sizeof(complex_float);
+  const auto* data_bytes = reinterpret_cast<const char*>(data_buf);
+  const size_t sc_offset = Agora_transpose::Offset(
+      transpose_block_size_, cfg_->BsAntNum(), sc_id, 0);
+  for (size_t ant = 0; ant < cfg_->BsAntNum(); ant++) {
+    const size_t src_idx =
+        partial_transpose_ ? sc_offset + (ant * transpose_block_size_)
+                           : (ant * cfg_->OfdmDataNum()) + sc_id;
+    Agora_memory::Prefetch(data_bytes + (src_idx * elem_bytes),
+                           kSCsPerCacheline * elem_bytes);
+  }
+  if (prefetch_beams == false) {
+    return;
+  }
+
+  const size_t beam_bytes = cfg_->UeAntNum() * cfg_->BsAntNum() * elem_bytes;
+  size_t last_beam_sc_id = SIZE_MAX;
+  for (size_t j = 0; j < kSCsPerCacheline; j++) {
+    // Subcarriers of a pilot group share one beam matrix
+    const size_t beam_sc_id = cfg_->GetBeamScId(sc_id + j);
+    if (beam_sc_id != last_beam_sc_id) {
+      Agora_memory::Prefetch(ul_beam_matrices_[frame_slot][beam_sc_id],
+                             beam_bytes);
+      last_beam_sc_id = beam_sc_id;
+    }
+  }
+}
+
+void DoDemul::EqualizeScFixedPoint(size_t frame_slot,
+                                   size_t total_data_symbol_idx_ul,
+                                   size_t sc_id, int data_exp,
+                                   complex_float* equal_ptr) {
+  const short* data_buf = data_buffer_fixed_[total_data_symbol_idx_ul];
+  const size_t sc_offset = Agora_transpose::Offset(
+      transpose_block_size_, cfg_->BsAntNum(), sc_id, 0);
+  for (size_t ant = 0; ant < cfg_->BsAntNum(); ant++) {
+    const size_t src_idx =
+        partial_transpose_ ? sc_offset + (ant * transpose_block_size_)
+                           : (ant * cfg_->OfdmDataNum()) + sc_id;
+    data_gather_buffer_fixed_[2 * ant] = static_cast<short>(
+        data_buf[2 * src_idx] >> fixed_point_shifts_[ant]);
+    data_gather_buffer_fixed_[2 * ant + 1] = static_cast<short>(
+        data_buf[2 * src_idx + 1] >> fixed_point_shifts_[ant]);
+  }
+
+  const size_t beam_sc_id = cfg_->GetBeamScId(sc_id);
+  const float scale =
+      std::ldexp(1.0f, data_exp + ul_beam_exp_buffer_[frame_slot][beam_sc_id] -
+                           kFixedPointDataFracBits - kFixedPointBeamFracBits);
+  FixedPointEqualize(ul_beam_matrices_fixed_[frame_slot][beam_sc_id],
+                     data_gather_buffer_fixed_, cfg_->UeAntNum(),
+                     cfg_->BsAntNum(), scale,
+                     reinterpret_cast<float*>(equal_ptr));
+}
@@ -5,13 +5,17 @@
 #ifndef DODEMUL_H_
 #define DODEMUL_H_
 
+#include <vector>
+
 #include "armadillo"
 #include "common_typedef_sdk.h"
 #include "concurrentqueue.h"
 #include "config.h"
 #include "doer.h"
+#include "frame_block_sizes.h"
 #include "memory_manage.h"
 #include "mkl_dfti.h"
+#include "partial_transpose.h"
 #include "phy_stats.h"
 #include "stats.h"
 #include "symbols.h"
@@ -19,11 +23,15 @@
 class DoDemul : public Doer {
  public:
   DoDemul(Config* config, int tid, Table<complex_float>& data_buffer,
-          PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& ul_beam_matrices,
+          PtrGrid<complex_float>& ul_beam_matrices,
+          Table<short>& data_buffer_fixed, Table<int8_t>& data_exp_buffer,
+          PtrGrid<short>& ul_beam_matrices_fixed,
+          Table<int8_t>& ul_beam_exp_buffer,
           Table<complex_float>& ue_spec_pilot_buffer,
           Table<complex_float>& equal_buffer,
-          PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& demod_buffers_,
-          PhyStats* in_phy_stats, Stats* in_stats_manager);
+          PtrCube<int8_t>& demod_buffers_,
+          const FrameBlockSizes& block_sizes, PhyStats* in_phy_stats,
+          Stats* in_stats_manager);
   ~DoDemul() override;
 
   /**
@@ -55,24 +63,76 @@ class DoDemul : public Doer {
   EventData Launch(size_t tag) override;
 
  private:
+  /// Location of the equalized data of subcarrier [sc_id] in the block
+  /// starting at [base_sc_id]
+  complex_float* EqualPtr(size_t total_data_symbol_idx_ul, size_t base_sc_id,
+                          size_t sc_id);
+
+  /// Track the UE phase shift on pilot symbols and correct it on data symbols
+  void PhaseCorrection(size_t frame_id, size_t symbol_idx_ul,
+                       size_t data_symbol_idx_ul, size_t sc_id,
+                       arma::cx_fmat& mat_equaled);
+
+  /// Prefetch the input samples of the kSCsPerCacheline subcarriers starting
+  /// at [sc_id] and, if [prefetch_beams], their beam matrices
+  void PrefetchScGroup(const complex_float* data_buf, size_t frame_slot,
+                       size_t sc_id, bool prefetch_beams);
+
+  /// Gather the int16 samples of one subcarrier, aligned to the largest
+  /// antenna exponent, and equalize them with integer complex MACs
+  void EqualizeScFixedPoint(size_t frame_slot,
+                            size_t total_data_symbol_idx_ul, size_t sc_id,
+                            int data_exp, complex_float* equal_ptr);
+
+  /// Equalize [num_sc] gathered subcarriers with one batched cgemm call
+  void EqualizeBlockBatched(size_t frame_slot, size_t base_sc_id,
+                            size_t num_sc, complex_float* equal_ptr);
+
   Table<complex_float>& data_buffer_;
-  PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& ul_beam_matrices_;
+  PtrGrid<complex_float>& ul_beam_matrices_;
+  Table<short>& data_buffer_fixed_;
+  Table<int8_t>& data_exp_buffer_;
+  PtrGrid<short>& ul_beam_matrices_fixed_;
+  Table<int8_t>& ul_beam_exp_buffer_;
   Table<complex_float>& ue_spec_pilot_buffer_;
   Table<complex_float>& equal_buffer_;
-  PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& demod_buffers_;
+  PtrCube<int8_t>& demod_buffers_;
+  // Demul block size of each frame
+  const FrameBlockSizes& block_sizes_;
   DurationStat* duration_stat_;
+  ScratchAllocStat* scratch_stat_;
   PhyStats* phy_stats_;
 
+  /// Layout and partial transpose block size of data_buffer_ and the gather
+  /// kernel specialized for it
+  bool partial_transpose_;
+  size_t transpose_block_size_;
+  Agora_transpose::GatherScFn gather_sc_;
+
   /// Intermediate buffer to gather raw data. Size = subcarriers per cacheline
   /// times number of antennas
   complex_float* data_gather_buffer_;
 
+  /// int16 gather buffer and per-antenna alignment shifts for the fixed-point
+  /// path
+  short* data_gather_buffer_fixed_;
+  std::vector<uint8_t> fixed_point_shifts_;
+
+  /// float32 copy of the current float16 beam matrix with half precision
+  /// storage
+  complex_float* ul_beam_half_buffer_;
+
   // Intermediate buffers for equalized data
   complex_float* equaled_buffer_temp_;
   complex_float* equaled_buffer_temp_transposed_;
   arma::cx_fmat ue_pilot_data_;
   int ue_num_simd256_;
 
+  // Per-subcarrier matrix pointers for the batched cgemm path
+  std::vector<const void*> batch_beam_ptrs_;
+  std::vector<const void*> batch_data_ptrs_;
+  std::vector<void*> batch_equal_ptrs_;
+
 #if defined(USE_MKL_JIT)
   void* jitter_;
   cgemm_jit_kernel_t mkl_jit_cgemm_;
@@ -24,42 +24,100 @@ DoEncode::DoEncode(Config* in_config, int in_tid, Direction dir,
       mod_bits_buffer_(in_mod_bits_buffer),
       scrambler_(std::make_unique<AgoraScrambler::Scrambler>()) {
   duration_stat_ = in_stats_manager->GetDurationStat(DoerType::kEncode, in_tid);
-  parity_buffer_ = static_cast<int8_t*>(Agora_memory::PaddedAlignedAlloc(
-      Agora_memory::Alignment_t::kAlign64,
-      LdpcEncodingParityBufSize(cfg_->LdpcConfig(dir).BaseGraph(),
-                                cfg_->LdpcConfig(dir).ExpansionFactor())));
-  assert(parity_buffer_ != nullptr);
-  encoded_buffer_temp_ = static_cast<int8_t*>(Agora_memory::PaddedAlignedAlloc(
-      Agora_memory::Alignment_t::kAlign64,
-      LdpcEncodingEncodedBufSize(cfg_->LdpcConfig(dir).BaseGraph(),
-                                 cfg_->LdpcConfig(dir).ExpansionFactor())));
-  assert(encoded_buffer_temp_ != nullptr);
-
   const size_t scrambler_buffer_bytes =
       cfg_->NumBytesPerCb(dir) + cfg_->NumPaddingBytesPerCb(dir);
 
-  scrambler_buffer_ = static_cast<int8_t*>(Agora_memory::PaddedAlignedAlloc(
-      Agora_memory::Alignment_t::kAlign64, scrambler_buffer_bytes));
-  std::memset(scrambler_buffer_, 0u, scrambler_buffer_bytes);
-
-  assert(scrambler_buffer_ != nullptr);
+  // One set of intermediate buffers per codeblock of a batch
+  const size_t batch_size = cfg_->EncodeBlockSize();
+  parity_buffer_.resize(batch_size);
+  encoded_buffer_temp_.resize(batch_size);
+  scrambler_buffer_.resize(batch_size);
+  ldpc_input_.resize(batch_size);
+  for (size_t i = 0; i < batch_size; i++) {
+    parity_buffer_.at(i) =
+        static_cast<int8_t*>(Agora_memory::PaddedAlignedAlloc(
+            Agora_memory::Alignment_t::kAlign64,
+            LdpcEncodingParityBufSize(
+                cfg_->LdpcConfig(dir).BaseGraph(),
+                cfg_->LdpcConfig(dir).ExpansionFactor())));
+    assert(parity_buffer_.at(i) != nullptr);
+    encoded_buffer_temp_.at(i) =
+        static_cast<int8_t*>(Agora_memory::PaddedAlignedAlloc(
+            Agora_memory::Alignment_t::kAlign64,
+            LdpcEncodingEncodedBufSize(
+                cfg_->LdpcConfig(dir).BaseGraph(),
+                cfg_->LdpcConfig(dir).ExpansionFactor())));
+    assert(encoded_buffer_temp_.at(i) != nullptr);
+
+    scrambler_buffer_.at(i) =
+        static_cast<int8_t*>(Agora_memory::PaddedAlignedAlloc(
+            Agora_memory::Alignment_t::kAlign64, scrambler_buffer_bytes));
+    assert(scrambler_buffer_.at(i) != nullptr);
+    std::memset(scrambler_buffer_.at(i), 0u, scrambler_buffer_bytes);
+  }
 }
 
 DoEncode::~DoEncode() {
-  std::free(parity_buffer_);
-  std::free(encoded_buffer_temp_);
-  std::free(scrambler_buffer_);
+  for (size_t i = 0; i < parity_buffer_.size(); i++) {
+    std::free(parity_buffer_.at(i));
+    std::free(encoded_buffer_temp_.at(i));
+    std::free(scrambler_buffer_.at(i));
+  }
+}
+
+bool DoEncode::TryLaunch(
+    moodycamel::ConcurrentQueue<EventData>& task_queue,
+    moodycamel::ConcurrentQueue<EventData>& complete_task_queue,
+    moodycamel::ProducerToken* worker_ptok) {
+  EventData req_event;
+  if (task_queue.try_dequeue(req_event)) {
+    RtAssert(req_event.event_type_ == EventType::kEncode,
+             "Invalid event type for DoEncode");
+    // The response carries the same codeblock tags as the request
+    LaunchBatch(req_event.tags_.data(), req_event.num_tags_);
+    TryEnqueueFallback(&complete_task_queue, worker_ptok, req_event);
+    return true;
+  }
+  return false;
 }
 
 EventData DoEncode::Launch(size_t tag) {
+  LaunchBatch(&tag, 1);
+  return EventData(EventType::kEncode, tag);
+}
+
+void DoEncode::LaunchBatch(const size_t* tags, size_t num_tags) {
+  RtAssert(num_tags <= parity_buffer_.size(),
+           "DoEncode: more codeblocks than encode_block_size");
   const LDPCconfig& ldpc_config = cfg_->LdpcConfig(dir_);
+  size_t start_tsc = GetTime::WorkerRdtsc();
+
+  for (size_t i = 0; i < num_tags; i++) {
+    ldpc_input_.at(i) = PrepareInput(tags[i], i);
+  }
+  LdpcEncodeBatchHelper(ldpc_config.BaseGraph(),
+                        ldpc_config.ExpansionFactor(), ldpc_config.NumRows(),
+                        encoded_buffer_temp_.data(), parity_buffer_.data(),
+                        ldpc_input_.data(), num_tags);
+  for (size_t i = 0; i < num_tags; i++) {
+    StoreEncoded(tags[i], i);
+  }
+
+  const size_t duration = GetTime::WorkerRdtsc() - start_tsc;
+  duration_stat_->task_duration_[0] += duration;
+  duration_stat_->task_count_ += num_tags;
+  if (GetTime::CyclesToUs(duration, cfg_->FreqGhz()) > 500) {
+    std::printf("Thread %d Encode takes %.2f\n", tid_,
+                GetTime::CyclesToUs(duration, cfg_->FreqGhz()));
+  }
+}
+
+int8_t* DoEncode::PrepareInput(size_t tag, size_t slot) {
   size_t frame_id = gen_tag_t(tag).frame_id_;
   size_t symbol_id = gen_tag_t(tag).symbol_id_;
   size_t cb_id = gen_tag_t(tag).cb_id_;
-  size_t cur_cb_id = cb_id % ldpc_config.NumBlocksInSymbol();
-  size_t ue_id = cb_id / ldpc_config.NumBlocksInSymbol();
-
-  size_t start_tsc = GetTime::WorkerRdtsc();
+  size_t cur_cb_id = cb_id % cfg_->LdpcConfig(dir_).NumBlocksInSymbol();
+  size_t ue_id = cb_id / cfg_->LdpcConfig(dir_).NumBlocksInSymbol();
 
   size_t symbol_idx;
   size_t symbol_idx_data;
@@ -114,8 +172,9 @@ EventData DoEncode::Launch(size_t tag) {
   const size_t num_padding_bytes_per_cb = cfg_->NumPaddingBytesPerCb(dir_);
 
   if (this->cfg_->ScrambleEnabled()) {
-    scrambler_->Scramble(scrambler_buffer_, ldpc_input, num_bytes_per_cb);
-    ldpc_input = scrambler_buffer_;
+    scrambler_->Scramble(scrambler_buffer_.at(slot), ldpc_input,
+                         num_bytes_per_cb);
+    ldpc_input = scrambler_buffer_.at(slot);
   }
   if (num_padding_bytes_per_cb > 0) {
     std::memset(&ldpc_input[num_bytes_per_cb], 0u, num_padding_bytes_per_cb);
@@ -133,16 +192,28 @@ EventData DoEncode::Launch(size_t tag) {
                    ue_id, dataprint.str().c_str());
   }
 
-  LdpcEncodeHelper(ldpc_config.BaseGraph(), ldpc_config.ExpansionFactor(),
-                   ldpc_config.NumRows(), encoded_buffer_temp_, parity_buffer_,
-                   ldpc_input);
+  return ldpc_input;
+}
+
+void DoEncode::StoreEncoded(size_t tag, size_t slot) {
+  const LDPCconfig& ldpc_config = cfg_->LdpcConfig(dir_);
+  size_t frame_id = gen_tag_t(tag).frame_id_;
+  size_t symbol_id = gen_tag_t(tag).symbol_id_;
+  size_t cb_id = gen_tag_t(tag).cb_id_;
+  size_t cur_cb_id = cb_id % ldpc_config.NumBlocksInSymbol();
+  size_t ue_id = cb_id / ldpc_config.NumBlocksInSymbol();
+  const size_t symbol_idx = (dir_ == Direction::kDownlink)
+                                ? cfg_->Frame().GetDLSymbolIdx(symbol_id)
+                                : cfg_->Frame().GetULSymbolIdx(symbol_id);
+  int8_t* encoded_buffer_temp = encoded_buffer_temp_.at(slot);
+
   if (kDebugTxData) {
     std::stringstream dataprint;
     dataprint << std::setfill('0') << std::hex;
     for (size_t i = 0; i < BitsToBytes(ldpc_config.NumCbCodewLen()); i++) {
       dataprint << " " << std::setw(2)
                 << std::to_integer<int>(
-                       reinterpret_cast<std::byte*>(encoded_buffer_temp_)[i]);
+                       reinterpret_cast<std::byte*>(encoded_buffer_temp)[i]);
     }
     AGORA_LOG_INFO("ldpc output (%zu %zu %zu): %s\n", frame_id, symbol_idx,
                    ue_id, dataprint.str().c_str());
@@ -155,7 +226,7 @@ EventData DoEncode::Launch(size_t tag) {
                 frame_id, symbol_idx, ue_id,
                 reinterpret_cast<intptr_t>(mod_buffer_ptr));
   }
-  AdaptBitsForMod(reinterpret_cast<uint8_t*>(encoded_buffer_temp_),
+  AdaptBitsForMod(reinterpret_cast<uint8_t*>(encoded_buffer_temp),
                   reinterpret_cast<uint8_t*>(mod_buffer_ptr),
                   BitsToBytes(ldpc_config.NumCbCodewLen()),
                   cfg_->ModOrderBits(dir_));
@@ -168,13 +239,4 @@ EventData DoEncode::Launch(size_t tag) {
     }
     std::printf("\n");
   }
-
-  const size_t duration = GetTime::WorkerRdtsc() - start_tsc;
-  duration_stat_->task_duration_[0] += duration;
-  duration_stat_->task_count_++;
-  if (GetTime::CyclesToUs(duration, cfg_->FreqGhz()) > 500) {
-    std::printf("Thread %d Encode takes %.2f\n", tid_,
-                GetTime::CyclesToUs(duration, cfg_->FreqGhz()));
-  }
-  return EventData(EventType::kEncode, tag);
 }
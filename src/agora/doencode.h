@@ -9,6 +9,7 @@
 
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 #include "config.h"
 #include "doer.h"
@@ -24,9 +25,24 @@ class DoEncode : public Doer {
            Table<int8_t>& in_mod_bits_buffer, Stats* in_stats_manager);
   ~DoEncode() override;
 
+  /// Encode all codeblock tags of one kEncode event with a single batched
+  /// encoder call
+  bool TryLaunch(moodycamel::ConcurrentQueue<EventData>& task_queue,
+                 moodycamel::ConcurrentQueue<EventData>& complete_task_queue,
+                 moodycamel::ProducerToken* worker_ptok) override;
+
   EventData Launch(size_t tag) override;
 
+  /// Encode the codeblocks of up to EncodeBlockSize() tags together
+  void LaunchBatch(const size_t* tags, size_t num_tags);
+
  private:
+  // Return the (scrambled, padded) LDPC input of a codeblock, using the
+  // intermediate buffers of batch slot [slot]
+  int8_t* PrepareInput(size_t tag, size_t slot);
+  // Copy the encoded codeblock of batch slot [slot] to mod_bits_buffer_
+  void StoreEncoded(size_t tag, size_t slot);
+
   Direction dir_;
 
   // References to buffers allocated pre-construction
@@ -34,14 +50,17 @@ class DoEncode : public Doer {
   size_t raw_buffer_rollover_;
   Table<int8_t>& mod_bits_buffer_;
 
-  // Intermediate buffer to hold LDPC encoding parity
-  int8_t* parity_buffer_;
+  // Intermediate buffers to hold LDPC encoding parity, one per batch slot
+  std::vector<int8_t*> parity_buffer_;
+
+  // Intermediate buffers to hold LDPC encoding output
+  std::vector<int8_t*> encoded_buffer_temp_;
 
-  // Intermediate buffer to hold LDPC encoding output
-  int8_t* encoded_buffer_temp_;
+  // Intermediate buffers to hold pre/post scrambled data
+  std::vector<int8_t*> scrambler_buffer_;
 
-  // Intermediate buffer to hold pre/post scrambled data
-  int8_t* scrambler_buffer_;
+  // LDPC input of each batch slot
+  std::vector<const int8_t*> ldpc_input_;
 
   DurationStat* duration_stat_;
   std::unique_ptr<AgoraScrambler::Scrambler> scrambler_;
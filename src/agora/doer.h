@@ -11,6 +11,7 @@
 #include "concurrent_queue_wrapper.h"
 #include "concurrentqueue.h"
 #include "config.h"
+#include "memory_arena.h"
 #include "message.h"
 #include "utils.h"
 
@@ -64,6 +65,10 @@ class Doer {
   Doer(Config* in_config, int in_tid) : cfg_(in_config), tid_(in_tid) {}
   virtual ~Doer() = default;
 
+  /// Scratch memory of the calling worker thread, shared by its Doers.
+  /// Doers reset it at their task boundaries.
+  static MemoryArena& Arena() { return MemoryArena::ThreadLocal(); }
+
   Config* cfg_;
   int tid_;  // Thread ID of this Doer
 };
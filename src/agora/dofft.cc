@@ -7,6 +7,7 @@
 #include "comms-lib.h"
 #include "concurrent_queue_wrapper.h"
 #include "datatype_conversion.h"
+#include "fixed_point.h"
 #include "logger.h"
 
 static constexpr bool kPrintFFTInput = false;
@@ -14,18 +15,23 @@ static constexpr bool kPrintInputPilot = false;
 static constexpr bool kPrintPilotCorrStats = false;
 
 DoFFT::DoFFT(Config* config, size_t tid, Table<complex_float>& data_buffer,
-             PtrGrid<kFrameWnd, kMaxUEs, complex_float>& csi_buffers,
+             Table<short>& data_buffer_fixed, Table<int8_t>& data_exp_buffer,
+             PtrGrid<complex_float>& csi_buffers,
              Table<complex_float>& calib_dl_buffer,
              Table<complex_float>& calib_ul_buffer, PhyStats* in_phy_stats,
              Stats* stats_manager)
     : Doer(config, tid),
       data_buffer_(data_buffer),
+      data_buffer_fixed_(data_buffer_fixed),
+      data_exp_buffer_(data_exp_buffer),
       csi_buffers_(csi_buffers),
       calib_dl_buffer_(calib_dl_buffer),
       calib_ul_buffer_(calib_ul_buffer),
       phy_stats_(in_phy_stats) {
   duration_stat_fft_ = stats_manager->GetDurationStat(DoerType::kFFT, tid);
   duration_stat_csi_ = stats_manager->GetDurationStat(DoerType::kCSI, tid);
+  partial_transpose_ = cfg_->PartialTranspose();
+  transpose_block_size_ = cfg_->TransposeBlockSize();
   DftiCreateDescriptor(&mkl_handle_, DFTI_SINGLE, DFTI_COMPLEX, 1,
                        cfg_->OfdmCaNum());
   DftiCommitDescriptor(mkl_handle_);
@@ -90,7 +96,7 @@ EventData DoFFT::Launch(size_t tag) {
   const size_t start_tsc = GetTime::WorkerRdtsc();
   Packet* pkt = fft_req_tag_t(tag).rx_packet_->RawPacket();
   const size_t frame_id = pkt->frame_id_;
-  const size_t frame_slot = frame_id % kFrameWnd;
+  const size_t frame_slot = cfg_->FrameSlot(frame_id);
   const size_t symbol_id = pkt->symbol_id_;
   const size_t ant_id = pkt->ant_id_;
   const size_t radio_id = ant_id / cfg_->NumChannels();
@@ -213,32 +219,61 @@ EventData DoFFT::Launch(size_t tag) {
                      SymbolType::kPilot);
 
     // Expand partial CSI from freq-orth pilot to full CSI per UE
-    // TODO 1. allow pilot sc group size different than kTransposeBlockSize
+    // TODO 1. allow pilot sc group size different than the transpose block
     // TODO 2. potential use of multiple pilot symbols
     // TODO 3. interpolation of CSI in gap subcarriers
     if (cfg_->FreqOrthogonalPilot() &&
         pilot_symbol_id == cfg_->Frame().NumPilotSyms() - 1) {
-      const size_t num_blocks = cfg_->OfdmDataNum() / kTransposeBlockSize;
+      const size_t num_blocks = cfg_->OfdmDataNum() / transpose_block_size_;
       for (size_t block_idx = 0; block_idx < num_blocks; block_idx++) {
         const size_t block_base_offset =
-            block_idx * (kTransposeBlockSize * cfg_->BsAntNum());
+            block_idx * (transpose_block_size_ * cfg_->BsAntNum());
         const size_t block_offset =
-            kUsePartialTrans
-                ? block_base_offset + (ant_id * kTransposeBlockSize)
+            partial_transpose_
+                ? block_base_offset + (ant_id * transpose_block_size_)
                 : (cfg_->OfdmDataNum() * ant_id) +
-                      (block_idx * kTransposeBlockSize);
+                      (block_idx * transpose_block_size_);
+        if (cfg_->HalfPrecisionStorage()) {
+          // A complex float16 value is a single 32-bit word
+          const auto* src =
+              reinterpret_cast<uint32_t*>(csi_buffers_[frame_slot][0]) +
+              block_offset;
+          for (ssize_t ue_id = cfg_->UeAntNum() - 1; ue_id >= 0; ue_id--) {
+            auto* dst =
+                reinterpret_cast<uint32_t*>(csi_buffers_[frame_slot][ue_id]) +
+                block_offset;
+            for (size_t sc_idx = 0; sc_idx < transpose_block_size_;
+                 sc_idx++) {
+              dst[sc_idx] = src[ue_id];
+            }
+          }
+          continue;
+        }
         complex_float* src = &csi_buffers_[frame_slot][0][block_offset];
         for (ssize_t ue_id = cfg_->UeAntNum() - 1; ue_id >= 0; ue_id--) {
           complex_float* dst = &csi_buffers_[frame_slot][ue_id][block_offset];
-          for (size_t sc_idx = 0; sc_idx < kTransposeBlockSize; sc_idx++) {
+          for (size_t sc_idx = 0; sc_idx < transpose_block_size_; sc_idx++) {
             dst[sc_idx] = src[ue_id];
           }
         }
       }
     }
   } else if (sym_type == SymbolType::kUL) {
-    PartialTranspose(cfg_->GetDataBuf(data_buffer_, frame_id, symbol_id),
-                     ant_id, SymbolType::kUL);
+    if (cfg_->UlFixedPoint()) {
+      const size_t total_data_symbol_idx_ul = cfg_->GetTotalDataSymbolIdxUl(
+          frame_id, cfg_->Frame().GetULSymbolIdx(symbol_id));
+      data_exp_buffer_[total_data_symbol_idx_ul][ant_id] =
+          PartialTransposeFixed(data_buffer_fixed_[total_data_symbol_idx_ul],
+                                ant_id);
+    } else {
+      PartialTranspose(cfg_->GetDataBuf(data_buffer_, frame_id, symbol_id),
+                       ant_id, SymbolType::kUL);
+      if (kCollectPhyStats && cfg_->HalfPrecisionStorage()) {
+        phy_stats_->UpdateHalfPrecisionDataError(
+            frame_id, cfg_->Frame().GetULSymbolIdx(symbol_id), ant_id,
+            fft_inout_);
+      }
+    }
   } else if (sym_type == SymbolType::kCalUL) {
     // Only process uplink for antennas that also do downlink in this frame
     // for consistency with calib downlink processing.
@@ -298,16 +333,20 @@ EventData DoFFT::Launch(size_t tag) {
 
 void DoFFT::PartialTranspose(complex_float* out_buf, size_t ant_id,
                              SymbolType symbol_type) const {
-  // We have OfdmDataNum() % kTransposeBlockSize == 0
-  const size_t num_sc_blocks = cfg_->OfdmDataNum() / kTransposeBlockSize;
+  // We have OfdmDataNum() % transpose_block_size_ == 0
+  const size_t num_sc_blocks = cfg_->OfdmDataNum() / transpose_block_size_;
+  // Calibration buffers always stay in float32
+  const bool half_precision = cfg_->HalfPrecisionStorage() &&
+                              (symbol_type != SymbolType::kCalDL) &&
+                              (symbol_type != SymbolType::kCalUL);
 
   for (size_t sc_block_idx = 0; sc_block_idx < num_sc_blocks; sc_block_idx++) {
     const size_t sc_block_base_offset =
-        sc_block_idx * (kTransposeBlockSize * cfg_->BsAntNum());
-    // We have kTransposeBlockSize % kSCsPerCacheline == 0
-    for (size_t sc_j = 0; sc_j < kTransposeBlockSize;
+        sc_block_idx * (transpose_block_size_ * cfg_->BsAntNum());
+    // We have transpose_block_size_ % kSCsPerCacheline == 0
+    for (size_t sc_j = 0; sc_j < transpose_block_size_;
          sc_j += kSCsPerCacheline) {
-      const size_t sc_idx = (sc_block_idx * kTransposeBlockSize) + sc_j;
+      const size_t sc_idx = (sc_block_idx * transpose_block_size_) + sc_j;
       const complex_float* src = &fft_inout_[sc_idx + cfg_->OfdmDataStart()];
 
       complex_float* dst = nullptr;
@@ -315,11 +354,11 @@ void DoFFT::PartialTranspose(complex_float* out_buf, size_t ant_id,
           (symbol_type == SymbolType::kCalUL)) {
         dst = &out_buf[sc_idx];
       } else {
-        dst = kUsePartialTrans
+        dst = partial_transpose_
                   ? &out_buf[sc_block_base_offset +
-                             (ant_id * kTransposeBlockSize) + sc_j]
+                             (ant_id * transpose_block_size_) + sc_j]
                   : &out_buf[(cfg_->OfdmDataNum() * ant_id) + sc_j +
-                             sc_block_idx * kTransposeBlockSize];
+                             sc_block_idx * transpose_block_size_];
       }
 
       // With either of AVX-512 or AVX2, load one cacheline =
@@ -340,6 +379,14 @@ void DoFFT::PartialTranspose(complex_float* out_buf, size_t ant_id,
             cfg_->PilotsSgn()[sc_idx].im, cfg_->PilotsSgn()[sc_idx].re);
         fft_result = CommsLib::M512ComplexCf32Mult(fft_result, pilot_tx, true);
       }
+      if (half_precision) {
+        // Same element index, but 4 bytes per complex value
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(reinterpret_cast<uint16_t*>(out_buf) +
+                                       2 * (dst - out_buf)),
+            _mm512_cvtps_ph(fft_result, _MM_FROUND_TO_NEAREST_INT));
+        continue;
+      }
       _mm512_stream_ps(reinterpret_cast<float*>(dst), fft_result);
 #else
       __m256 fft_result0 = _mm256_load_ps(reinterpret_cast<const float*>(src));
@@ -362,9 +409,44 @@ void DoFFT::PartialTranspose(complex_float* out_buf, size_t ant_id,
         fft_result1 =
             CommsLib::M256ComplexCf32Mult(fft_result1, pilot_tx1, true);
       }
+      if (half_precision) {
+        // Same element index, but 4 bytes per complex value
+        auto* dst_half = reinterpret_cast<__m128i*>(
+            reinterpret_cast<uint16_t*>(out_buf) + 2 * (dst - out_buf));
+        _mm_storeu_si128(
+            dst_half, _mm256_cvtps_ph(fft_result0, _MM_FROUND_TO_NEAREST_INT));
+        _mm_storeu_si128(dst_half + 1, _mm256_cvtps_ph(
+                                           fft_result1,
+                                           _MM_FROUND_TO_NEAREST_INT));
+        continue;
+      }
       _mm256_stream_ps(reinterpret_cast<float*>(dst), fft_result0);
       _mm256_stream_ps(reinterpret_cast<float*>(dst + 4), fft_result1);
 #endif
     }
   }
 }
+
+int8_t DoFFT::PartialTransposeFixed(short* out_buf, size_t ant_id) const {
+  const auto* fft_data =
+      reinterpret_cast<const float*>(&fft_inout_[cfg_->OfdmDataStart()]);
+  const int8_t exp =
+      FixedPointBlockExponent(fft_data, cfg_->OfdmDataNum() * 2);
+
+  if (partial_transpose_ == false) {
+    FixedPointQuantize(fft_data, &out_buf[cfg_->OfdmDataNum() * ant_id * 2],
+                       cfg_->OfdmDataNum() * 2, exp, kFixedPointDataFracBits);
+    return exp;
+  }
+  // We have OfdmDataNum() % transpose_block_size_ == 0
+  const size_t num_sc_blocks = cfg_->OfdmDataNum() / transpose_block_size_;
+  for (size_t sc_block_idx = 0; sc_block_idx < num_sc_blocks; sc_block_idx++) {
+    const size_t dst_offset =
+        sc_block_idx * (transpose_block_size_ * cfg_->BsAntNum()) +
+        (ant_id * transpose_block_size_);
+    FixedPointQuantize(&fft_data[sc_block_idx * transpose_block_size_ * 2],
+                       &out_buf[dst_offset * 2], transpose_block_size_ * 2,
+                       exp, kFixedPointDataFracBits);
+  }
+  return exp;
+}
@@ -21,7 +21,8 @@
 class DoFFT : public Doer {
  public:
   DoFFT(Config* config, size_t tid, Table<complex_float>& data_buffer,
-        PtrGrid<kFrameWnd, kMaxUEs, complex_float>& csi_buffers,
+        Table<short>& data_buffer_fixed, Table<int8_t>& data_exp_buffer,
+        PtrGrid<complex_float>& csi_buffers,
         Table<complex_float>& calib_dl_buffer,
         Table<complex_float>& calib_ul_buffer, PhyStats* in_phy_stats,
         Stats* stats_manager);
@@ -67,7 +68,7 @@ class DoFFT : public Doer {
    *
    * The fully-transposed matrix after FFT is a subcarriers x antennas matrix
    * that should look like so (using the notation subcarrier/antenna, and
-   * assuming kTransposeBlockSize = 16)
+   * assuming a transpose block size of 16)
    *
    * 0/0, 0/1, ........................................................., 0/63
    * 1/0, 0/1, ........................................................ , 1/63
@@ -90,13 +91,25 @@ class DoFFT : public Doer {
    * Each partially-transposed block is identical to the corresponding block
    * of the fully-transposed matrix, but laid out in memory in column-major
    * order.
+   *
+   * With half precision storage, pilot and uplink data are written as complex
+   * float16 at the same element index, so only the first half of out_buf is
+   * used.
    */
   void PartialTranspose(complex_float* out_buf, size_t ant_id,
                         SymbolType symbol_type) const;
 
+  /**
+   * Same layout as PartialTranspose for uplink data, but quantized to int16
+   * I/Q with a single block exponent for this antenna, which is returned.
+   */
+  int8_t PartialTransposeFixed(short* out_buf, size_t ant_id) const;
+
  private:
   Table<complex_float>& data_buffer_;
-  PtrGrid<kFrameWnd, kMaxUEs, complex_float>& csi_buffers_;
+  Table<short>& data_buffer_fixed_;
+  Table<int8_t>& data_exp_buffer_;
+  PtrGrid<complex_float>& csi_buffers_;
   Table<complex_float>& calib_dl_buffer_;
   Table<complex_float>& calib_ul_buffer_;
   DFTI_DESCRIPTOR_HANDLE mkl_handle_;
@@ -110,6 +123,10 @@ class DoFFT : public Doer {
   DurationStat* duration_stat_fft_;
   DurationStat* duration_stat_csi_;
   PhyStats* phy_stats_;
+
+  // See Config::PartialTranspose and Config::TransposeBlockSize
+  bool partial_transpose_;
+  size_t transpose_block_size_;
 };
 
 #endif  // DOFFT_H_
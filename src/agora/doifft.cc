@@ -17,10 +17,12 @@ static constexpr bool kPrintIfftStats = false;
 
 DoIFFT::DoIFFT(Config* in_config, int in_tid,
                Table<complex_float>& in_dl_ifft_buffer,
-               char* in_dl_socket_buffer, Stats* in_stats_manager)
+               char* in_dl_socket_buffer, PhyStats* in_phy_stats,
+               Stats* in_stats_manager)
     : Doer(in_config, in_tid),
       dl_ifft_buffer_(in_dl_ifft_buffer),
-      dl_socket_buffer_(in_dl_socket_buffer) {
+      dl_socket_buffer_(in_dl_socket_buffer),
+      phy_stats_(in_phy_stats) {
   duration_stat_ = in_stats_manager->GetDurationStat(DoerType::kIFFT, in_tid);
   DftiCreateDescriptor(&mkl_handle_, DFTI_SINGLE, DFTI_COMPLEX, 1,
                        cfg_->OfdmCaNum());
@@ -91,30 +93,6 @@ EventData DoIFFT::Launch(size_t tag) {
     }
   }
 
-  bool clipping = false;
-  float max_abs = 0;
-  for (size_t i = 0; i < 2 * cfg_->OfdmCaNum(); i++) {
-    float sample_val = ifft_out_ptr[i] / ifft_scale_factor_;
-    if (sample_val >= 1) {
-      clipping = true;
-      break;
-    }
-    if (std::abs(sample_val) > max_abs) {
-      max_abs = std::abs(sample_val);
-    }
-  }
-  if (clipping) {
-    AGORA_LOG_WARN("Clipping occured in Frame %zu, Symbol %zu, Antenna %zu\n",
-                   frame_id, symbol_id, ant_id);
-  }
-  if (ant_id < cfg_->BfAntNum() && max_abs < 1e-4) {
-    AGORA_LOG_WARN("Possibly bad antenna %zu with max sample value %2.2f\n",
-                   ant_id, max_abs);
-  }
-  if (kPrintIfftStats) {
-    std::printf("%2.3f\n", max_abs);
-  }
-
   if (kPrintIFFTOutput) {
     std::stringstream ss;
     ss << "IFFT_output" << ant_id << "=[";
@@ -136,8 +114,20 @@ EventData DoIFFT::Launch(size_t tag) {
 
   // IFFT scaled results by OfdmCaNum(), we scale down IFFT results
   // during data type coversion.  * 2 complex float -> float
-  SimdConvertFloatToShort(ifft_out_ptr, socket_ptr, cfg_->OfdmCaNum() * 2,
-                          cfg_->CpLen() * 2, ifft_scale_factor_);
+  // Peak and clipping are tracked in the same pass, clipping is reported
+  // per frame by the master thread
+  size_t num_clipped = 0;
+  const float max_abs = SimdConvertFloatToShortPeak(
+      ifft_out_ptr, socket_ptr, cfg_->OfdmCaNum() * 2, cfg_->CpLen() * 2,
+      ifft_scale_factor_, num_clipped);
+  phy_stats_->UpdateIfftClipping(tid_, frame_id, num_clipped, max_abs);
+  if (ant_id < cfg_->BfAntNum() && max_abs < 1e-4) {
+    AGORA_LOG_WARN("Possibly bad antenna %zu with max sample value %2.2f\n",
+                   ant_id, max_abs);
+  }
+  if (kPrintIfftStats) {
+    std::printf("%2.3f\n", max_abs);
+  }
 
   duration_stat_->task_duration_[3u] += GetTime::WorkerRdtsc() - start_tsc2;
 
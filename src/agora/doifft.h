@@ -10,12 +10,14 @@
 #include "doer.h"
 #include "memory_manage.h"
 #include "mkl_dfti.h"
+#include "phy_stats.h"
 #include "stats.h"
 
 class DoIFFT : public Doer {
  public:
   DoIFFT(Config* in_config, int in_tid, Table<complex_float>& in_dl_ifft_buffer,
-         char* in_dl_socket_buffer, Stats* in_stats_manager);
+         char* in_dl_socket_buffer, PhyStats* in_phy_stats,
+         Stats* in_stats_manager);
   ~DoIFFT() override;
 
   /**
@@ -46,6 +48,7 @@ class DoIFFT : public Doer {
  private:
   Table<complex_float>& dl_ifft_buffer_;
   char* dl_socket_buffer_;
+  PhyStats* phy_stats_;
   DurationStat* duration_stat_;
   DFTI_DESCRIPTOR_HANDLE mkl_handle_;
   float* ifft_out_;  // Buffer for IFFT output
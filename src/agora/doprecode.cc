@@ -5,28 +5,39 @@
 #include "doprecode.h"
 
 #include "concurrent_queue_wrapper.h"
+#include "datatype_conversion.h"
 #include "modulation.h"
 
 static constexpr bool kUseSpatialLocality = true;
 
 DoPrecode::DoPrecode(
     Config* in_config, int in_tid,
-    PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& dl_beam_matrices,
+    PtrGrid<complex_float>& dl_beam_matrices,
     Table<complex_float>& in_dl_ifft_buffer,
     Table<int8_t>& dl_encoded_or_raw_data /* Encoded if LDPC is enabled */,
-    Stats* in_stats_manager)
+    const FrameBlockSizes& block_sizes, Stats* in_stats_manager)
     : Doer(in_config, in_tid),
       dl_beam_matrices_(dl_beam_matrices),
       dl_ifft_buffer_(in_dl_ifft_buffer),
-      dl_raw_data_(dl_encoded_or_raw_data) {
+      dl_raw_data_(dl_encoded_or_raw_data),
+      block_sizes_(block_sizes) {
   duration_stat_ =
       in_stats_manager->GetDurationStat(DoerType::kPrecode, in_tid);
 
-  AllocBuffer1d(&modulated_buffer_temp_, kSCsPerCacheline * cfg_->UeAntNum(),
+  // The batched path modulates a whole block before precoding it
+  const size_t modulated_sc_num =
+      cfg_->BatchedGemm() ? cfg_->DemulBlockSize() : kSCsPerCacheline;
+  AllocBuffer1d(&modulated_buffer_temp_, modulated_sc_num * cfg_->UeAntNum(),
                 Agora_memory::Alignment_t::kAlign64, 0);
   AllocBuffer1d(&precoded_buffer_temp_,
                 cfg_->DemulBlockSize() * cfg_->BsAntNum(),
                 Agora_memory::Alignment_t::kAlign64, 0);
+  batch_precoder_ptrs_.resize(cfg_->DemulBlockSize());
+  batch_data_ptrs_.resize(cfg_->DemulBlockSize());
+  batch_precoded_ptrs_.resize(cfg_->DemulBlockSize());
+  AllocBuffer1d(&precoder_half_buffer_, cfg_->BsAntNum() * cfg_->UeAntNum(),
+                Agora_memory::Alignment_t::kAlign64, 0);
+  half_precoder_sc_id_ = SIZE_MAX;
 
 #if defined(USE_MKL_JIT)
   MKL_Complex8 alpha = {1, 0};
@@ -53,6 +64,7 @@ DoPrecode::DoPrecode(
 DoPrecode::~DoPrecode() {
   FreeBuffer1d(&modulated_buffer_temp_);
   FreeBuffer1d(&precoded_buffer_temp_);
+  FreeBuffer1d(&precoder_half_buffer_);
 
 #if defined(USE_MKL_JIT)
   mkl_jit_status_t status = mkl_jit_destroy(jitter_);
@@ -70,7 +82,8 @@ EventData DoPrecode::Launch(size_t tag) {
   const size_t symbol_idx_dl = cfg_->Frame().GetDLSymbolIdx(symbol_id);
   const size_t total_data_symbol_idx =
       cfg_->GetTotalDataSymbolIdxDl(frame_id, symbol_idx_dl);
-  const size_t frame_slot = frame_id % kFrameWnd;
+  const size_t frame_slot = cfg_->FrameSlot(frame_id);
+  half_precoder_sc_id_ = SIZE_MAX;
 
   // Mark pilot subcarriers in this block
   // In downlink pilot symbols, all subcarriers are used as pilots
@@ -96,12 +109,33 @@ EventData DoPrecode::Launch(size_t tag) {
         frame_id, symbol_id, base_sc_id);
   }
 
-  size_t max_sc_ite =
-      std::min(cfg_->DemulBlockSize(), cfg_->OfdmDataNum() - base_sc_id);
+  const size_t block_size = block_sizes_.Get(frame_id).demul_;
+  size_t max_sc_ite = std::min(block_size, cfg_->OfdmDataNum() - base_sc_id);
+  const size_t prefetch_distance = cfg_->PrefetchDistance();
+
+  if (cfg_->BatchedGemm()) {
+    size_t start_tsc1 = GetTime::WorkerRdtsc();
+    for (size_t i = 0; i < max_sc_ite; i++) {
+      for (size_t user_id = 0; user_id < cfg_->UeAntNum(); user_id++) {
+        LoadInputData(symbol_idx_dl, total_data_symbol_idx, user_id,
+                      base_sc_id + i, i);
+      }
+    }
+    size_t start_tsc2 = GetTime::WorkerRdtsc();
+    duration_stat_->task_duration_[1] += start_tsc2 - start_tsc1;
 
-  if (kUseSpatialLocality) {
+    PrecodingBlockBatched(frame_slot, base_sc_id, max_sc_ite);
+    duration_stat_->task_count_ = duration_stat_->task_count_ + max_sc_ite;
+    duration_stat_->task_duration_[2] += GetTime::WorkerRdtsc() - start_tsc2;
+  } else if (kUseSpatialLocality) {
+    // Whole cachelines ahead, matching the loop stride
+    const size_t group_distance = Roundup<kSCsPerCacheline>(prefetch_distance);
     for (size_t i = 0; i < max_sc_ite; i = i + kSCsPerCacheline) {
       size_t start_tsc1 = GetTime::WorkerRdtsc();
+      if ((group_distance > 0) && (i + group_distance < max_sc_ite)) {
+        PrefetchPrecoders(frame_slot, base_sc_id + i + group_distance,
+                          kSCsPerCacheline);
+      }
       for (size_t user_id = 0; user_id < cfg_->UeAntNum(); user_id++) {
         for (size_t j = 0; j < kSCsPerCacheline; j++) {
           LoadInputData(symbol_idx_dl, total_data_symbol_idx, user_id,
@@ -122,6 +156,9 @@ EventData DoPrecode::Launch(size_t tag) {
     for (size_t i = 0; i < max_sc_ite; i++) {
       size_t start_tsc1 = GetTime::WorkerRdtsc();
       int cur_sc_id = base_sc_id + i;
+      if ((prefetch_distance > 0) && (i + prefetch_distance < max_sc_ite)) {
+        PrefetchPrecoders(frame_slot, cur_sc_id + prefetch_distance, 1);
+      }
       for (size_t user_id = 0; user_id < cfg_->UeAntNum(); user_id++) {
         LoadInputData(symbol_idx_dl, total_data_symbol_idx, user_id, cur_sc_id,
                       0);
@@ -145,7 +182,7 @@ EventData DoPrecode::Launch(size_t tag) {
     auto* ifft_ptr = reinterpret_cast<float*>(
         &dl_ifft_buffer_[ifft_buffer_offset]
                         [base_sc_id + cfg_->OfdmDataStart()]);
-    for (size_t i = 0; i < cfg_->DemulBlockSize() / 4; i++) {
+    for (size_t i = 0; i < block_size / 4; i++) {
       float* input_shifted_ptr =
           precoded_ptr + 4 * i * 2 * cfg_->BsAntNum() + ant_id * 2;
       __m256d t_data = _mm256_i64gather_pd(
@@ -182,10 +219,36 @@ void DoPrecode::LoadInputData(size_t symbol_idx_dl,
   }
 }
 
+void DoPrecode::PrefetchPrecoders(size_t frame_slot, size_t sc_id,
+                                  size_t num_sc) {
+  const size_t precoder_bytes =
+      cfg_->UeAntNum() * cfg_->BsAntNum() *
+      (cfg_->HalfPrecisionStorage() ? sizeof(complex_float) / 2
+                                    : sizeof(complex_float));
+  size_t last_beam_sc_id = SIZE_MAX;
+  for (size_t i = 0; i < num_sc; i++) {
+    const size_t beam_sc_id = cfg_->GetBeamScId(sc_id + i);
+    if (beam_sc_id != last_beam_sc_id) {
+      Agora_memory::Prefetch(dl_beam_matrices_[frame_slot][beam_sc_id],
+                             precoder_bytes);
+      last_beam_sc_id = beam_sc_id;
+    }
+  }
+}
+
 void DoPrecode::PrecodingPerSc(size_t frame_slot, size_t sc_id,
                                size_t sc_id_in_block) {
   arma::cx_float* precoder_ptr = reinterpret_cast<arma::cx_float*>(
       dl_beam_matrices_[frame_slot][cfg_->GetBeamScId(sc_id)]);
+  if (cfg_->HalfPrecisionStorage()) {
+    if (half_precoder_sc_id_ != cfg_->GetBeamScId(sc_id)) {
+      half_precoder_sc_id_ = cfg_->GetBeamScId(sc_id);
+      SimdConvertHalfToFloat(reinterpret_cast<const uint16_t*>(precoder_ptr),
+                             reinterpret_cast<float*>(precoder_half_buffer_),
+                             2 * cfg_->BsAntNum() * cfg_->UeAntNum());
+    }
+    precoder_ptr = reinterpret_cast<arma::cx_float*>(precoder_half_buffer_);
+  }
   arma::cx_float* data_ptr = reinterpret_cast<arma::cx_float*>(
       modulated_buffer_temp_ +
       (kUseSpatialLocality
@@ -207,3 +270,41 @@ void DoPrecode::PrecodingPerSc(size_t frame_slot, size_t sc_id,
   // cout << "Precoded data: \n" << mat_precoded << endl;
 #endif
 }
+
+void DoPrecode::PrecodingBlockBatched(size_t frame_slot, size_t base_sc_id,
+                                      size_t num_sc) {
+  const MKL_INT m = cfg_->BsAntNum();
+  const MKL_INT k = cfg_->UeAntNum();
+  const MKL_Complex8 alpha = {1, 0};
+  const MKL_Complex8 beta = {0, 0};
+
+  if (cfg_->FreqOrthogonalPilot() == false) {
+    // One precoder per subcarrier, contiguous in the PtrGrid backing buffer
+    const complex_float* precoder_ptr =
+        dl_beam_matrices_[frame_slot][base_sc_id];
+    const MKL_INT precoder_stride =
+        (num_sc > 1) ? static_cast<MKL_INT>(
+                           dl_beam_matrices_[frame_slot][base_sc_id + 1] -
+                           precoder_ptr)
+                     : 0;
+    cblas_cgemm_batch_strided(CblasColMajor, CblasNoTrans, CblasNoTrans, m, 1,
+                              k, &alpha, precoder_ptr, m, precoder_stride,
+                              modulated_buffer_temp_, k, k, &beta,
+                              precoded_buffer_temp_, m, m, num_sc);
+  } else {
+    // Subcarriers in a pilot group share a precoder
+    for (size_t i = 0; i < num_sc; i++) {
+      batch_precoder_ptrs_[i] =
+          dl_beam_matrices_[frame_slot][cfg_->GetBeamScId(base_sc_id + i)];
+      batch_data_ptrs_[i] = modulated_buffer_temp_ + (i * k);
+      batch_precoded_ptrs_[i] = precoded_buffer_temp_ + (i * m);
+    }
+    const CBLAS_TRANSPOSE trans = CblasNoTrans;
+    const MKL_INT n = 1;
+    const auto group_size = static_cast<MKL_INT>(num_sc);
+    cblas_cgemm_batch(CblasColMajor, &trans, &trans, &m, &n, &k, &alpha,
+                      batch_precoder_ptrs_.data(), &m, batch_data_ptrs_.data(),
+                      &k, &beta, batch_precoded_ptrs_.data(), &m, 1,
+                      &group_size);
+  }
+}
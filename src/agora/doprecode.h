@@ -12,6 +12,7 @@
 #include "common_typedef_sdk.h"
 #include "config.h"
 #include "doer.h"
+#include "frame_block_sizes.h"
 #include "memory_manage.h"
 #include "message.h"
 #include "mkl_dfti.h"
@@ -21,9 +22,10 @@
 class DoPrecode : public Doer {
  public:
   DoPrecode(Config* in_config, int in_tid,
-            PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& dl_beam_matrices_,
+            PtrGrid<complex_float>& dl_beam_matrices_,
             Table<complex_float>& in_dl_ifft_buffer,
-            Table<int8_t>& dl_encoded_or_raw_data, Stats* in_stats_manager);
+            Table<int8_t>& dl_encoded_or_raw_data,
+            const FrameBlockSizes& block_sizes, Stats* in_stats_manager);
   ~DoPrecode() override;
 
   /**
@@ -58,15 +60,31 @@ class DoPrecode : public Doer {
   void LoadInputData(size_t symbol_idx_dl, size_t total_data_symbol_idx,
                      size_t user_id, size_t sc_id, size_t sc_id_in_block);
   void PrecodingPerSc(size_t frame_slot, size_t sc_id, size_t sc_id_in_block);
+  // Prefetch the precoders of the [num_sc] subcarriers starting at [sc_id]
+  void PrefetchPrecoders(size_t frame_slot, size_t sc_id, size_t num_sc);
+  // Precode [num_sc] subcarriers starting at [base_sc_id] with one batched
+  // cgemm call
+  void PrecodingBlockBatched(size_t frame_slot, size_t base_sc_id,
+                             size_t num_sc);
 
  private:
-  PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& dl_beam_matrices_;
+  PtrGrid<complex_float>& dl_beam_matrices_;
   Table<complex_float>& dl_ifft_buffer_;
   Table<int8_t>& dl_raw_data_;
+  // Precode block size of each frame, the demul block size
+  const FrameBlockSizes& block_sizes_;
   Table<float> qam_table_;
   DurationStat* duration_stat_;
   complex_float* modulated_buffer_temp_;
   complex_float* precoded_buffer_temp_;
+  // Per-subcarrier matrix pointers for the batched cgemm path
+  std::vector<const void*> batch_precoder_ptrs_;
+  std::vector<const void*> batch_data_ptrs_;
+  std::vector<void*> batch_precoded_ptrs_;
+  // float32 copy of the current float16 precoder with half precision storage,
+  // and the subcarrier of this Launch() it was converted from
+  complex_float* precoder_half_buffer_;
+  size_t half_precoder_sc_id_;
 #if defined(USE_MKL_JIT)
   void* jitter_;
   cgemm_jit_kernel_t my_cgemm_;
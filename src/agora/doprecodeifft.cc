@@ -0,0 +1,146 @@
+/**
+ * @file doprecodeifft.cc
+ * @brief Implementation file for the DoPrecodeIFFT class.
+ */
+#include "doprecodeifft.h"
+
+#include "concurrent_queue_wrapper.h"
+#include "datatype_conversion.h"
+#include "logger.h"
+#include "modulation.h"
+#include "precode_ifft.h"
+
+DoPrecodeIFFT::DoPrecodeIFFT(
+    Config* in_config, int in_tid,
+    PtrGrid<complex_float>& dl_beam_matrices,
+    Table<int8_t>& dl_encoded_or_raw_data /* Encoded if LDPC is enabled */,
+    char* in_dl_socket_buffer, const FrameBlockSizes& block_sizes,
+    PhyStats* in_phy_stats, Stats* in_stats_manager)
+    : Doer(in_config, in_tid),
+      dl_beam_matrices_(dl_beam_matrices),
+      dl_raw_data_(dl_encoded_or_raw_data),
+      dl_socket_buffer_(in_dl_socket_buffer),
+      block_sizes_(block_sizes),
+      phy_stats_(in_phy_stats) {
+  duration_stat_ = in_stats_manager->GetDurationStat(DoerType::kIFFT, in_tid);
+  DftiCreateDescriptor(&mkl_handle_, DFTI_SINGLE, DFTI_COMPLEX, 1,
+                       cfg_->OfdmCaNum());
+  DftiSetValue(mkl_handle_, DFTI_PLACEMENT, DFTI_NOT_INPLACE);
+  DftiCommitDescriptor(mkl_handle_);
+
+  AllocBuffer1d(&modulated_buffer_, cfg_->OfdmDataNum() * cfg_->UeAntNum(),
+                Agora_memory::Alignment_t::kAlign64, 0);
+  AllocBuffer1d(&precoded_rows_, cfg_->FftBlockSize() * cfg_->OfdmCaNum(),
+                Agora_memory::Alignment_t::kAlign64, 1);
+  AllocBuffer1d(&ifft_out_, 2 * cfg_->OfdmCaNum(),
+                Agora_memory::Alignment_t::kAlign64, 0);
+  ifft_scale_factor_ = cfg_->OfdmCaNum();
+  mod_frame_id_ = SIZE_MAX;
+  mod_symbol_id_ = SIZE_MAX;
+  block_ant_start_ = SIZE_MAX;
+}
+
+DoPrecodeIFFT::~DoPrecodeIFFT() {
+  DftiFreeDescriptor(&mkl_handle_);
+  FreeBuffer1d(&modulated_buffer_);
+  FreeBuffer1d(&precoded_rows_);
+  FreeBuffer1d(&ifft_out_);
+}
+
+EventData DoPrecodeIFFT::Launch(size_t tag) {
+  const size_t start_tsc = GetTime::WorkerRdtsc();
+  const size_t frame_id = gen_tag_t(tag).frame_id_;
+  const size_t symbol_id = gen_tag_t(tag).symbol_id_;
+  const size_t ant_id = gen_tag_t(tag).ant_id_;
+  const size_t symbol_idx_dl = cfg_->Frame().GetDLSymbolIdx(symbol_id);
+  const size_t total_data_symbol_idx =
+      cfg_->GetTotalDataSymbolIdxDl(frame_id, symbol_idx_dl);
+
+  if (kDebugPrintInTask) {
+    std::printf(
+        "In doPrecodeIFFT thread %d: frame: %zu, symbol: %zu, antenna: %zu\n",
+        tid_, frame_id, symbol_id, ant_id);
+  }
+
+  // Antenna blocks start at multiples of the frame's FFT block size
+  // (ScheduleAntennas)
+  const size_t fft_block_size = block_sizes_.Get(frame_id).fft_;
+  const size_t ant_start = ant_id - (ant_id % fft_block_size);
+  if ((mod_frame_id_ != frame_id) || (mod_symbol_id_ != symbol_id)) {
+    ModulateSymbol(symbol_idx_dl, total_data_symbol_idx);
+    mod_frame_id_ = frame_id;
+    mod_symbol_id_ = symbol_id;
+    block_ant_start_ = SIZE_MAX;
+  }
+  if (block_ant_start_ != ant_start) {
+    PrecodeBlock(cfg_->FrameSlot(frame_id), ant_start,
+                 std::min(fft_block_size, cfg_->BsAntNum() - ant_start));
+    block_ant_start_ = ant_start;
+  }
+
+  const size_t start_tsc1 = GetTime::WorkerRdtsc();
+  duration_stat_->task_duration_[1u] += start_tsc1 - start_tsc;
+
+  DftiComputeBackward(
+      mkl_handle_,
+      precoded_rows_ + ((ant_id - ant_start) * cfg_->OfdmCaNum()), ifft_out_);
+
+  const size_t start_tsc2 = GetTime::WorkerRdtsc();
+  duration_stat_->task_duration_[2u] += start_tsc2 - start_tsc1;
+
+  const size_t offset = (total_data_symbol_idx * cfg_->BsAntNum()) + ant_id;
+  auto* pkt = reinterpret_cast<Packet*>(
+      &dl_socket_buffer_[offset * cfg_->DlPacketLength()]);
+  short* socket_ptr = &pkt->data_[2u * cfg_->OfdmTxZeroPrefix()];
+  size_t num_clipped = 0;
+  const float max_abs = SimdConvertFloatToShortPeak(
+      ifft_out_, socket_ptr, cfg_->OfdmCaNum() * 2, cfg_->CpLen() * 2,
+      ifft_scale_factor_, num_clipped);
+  phy_stats_->UpdateIfftClipping(tid_, frame_id, num_clipped, max_abs);
+  if (ant_id < cfg_->BfAntNum() && max_abs < 1e-4) {
+    AGORA_LOG_WARN("Possibly bad antenna %zu with max sample value %2.2f\n",
+                   ant_id, max_abs);
+  }
+
+  duration_stat_->task_duration_[3u] += GetTime::WorkerRdtsc() - start_tsc2;
+  duration_stat_->task_count_++;
+  duration_stat_->task_duration_[0u] += GetTime::WorkerRdtsc() - start_tsc;
+  return EventData(EventType::kIFFT, tag);
+}
+
+void DoPrecodeIFFT::ModulateSymbol(size_t symbol_idx_dl,
+                                   size_t total_data_symbol_idx) {
+  const bool pilot_symbol =
+      symbol_idx_dl < cfg_->Frame().ClientDlPilotSymbols();
+  for (size_t sc_id = 0; sc_id < cfg_->OfdmDataNum(); sc_id++) {
+    complex_float* data_ptr = modulated_buffer_ + (sc_id * cfg_->UeAntNum());
+    for (size_t user_id = 0; user_id < cfg_->UeAntNum(); user_id++) {
+      if (pilot_symbol || (cfg_->IsDataSubcarrier(sc_id) == false)) {
+        data_ptr[user_id] = cfg_->UeSpecificPilot()[user_id][sc_id];
+      } else {
+        const int8_t* raw_data_ptr =
+            &dl_raw_data_[total_data_symbol_idx]
+                         [cfg_->GetOFDMDataIndex(sc_id) +
+                          Roundup<64>(cfg_->GetOFDMDataNum()) * user_id];
+        data_ptr[user_id] = ModSingleUint8(
+            static_cast<uint8_t>(*raw_data_ptr),
+            cfg_->ModTable(Direction::kDownlink));
+      }
+    }
+  }
+}
+
+void DoPrecodeIFFT::PrecodeBlock(size_t frame_slot, size_t ant_start,
+                                 size_t ant_num) {
+  // Guard bands stay zero from the allocation, data subcarriers are
+  // overwritten for every symbol
+  for (size_t sc_id = 0; sc_id < cfg_->OfdmDataNum(); sc_id++) {
+    const size_t row_idx = PrecodeIfftShiftedIndex(
+        sc_id + cfg_->OfdmDataStart(), cfg_->OfdmCaNum());
+    PrecodeAntennaBlock(
+        dl_beam_matrices_[frame_slot][cfg_->GetBeamScId(sc_id)] + ant_start,
+        modulated_buffer_ + (sc_id * cfg_->UeAntNum()), cfg_->BsAntNum(),
+        cfg_->UeAntNum(), ant_num, precoded_rows_ + row_idx,
+        cfg_->OfdmCaNum());
+  }
+}
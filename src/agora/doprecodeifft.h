@@ -0,0 +1,70 @@
+/**
+ * @file doprecodeifft.h
+ * @brief Declaration file for the DoPrecodeIFFT class.
+ */
+#ifndef DOPRECODEIFFT_H_
+#define DOPRECODEIFFT_H_
+
+#include <cstdint>
+
+#include "common_typedef_sdk.h"
+#include "config.h"
+#include "doer.h"
+#include "frame_block_sizes.h"
+#include "memory_manage.h"
+#include "message.h"
+#include "mkl_dfti.h"
+#include "phy_stats.h"
+#include "stats.h"
+#include "symbols.h"
+
+/// Fused downlink precoding and IFFT, used instead of DoPrecode and DoIFFT
+/// when fused_precode_ifft is set. Handles the kIFFT tags of one antenna
+/// block (fft_block_size antennas) over all subcarriers of a symbol.
+class DoPrecodeIFFT : public Doer {
+ public:
+  DoPrecodeIFFT(
+      Config* in_config, int in_tid,
+      PtrGrid<complex_float>& dl_beam_matrices,
+      Table<int8_t>& dl_encoded_or_raw_data, char* in_dl_socket_buffer,
+      const FrameBlockSizes& block_sizes, PhyStats* in_phy_stats,
+      Stats* in_stats_manager);
+  ~DoPrecodeIFFT() override;
+
+  /**
+   * Precode, IFFT and convert one antenna of a downlink symbol
+   * The first tag of an antenna block modulates the symbol and precodes
+   * every antenna of the block into antenna-major, FFT-shifted IFFT input
+   * rows. Each tag then transforms its row and writes the int16 samples
+   * with cyclic prefix to dl_socket_buffer_.
+   */
+  EventData Launch(size_t tag) override;
+
+ private:
+  // Modulate all data subcarriers of a symbol for all UEs
+  void ModulateSymbol(size_t symbol_idx_dl, size_t total_data_symbol_idx);
+  void PrecodeBlock(size_t frame_slot, size_t ant_start, size_t ant_num);
+
+  PtrGrid<complex_float>& dl_beam_matrices_;
+  Table<int8_t>& dl_raw_data_;
+  char* dl_socket_buffer_;
+  // Antenna block size of each frame
+  const FrameBlockSizes& block_sizes_;
+  PhyStats* phy_stats_;
+  DurationStat* duration_stat_;
+  DFTI_DESCRIPTOR_HANDLE mkl_handle_;
+  // OfdmDataNum() x UeAntNum() modulated symbols, subcarrier-major
+  complex_float* modulated_buffer_;
+  // FftBlockSize() IFFT input rows of OfdmCaNum() samples, enough for the
+  // antenna block of any frame
+  complex_float* precoded_rows_;
+  float* ifft_out_;
+  float ifft_scale_factor_;
+  // Frame and symbol held in modulated_buffer_
+  size_t mod_frame_id_;
+  size_t mod_symbol_id_;
+  // First antenna of the block held in precoded_rows_
+  size_t block_ant_start_;
+};
+
+#endif  // DOPRECODEIFFT_H_
@@ -0,0 +1,82 @@
+/**
+ * @file dorecipcal.cc
+ * @brief Implementation file for the DoRecipCal class.
+ */
+#include "dorecipcal.h"
+
+#include "logger.h"
+#include "recip_calib.h"
+
+DoRecipCal::DoRecipCal(Config* in_config, int in_tid,
+                       Table<complex_float>& calib_dl_buffer,
+                       Table<complex_float>& calib_ul_buffer,
+                       Table<complex_float>& calib_dl_msum_buffer,
+                       Table<complex_float>& calib_ul_msum_buffer,
+                       Table<complex_float>& calib_buffer,
+                       PhyStats* in_phy_stats, Stats* in_stats_manager)
+    : Doer(in_config, in_tid),
+      calib_dl_buffer_(calib_dl_buffer),
+      calib_ul_buffer_(calib_ul_buffer),
+      calib_dl_msum_buffer_(calib_dl_msum_buffer),
+      calib_ul_msum_buffer_(calib_ul_msum_buffer),
+      calib_buffer_(calib_buffer),
+      phy_stats_(in_phy_stats) {
+  duration_stat_ = in_stats_manager->GetDurationStat(DoerType::kRC, in_tid);
+}
+
+EventData DoRecipCal::Launch(size_t tag) {
+  const size_t start_tsc = GetTime::WorkerRdtsc();
+  const size_t frame_id = gen_tag_t(tag).frame_id_;
+  const size_t sc_num = cfg_->OfdmDataNum();
+  const size_t ant_num = cfg_->BfAntNum();
+
+  const size_t cal_slot_current = cfg_->RecipCalIndex(frame_id);
+  // Use the previous window which has a full set of calibration results
+  const size_t cal_slot_complete =
+      cfg_->ModifyRecCalIndex(cal_slot_current, -1);
+  AGORA_LOG_TRACE(
+      "DoRecipCal[%d]: (Frame %zu) updating calib at slot %zu\n", tid_,
+      frame_id, cal_slot_complete);
+
+  if (cfg_->SmoothCalib()) {
+    // oldest frame data in buffer but could be partially written with newest
+    // values using the second oldest....
+    const size_t cal_slot_old = cfg_->ModifyRecCalIndex(cal_slot_current, +1);
+    const size_t cal_slot_prev =
+        cfg_->ModifyRecCalIndex(cal_slot_complete, -1);
+
+    // Add new value to old rolling sum.  Then subtract out the oldest.
+    RecipCalibMovingSum(calib_dl_msum_buffer_[cal_slot_prev],
+                        calib_dl_buffer_[cal_slot_complete],
+                        calib_dl_buffer_[cal_slot_old],
+                        calib_dl_msum_buffer_[cal_slot_complete],
+                        sc_num * ant_num);
+    RecipCalibMovingSum(calib_ul_msum_buffer_[cal_slot_prev],
+                        calib_ul_buffer_[cal_slot_complete],
+                        calib_ul_buffer_[cal_slot_old],
+                        calib_ul_msum_buffer_[cal_slot_complete],
+                        sc_num * ant_num);
+    RecipCalibDivideTranspose(calib_ul_msum_buffer_[cal_slot_complete],
+                              calib_dl_msum_buffer_[cal_slot_complete],
+                              calib_buffer_[cal_slot_complete], sc_num,
+                              ant_num);
+  } else {
+    RecipCalibDivideTranspose(calib_ul_buffer_[cal_slot_complete],
+                              calib_dl_buffer_[cal_slot_complete],
+                              calib_buffer_[cal_slot_complete], sc_num,
+                              ant_num);
+  }
+
+  if (kEnableMatLog) {
+    const arma::cx_fmat calib_mat(
+        reinterpret_cast<arma::cx_float*>(calib_buffer_[cal_slot_complete]),
+        ant_num, sc_num, false);
+    for (size_t sc_id = 0; sc_id < sc_num; sc_id++) {
+      phy_stats_->UpdateCalibMat(frame_id, sc_id, calib_mat.col(sc_id));
+    }
+  }
+
+  duration_stat_->task_count_++;
+  duration_stat_->task_duration_[0u] += GetTime::WorkerRdtsc() - start_tsc;
+  return EventData(EventType::kRC, tag);
+}
@@ -0,0 +1,54 @@
+/**
+ * @file dorecipcal.h
+ * @brief Declaration file for the DoRecipCal class.  Computes the reciprocity
+ * calibration vectors of all subcarriers once per calibration update.
+ */
+#ifndef DORECIPCAL_H_
+#define DORECIPCAL_H_
+
+#include "common_typedef_sdk.h"
+#include "config.h"
+#include "doer.h"
+#include "memory_manage.h"
+#include "message.h"
+#include "phy_stats.h"
+#include "stats.h"
+
+class DoRecipCal : public Doer {
+ public:
+  DoRecipCal(Config* in_config, int in_tid,
+             Table<complex_float>& calib_dl_buffer,
+             Table<complex_float>& calib_ul_buffer,
+             Table<complex_float>& calib_dl_msum_buffer,
+             Table<complex_float>& calib_ul_msum_buffer,
+             Table<complex_float>& calib_buffer, PhyStats* in_phy_stats,
+             Stats* in_stats_manager);
+  ~DoRecipCal() override = default;
+
+  /**
+   * Update the calibration vectors from the last complete calibration window
+   * @param tag: task description with frame_id
+   * Buffers: calib_dl_buffer_, calib_ul_buffer_, calib_buffer_
+   *     Input buffer: calib_dl_buffer_, calib_ul_buffer_ (antenna-major)
+   *     Output buffer: calib_buffer_ (one BfAntNum() vector per subcarrier)
+   * Description:
+   *     1. with smooth_calib, update the moving sums calib_*_msum_buffer_
+   *     2. store the UL over DL ratio of every subcarrier in calib_buffer_
+   */
+  EventData Launch(size_t tag) override;
+
+ private:
+  //Set by FFT
+  Table<complex_float>& calib_dl_buffer_;
+  Table<complex_float>& calib_ul_buffer_;
+
+  //Antenna-major, same layout as calib_dl_buffer_
+  Table<complex_float>& calib_dl_msum_buffer_;
+  Table<complex_float>& calib_ul_msum_buffer_;
+  //Read by DoBeamWeights
+  Table<complex_float>& calib_buffer_;
+  PhyStats* phy_stats_;
+  DurationStat* duration_stat_;
+};
+
+#endif  // DORECIPCAL_H_
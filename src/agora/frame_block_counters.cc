@@ -0,0 +1,128 @@
+/**
+ * @file frame_block_counters.cc
+ * @brief Implementation file for the FrameBlockCounters class
+ */
+#include "frame_block_counters.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "logger.h"
+
+FrameBlockCounters::FrameBlockCounters(const Config* cfg,
+                                       FrameBlockSizes& block_sizes)
+    : cfg_(cfg), block_sizes_(block_sizes) {
+  SetNext(BlockSizes::Configured(cfg));
+  frame_counters_.assign(cfg->FrameWnd(), next_counters_);
+}
+
+void FrameBlockCounters::StartFrames(size_t frame_id) {
+  // The slot of a frame in flight is not reused before the frame window
+  // moves past it, so its sizes and counters stay in place
+  for (; started_end_ <= frame_id; started_end_++) {
+    block_sizes_.Stamp(started_end_, next_sizes_);
+    frame_counters_.at(cfg_->FrameSlot(started_end_)) = next_counters_;
+  }
+}
+
+void FrameBlockCounters::SetNext(const BlockSizes& sizes) {
+  next_sizes_ = sizes;
+  next_counters_ = CountersFor(sizes);
+}
+
+BlockCounters* FrameBlockCounters::CountersFor(const BlockSizes& sizes) {
+  for (const auto& counters : counter_sets_) {
+    if ((counters->demul_block_size_ == sizes.demul_) &&
+        (counters->beam_block_size_ == sizes.beam_)) {
+      return counters.get();
+    }
+  }
+  // Every set returns its slots to zero when their frame completes, so
+  // frames of any sizes can use it later
+  auto counters = std::make_unique<BlockCounters>();
+  counters->demul_block_size_ = sizes.demul_;
+  counters->beam_block_size_ = sizes.beam_;
+  InitCounters(*counters);
+  counter_sets_.push_back(std::move(counters));
+  AGORA_LOG_TRACE("FrameBlockCounters: counters for demul %zu, beam %zu\n",
+                  sizes.demul_, sizes.beam_);
+  return counter_sets_.back().get();
+}
+
+void FrameBlockCounters::InitCounters(BlockCounters& counters) const {
+  const size_t frame_wnd = cfg_->FrameWnd();
+  const size_t num_symbols = cfg_->Frame().NumTotalSyms();
+  const size_t demul_block_size = counters.demul_block_size_;
+  const size_t demul_events_per_symbol =
+      1 + (cfg_->OfdmDataNum() - 1) / demul_block_size;
+  const size_t beam_events_per_symbol =
+      1 + (cfg_->OfdmDataNum() - 1) / counters.beam_block_size_;
+
+  counters.beam_.Init(frame_wnd, num_symbols, beam_events_per_symbol);
+
+  counters.demul_.Init(frame_wnd, num_symbols, cfg_->Frame().NumULSyms(),
+                       demul_events_per_symbol);
+
+  if (cfg_->Frame().NumULSyms() > 0) {
+    // Subcarriers of the LLRs that DoDecode reads for each codeblock
+    const LDPCconfig& ul_ldpc_config = cfg_->LdpcConfig(Direction::kUplink);
+    const size_t mod_order_bits = cfg_->ModOrderBits(Direction::kUplink);
+    std::vector<std::pair<size_t, size_t>> cb_sc_ranges(
+        ul_ldpc_config.NumBlocksInSymbol());
+    for (size_t cb_id = 0; cb_id < cb_sc_ranges.size(); cb_id++) {
+      const size_t first_llr =
+          mod_order_bits * ul_ldpc_config.NumCbCodewLen() * cb_id;
+      const size_t end_sc = std::min(
+          (first_llr + ul_ldpc_config.NumCbCodewLen() + mod_order_bits - 1) /
+              mod_order_bits,
+          cfg_->OfdmDataNum());
+      cb_sc_ranges.at(cb_id) =
+          std::make_pair(std::min(first_llr / mod_order_bits, end_sc - 1),
+                         end_sc);
+    }
+    counters.demul_cb_.Init(frame_wnd, num_symbols, demul_events_per_symbol,
+                            demul_block_size, cb_sc_ranges);
+  }
+
+  if (cfg_->Frame().NumDLSyms() > 0) {
+    counters.precode_.Init(frame_wnd, num_symbols, cfg_->Frame().NumDLSyms(),
+                           demul_events_per_symbol);
+    // Codeblocks (per UE) whose modulated bits each precode block reads.
+    // DoEncode places codeblock cb at data subcarrier index cb.
+    const size_t dl_num_cbs =
+        cfg_->LdpcConfig(Direction::kDownlink).NumBlocksInSymbol();
+    const size_t dl_sc_per_cb =
+        cfg_->SubcarrierPerCodeBlock(Direction::kDownlink);
+    std::vector<std::vector<size_t>> block_cbs(demul_events_per_symbol);
+    for (size_t block_id = 0; block_id < block_cbs.size(); block_id++) {
+      const size_t base_sc_id = block_id * demul_block_size;
+      const size_t end_sc_id =
+          std::min(base_sc_id + demul_block_size, cfg_->OfdmDataNum());
+      std::vector<bool> reads_cb(dl_num_cbs, false);
+      for (size_t sc_id = base_sc_id; sc_id < end_sc_id; sc_id++) {
+        if (cfg_->IsDataSubcarrier(sc_id) == false) {
+          continue;
+        }
+        const size_t data_sc_id = cfg_->GetOFDMDataIndex(sc_id);
+        for (size_t cb_id = 0; cb_id < dl_num_cbs; cb_id++) {
+          if ((data_sc_id >= cb_id) && (data_sc_id < cb_id + dl_sc_per_cb)) {
+            reads_cb.at(cb_id) = true;
+          }
+        }
+      }
+      for (size_t cb_id = 0; cb_id < dl_num_cbs; cb_id++) {
+        if (reads_cb.at(cb_id)) {
+          block_cbs.at(block_id).push_back(cb_id);
+        }
+      }
+      // Blocks of only pilot subcarriers still wait for the whole symbol
+      if (block_cbs.at(block_id).empty()) {
+        for (size_t cb_id = 0; cb_id < dl_num_cbs; cb_id++) {
+          block_cbs.at(block_id).push_back(cb_id);
+        }
+      }
+    }
+    counters.precode_sc_block_.Init(frame_wnd, num_symbols, block_cbs,
+                                    dl_num_cbs, cfg_->UeAntNum());
+  }
+}
@@ -0,0 +1,79 @@
+/**
+ * @file frame_block_counters.h
+ * @brief Declaration file for the FrameBlockCounters class, which gives every
+ * frame the block sizes it started with and the task counters of those sizes
+ */
+#ifndef FRAME_BLOCK_COUNTERS_H_
+#define FRAME_BLOCK_COUNTERS_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "config.h"
+#include "frame_block_sizes.h"
+#include "message.h"
+
+/// Master thread counters whose task counts follow the demul and beam block
+/// sizes
+struct BlockCounters {
+  size_t demul_block_size_;
+  size_t beam_block_size_;
+  FrameCounters beam_;
+  FrameCounters demul_;
+  // Demodulated subcarrier blocks read by each uplink codeblock
+  CodeblockCounters demul_cb_;
+  FrameCounters precode_;
+  // Encoded codeblocks read by each downlink precode block
+  ScBlockCounters precode_sc_block_;
+};
+
+/**
+ * @brief The master thread starts a frame before it schedules the frame's
+ * first task. Starting stamps the frame's block sizes into FrameBlockSizes,
+ * where the Doers read them, and picks the counters of those sizes for the
+ * frame. Frames keep their sizes and counters while later frames start with
+ * others, so block sizes can change with frames in flight.
+ */
+class FrameBlockCounters {
+ public:
+  /// Frames start with the configured sizes. [block_sizes] is the table the
+  /// Doers read.
+  FrameBlockCounters(const Config* cfg, FrameBlockSizes& block_sizes);
+
+  /// Start the frames up to [frame_id] that have not started yet
+  void StartFrames(size_t frame_id);
+
+  /// Frames that start from now on run with [sizes]
+  void SetNext(const BlockSizes& sizes);
+
+  /// One past the latest started frame
+  inline size_t StartedEnd() const { return this->started_end_; }
+
+  inline const BlockSizes& Sizes(size_t frame_id) const {
+    return this->block_sizes_.Get(frame_id);
+  }
+
+  inline BlockCounters& Counters(size_t frame_id) {
+    return *this->frame_counters_.at(this->cfg_->FrameSlot(frame_id));
+  }
+
+  /// Counter sets created so far, one per pair of demul and beam sizes
+  inline size_t NumCounterSets() const { return this->counter_sets_.size(); }
+
+ private:
+  /// The counters of [sizes], created on first use
+  BlockCounters* CountersFor(const BlockSizes& sizes);
+  void InitCounters(BlockCounters& counters) const;
+
+  const Config* const cfg_;
+  FrameBlockSizes& block_sizes_;
+  std::vector<std::unique_ptr<BlockCounters>> counter_sets_;
+  // Counters of the frame in each frame slot
+  std::vector<BlockCounters*> frame_counters_;
+  BlockSizes next_sizes_;
+  BlockCounters* next_counters_;
+  size_t started_end_{0};
+};
+
+#endif  // FRAME_BLOCK_COUNTERS_H_
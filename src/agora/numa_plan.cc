@@ -0,0 +1,62 @@
+/**
+ * @file numa_plan.cc
+ * @brief Implementation file for the NumaPlan class
+ */
+#include "numa_plan.h"
+
+#include <algorithm>
+
+#include "utils.h"
+
+NumaPlan::NumaPlan(const std::vector<size_t>& worker_node_ids, size_t num_sc,
+                   size_t sc_block_size, size_t num_ant,
+                   size_t ant_block_size) {
+  RtAssert(worker_node_ids.empty() == false, "NumaPlan needs workers");
+  node_ids_ = worker_node_ids;
+  std::sort(node_ids_.begin(), node_ids_.end());
+  node_ids_.erase(std::unique(node_ids_.begin(), node_ids_.end()),
+                  node_ids_.end());
+  for (const size_t node_id : worker_node_ids) {
+    worker_nodes_.push_back(
+        std::lower_bound(node_ids_.begin(), node_ids_.end(), node_id) -
+        node_ids_.begin());
+  }
+  sc_starts_ = SplitByWorkers(num_sc, sc_block_size);
+  ant_starts_ = SplitByWorkers(num_ant, ant_block_size);
+}
+
+std::vector<size_t> NumaPlan::SplitByWorkers(size_t num,
+                                             size_t block_size) const {
+  RtAssert(block_size > 0, "NumaPlan block size must be positive");
+  std::vector<size_t> node_workers(NumNodes(), 0);
+  for (const size_t node : worker_nodes_) {
+    node_workers.at(node)++;
+  }
+  const size_t num_blocks = (num + block_size - 1) / block_size;
+  std::vector<size_t> starts(1, 0);
+  size_t workers_before = 0;
+  for (const size_t workers : node_workers) {
+    workers_before += workers;
+    const size_t blocks_before =
+        (num_blocks * workers_before + worker_nodes_.size() / 2) /
+        worker_nodes_.size();
+    starts.push_back(std::min(blocks_before * block_size, num));
+  }
+  return starts;
+}
+
+size_t NumaPlan::ScNode(size_t sc_id) const {
+  size_t node = 0;
+  while ((node + 1 < NumNodes()) && (sc_id >= ScStop(node))) {
+    node++;
+  }
+  return node;
+}
+
+size_t NumaPlan::AntNode(size_t ant_id) const {
+  size_t node = 0;
+  while ((node + 1 < NumNodes()) && (ant_id >= AntStop(node))) {
+    node++;
+  }
+  return node;
+}
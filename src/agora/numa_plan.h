@@ -0,0 +1,51 @@
+/**
+ * @file numa_plan.h
+ * @brief Declaration file for the NumaPlan class, which splits the
+ * subcarrier and antenna ranges across the NUMA nodes running workers
+ */
+
+#ifndef NUMA_PLAN_H_
+#define NUMA_PLAN_H_
+
+#include <cstddef>
+#include <vector>
+
+class NumaPlan {
+ public:
+  /// [worker_node_ids] holds the system NUMA node of each worker thread.
+  /// Subcarriers are split in units of [sc_block_size] and antennas in units
+  /// of [ant_block_size], in proportion to the number of workers per node.
+  NumaPlan(const std::vector<size_t>& worker_node_ids, size_t num_sc,
+           size_t sc_block_size, size_t num_ant, size_t ant_block_size);
+
+  /// Number of nodes running workers. Nodes are indexed 0..NumNodes() - 1.
+  inline size_t NumNodes() const { return node_ids_.size(); }
+  /// System NUMA node id of node index [node]
+  inline size_t NodeId(size_t node) const { return node_ids_.at(node); }
+  /// Node index of worker [tid]
+  inline size_t WorkerNode(size_t tid) const { return worker_nodes_.at(tid); }
+
+  /// Subcarriers [ScStart(node), ScStop(node)) live on node index [node]
+  inline size_t ScStart(size_t node) const { return sc_starts_.at(node); }
+  inline size_t ScStop(size_t node) const { return sc_starts_.at(node + 1); }
+  /// Antennas [AntStart(node), AntStop(node)) live on node index [node]
+  inline size_t AntStart(size_t node) const { return ant_starts_.at(node); }
+  inline size_t AntStop(size_t node) const { return ant_starts_.at(node + 1); }
+
+  /// Node index owning subcarrier [sc_id]
+  size_t ScNode(size_t sc_id) const;
+  /// Node index owning antenna [ant_id]
+  size_t AntNode(size_t ant_id) const;
+
+ private:
+  /// Split [num] items in whole blocks of [block_size] by the worker count
+  /// of each node. Returns NumNodes() + 1 range boundaries.
+  std::vector<size_t> SplitByWorkers(size_t num, size_t block_size) const;
+
+  std::vector<size_t> node_ids_;
+  std::vector<size_t> worker_nodes_;
+  std::vector<size_t> sc_starts_;
+  std::vector<size_t> ant_starts_;
+};
+
+#endif  // NUMA_PLAN_H_
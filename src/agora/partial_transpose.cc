@@ -0,0 +1,76 @@
+/**
+ * @file partial_transpose.cc
+ * @brief Implementation file for the transpose block size tuner
+ */
+#include "partial_transpose.h"
+
+#include <cstring>
+#include <limits>
+
+#include "gettime.h"
+#include "logger.h"
+#include "memory_manage.h"
+#include "utils.h"
+
+namespace Agora_transpose {
+// Runs per block size. The fastest one is kept, so that a single
+// preemption does not skew the choice.
+static constexpr size_t kTuneIterations = 20;
+
+size_t TuneBlockSize(const Config* cfg) {
+  const size_t bs_ant_num = cfg->BsAntNum();
+  const size_t num_sc = cfg->OfdmDataNum();
+  // One antenna's FFT output, one partially transposed symbol, and the
+  // antennas of one subcarrier
+  Table<complex_float> buffers;
+  buffers.RandAllocCxFloat(3, bs_ant_num * num_sc,
+                           Agora_memory::Alignment_t::kAlign64);
+  const complex_float* fft_out = buffers[0];
+  complex_float* symbol = buffers[1];
+  complex_float* gathered = buffers[2];
+
+  size_t best_block_size = kTransposeBlockSize;
+  size_t best_cycles = std::numeric_limits<size_t>::max();
+  for (const size_t block_size : kTransposeBlockSizes) {
+    if ((num_sc % block_size != 0) ||
+        (cfg->DemulBlockSize() % block_size != 0)) {
+      continue;
+    }
+    const GatherScFn gather_sc = SelectGatherSc(block_size);
+    size_t cycles = std::numeric_limits<size_t>::max();
+    for (size_t iter = 0; iter < kTuneIterations; iter++) {
+      const size_t start_tsc = GetTime::Rdtsc();
+      // DoFFT writes every antenna one block at a time
+      for (size_t ant = 0; ant < bs_ant_num; ant++) {
+        for (size_t sc = 0; sc < num_sc; sc += block_size) {
+          std::memcpy(symbol + Offset(block_size, bs_ant_num, sc, ant),
+                      fft_out + sc, block_size * sizeof(complex_float));
+        }
+      }
+      // DoDemul and DoBeamWeights read every subcarrier across antennas
+      for (size_t sc = 0; sc < num_sc; sc++) {
+        gather_sc(symbol, sc, bs_ant_num, gathered);
+      }
+      cycles = std::min(cycles, GetTime::Rdtsc() - start_tsc);
+    }
+    AGORA_LOG_INFO(
+        "Transpose block size %zu: %.2f us per symbol (%zu antennas)\n",
+        block_size, GetTime::CyclesToUs(cycles, cfg->FreqGhz()), bs_ant_num);
+    if (cycles < best_cycles) {
+      best_cycles = cycles;
+      best_block_size = block_size;
+    }
+  }
+  buffers.Free();
+  AGORA_LOG_INFO("Transpose block size: selected %zu\n", best_block_size);
+  return best_block_size;
+}
+
+void ResolveBlockSize(Config* cfg) {
+  if (cfg->TransposeBlockSize() != 0) {
+    return;
+  }
+  cfg->TransposeBlockSize(cfg->PartialTranspose() ? TuneBlockSize(cfg)
+                                                  : kTransposeBlockSize);
+}
+}  // namespace Agora_transpose
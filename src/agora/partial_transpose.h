@@ -0,0 +1,102 @@
+/**
+ * @file partial_transpose.h
+ * @brief Gathers from the partially transposed FFT output and CSI buffers,
+ * specialized for each supported transpose block size
+ */
+#ifndef PARTIAL_TRANSPOSE_H_
+#define PARTIAL_TRANSPOSE_H_
+
+#include <immintrin.h>
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#include "common_typedef_sdk.h"
+#include "config.h"
+#include "symbols.h"
+
+namespace Agora_transpose {
+#ifdef __AVX512F__
+static constexpr size_t kAntNumPerSimd = 8;
+#else
+static constexpr size_t kAntNumPerSimd = 4;
+#endif
+
+/// Element offset of antenna [ant_id] of subcarrier [sc_id] in one symbol
+/// laid out in blocks of [block_size] subcarriers
+static inline size_t Offset(size_t block_size, size_t bs_ant_num,
+                            size_t sc_id, size_t ant_id) {
+  return ((sc_id / block_size) * (block_size * bs_ant_num)) +
+         (ant_id * block_size) + (sc_id % block_size);
+}
+
+/// Copy the [bs_ant_num] antennas of subcarrier [sc_id] from the symbol at
+/// [src] to [dst], with the block size known at compile time
+template <size_t kBlockSize>
+static void GatherSc(const complex_float* src, size_t sc_id,
+                     size_t bs_ant_num, complex_float* dst) {
+  static_assert(IsPowerOfTwo(kBlockSize));
+  const complex_float* sc_src = src + Offset(kBlockSize, bs_ant_num, sc_id, 0);
+  const auto* src_f = reinterpret_cast<const float*>(sc_src);
+  auto* dst_f = reinterpret_cast<float*>(dst);
+  size_t ant = 0;
+#ifdef __AVX512F__
+  const __m512i index = _mm512_setr_epi32(
+      0, 1, kBlockSize * 2, kBlockSize * 2 + 1, kBlockSize * 4,
+      kBlockSize * 4 + 1, kBlockSize * 6, kBlockSize * 6 + 1, kBlockSize * 8,
+      kBlockSize * 8 + 1, kBlockSize * 10, kBlockSize * 10 + 1,
+      kBlockSize * 12, kBlockSize * 12 + 1, kBlockSize * 14,
+      kBlockSize * 14 + 1);
+  for (; ant + kAntNumPerSimd <= bs_ant_num; ant += kAntNumPerSimd) {
+    _mm512_storeu_ps(
+        dst_f + (ant * 2),
+        _mm512_i32gather_ps(index, src_f + (ant * kBlockSize * 2), 4));
+  }
+#else
+  const __m256i index = _mm256_setr_epi32(
+      0, 1, kBlockSize * 2, kBlockSize * 2 + 1, kBlockSize * 4,
+      kBlockSize * 4 + 1, kBlockSize * 6, kBlockSize * 6 + 1);
+  for (; ant + kAntNumPerSimd <= bs_ant_num; ant += kAntNumPerSimd) {
+    _mm256_storeu_ps(
+        dst_f + (ant * 2),
+        _mm256_i32gather_ps(src_f + (ant * kBlockSize * 2), index, 4));
+  }
+#endif
+  for (; ant < bs_ant_num; ant++) {
+    dst[ant] = sc_src[ant * kBlockSize];
+  }
+}
+
+using GatherScFn = void (*)(const complex_float*, size_t, size_t,
+                            complex_float*);
+
+/// The GatherSc specialization for [block_size], one of kTransposeBlockSizes
+static inline GatherScFn SelectGatherSc(size_t block_size) {
+  switch (block_size) {
+    case 8:
+      return GatherSc<8>;
+    case 16:
+      return GatherSc<16>;
+    case 32:
+      return GatherSc<32>;
+    case 64:
+      return GatherSc<64>;
+    default:
+      throw std::runtime_error("Unsupported transpose block size " +
+                               std::to_string(block_size));
+  }
+}
+
+/// Benchmark the FFT-side scatter and the gather of one uplink symbol for
+/// every supported block size that divides the OFDM data subcarriers and the
+/// demul block size. Returns the fastest size and logs every measurement.
+size_t TuneBlockSize(const Config* cfg);
+
+/// Replace a configured block size of 0 with the one TuneBlockSize()
+/// selects. Without the partial transpose the size only sets loop bounds and
+/// kTransposeBlockSize is kept. Call before creating any Doer.
+void ResolveBlockSize(Config* cfg);
+}  // namespace Agora_transpose
+
+#endif  // PARTIAL_TRANSPOSE_H_
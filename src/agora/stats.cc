@@ -4,6 +4,8 @@
  */
 #include "stats.h"
 
+#include <algorithm>
+#include <map>
 #include <typeinfo>
 
 #include "gettime.h"
@@ -448,6 +450,60 @@ void Stats::PrintSummary() {
       std::printf("\n");
     }
   }  // kIsWorkerTimingEnabled == true
+  PrintScratchSummary();
+  if (config_->NumaAware()) {
+    PrintNumaSummary();
+  }
+}
+
+void Stats::PrintNumaSummary() {
+  // Node -> (local tasks, remote tasks)
+  std::map<size_t, std::pair<size_t, size_t>> node_tasks;
+  for (size_t i = 0; i < task_thread_num_; i++) {
+    const NumaTaskStat* numa_stat = GetNumaTaskStat(i);
+    auto& tasks = node_tasks[numa_stat->node_];
+    tasks.first += numa_stat->local_tasks_;
+    tasks.second += numa_stat->remote_tasks_;
+  }
+  for (const auto& [node, tasks] : node_tasks) {
+    const size_t total_tasks = tasks.first + tasks.second;
+    std::printf(
+        "NUMA node %zu performed %zu tasks, %zu from other nodes (%.2f%% "
+        "remote accesses)\n",
+        node, total_tasks, tasks.second,
+        (total_tasks == 0)
+            ? 0.0
+            : (static_cast<double>(tasks.second) * 100.0) / total_tasks);
+  }
+}
+
+void Stats::PrintScratchSummary() {
+  size_t total_tasks = 0;
+  size_t total_arena_allocs = 0;
+  size_t total_heap_allocs = 0;
+  size_t peak_bytes = 0;
+  for (size_t i = 0; i < task_thread_num_; i++) {
+    const ScratchAllocStat* scratch_stat = GetScratchAllocStat(i);
+    total_tasks += scratch_stat->tasks_;
+    total_arena_allocs += scratch_stat->arena_allocs_;
+    total_heap_allocs += scratch_stat->heap_allocs_;
+    peak_bytes = std::max(peak_bytes, scratch_stat->peak_bytes_);
+  }
+  if (total_tasks == 0) {
+    return;
+  }
+  std::printf(
+      "Scratch arenas: %zu arena growths in %zu tasks, peak %zu KiB per "
+      "task\n",
+      total_arena_allocs, total_tasks, peak_bytes >> 10);
+  if (AllocCounter::Enabled()) {
+    std::printf("Task heap allocations: %zu (%.4f per task)\n",
+                total_heap_allocs,
+                static_cast<double>(total_heap_allocs) / total_tasks);
+  } else {
+    std::printf(
+        "Task heap allocations: not counted, build with ALLOC_COUNTING\n");
+  }
 }
 
 void Stats::PrintPerFrameDone(PrintType print_type, size_t frame_id) const {
@@ -7,11 +7,14 @@
 #define STATS_H_
 
 #include <array>
+#include <atomic>
 #include <cstddef>
 #include <string>
 
+#include "alloc_counter.h"
 #include "config.h"
 #include "gettime.h"
+#include "memory_arena.h"
 #include "memory_manage.h"
 #include "message.h"
 #include "symbols.h"
@@ -26,6 +29,46 @@ struct DurationStat {
   void Reset() { std::memset(this, 0, sizeof(DurationStat)); }
 };
 
+// Task count and busy cycles of one worker and Doer type, copied from its
+// DurationStat by the worker after every task. Unlike the DurationStat,
+// other threads may read it while the worker runs.
+struct PublishedTaskStat {
+  std::atomic<size_t> task_count_{0};
+  std::atomic<size_t> task_cycles_{0};
+};
+
+// Tasks a worker took from the queues of its own NUMA node (local) and from
+// the queues of other nodes (remote, their data lives on the other node)
+struct NumaTaskStat {
+  size_t node_ = 0;  // System NUMA node of the worker
+  size_t local_tasks_ = 0;
+  size_t remote_tasks_ = 0;
+};
+
+// Tasks a worker ran with its scratch arena and the heap allocations they
+// needed, which stay at zero once the arena has grown to the largest task
+struct ScratchAllocStat {
+  size_t tasks_ = 0;
+  // Heap allocations of the arena itself, while it grows
+  size_t arena_allocs_ = 0;
+  // All heap allocations of the tasks, counted only with ALLOC_COUNTING
+  size_t heap_allocs_ = 0;
+  size_t peak_bytes_ = 0;  // Largest arena use of a single task
+  size_t task_start_allocs_ = 0;
+
+  inline void BeginTask() {
+    task_start_allocs_ = AllocCounter::ThreadAllocs();
+  }
+
+  /// Task boundary: reset [arena] and count what the task allocated
+  inline void EndTask(MemoryArena& arena) {
+    tasks_++;
+    arena_allocs_ += arena.Reset();
+    heap_allocs_ += AllocCounter::ThreadAllocs() - task_start_allocs_;
+    peak_bytes_ = arena.PeakBytes();
+  }
+};
+
 // Temporary summary statistics assembled from per-thread runtime stats
 struct FrameSummary {
   std::array<double, kMaxStatBreakdown> us_this_thread_;
@@ -172,6 +215,41 @@ class Stats {
                 .duration_stat_[static_cast<size_t>(doer_type)];
   }
 
+  /// Publish the task counts and busy cycles of worker thread_id to other
+  /// threads. Called by the worker after every task.
+  inline void PublishTaskStats(size_t thread_id) {
+    const auto& durations = this->worker_durations_[thread_id].duration_stat_;
+    auto& published = this->worker_published_tasks_[thread_id].task_stat_;
+    for (size_t i = 0; i < kNumDoerTypes; i++) {
+      published[i].task_count_.store(durations[i].task_count_,
+                                     std::memory_order_relaxed);
+      published[i].task_cycles_.store(durations[i].task_duration_[0],
+                                      std::memory_order_relaxed);
+    }
+  }
+
+  /// The task count and busy cycles of thread thread_id for DoerType
+  /// doer_type as of its last PublishTaskStats(). Safe to call from any
+  /// thread.
+  inline void PublishedTaskStats(DoerType doer_type, size_t thread_id,
+                                 size_t& count, size_t& cycles) const {
+    const PublishedTaskStat& published =
+        this->worker_published_tasks_[thread_id]
+            .task_stat_[static_cast<size_t>(doer_type)];
+    count = published.task_count_.load(std::memory_order_relaxed);
+    cycles = published.task_cycles_.load(std::memory_order_relaxed);
+  }
+
+  /// Get the NumaTaskStat object used by thread thread_id
+  NumaTaskStat* GetNumaTaskStat(size_t thread_id) {
+    return &this->worker_numa_tasks_.at(thread_id).numa_task_stat_;
+  }
+
+  /// Get the ScratchAllocStat object used by thread thread_id
+  ScratchAllocStat* GetScratchAllocStat(size_t thread_id) {
+    return &this->worker_scratch_allocs_.at(thread_id).scratch_alloc_stat_;
+  }
+
   inline size_t LastFrameId() const { return this->last_frame_id_; }
   /// Dimensions = number of packet RX threads x kNumStatsFrames.
   /// frame_start[i][j] is the RDTSC timestamp taken by thread i when it
@@ -192,6 +270,11 @@ class Stats {
                                    FrameSummary const& frame_summary);
 
   size_t GetTotalTaskCount(DoerType doer_type, size_t thread_num);
+  /// Print the local and remote task counts of the workers on each NUMA
+  /// node
+  void PrintNumaSummary();
+  /// Print the scratch arena heap allocations per task of all workers
+  void PrintScratchSummary();
 
   const Config* const config_;
 
@@ -220,6 +303,24 @@ class Stats {
   std::array<TimeDurationsStats, kMaxThreads> worker_durations_;
   std::array<TimeDurationsStats, kMaxThreads> worker_durations_old_;
 
+  struct PublishedTaskStatSet {
+    std::array<PublishedTaskStat, kNumDoerTypes> task_stat_;
+    std::array<uint8_t, 64> false_sharing_padding_;
+  };
+  std::array<PublishedTaskStatSet, kMaxThreads> worker_published_tasks_;
+
+  struct NumaTaskStats {
+    NumaTaskStat numa_task_stat_;
+    std::array<uint8_t, 64> false_sharing_padding_;
+  };
+  std::array<NumaTaskStats, kMaxThreads> worker_numa_tasks_;
+
+  struct ScratchAllocStats {
+    ScratchAllocStat scratch_alloc_stat_;
+    std::array<uint8_t, 64> false_sharing_padding_;
+  };
+  std::array<ScratchAllocStats, kMaxThreads> worker_scratch_allocs_;
+
   std::array<std::array<double, kNumStatsFrames>, kNumDoerTypes> doer_us_;
   std::array<std::array<std::array<double, kNumStatsFrames>, kMaxStatBreakdown>,
              kNumDoerTypes>
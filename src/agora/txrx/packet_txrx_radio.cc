@@ -59,10 +59,10 @@ bool PacketTxRxRadio::StartTxRx(Table<complex_float>& calib_dl_buffer,
   //RadioStart creates the following: radio_config_->GetCalibDl() and radio_config_->GetCalibUl();
   if (cfg_->Frame().NumDLSyms() > 0) {
     std::memset(
-        calib_dl_buffer[kFrameWnd - 1], 0,
+        calib_dl_buffer[cfg_->FrameWnd() - 1], 0,
         cfg_->OfdmDataNum() * cfg_->BfAntNum() * sizeof(arma::cx_float));
     std::memset(
-        calib_ul_buffer[kFrameWnd - 1], 0,
+        calib_ul_buffer[cfg_->FrameWnd() - 1], 0,
         cfg_->OfdmDataNum() * cfg_->BfAntNum() * sizeof(arma::cx_float));
   }
 
@@ -15,8 +15,6 @@
 static constexpr bool kEnableSlowStart = true;
 static constexpr bool kDebugPrintBeacon = false;
 
-static constexpr size_t kSlowStartThresh1 = kFrameWnd;
-static constexpr size_t kSlowStartThresh2 = (kFrameWnd * 4);
 static constexpr size_t kSlowStartMulStage1 = 32;
 static constexpr size_t kSlowStartMulStage2 = 8;
 
@@ -71,6 +69,9 @@ void TxRxWorkerSim::DoTxRx() {
       std::max(kSlowStartMulStage1 * frame_tsc_delta, two_hundred_ms_ticks);
 
   const size_t slow_start_tsc2 = kSlowStartMulStage2 * frame_tsc_delta;
+  // The slow start stages end after one and four frame windows
+  const size_t slow_start_thresh1 = Configuration()->FrameWnd();
+  const size_t slow_start_thresh2 = Configuration()->FrameWnd() * 4;
   size_t delay_tsc = frame_tsc_delta;
 
   if (kEnableSlowStart) {
@@ -98,18 +99,18 @@ void TxRxWorkerSim::DoTxRx() {
       SendBeacon(tx_frame_id++);
 
       if (kEnableSlowStart) {
-        if (tx_frame_id == kSlowStartThresh1) {
+        if (tx_frame_id == slow_start_thresh1) {
           delay_tsc = slow_start_tsc2;
           AGORA_LOG_TRACE(
               "TxRxWorkerSim[%zu]: increasing beacon rate at frame %zu time "
               "%zu\n",
-              tid_, kSlowStartThresh1, rdtsc_now);
-        } else if (tx_frame_id == kSlowStartThresh2) {
+              tid_, slow_start_thresh1, rdtsc_now);
+        } else if (tx_frame_id == slow_start_thresh2) {
           delay_tsc = frame_tsc_delta;
           AGORA_LOG_TRACE(
               "TxRxWorkerSim[%zu]: increasing beacon rate to full speed at "
               "frame %zu time %zu\n",
-              tid_, kSlowStartThresh2, rdtsc_now);
+              tid_, slow_start_thresh2, rdtsc_now);
         }
       }
       tx_frame_start = send_time;
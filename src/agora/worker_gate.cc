@@ -0,0 +1,159 @@
+/**
+ * @file worker_gate.cc
+ * @brief Implementation file for the WorkerGate class
+ */
+#include "worker_gate.h"
+
+#include <cpuid.h>
+#include <immintrin.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <climits>
+#include <ctime>
+#include <stdexcept>
+
+#include "gettime.h"
+#include "logger.h"
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) &&
+                  std::atomic<uint32_t>::is_always_lock_free,
+              "Futex words must be plain 32-bit integers");
+
+// Bound on one sleep of an idle worker, in case a scheduler does not call
+// Notify()
+static constexpr size_t kIdleSleepUs = 1000;
+// Parked workers recheck their state this often
+static constexpr size_t kParkSleepUs = 100000;
+// Longest single umwait, in TSC cycles. The OS may cap it further.
+static constexpr size_t kUmwaitCycles = 100000;
+
+static WorkerGate::IdleWait SupportedIdleWait(WorkerGate::IdleWait idle_wait) {
+  if ((idle_wait == WorkerGate::IdleWait::kUmwait) &&
+      (WorkerGate::UmwaitSupported() == false)) {
+    AGORA_LOG_WARN("WorkerGate: umwait is not supported, using futex\n");
+    return WorkerGate::IdleWait::kFutex;
+  }
+  return idle_wait;
+}
+
+WorkerGate::WorkerGate(size_t num_workers, IdleWait idle_wait,
+                       size_t spin_cycles)
+    : num_workers_(num_workers),
+      idle_wait_(SupportedIdleWait(idle_wait)),
+      spin_cycles_(spin_cycles),
+      active_(num_workers) {}
+
+WorkerGate::IdleWait WorkerGate::ParseIdleWait(const std::string& name) {
+  if (name == "spin") {
+    return IdleWait::kSpin;
+  } else if (name == "umwait") {
+    return IdleWait::kUmwait;
+  } else if (name == "futex") {
+    return IdleWait::kFutex;
+  }
+  throw std::runtime_error("Unknown worker idle wait " + name);
+}
+
+bool WorkerGate::UmwaitSupported() {
+#ifdef __WAITPKG__
+  unsigned int eax;
+  unsigned int ebx;
+  unsigned int ecx;
+  unsigned int edx;
+  // CPUID.(EAX=07H, ECX=0):ECX[bit 5] is WAITPKG
+  return (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) != 0) &&
+         ((ecx & (1u << 5)) != 0);
+#else
+  return false;
+#endif
+}
+
+void WorkerGate::Busy(IdleState& state) {
+  if (state.armed_) {
+    num_waiting_.fetch_sub(1);
+    state.armed_ = false;
+  }
+  state.idle_ = false;
+}
+
+void WorkerGate::Idle(IdleState& state) {
+  if (idle_wait_ == IdleWait::kSpin) {
+    _mm_pause();
+    return;
+  }
+  if (state.idle_ == false) {
+    state.idle_ = true;
+    state.idle_start_tsc_ = GetTime::Rdtsc();
+    return;
+  }
+  if (state.armed_ == false) {
+    if (GetTime::Rdtsc() - state.idle_start_tsc_ < spin_cycles_) {
+      _mm_pause();
+      return;
+    }
+    // Count this worker as waiting before its last passes over the queues.
+    // Tasks scheduled after that see it and Notify().
+    state.wake_seq_ = wake_seq_.load();
+    num_waiting_.fetch_add(1);
+    state.armed_ = true;
+    state.armed_passes_ = 0;
+    return;
+  }
+  if (state.armed_passes_ < kArmedPasses) {
+    state.armed_passes_++;
+    _mm_pause();
+    return;
+  }
+
+  if (idle_wait_ == IdleWait::kUmwait) {
+#ifdef __WAITPKG__
+    _umonitor(&wake_seq_);
+    if (wake_seq_.load() == state.wake_seq_) {
+      // C0.2, the deeper of the two light sleep states
+      _umwait(0, GetTime::Rdtsc() + kUmwaitCycles);
+    }
+#endif
+  } else {
+    Sleep(wake_seq_, state.wake_seq_, kIdleSleepUs);
+  }
+  num_waiting_.fetch_sub(1);
+  state.armed_ = false;
+}
+
+void WorkerGate::SetActive(size_t count) {
+  active_.store(std::clamp<size_t>(count, 1, num_workers_));
+  WakeAll(active_);
+}
+
+void WorkerGate::WaitActive(size_t tid) {
+  uint32_t active = active_.load();
+  while ((tid >= active) && (released_.load() == false)) {
+    Sleep(active_, active, kParkSleepUs);
+    active = active_.load();
+  }
+}
+
+void WorkerGate::Release() {
+  released_.store(true);
+  wake_seq_.fetch_add(1);
+  WakeAll(wake_seq_);
+  WakeAll(active_);
+}
+
+void WorkerGate::Sleep(std::atomic<uint32_t>& word, uint32_t expected,
+                       size_t timeout_us) {
+  struct timespec timeout;
+  timeout.tv_sec = timeout_us / 1000000;
+  timeout.tv_nsec = (timeout_us % 1000000) * 1000;
+  // Returns at once if the word no longer holds the expected value
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE,
+          expected, &timeout, nullptr, 0);
+}
+
+void WorkerGate::WakeAll(std::atomic<uint32_t>& word) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE,
+          INT_MAX, nullptr, nullptr, 0);
+}
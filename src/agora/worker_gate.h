@@ -0,0 +1,93 @@
+/**
+ * @file worker_gate.h
+ * @brief Declaration file for the WorkerGate class, which lets idle workers
+ * back off instead of spinning at full speed, and parks the workers beyond
+ * the active worker count
+ */
+#ifndef WORKER_GATE_H_
+#define WORKER_GATE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class WorkerGate {
+ public:
+  /// How a worker waits once it found no task for the spin time
+  enum class IdleWait { kSpin, kUmwait, kFutex };
+
+  /// Empty passes between arming and sleeping, enough for a worker to look
+  /// at both sets of task queues after it counted itself as waiting
+  static constexpr size_t kArmedPasses = 16;
+
+  /// Idle tracking of one worker, owned by the worker thread
+  struct IdleState {
+    bool idle_{false};
+    size_t idle_start_tsc_{0};
+    // Counted as waiting. Sleeps after kArmedPasses more empty passes.
+    bool armed_{false};
+    size_t armed_passes_{0};
+    uint32_t wake_seq_{0};
+  };
+
+  /// [idle_wait] falls back to kFutex if umwait is not supported. Idle
+  /// workers spin for [spin_cycles] before they sleep.
+  WorkerGate(size_t num_workers, IdleWait idle_wait, size_t spin_cycles);
+
+  /// Map the worker_idle_wait config value to its IdleWait
+  static IdleWait ParseIdleWait(const std::string& name);
+  /// True if both the build and this CPU support umonitor/umwait
+  static bool UmwaitSupported();
+
+  inline IdleWait Wait() const { return this->idle_wait_; }
+
+  /// A pass over the task queues found a task
+  void Busy(IdleState& state);
+
+  /// A pass over the task queues found nothing. Pauses, or sleeps until
+  /// Notify() or a timeout once the worker has been idle for the spin time.
+  void Idle(IdleState& state);
+
+  /// Wake the sleeping workers after scheduling tasks. Costs a fence and an
+  /// atomic load if no worker sleeps.
+  inline void Notify() {
+    // Orders the scheduler's enqueues before the load, as the fetch_add in
+    // Idle() orders the worker's count before its last pass
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (this->num_waiting_.load() > 0) {
+      this->wake_seq_.fetch_add(1);
+      if (this->idle_wait_ == IdleWait::kFutex) {
+        WakeAll(this->wake_seq_);
+      }
+    }
+  }
+
+  /// Workers [0, count) take tasks and the others park. [count] is clamped
+  /// to [1, number of workers].
+  void SetActive(size_t count);
+  inline size_t Active() const { return this->active_.load(); }
+
+  /// Block worker [tid] while it is parked, until SetActive() or Release()
+  void WaitActive(size_t tid);
+
+  /// Wake all parked and sleeping workers for good, to let them exit
+  void Release();
+
+ private:
+  static void Sleep(std::atomic<uint32_t>& word, uint32_t expected,
+                    size_t timeout_us);
+  static void WakeAll(std::atomic<uint32_t>& word);
+
+  const size_t num_workers_;
+  const IdleWait idle_wait_;
+  const size_t spin_cycles_;
+
+  // Incremented by Notify(). Sleeping workers wait for it to change.
+  alignas(64) std::atomic<uint32_t> wake_seq_{0};
+  std::atomic<size_t> num_waiting_{0};
+  alignas(64) std::atomic<uint32_t> active_;
+  std::atomic<bool> released_{false};
+};
+
+#endif  // WORKER_GATE_H_
@@ -17,8 +17,8 @@ static constexpr size_t kVarNodesSize = 1024 * 1024 * sizeof(int16_t);
 
 DoDecodeClient::DoDecodeClient(
     Config* in_config, int in_tid,
-    PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& demod_buffers,
-    PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& decoded_buffers,
+    PtrCube<int8_t>& demod_buffers,
+    PtrCube<int8_t>& decoded_buffers,
     PhyStats* in_phy_stats, Stats* in_stats_manager)
     : Doer(in_config, in_tid),
       demod_buffers_(demod_buffers),
@@ -43,7 +43,7 @@ EventData DoDecodeClient::Launch(size_t tag) {
       cfg_->GetTotalDataSymbolIdxDl(frame_id, symbol_idx_dl);
   const size_t cur_cb_id = (cb_id % ldpc_config.NumBlocksInSymbol());
   const size_t ue_id = (cb_id / ldpc_config.NumBlocksInSymbol());
-  const size_t frame_slot = (frame_id % kFrameWnd);
+  const size_t frame_slot = cfg_->FrameSlot(frame_id);
 
   if (kDebugPrintInTask == true) {
     AGORA_LOG_INFO(
@@ -115,26 +115,22 @@ EventData DoDecodeClient::Launch(size_t tag) {
     AGORA_LOG_INFO("\n");
   }
 
+  // Check every BerSampleInterval()-th codeblock of each UE
   if ((kEnableMac == false) && (kPrintPhyStats == true) &&
-      (symbol_idx_dl >= cfg_->Frame().ClientDlPilotSymbols())) {
+      (symbol_idx_dl >= cfg_->Frame().ClientDlPilotSymbols()) &&
+      ((symbol_offset * ldpc_config.NumBlocksInSymbol() + cur_cb_id) %
+           cfg_->BerSampleInterval() ==
+       0)) {
     phy_stats_->UpdateDecodedBits(
-        ue_id, symbol_offset, frame_slot,
+        tid_, ue_id, frame_slot,
         cfg_->NumBytesPerCb(Direction::kDownlink) * 8);
-    phy_stats_->IncrementDecodedBlocks(ue_id, symbol_offset, frame_slot);
-    size_t block_error(0);
-    for (size_t i = 0; i < cfg_->NumBytesPerCb(Direction::kDownlink); i++) {
-      uint8_t rx_byte = decoded_buffer_ptr[i];
-      auto tx_byte = static_cast<uint8_t>(
-          cfg_->GetInfoBits(cfg_->DlBits(), Direction::kDownlink, symbol_idx_dl,
-                            kDebugDownlink ? 0 : ue_id, cur_cb_id)[i]);
-      phy_stats_->UpdateBitErrors(ue_id, symbol_offset, frame_slot, tx_byte,
-                                  rx_byte);
-      if (rx_byte != tx_byte) {
-        block_error++;
-      }
-    }
-    phy_stats_->UpdateBlockErrors(ue_id, symbol_offset, frame_slot,
-                                  block_error);
+    phy_stats_->IncrementDecodedBlocks(tid_, ue_id, frame_slot);
+    phy_stats_->UpdateBlockBitErrors(
+        tid_, ue_id, frame_slot,
+        reinterpret_cast<const uint8_t*>(cfg_->GetInfoBits(
+            cfg_->DlBits(), Direction::kDownlink, symbol_idx_dl,
+            kDebugDownlink ? 0 : ue_id, cur_cb_id)),
+        decoded_buffer_ptr, cfg_->NumBytesPerCb(Direction::kDownlink));
   }
 
   size_t duration = GetTime::WorkerRdtsc() - start_tsc;
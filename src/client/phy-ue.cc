@@ -44,10 +44,11 @@ static const std::vector<Agora_recorder::RecorderWorker::RecorderWorkerTypes>
 PhyUe::PhyUe(Config* config)
     : stats_(std::make_unique<Stats>(config)),
       phy_stats_(std::make_unique<PhyStats>(config, Direction::kDownlink)),
-      demod_buffer_(kFrameWnd, config->Frame().NumDLSyms(), config->UeAntNum(),
+      demod_buffer_(config->FrameWnd(), config->Frame().NumDLSyms(),
+                    config->UeAntNum(),
                     kMaxModType * Roundup<64>(config->GetOFDMDataNum())),
       decoded_buffer_(
-          kFrameWnd, config->Frame().NumDLSyms(), config->UeAntNum(),
+          config->FrameWnd(), config->Frame().NumDLSyms(), config->UeAntNum(),
           config->LdpcConfig(Direction::kDownlink).NumBlocksInSymbol() *
               Roundup<64>(config->NumBytesPerCb(Direction::kDownlink))) {
   srand(time(nullptr));
@@ -61,6 +62,7 @@ PhyUe::PhyUe(Config* config)
     non_null_sc_ind_.push_back(i);
   }
 
+  next_frame_processed_.assign(config_->UeAntNum(), 0);
   ue_pilot_vec_.resize(config_->UeAntNum());
   for (size_t i = 0; i < config_->UeAntNum(); i++) {
     const size_t pilot_len_samples =
@@ -75,15 +77,15 @@ PhyUe::PhyUe(Config* config)
   }
 
   complete_queue_ = moodycamel::ConcurrentQueue<EventData>(
-      kFrameWnd * config_->Frame().NumTotalSyms() * config_->UeAntNum() *
-      kDefaultQueueSize);
+      config_->FrameWnd() * config_->Frame().NumTotalSyms() *
+      config_->UeAntNum() * kDefaultQueueSize);
   work_queue_ = moodycamel::ConcurrentQueue<EventData>(
-      kFrameWnd * config_->Frame().NumTotalSyms() * config_->UeAntNum() *
-      kDefaultQueueSize);
+      config_->FrameWnd() * config_->Frame().NumTotalSyms() *
+      config_->UeAntNum() * kDefaultQueueSize);
   tx_queue_ = moodycamel::ConcurrentQueue<EventData>(
-      kFrameWnd * config_->UeAntNum() * kDefaultQueueSize);
+      config_->FrameWnd() * config_->UeAntNum() * kDefaultQueueSize);
   to_mac_queue_ = moodycamel::ConcurrentQueue<EventData>(
-      kFrameWnd * config_->UeAntNum() * kDefaultQueueSize);
+      config_->FrameWnd() * config_->UeAntNum() * kDefaultQueueSize);
 
   for (size_t i = 0; i < rx_thread_num_; i++) {
     rx_ptoks_ptr_[i] = new moodycamel::ProducerToken(complete_queue_);
@@ -142,8 +144,8 @@ PhyUe::PhyUe(Config* config)
     auto& new_recorder = recorders_.emplace_back(
         std::make_unique<Agora_recorder::RecorderThread>(
             config_, 0, core_offset_worker + config_->UeWorkerThreadNum(),
-            kFrameWnd * config_->Frame().NumTotalSyms() * config_->UeAntNum() *
-                kDefaultQueueSize,
+            config_->FrameWnd() * config_->Frame().NumTotalSyms() *
+                config_->UeAntNum() * kDefaultQueueSize,
             0, config_->UeAntNum(), kRecordFrameInterval, Direction::kDownlink,
             kRecorderTypes, true));
     new_recorder->Start();
@@ -151,40 +153,52 @@ PhyUe::PhyUe(Config* config)
 
   // initilize all kinds of checkers
   // Init the frame work tracking structure
+  const size_t frame_wnd = config_->FrameWnd();
+  const size_t num_symbols = config_->Frame().NumTotalSyms();
+  frame_tasks_.resize(frame_wnd);
   for (size_t frame = 0; frame < this->frame_tasks_.size(); frame++) {
     FrameInit(frame);
   }
-  decode_counters_.Init(dl_data_symbol_perframe_, config_->UeAntNum());
-  demul_counters_.Init(dl_data_symbol_perframe_, config_->UeAntNum());
-  fft_dlpilot_counters_.Init(config->Frame().ClientDlPilotSymbols(),
+  decode_counters_.Init(frame_wnd, num_symbols, dl_data_symbol_perframe_,
+                        config_->UeAntNum());
+  demul_counters_.Init(frame_wnd, num_symbols, dl_data_symbol_perframe_,
+                       config_->UeAntNum());
+  fft_dlpilot_counters_.Init(frame_wnd, num_symbols,
+                             config->Frame().ClientDlPilotSymbols(),
                              config_->UeAntNum());
-  fft_dldata_counters_.Init(dl_data_symbol_perframe_, config_->UeAntNum());
+  fft_dldata_counters_.Init(frame_wnd, num_symbols, dl_data_symbol_perframe_,
+                            config_->UeAntNum());
 
   /* Each UE / Radio will send a TxComplete */
-  tx_counters_.Init(config_->UeAntNum());
-  encode_counter_.Init(ul_data_symbol_perframe_, config_->UeAntNum());
-  modulation_counters_.Init(ul_data_symbol_perframe_, config_->UeAntNum());
+  tx_counters_.Init(frame_wnd, num_symbols, config_->UeAntNum());
+  encode_counter_.Init(frame_wnd, num_symbols, ul_data_symbol_perframe_,
+                       config_->UeAntNum());
+  modulation_counters_.Init(frame_wnd, num_symbols, ul_data_symbol_perframe_,
+                            config_->UeAntNum());
 
   const size_t num_ue = config_->UeNum();
   ue_tracker_.reserve(num_ue);
   ue_tracker_.resize(num_ue);
   for (auto& ue : ue_tracker_) {
-    ue.ifft_counters_.Init(ul_symbol_perframe_, config_->NumUeChannels());
+    ue.ifft_counters_.Init(frame_wnd, num_symbols, ul_symbol_perframe_,
+                           config_->NumUeChannels());
     ue.tx_pending_frame_ = 0;
     ue.tx_ready_frames_.clear();
   }
 
   // This usage doesn't effect the user num_reciprocity_pkts_per_frame_;
+  rx_counters_.Init(frame_wnd);
   rx_counters_.num_rx_pkts_per_frame_ =
       config_->UeAntNum() *
       (config_->Frame().NumDLSyms() + config_->Frame().NumBeaconSyms());
   rx_counters_.num_pilot_pkts_per_frame_ =
       config_->UeAntNum() * config_->Frame().ClientDlPilotSymbols();
 
-  rx_downlink_deferral_.resize(kFrameWnd);
+  rx_downlink_deferral_.resize(frame_wnd);
 
   // Mac counters for downlink data
-  tomac_counters_.Init(config_->Frame().NumDlDataSyms(), config_->UeAntNum());
+  tomac_counters_.Init(frame_wnd, num_symbols, config_->Frame().NumDlDataSyms(),
+                       config_->UeAntNum());
 }
 
 PhyUe::~PhyUe() {
@@ -240,7 +254,7 @@ void PhyUe::ScheduleWork(EventData do_task) {
 }
 
 void PhyUe::ReceiveDownlinkSymbol(Packet* rx_packet, size_t tag) {
-  const size_t frame_slot = rx_packet->frame_id_ % kFrameWnd;
+  const size_t frame_slot = config_->FrameSlot(rx_packet->frame_id_);
   const size_t dl_symbol_idx =
       config_->Frame().GetDLSymbolIdx(rx_packet->symbol_id_);
 
@@ -259,7 +273,7 @@ void PhyUe::ReceiveDownlinkSymbol(Packet* rx_packet, size_t tag) {
 }
 
 void PhyUe::ScheduleDefferedDownlinkSymbols(size_t frame_id) {
-  const size_t frame_slot = frame_id % kFrameWnd;
+  const size_t frame_slot = config_->FrameSlot(frame_id);
   // Complete the csi offset
   const size_t csi_offset_base = frame_slot * config_->UeAntNum();
 
@@ -283,7 +297,7 @@ void PhyUe::ScheduleDefferedDownlinkSymbols(size_t frame_id) {
 }
 
 void PhyUe::ClearCsi(size_t frame_id) {
-  const size_t frame_slot = frame_id % kFrameWnd;
+  const size_t frame_slot = config_->FrameSlot(frame_id);
 
   if (config_->Frame().ClientDlPilotSymbols() > 0) {
     const size_t csi_offset_base = frame_slot * config_->UeAntNum();
@@ -312,7 +326,8 @@ void PhyUe::Stop() {
 void PhyUe::Start() {
   PinToCoreWithOffset(ThreadType::kMaster, config_->UeCoreOffset(), 0);
   Table<complex_float> calib_buffer;
-  calib_buffer.Malloc(kFrameWnd, config_->UeAntNum() * config_->OfdmDataNum(),
+  calib_buffer.Malloc(config_->FrameWnd(),
+                      config_->UeAntNum() * config_->OfdmDataNum(),
                       Agora_memory::Alignment_t::kAlign64);
 
   const bool start_status = ru_->StartTxRx(calib_buffer, calib_buffer);
@@ -370,8 +385,8 @@ void PhyUe::Start() {
           const size_t frame_id = pkt->frame_id_;
           const size_t symbol_id = pkt->symbol_id_;
           const size_t ant_id = pkt->ant_id_;
-          const size_t frame_slot = frame_id % kFrameWnd;
-          RtAssert(pkt->frame_id_ < (cur_frame_id + kFrameWnd),
+          const size_t frame_slot = config_->FrameSlot(frame_id);
+          RtAssert(pkt->frame_id_ < (cur_frame_id + config_->FrameWnd()),
                    "Error: Received packet for future frame beyond frame "
                    "window. This can happen if PHY is running "
                    "slowly, e.g., in debug mode");
@@ -381,8 +396,7 @@ void PhyUe::Start() {
           if (rx_counters_.num_pkts_.at(frame_slot) == 0) {
             this->stats_->MasterSetTsc(TsType::kFirstSymbolRX, frame_id);
             if (kDebugPrintPerFrameStart) {
-              const size_t prev_frame_slot =
-                  (frame_slot + kFrameWnd - 1) % kFrameWnd;
+              const size_t prev_frame_slot = config_->FrameSlot(frame_id - 1);
               AGORA_LOG_INFO(
                   "PhyUe [frame %zu + %.2f ms since last frame]: Received "
                   "first packet. Remaining packets in prev frame: %zu\n",
@@ -637,8 +651,9 @@ void PhyUe::Start() {
           // This is an entire frame (multiple mac packets)
           const size_t ue_id = rx_mac_tag_t(event.tags_[0]).tid_;
           const size_t radio_buf_id = rx_mac_tag_t(event.tags_[0]).offset_;
-          RtAssert(radio_buf_id == (expected_frame_id_from_mac_ % kFrameWnd),
-                   "Radio buffer id does not match expected");
+          RtAssert(
+              radio_buf_id == config_->FrameSlot(expected_frame_id_from_mac_),
+              "Radio buffer id does not match expected");
 
           const auto* pkt = reinterpret_cast<const MacPacketPacked*>(
               &ul_bits_buffer_[ue_id]
@@ -835,8 +850,8 @@ void PhyUe::Start() {
           RtAssert(frame_id == next_frame_processed_[ue_ant],
                    "PhyUe: Unexpected frame was transmitted!");
 
-          ul_bits_buffer_status_[ue_ant]
-                                [next_frame_processed_[ue_ant] % kFrameWnd] = 0;
+          ul_bits_buffer_status_[ue_ant][config_->FrameSlot(
+              next_frame_processed_[ue_ant])] = 0;
           next_frame_processed_[ue_ant]++;
 
           PrintPerTaskDone(PrintType::kPacketTX, frame_id, 0, ue_ant);
@@ -886,30 +901,31 @@ void PhyUe::InitializeVarsFromCfg() {
           ? config_->UeNum()
           : std::min(config_->UeNum(), config_->UeSocketThreadNum());
 
-  tx_buffer_size_ = config_->PacketLength() *
-                    (ul_symbol_perframe_ * config_->UeAntNum() * kFrameWnd);
+  tx_buffer_size_ =
+      config_->PacketLength() *
+      (ul_symbol_perframe_ * config_->UeAntNum() * config_->FrameWnd());
 
   rx_buffer_size_ = config_->DlPacketLength() *
                     (dl_symbol_perframe_ + config_->Frame().NumBeaconSyms()) *
-                    config_->UeAntNum() * kFrameWnd;
+                    config_->UeAntNum() * config_->FrameWnd();
 }
 
 void PhyUe::InitializeUplinkBuffers() {
   // initialize ul data buffer
   ul_bits_buffer_size_ =
-      kFrameWnd * config_->MacBytesNumPerframe(Direction::kUplink);
+      config_->FrameWnd() * config_->MacBytesNumPerframe(Direction::kUplink);
   ul_bits_buffer_.Malloc(config_->UeAntNum(), ul_bits_buffer_size_,
                          Agora_memory::Alignment_t::kAlign64);
-  ul_bits_buffer_status_.Calloc(config_->UeAntNum(), kFrameWnd,
+  ul_bits_buffer_status_.Calloc(config_->UeAntNum(), config_->FrameWnd(),
                                 Agora_memory::Alignment_t::kAlign64);
 
   // Temp -- Using more memory than necessary to comply with the DoEncode
   // function which uses the total number of ul symbols offset (instead of
   // just the data specific ones) ul_syms_buffer_size_ =
-  //    kFrameWnd * ul_symbol_perframe_ * config_->OfdmDataNum();
+  //    config_->FrameWnd() * ul_symbol_perframe_ * config_->OfdmDataNum();
   // ul_syms_buffer_.Calloc(config_->UeAntNum(), ul_syms_buffer_size_,
   //                       Agora_memory::Alignment_t::kAlign64);
-  const size_t ul_syms_buffer_dim1 = ul_symbol_perframe_ * kFrameWnd;
+  const size_t ul_syms_buffer_dim1 = ul_symbol_perframe_ * config_->FrameWnd();
   const size_t ul_syms_buffer_dim2 =
       Roundup<64>(config_->OfdmDataNum()) * config_->UeAntNum();
 
@@ -923,7 +939,7 @@ void PhyUe::InitializeUplinkBuffers() {
 
   // initialize IFFT buffer
   const size_t ifft_buffer_block_num =
-      config_->UeAntNum() * ul_symbol_perframe_ * kFrameWnd;
+      config_->UeAntNum() * ul_symbol_perframe_ * config_->FrameWnd();
   ifft_buffer_.Calloc(ifft_buffer_block_num, config_->OfdmCaNum(),
                       Agora_memory::Alignment_t::kAlign64);
 
@@ -948,12 +964,13 @@ void PhyUe::InitializeDownlinkBuffers() {
 
   // initialize FFT buffer
   size_t fft_buffer_block_num =
-      config_->UeAntNum() * dl_symbol_perframe_ * kFrameWnd;
+      config_->UeAntNum() * dl_symbol_perframe_ * config_->FrameWnd();
   fft_buffer_.Calloc(fft_buffer_block_num, config_->OfdmCaNum(),
                      Agora_memory::Alignment_t::kAlign64);
 
   // initialize CSI buffer
-  csi_buffer_.Calloc(config_->UeAntNum() * kFrameWnd, config_->OfdmDataNum(),
+  csi_buffer_.Calloc(config_->UeAntNum() * config_->FrameWnd(),
+                     config_->OfdmDataNum(),
                      Agora_memory::Alignment_t::kAlign64);
   assert(reinterpret_cast<size_t>(csi_buffer_[0]) % 64 == 0);
   if (config_->Frame().ClientDlPilotSymbols() == 0) {
@@ -969,7 +986,7 @@ void PhyUe::InitializeDownlinkBuffers() {
   if (dl_data_symbol_perframe_ > 0) {
     // initialize equalized data buffer
     const size_t task_buffer_symbol_num_dl =
-        dl_data_symbol_perframe_ * kFrameWnd;
+        dl_data_symbol_perframe_ * config_->FrameWnd();
     size_t buffer_size = config_->UeAntNum() * task_buffer_symbol_num_dl;
     equal_buffer_.resize(buffer_size);
     for (auto& i : equal_buffer_) {
@@ -1245,13 +1262,14 @@ void PhyUe::FrameInit(size_t frame) {
   if ((kEnableMac == false) || (config_->Frame().NumDLSyms() == 0)) {
     initial |= static_cast<std::uint8_t>(FrameTasksFlags::kMacTxComplete);
   }
-  frame_tasks_.at(frame % kFrameWnd) = initial;
+  frame_tasks_.at(config_->FrameSlot(frame)) = initial;
 }
 
 bool PhyUe::FrameComplete(size_t frame, FrameTasksFlags complete) {
-  frame_tasks_.at(frame % kFrameWnd) |= static_cast<std::uint8_t>(complete);
+  frame_tasks_.at(config_->FrameSlot(frame)) |=
+      static_cast<std::uint8_t>(complete);
   bool is_complete =
-      (frame_tasks_.at(frame % kFrameWnd) ==
+      (frame_tasks_.at(config_->FrameSlot(frame)) ==
        static_cast<std::uint8_t>(FrameTasksFlags::kFrameComplete));
   return is_complete;
 }
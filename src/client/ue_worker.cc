@@ -5,12 +5,14 @@
  */
 #include "ue_worker.h"
 
+#include <array>
 #include <memory>
 #include <utility>
 
 #include "comms-lib.h"
 #include "datatype_conversion.h"
 #include "logger.h"
+#include "memory_arena.h"
 #include "modulation.h"
 #include "phy_ldpc_decoder_5gnr.h"
 #include "phy_stats.h"
@@ -39,8 +41,8 @@ UeWorker::UeWorker(
     Table<char>& rx_buffer, Table<complex_float>& csi_buffer,
     std::vector<SimdAlignCxFltVector>& equal_buffer,
     std::vector<size_t>& non_null_sc_ind, Table<complex_float>& fft_buffer,
-    PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& demod_buffer,
-    PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& decoded_buffer,
+    PtrCube<int8_t>& demod_buffer,
+    PtrCube<int8_t>& decoded_buffer,
     std::vector<std::vector<std::complex<float>>>& ue_pilot_vec)
     : tid_(tid),
       notify_queue_(notify_queue),
@@ -99,7 +101,8 @@ void UeWorker::TaskThread(size_t core_offset) {
   auto encoder = std::make_unique<DoEncode>(
       &config_, (int)tid_, Direction::kUplink,
       (kEnableMac == true) ? ul_bits_buffer_ : config_.UlBits(),
-      (kEnableMac == true) ? kFrameWnd : 1, encoded_buffer_, &stats_);
+      (kEnableMac == true) ? config_.FrameWnd() : 1, encoded_buffer_,
+      &stats_);
 
   auto iffter = std::make_unique<DoIFFTClient>(
       &config_, (int)tid_, ifft_buffer_, tx_buffer_, &stats_);
@@ -108,10 +111,15 @@ void UeWorker::TaskThread(size_t core_offset) {
       std::make_unique<DoDecodeClient>(&config_, (int)tid_, demod_buffer_,
                                        decoded_buffer_, &phy_stats_, &stats_);
 
+  // Task scratch memory, allocation free once it has grown to the largest task
+  MemoryArena& arena = MemoryArena::ThreadLocal();
+  ScratchAllocStat* scratch_stat = stats_.GetScratchAllocStat(tid_);
+
   EventData event;
   while (config_.Running() == true) {
     if (work_queue_.try_dequeue_from_producer(work_producer_token_, event) ==
         true) {
+      scratch_stat->BeginTask();
       switch (event.event_type_) {
         case EventType::kDecode: {
           DoDecodeUe(decoder.get(), event.tags_[0]);
@@ -140,6 +148,7 @@ void UeWorker::TaskThread(size_t core_offset) {
                          static_cast<int>(event.event_type_));
         }
       }
+      scratch_stat->EndTask(arena);
     }  // end dequeue
   }
 }
@@ -156,7 +165,7 @@ void UeWorker::DoFftPilot(size_t tag) {
   const size_t frame_id = pkt->frame_id_;
   const size_t symbol_id = pkt->symbol_id_;
   const size_t ant_id = pkt->ant_id_;
-  const size_t frame_slot = frame_id % kFrameWnd;
+  const size_t frame_slot = config_.FrameSlot(frame_id);
 
   if (kDebugPrintInTask || kDebugPrintFft) {
     AGORA_LOG_INFO("UeWorker[%zu]: Fft Pilot(frame %zu, symbol %zu, ant %zu)\n",
@@ -203,8 +212,8 @@ void UeWorker::DoFftPilot(size_t tag) {
   DftiComputeForward(mkl_handle_, fft_buffer_[fft_buffer_target_id]);
 
   //// FFT shift the buffer
-  std::vector<complex_float> temp_fft_buf(config_.OfdmCaNum());
-  auto* temp_buff = reinterpret_cast<complex_float*>(temp_fft_buf.data());
+  auto* temp_buff =
+      MemoryArena::ThreadLocal().Alloc<complex_float>(config_.OfdmCaNum());
   auto* fft_buff_complex =
       reinterpret_cast<complex_float*>(fft_buffer_[fft_buffer_target_id]);
   CommsLib::FFTShift(fft_buff_complex, temp_buff, config_.OfdmCaNum());
@@ -259,7 +268,7 @@ void UeWorker::DoFftData(size_t tag) {
   const size_t frame_id = pkt->frame_id_;
   const size_t symbol_id = pkt->symbol_id_;
   const size_t ant_id = pkt->ant_id_;
-  const size_t frame_slot = frame_id % kFrameWnd;
+  const size_t frame_slot = config_.FrameSlot(frame_id);
 
   if (kDebugPrintInTask || kDebugPrintFft) {
     AGORA_LOG_INFO("UeWorker[%zu]: Fft Data(frame %zu, symbol %zu, ant %zu)\n",
@@ -286,8 +295,8 @@ void UeWorker::DoFftData(size_t tag) {
   DftiComputeForward(mkl_handle_, fft_buffer_[fft_buffer_target_id]);
 
   //// FFT shift the buffer
-  std::vector<complex_float> temp_fft_buf(config_.OfdmCaNum());
-  auto* temp_buff = reinterpret_cast<complex_float*>(temp_fft_buf.data());
+  auto* temp_buff =
+      MemoryArena::ThreadLocal().Alloc<complex_float>(config_.OfdmCaNum());
   auto* fft_buff_complex =
       reinterpret_cast<complex_float*>(fft_buffer_[fft_buffer_target_id]);
   CommsLib::FFTShift(fft_buff_complex, temp_buff, config_.OfdmCaNum());
@@ -336,8 +345,8 @@ void UeWorker::DoFftData(size_t tag) {
       if (kCollectPhyStats) {
         const size_t dl_data_symbol_id =
             dl_symbol_id - config_.Frame().ClientDlPilotSymbols();
-        phy_stats_.UpdateEvm(frame_id, dl_data_symbol_id, j, ant, ant_id,
-                             equ_buffer_ptr[data_sc_id]);
+        phy_stats_.UpdateEvm(tid_, frame_id, dl_data_symbol_id, j, ant,
+                             ant_id, equ_buffer_ptr[data_sc_id]);
       }
       complex_float tx =
           config_.DlIqF()[dl_symbol_id][ant * config_.OfdmDataNum() + j];
@@ -396,7 +405,7 @@ void UeWorker::DoDemul(size_t tag) {
   }
   const size_t start_tsc = GetTime::Rdtsc();
 
-  const size_t frame_slot = frame_id % kFrameWnd;
+  const size_t frame_slot = config_.FrameSlot(frame_id);
   const size_t dl_symbol_id = config_.Frame().GetDLSymbolIdx(symbol_id);
   const size_t dl_data_symbol_perframe = config_.Frame().NumDlDataSyms();
   const size_t total_dl_symbol_id = frame_slot * dl_data_symbol_perframe +
@@ -445,28 +454,21 @@ void UeWorker::DoDemul(size_t tag) {
   if (kDownlinkHardDemod && (kPrintPhyStats || kEnableCsvLog) &&
       (dl_symbol_id >= config_.Frame().ClientDlPilotSymbols())) {
     phy_stats_.UpdateDecodedBits(
-        ant_id, total_dl_symbol_id, frame_slot,
+        tid_, ant_id, frame_slot,
         config_.GetOFDMDataNum() * config_.ModOrderBits(Direction::kDownlink));
-    phy_stats_.IncrementDecodedBlocks(ant_id, total_dl_symbol_id, frame_slot);
+    phy_stats_.IncrementDecodedBlocks(tid_, ant_id, frame_slot);
     int8_t* tx_bytes = config_.GetModBitsBuf(
         config_.DlModBits(), Direction::kDownlink, 0, dl_symbol_id,
         kDebugDownlink ? 0 : ant_id, base_sc_id);
-    size_t block_error(0);
-    for (size_t i = 0; i < config_.GetOFDMDataNum(); i++) {
-      uint8_t rx_byte = static_cast<uint8_t>(demod_ptr[i]);
-      uint8_t tx_byte = static_cast<uint8_t>(tx_bytes[i]);
-      phy_stats_.UpdateBitErrors(ant_id, total_dl_symbol_id, frame_slot,
-                                 tx_byte, rx_byte);
-      if (rx_byte != tx_byte) {
-        block_error++;
-      }
-    }
+    const size_t block_error = phy_stats_.UpdateBlockBitErrors(
+        tid_, ant_id, frame_slot,
+        reinterpret_cast<const uint8_t*>(tx_bytes),
+        reinterpret_cast<const uint8_t*>(demod_ptr),
+        config_.GetOFDMDataNum());
     if (kPrintPhyStats && block_error > 0) {
       AGORA_LOG_INFO("Frame %zu Symbol %zu Ue %zu: %zu symbol errors\n",
                      frame_id, symbol_id, ant_id, block_error);
     }
-    phy_stats_.UpdateBlockErrors(ant_id, total_dl_symbol_id, frame_slot,
-                                 block_error);
   }
 
   if ((kDebugPrintPerTaskDone == true) || (kDebugPrintDemul == true)) {
@@ -527,13 +529,20 @@ void UeWorker::DoEncodeUe(DoEncode* encoder, size_t tag) {
   const size_t ant_id = gen_tag_t(tag).ue_id_;
   const LDPCconfig& ldpc_config = config_.LdpcConfig(Direction::kUplink);
 
-  // For now, call for each cb
+  // Encode the codeblocks of the symbol EncodeBlockSize() at a time
+  std::array<size_t, EventData::kMaxTags> cb_tags;
+  size_t num_tags = 0;
   for (size_t cb_id = 0; cb_id < ldpc_config.NumBlocksInSymbol(); cb_id++) {
-    // For now, call for each cb
-    encoder->Launch(
+    cb_tags.at(num_tags) =
         gen_tag_t::FrmSymCb(frame_id, symbol_id,
                             cb_id + (ant_id * ldpc_config.NumBlocksInSymbol()))
-            .tag_);
+            .tag_;
+    num_tags++;
+    if ((num_tags == config_.EncodeBlockSize()) ||
+        (cb_id == ldpc_config.NumBlocksInSymbol() - 1)) {
+      encoder->LaunchBatch(cb_tags.data(), num_tags);
+      num_tags = 0;
+    }
   }
   // Post the completion event (symbol)
   const size_t completion_tag =
@@ -632,7 +641,7 @@ void UeWorker::DoIfft(size_t tag) {
   const size_t frame_id = gen_tag_t(tag).frame_id_;
   const size_t symbol_id = gen_tag_t(tag).symbol_id_;
   const size_t ant_id = gen_tag_t(tag).ue_id_;
-  const size_t frame_slot = (frame_id % kFrameWnd);
+  const size_t frame_slot = config_.FrameSlot(frame_id);
 
   if (kDebugPrintInTask) {
     AGORA_LOG_INFO("User Task[%zu]: iFFT   (frame %zu, symbol %zu, user %zu)\n",
@@ -685,8 +694,8 @@ void UeWorker::DoIfft(size_t tag) {
   std::memset(ifft_buff + config_.OfdmDataStop(), 0,
               sizeof(complex_float) * config_.OfdmDataStart());
 
-  std::vector<complex_float> temp_fft_buf(config_.OfdmCaNum());
-  auto* temp_buff = reinterpret_cast<complex_float*>(temp_fft_buf.data());
+  auto* temp_buff =
+      MemoryArena::ThreadLocal().Alloc<complex_float>(config_.OfdmCaNum());
   CommsLib::FFTShift(ifft_buff, temp_buff, config_.OfdmCaNum());
   CommsLib::IFFT(ifft_buff, config_.OfdmCaNum(), false);
 
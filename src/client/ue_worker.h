@@ -34,8 +34,8 @@ class UeWorker {
       Table<char>& rx_buffer, Table<complex_float>& csi_buffer,
       std::vector<SimdAlignCxFltVector>& equal_buffer,
       std::vector<size_t>& non_null_sc_ind, Table<complex_float>& fft_buffer,
-      PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& demod_buffer,
-      PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& decoded_buffer,
+      PtrCube<int8_t>& demod_buffer,
+      PtrCube<int8_t>& decoded_buffer,
       std::vector<std::vector<std::complex<float>>>& ue_pilot_vec);
   ~UeWorker();
 
@@ -147,8 +147,8 @@ class UeWorker {
   std::vector<SimdAlignCxFltVector>& equal_buffer_;
   std::vector<size_t>& non_null_sc_ind_;
   Table<complex_float>& fft_buffer_;
-  PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& demod_buffer_;
-  PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& decoded_buffer_;
+  PtrCube<int8_t>& demod_buffer_;
+  PtrCube<int8_t>& decoded_buffer_;
 
   std::vector<std::vector<std::complex<float>>>& ue_pilot_vec_;
 };
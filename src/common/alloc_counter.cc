@@ -0,0 +1,76 @@
+/**
+ * @file alloc_counter.cc
+ * @brief Implementation file for the heap allocation counter. With
+ * ALLOC_COUNTING, the allocation functions of the C library are wrapped
+ * here and forward to glibc's internal entry points.
+ */
+#include "alloc_counter.h"
+
+#if defined(ALLOC_COUNTING)
+#include <cerrno>
+#include <cstdint>
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t num, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+}
+
+// Initial-exec TLS does not allocate on first use, unlike the default
+// model, so it is safe to touch from malloc itself
+static thread_local size_t thread_allocs
+    __attribute__((tls_model("initial-exec"))) = 0;
+
+extern "C" {
+void* malloc(size_t size) {
+  thread_allocs++;
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t num, size_t size) {
+  thread_allocs++;
+  return __libc_calloc(num, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+  thread_allocs++;
+  return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size) {
+  thread_allocs++;
+  return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+  thread_allocs++;
+  return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size) {
+  if ((alignment % sizeof(void*) != 0) ||
+      ((alignment & (alignment - 1)) != 0)) {
+    return EINVAL;
+  }
+  thread_allocs++;
+  void* mem = __libc_memalign(alignment, size);
+  if (mem == nullptr) {
+    return ENOMEM;
+  }
+  *ptr = mem;
+  return 0;
+}
+}
+
+bool AllocCounter::Enabled() { return true; }
+
+size_t AllocCounter::ThreadAllocs() { return thread_allocs; }
+
+#else
+
+bool AllocCounter::Enabled() { return false; }
+
+size_t AllocCounter::ThreadAllocs() { return 0; }
+
+#endif  // defined(ALLOC_COUNTING)
@@ -0,0 +1,23 @@
+/**
+ * @file alloc_counter.h
+ * @brief Per-thread count of heap allocations, for checking that the worker
+ * hot paths do not allocate. Builds with ALLOC_COUNTING replace malloc and
+ * its relatives to count every allocation, including those made inside
+ * Armadillo and the standard library. Other builds count nothing.
+ */
+#ifndef ALLOC_COUNTER_H_
+#define ALLOC_COUNTER_H_
+
+#include <cstddef>
+
+namespace AllocCounter {
+
+/// True if this build counts heap allocations
+bool Enabled();
+
+/// Heap allocations made by the calling thread so far, 0 if not Enabled()
+size_t ThreadAllocs();
+
+}  // namespace AllocCounter
+
+#endif  // ALLOC_COUNTER_H_
@@ -0,0 +1,141 @@
+/**
+ * @file approx_zf.h
+ * @brief Iterative approximations of the zero-forcing beamformer
+ * W = inv(H^H * H) * H^H for large antenna arrays. With many more base
+ * station antennas than UEs the Gram matrix H^H * H is strongly diagonally
+ * dominant (channel hardening), so a few iterations replace the exact
+ * Hermitian inverse. Scratch matrices live in a MemoryArena and results are
+ * written into caller-provided matrices of the right size, so no heap
+ * allocation is made per subcarrier.
+ */
+#ifndef APPROX_ZF_H_
+#define APPROX_ZF_H_
+
+#include <algorithm>
+#include <cstddef>
+
+#include "armadillo"
+#include "memory_arena.h"
+
+namespace ApproxZf {
+
+/// Truncated Neumann series of inv(gram) around its diagonal D, written to
+/// the gram-sized [inv]: sum_{k=0}^{num_iterations} (-inv(D) * E)^k *
+/// inv(D), where E is the off-diagonal part of gram. One iteration costs
+/// only a diagonal scaling; every further iteration costs one UE x UE
+/// matrix product.
+static inline void NeumannInverse(MemoryArena& arena,
+                                  const arma::cx_fmat& gram,
+                                  size_t num_iterations, arma::cx_fmat& inv) {
+  const size_t dim = gram.n_rows;
+  arma::cx_fvec d_inv(arena.Alloc<arma::cx_float>(dim), dim, false, false);
+  for (size_t i = 0; i < dim; i++) {
+    d_inv(i) = 1.0f / std::real(gram(i, i));
+  }
+  inv.zeros();
+  inv.diag() = d_inv;
+  if (num_iterations == 0) {
+    return;
+  }
+  // -inv(D) * E, and the first term (-inv(D) * E) * inv(D), which is a
+  // column scaling of it
+  arma::cx_fmat neg_jacobi(arena.Alloc<arma::cx_float>(dim * dim), dim, dim,
+                           false, false);
+  arma::cx_fmat term_a(arena.Alloc<arma::cx_float>(dim * dim), dim, dim,
+                       false, false);
+  arma::cx_fmat term_b(arena.Alloc<arma::cx_float>(dim * dim), dim, dim,
+                       false, false);
+  for (size_t col = 0; col < dim; col++) {
+    for (size_t row = 0; row < dim; row++) {
+      neg_jacobi(row, col) =
+          (row == col) ? arma::cx_float(0) : -d_inv(row) * gram(row, col);
+      term_a(row, col) = neg_jacobi(row, col) * d_inv(col);
+    }
+  }
+  inv += term_a;
+  // Alternate between the two term matrices, a product into its own
+  // operand would need a temporary
+  arma::cx_fmat* term = &term_a;
+  arma::cx_fmat* next_term = &term_b;
+  for (size_t i = 1; i < num_iterations; i++) {
+    *next_term = neg_jacobi * (*term);
+    inv += *next_term;
+    std::swap(term, next_term);
+  }
+}
+
+/// Run [num_iterations] conjugate gradient steps on gram * x = rhs for every
+/// column of rhs at once, starting from [x]. gram must be Hermitian positive
+/// definite.
+static inline void ConjugateGradient(MemoryArena& arena,
+                                     const arma::cx_fmat& gram,
+                                     const arma::cx_fmat& rhs,
+                                     arma::cx_fmat& x, size_t num_iterations) {
+  // Below this squared residual norm a column is considered solved
+  static constexpr float kMinResidual = 1e-12f;
+  const size_t num_rows = rhs.n_rows;
+  const size_t num_cols = rhs.n_cols;
+  arma::cx_fmat residual(arena.Alloc<arma::cx_float>(num_rows * num_cols),
+                         num_rows, num_cols, false, false);
+  arma::cx_fmat direction(arena.Alloc<arma::cx_float>(num_rows * num_cols),
+                          num_rows, num_cols, false, false);
+  arma::cx_fmat gram_dir(arena.Alloc<arma::cx_float>(num_rows * num_cols),
+                         num_rows, num_cols, false, false);
+  float* rs_old = arena.Alloc<float>(num_cols);
+
+  residual = gram * x;
+  float rs_max = 0.0f;
+  for (size_t col = 0; col < num_cols; col++) {
+    float rs = 0.0f;
+    for (size_t row = 0; row < num_rows; row++) {
+      const arma::cx_float r = rhs(row, col) - residual(row, col);
+      residual(row, col) = r;
+      direction(row, col) = r;
+      rs += std::norm(r);
+    }
+    rs_old[col] = rs;
+    rs_max = std::max(rs_max, rs);
+  }
+  // The columns are independent, so each one takes its whole step at once
+  for (size_t i = 0; (i < num_iterations) && (rs_max >= kMinResidual); i++) {
+    gram_dir = gram * direction;
+    rs_max = 0.0f;
+    for (size_t col = 0; col < num_cols; col++) {
+      float dir_energy = 0.0f;
+      for (size_t row = 0; row < num_rows; row++) {
+        dir_energy +=
+            std::real(std::conj(direction(row, col)) * gram_dir(row, col));
+      }
+      const float alpha =
+          (dir_energy > 0.0f) ? rs_old[col] / dir_energy : 0.0f;
+      float rs_new = 0.0f;
+      for (size_t row = 0; row < num_rows; row++) {
+        x(row, col) += alpha * direction(row, col);
+        residual(row, col) -= alpha * gram_dir(row, col);
+        rs_new += std::norm(residual(row, col));
+      }
+      const float beta = (rs_old[col] > 0.0f) ? rs_new / rs_old[col] : 0.0f;
+      for (size_t row = 0; row < num_rows; row++) {
+        direction(row, col) = residual(row, col) + beta * direction(row, col);
+      }
+      rs_old[col] = rs_new;
+      rs_max = std::max(rs_max, rs_new);
+    }
+  }
+}
+
+/// Jacobi initial guess inv(D) * H^H for ConjugateGradient when no previous
+/// solution is available, written to the csi_h-sized [guess]
+static inline void JacobiGuess(const arma::cx_fmat& gram,
+                               const arma::cx_fmat& csi_h,
+                               arma::cx_fmat& guess) {
+  for (size_t col = 0; col < csi_h.n_cols; col++) {
+    for (size_t row = 0; row < csi_h.n_rows; row++) {
+      guess(row, col) = csi_h(row, col) / std::real(gram(row, row));
+    }
+  }
+}
+
+}  // namespace ApproxZf
+
+#endif  // APPROX_ZF_H_
@@ -0,0 +1,68 @@
+/**
+ * @file bit_errors.h
+ * @brief Bit and byte error counting of a whole received block against its
+ * transmitted reference, with XOR + popcount over wide words.
+ */
+#ifndef BIT_ERRORS_H_
+#define BIT_ERRORS_H_
+
+#include <immintrin.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/// Count the bit errors between [num_bytes] bytes of [tx_bytes] and
+/// [rx_bytes]. [byte_errors] is set to the number of differing bytes.
+static inline size_t CountBitErrors(const uint8_t* tx_bytes,
+                                    const uint8_t* rx_bytes, size_t num_bytes,
+                                    size_t& byte_errors) {
+  size_t bit_errors = 0;
+  byte_errors = 0;
+  size_t i = 0;
+#if defined(__AVX512BW__)
+  __m512i bit_errors_512 = _mm512_setzero_si512();
+  for (; i + 64 <= num_bytes; i += 64) {
+    const __m512i diff = _mm512_xor_si512(_mm512_loadu_si512(tx_bytes + i),
+                                          _mm512_loadu_si512(rx_bytes + i));
+    byte_errors += __builtin_popcountll(_mm512_test_epi8_mask(diff, diff));
+#if defined(__AVX512VPOPCNTDQ__)
+    bit_errors_512 =
+        _mm512_add_epi64(bit_errors_512, _mm512_popcnt_epi64(diff));
+#else
+    alignas(64) uint64_t words[8];
+    _mm512_store_si512(words, diff);
+    for (uint64_t word : words) {
+      bit_errors += __builtin_popcountll(word);
+    }
+#endif
+  }
+  // Sum the lanes through memory, GCC 12 warns on _mm512_reduce_add_epi64
+  alignas(64) uint64_t lane_errors[8];
+  _mm512_store_si512(lane_errors, bit_errors_512);
+  for (uint64_t lane : lane_errors) {
+    bit_errors += lane;
+  }
+#endif
+  for (; i + sizeof(uint64_t) <= num_bytes; i += sizeof(uint64_t)) {
+    uint64_t tx_word;
+    uint64_t rx_word;
+    std::memcpy(&tx_word, tx_bytes + i, sizeof(uint64_t));
+    std::memcpy(&rx_word, rx_bytes + i, sizeof(uint64_t));
+    uint64_t diff = tx_word ^ rx_word;
+    bit_errors += __builtin_popcountll(diff);
+    // OR each byte down into its lowest bit to count the differing bytes
+    diff |= diff >> 4;
+    diff |= diff >> 2;
+    diff |= diff >> 1;
+    byte_errors += __builtin_popcountll(diff & 0x0101010101010101ull);
+  }
+  for (; i < num_bytes; i++) {
+    const unsigned diff = tx_bytes[i] ^ rx_bytes[i];
+    bit_errors += __builtin_popcount(diff);
+    byte_errors += static_cast<size_t>(diff != 0);
+  }
+  return bit_errors;
+}
+
+#endif  // BIT_ERRORS_H_
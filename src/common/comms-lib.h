@@ -24,7 +24,7 @@
 #include "mkl_dfti.h"
 
 static const std::map<std::string, size_t> kBeamformingStr{
-    {"ZF", 0}, {"MMSE", 1}, {"MRC", 2}};
+    {"ZF", 0}, {"MMSE", 1}, {"MRC", 2}, {"NEUMANN", 3}, {"CG", 4}};
 
 class CommsLib {
  public:
@@ -45,7 +45,14 @@ class CommsLib {
     kQaM256 = 8
   };
 
-  enum BeamformingAlgorithm { kZF = 0, kMMSE = 1, kMRC = 2 };
+  // kNeumann and kCG are iterative approximations of kZF
+  enum BeamformingAlgorithm {
+    kZF = 0,
+    kMMSE = 1,
+    kMRC = 2,
+    kNeumann = 3,
+    kCG = 4
+  };
 
   explicit CommsLib(std::string);
   ~CommsLib();
@@ -9,11 +9,14 @@
 
 #include "config.h"
 
+#include <algorithm>
 #include <ctime>
 #include <filesystem>
 #include <utility>
 
 #include "comms-lib.h"
+#include "core_layout.h"
+#include "fixed_point.h"
 #include "gettime.h"
 #include "logger.h"
 #include "message.h"
@@ -189,6 +192,11 @@ Config::Config(std::string jsonfilename)
   num_ue_channels_ = std::min(ue_channel_.size(), kMaxChannels);
   bs_ant_num_ = num_channels_ * num_radios_;
   ue_ant_num_ = ue_num_ * num_ue_channels_;
+  // Task tags carry 16-bit antenna and UE ids
+  RtAssert(bs_ant_num_ < UINT16_MAX,
+           "Number of base station antennas exceeds the task tag range");
+  RtAssert(ue_ant_num_ < UINT16_MAX,
+           "Number of UE antennas exceeds the task tag range");
 
   bf_ant_num_ = bs_ant_num_;
   for (size_t i = 0; i < num_cells_; i++) {
@@ -262,6 +270,7 @@ Config::Config(std::string jsonfilename)
   smooth_calib_ = tdd_conf.value("smooth_calib", false);
   beamforming_str_ = tdd_conf.value("beamforming", "ZF");
   beamforming_algo_ = kBeamformingStr.at(beamforming_str_);
+  approx_zf_iterations_ = tdd_conf.value("approx_zf_iterations", 3);
 
   bs_server_addr_ = tdd_conf.value("bs_server_addr", "127.0.0.1");
   bs_rru_addr_ = tdd_conf.value("bs_rru_addr", "127.0.0.1");
@@ -303,7 +312,17 @@ Config::Config(std::string jsonfilename)
       tdd_conf.value("ofdm_rx_zero_prefix_cal_dl", 0) + cp_len_;
   RtAssert(ofdm_data_num_ % kSCsPerCacheline == 0,
            "ofdm_data_num must be a multiple of subcarriers per cacheline");
-  RtAssert(ofdm_data_num_ % kTransposeBlockSize == 0,
+  partial_transpose_ = tdd_conf.value("partial_transpose", true);
+  // 0 lets Agora benchmark the supported sizes at startup
+  transpose_block_size_ =
+      tdd_conf.value("transpose_block_size", kTransposeBlockSize);
+  RtAssert((transpose_block_size_ == 0) ||
+               (std::find(kTransposeBlockSizes.begin(),
+                          kTransposeBlockSizes.end(),
+                          transpose_block_size_) != kTransposeBlockSizes.end()),
+           "transpose_block_size must be 0 (auto), 8, 16, 32 or 64");
+  RtAssert((transpose_block_size_ == 0) ||
+               (ofdm_data_num_ % transpose_block_size_ == 0),
            "Transpose block size must divide number of OFDM data subcarriers");
   ofdm_pilot_spacing_ = tdd_conf.value("ofdm_pilot_spacing", 16);
   ofdm_data_start_ = tdd_conf.value("ofdm_data_start",
@@ -330,13 +349,19 @@ Config::Config(std::string jsonfilename)
 
   bigstation_mode_ = tdd_conf.value("bigstation_mode", false);
   freq_orthogonal_pilot_ = tdd_conf.value("freq_orthogonal_pilot", false);
-  pilot_sc_group_size_ =
-      tdd_conf.value("pilot_sc_group_size", kTransposeBlockSize);
+  pilot_sc_group_size_ = tdd_conf.value(
+      "pilot_sc_group_size", (transpose_block_size_ == 0)
+                                 ? kTransposeBlockSize
+                                 : transpose_block_size_);
   if (freq_orthogonal_pilot_) {
-    RtAssert(pilot_sc_group_size_ == kTransposeBlockSize,
+    // Pilot groups are expanded one transpose block at a time
+    if (transpose_block_size_ == 0) {
+      transpose_block_size_ = pilot_sc_group_size_;
+    }
+    RtAssert(pilot_sc_group_size_ == transpose_block_size_,
              "In this version, pilot_sc_group_size must be equal to Transpose "
              "Block Size " +
-                 std::to_string(kTransposeBlockSize));
+                 std::to_string(transpose_block_size_));
     RtAssert(ofdm_data_num_ % pilot_sc_group_size_ == 0,
              "ofdm_data_num must be evenly divided by pilot_sc_group_size " +
                  std::to_string(pilot_sc_group_size_));
@@ -605,13 +630,42 @@ Config::Config(std::string jsonfilename)
   decode_thread_num_ = tdd_conf.value("decode_thread_num", 10);
   beam_thread_num_ = worker_thread_num_ - fft_thread_num_ - demul_thread_num_ -
                      decode_thread_num_;
+  worker_idle_wait_ = tdd_conf.value("worker_idle_wait", "spin");
+  RtAssert((worker_idle_wait_ == "spin") || (worker_idle_wait_ == "umwait") ||
+               (worker_idle_wait_ == "futex"),
+           "worker_idle_wait must be one of spin, umwait, futex");
+  worker_spin_us_ = tdd_conf.value("worker_spin_us", 20.0);
+  worker_elastic_ = tdd_conf.value("worker_elastic", false);
+  worker_min_active_ = tdd_conf.value("worker_min_active", 1);
+  RtAssert((worker_min_active_ >= 1) &&
+               (worker_min_active_ <= worker_thread_num_),
+           "worker_min_active must be between 1 and worker_thread_num");
+  worker_latency_budget_us_ = tdd_conf.value("worker_latency_budget_us", 0.0);
+  auto_core_layout_ = tdd_conf.value("auto_core_layout", false);
+  nic_device_ = tdd_conf.value("nic_device", "");
+  if (auto_core_layout_) {
+    // Replaces the layout of SetCpuLayoutOnNumaNodes, before any pinning
+    const int nic_node = nic_device_.empty()
+                             ? -1
+                             : CpuTopology::DeviceNumaNode(nic_device_);
+    if ((nic_device_.empty() == false) && (nic_node < 0)) {
+      AGORA_LOG_WARN("Config: NUMA node of NIC %s is unknown\n",
+                     nic_device_.c_str());
+    }
+    const CoreLayoutPlan plan(CpuTopology::FromSysfs(), excluded, nic_node,
+                              core_offset_, socket_thread_num_,
+                              worker_thread_num_, kEnableMac ? 1 : 0);
+    plan.Print();
+    SetCpuLayout(plan.Layout());
+  }
 
   demul_block_size_ = tdd_conf.value("demul_block_size", 48);
   RtAssert(demul_block_size_ % kSCsPerCacheline == 0,
            "Demodulation block size must be a multiple of subcarriers per "
            "cacheline");
   RtAssert(
-      demul_block_size_ % kTransposeBlockSize == 0,
+      (transpose_block_size_ == 0) ||
+          (demul_block_size_ % transpose_block_size_ == 0),
       "Demodulation block size must be a multiple of transpose block size");
   demul_events_per_symbol_ = 1 + (ofdm_data_num_ - 1) / demul_block_size_;
 
@@ -641,6 +695,14 @@ Config::Config(std::string jsonfilename)
            "frame must fit inside an fft block");
 
   encode_block_size_ = tdd_conf.value("encode_block_size", 1);
+  RtAssert(encode_block_size_ > 0 && encode_block_size_ <= EventData::kMaxTags,
+           "Encode block size must fit in one event");
+  block_size_tuning_ = tdd_conf.value("block_size_tuning", false);
+  block_size_tuning_frames_ = tdd_conf.value("block_size_tuning_frames", 50);
+  RtAssert(block_size_tuning_frames_ > 0,
+           "block_size_tuning_frames must be positive");
+  batched_gemm_ = tdd_conf.value("batched_gemm", false);
+  prefetch_distance_ = tdd_conf.value("prefetch_distance", kSCsPerCacheline);
 
   noise_level_ = tdd_conf.value("noise_level", 0.03);  // default: 30 dB
   AGORA_LOG_SYMBOL("Noise level: %.2f\n", noise_level_);
@@ -658,6 +720,49 @@ Config::Config(std::string jsonfilename)
   this->DumpMcsInfo();
 
   fft_in_rru_ = tdd_conf.value("fft_in_rru", false);
+  ul_fixed_point_ = tdd_conf.value("ul_fixed_point", false);
+  RtAssert(!ul_fixed_point_ || (bs_ant_num_ <= kFixedPointMaxAntennas),
+           "ul_fixed_point supports at most 64 base station antennas");
+  half_precision_storage_ = tdd_conf.value("half_precision_storage", false);
+  RtAssert(!half_precision_storage_ ||
+               (!ul_fixed_point_ && !batched_gemm_ && partial_transpose_),
+           "half_precision_storage requires the per-subcarrier float "
+           "datapath with partial transpose");
+  fused_precode_ifft_ = tdd_conf.value("fused_precode_ifft", false);
+  RtAssert(!fused_precode_ifft_ || !half_precision_storage_,
+           "fused_precode_ifft requires float32 downlink beam matrices");
+  adaptive_decoder_iter_ = tdd_conf.value("adaptive_decoder_iter", false);
+  decoder_snr_gap_db_ = tdd_conf.value("decoder_snr_gap_db", 3.0f);
+  decoder_abandon_margin_db_ =
+      tdd_conf.value("decoder_abandon_margin_db", 6.0f);
+  RtAssert(decoder_abandon_margin_db_ > 0,
+           "decoder_abandon_margin_db must be positive");
+  decode_frame_budget_us_ = tdd_conf.value("decode_frame_budget_us", 0.0f);
+  ber_sample_interval_ = tdd_conf.value("ber_sample_interval", 1);
+  RtAssert(ber_sample_interval_ > 0, "ber_sample_interval must be positive");
+  numa_aware_ = tdd_conf.value("numa_aware", false);
+  const std::string hugepages = tdd_conf.value("hugepages", "none");
+  if (hugepages == "2M") {
+    huge_page_size_ = Agora_memory::HugePageSize::k2M;
+  } else if (hugepages == "1G") {
+    huge_page_size_ = Agora_memory::HugePageSize::k1G;
+  } else {
+    RtAssert(hugepages == "none", "hugepages must be none, 2M or 1G");
+    huge_page_size_ = Agora_memory::HugePageSize::kNone;
+  }
+  // Applies to the buffers allocated from here on
+  Agora_memory::SetHugePageSize(huge_page_size_);
+  const size_t frame_window = tdd_conf.value("frame_window", kDefaultFrameWnd);
+  RtAssert(frame_window > 0, "frame_window must be positive");
+  // Round up so that frame slots are a mask instead of a modulo
+  frame_wnd_ = 1;
+  while (frame_wnd_ < frame_window) {
+    frame_wnd_ <<= 1;
+  }
+  if (frame_wnd_ != frame_window) {
+    AGORA_LOG_INFO("Config: frame_window %zu rounded up to %zu\n",
+                   frame_window, frame_wnd_);
+  }
 
   samps_per_symbol_ =
       ofdm_tx_zero_prefix_ + ofdm_ca_num_ + cp_len_ + ofdm_tx_zero_postfix_;
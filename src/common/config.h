@@ -108,6 +108,12 @@ class Config {
   inline bool SampleCalEn() const { return this->sample_cal_en_; }
   inline bool ImbalanceCalEn() const { return this->imbalance_cal_en_; }
   inline size_t BeamformingAlgo() const { return this->beamforming_algo_; }
+  void BeamformingAlgo(size_t beamforming_algo) {
+    this->beamforming_algo_ = beamforming_algo;
+  }
+  inline size_t ApproxZfIterations() const {
+    return this->approx_zf_iterations_;
+  }
   inline std::string Beamforming() const { return this->beamforming_str_; }
   inline bool ExternalRefNode(size_t id) const {
     return this->external_ref_node_.at(id);
@@ -134,7 +140,7 @@ class Config {
 
   inline size_t ModifyRecCalIndex(size_t previous_index,
                                   int mod_value = 0) const {
-    return (previous_index + mod_value) % kFrameWnd;
+    return FrameSlot(previous_index + mod_value);
   }
 
   inline size_t RecipCalIndex(size_t frame_id) const {
@@ -182,6 +188,17 @@ class Config {
   inline size_t CoreOffset() const { return this->core_offset_; }
   inline size_t WorkerThreadNum() const { return this->worker_thread_num_; }
   inline size_t SocketThreadNum() const { return this->socket_thread_num_; }
+  inline const std::string& WorkerIdleWait() const {
+    return this->worker_idle_wait_;
+  }
+  inline double WorkerSpinUs() const { return this->worker_spin_us_; }
+  inline bool WorkerElastic() const { return this->worker_elastic_; }
+  inline size_t WorkerMinActive() const { return this->worker_min_active_; }
+  inline double WorkerLatencyBudgetUs() const {
+    return this->worker_latency_budget_us_;
+  }
+  inline bool AutoCoreLayout() const { return this->auto_core_layout_; }
+  inline const std::string& NicDevice() const { return this->nic_device_; }
   inline size_t UeCoreOffset() const { return this->ue_core_offset_; }
   inline size_t UeWorkerThreadNum() const {
     return this->ue_worker_thread_num_;
@@ -195,6 +212,11 @@ class Config {
   inline size_t DecodeThreadNum() const { return this->decode_thread_num_; }
   inline size_t BeamThreadNum() const { return this->beam_thread_num_; }
   inline size_t DemulBlockSize() const { return this->demul_block_size_; }
+  void DemulBlockSize(size_t block_size) {
+    this->demul_block_size_ = block_size;
+    this->demul_events_per_symbol_ =
+        1 + (this->ofdm_data_num_ - 1) / this->demul_block_size_;
+  }
 
   inline size_t DemulEventsPerSymbol() const {
     return this->demul_events_per_symbol_;
@@ -206,10 +228,34 @@ class Config {
   inline size_t FftBlockSize() const { return this->fft_block_size_; }
 
   inline size_t EncodeBlockSize() const { return this->encode_block_size_; }
+  inline bool BlockSizeTuning() const { return this->block_size_tuning_; }
+  inline size_t BlockSizeTuningFrames() const {
+    return this->block_size_tuning_frames_;
+  }
+  inline bool BatchedGemm() const { return this->batched_gemm_; }
+  void BatchedGemm(bool batched_gemm) { this->batched_gemm_ = batched_gemm; }
+  inline size_t PrefetchDistance() const { return this->prefetch_distance_; }
+  void PrefetchDistance(size_t prefetch_distance) {
+    this->prefetch_distance_ = prefetch_distance;
+  }
   inline bool FreqOrthogonalPilot() const {
     return this->freq_orthogonal_pilot_;
   }
   inline size_t PilotScGroupSize() const { return this->pilot_sc_group_size_; }
+  /// If true, FFT output and CSI are subcarrier block major, otherwise
+  /// antenna major
+  inline bool PartialTranspose() const { return this->partial_transpose_; }
+  void PartialTranspose(bool partial_transpose) {
+    this->partial_transpose_ = partial_transpose;
+  }
+  /// Subcarriers per partial transpose block, 0 until
+  /// Agora_transpose::ResolveBlockSize() has tuned it
+  inline size_t TransposeBlockSize() const {
+    return this->transpose_block_size_;
+  }
+  void TransposeBlockSize(size_t block_size) {
+    this->transpose_block_size_ = block_size;
+  }
   inline size_t OfdmTxZeroPrefix() const { return this->ofdm_tx_zero_prefix_; }
   inline size_t OfdmTxZeroPostfix() const {
     return this->ofdm_tx_zero_postfix_;
@@ -311,6 +357,44 @@ class Config {
   inline size_t FramesToTest() const { return this->frames_to_test_; }
   inline float NoiseLevel() const { return this->noise_level_; }
   inline bool FftInRru() const { return this->fft_in_rru_; }
+  inline bool UlFixedPoint() const { return this->ul_fixed_point_; }
+  void UlFixedPoint(bool ul_fixed_point) {
+    this->ul_fixed_point_ = ul_fixed_point;
+  }
+  inline bool HalfPrecisionStorage() const {
+    return this->half_precision_storage_;
+  }
+  void HalfPrecisionStorage(bool half_precision_storage) {
+    this->half_precision_storage_ = half_precision_storage;
+  }
+  inline bool FusedPrecodeIfft() const { return this->fused_precode_ifft_; }
+  void FusedPrecodeIfft(bool fused_precode_ifft) {
+    this->fused_precode_ifft_ = fused_precode_ifft;
+  }
+  inline bool AdaptiveDecoderIter() const {
+    return this->adaptive_decoder_iter_;
+  }
+  void AdaptiveDecoderIter(bool adaptive_decoder_iter) {
+    this->adaptive_decoder_iter_ = adaptive_decoder_iter;
+  }
+  inline float DecoderSnrGapDb() const { return this->decoder_snr_gap_db_; }
+  inline float DecoderAbandonMarginDb() const {
+    return this->decoder_abandon_margin_db_;
+  }
+  inline float DecodeFrameBudgetUs() const {
+    return this->decode_frame_budget_us_;
+  }
+  inline size_t BerSampleInterval() const { return this->ber_sample_interval_; }
+  inline bool NumaAware() const { return this->numa_aware_; }
+  inline Agora_memory::HugePageSize HugePageSize() const {
+    return this->huge_page_size_;
+  }
+  /// Number of frames buffered at a time, a power of two
+  inline size_t FrameWnd() const { return this->frame_wnd_; }
+  /// Buffer slot of [frame_id] in the frame window
+  inline size_t FrameSlot(size_t frame_id) const {
+    return frame_id & (this->frame_wnd_ - 1);
+  }
 
   inline uint16_t DpdkNumPorts() const { return this->dpdk_num_ports_; }
   inline uint16_t DpdkPortOffset() const { return this->dpdk_port_offset_; }
@@ -423,23 +507,23 @@ class Config {
   SymbolType GetSymbolType(size_t symbol_id) const;
 
   /// Return total number of data symbols of all frames in a buffer
-  /// that holds data of kFrameWnd frames
+  /// that holds data of FrameWnd() frames
   inline size_t GetTotalDataSymbolIdx(size_t frame_id, size_t symbol_id) const {
-    return ((frame_id % kFrameWnd) * this->frame_.NumDataSyms() + symbol_id);
+    return (FrameSlot(frame_id) * this->frame_.NumDataSyms() + symbol_id);
   }
 
   /// Return total number of uplink data symbols of all frames in a buffer
-  /// that holds data of kFrameWnd frames
+  /// that holds data of FrameWnd() frames
   inline size_t GetTotalDataSymbolIdxUl(size_t frame_id,
                                         size_t symbol_idx_ul) const {
-    return ((frame_id % kFrameWnd) * this->frame_.NumULSyms() + symbol_idx_ul);
+    return (FrameSlot(frame_id) * this->frame_.NumULSyms() + symbol_idx_ul);
   }
 
   /// Return total number of downlink data symbols of all frames in a buffer
-  /// that holds data of kFrameWnd frames
+  /// that holds data of FrameWnd() frames
   inline size_t GetTotalDataSymbolIdxDl(size_t frame_id,
                                         size_t symbol_idx_dl) const {
-    return ((frame_id % kFrameWnd) * this->frame_.NumDLSyms() + symbol_idx_dl);
+    return (FrameSlot(frame_id) * this->frame_.NumDLSyms() + symbol_idx_dl);
   }
 
   //Returns Beacon+Dl symbol index
@@ -482,7 +566,7 @@ class Config {
   /// be an uplink symbol.
   inline complex_float* GetDataBuf(Table<complex_float>& data_buffers,
                                    size_t frame_id, size_t symbol_id) const {
-    size_t frame_slot = frame_id % kFrameWnd;
+    size_t frame_slot = FrameSlot(frame_id);
     size_t symbol_offset = (frame_slot * this->frame_.NumULSyms()) +
                            this->frame_.GetULSymbolIdx(symbol_id);
     return data_buffers[symbol_offset];
@@ -499,7 +583,7 @@ class Config {
   /// Get the calibration buffer for this frame and subcarrier ID
   inline complex_float* GetCalibBuffer(Table<complex_float>& calib_buffer,
                                        size_t frame_id, size_t sc_id) const {
-    size_t frame_slot = frame_id % kFrameWnd;
+    size_t frame_slot = FrameSlot(frame_id);
     return &calib_buffer[frame_slot][sc_id * bs_ant_num_];
   }
 
@@ -519,7 +603,7 @@ class Config {
       num_bytes_per_cb = this->ul_num_bytes_per_cb_;
       mac_packet_length = this->ul_mac_packet_length_;
     }
-    return &info_bits[ue_id][(frame_id % kFrameWnd) * mac_bytes_perframe +
+    return &info_bits[ue_id][FrameSlot(frame_id) * mac_bytes_perframe +
                              symbol_id * mac_packet_length +
                              cb_id * num_bytes_per_cb];
   }
@@ -753,6 +837,9 @@ class Config {
   bool imbalance_cal_en_;
   size_t beamforming_algo_;
   std::string beamforming_str_;
+  // Number of Neumann series terms or conjugate gradient steps of the
+  // approximate zero-forcing beamformers
+  size_t approx_zf_iterations_;
   std::vector<bool> external_ref_node_;
   std::string channel_;
   std::string ue_channel_;
@@ -764,6 +851,20 @@ class Config {
   size_t demul_thread_num_;
   size_t decode_thread_num_;
   size_t beam_thread_num_;
+  // How idle workers wait for tasks: "spin" (pause loop), "umwait" or
+  // "futex", the last two after spinning for worker_spin_us_
+  std::string worker_idle_wait_;
+  double worker_spin_us_;
+  // If true, workers beyond the load park, down to worker_min_active_
+  bool worker_elastic_;
+  size_t worker_min_active_;
+  // Frame latency above which parked workers are woken up (0: none)
+  double worker_latency_budget_us_;
+  // If true, the base station threads are placed by a CoreLayoutPlan of the
+  // sysfs CPU topology instead of consecutive cores from core_offset_
+  bool auto_core_layout_;
+  // NIC interface name or PCI address. Its NUMA node gets the I/O threads.
+  std::string nic_device_;
 
   size_t ue_core_offset_;
   size_t ue_worker_thread_num_;
@@ -785,12 +886,38 @@ class Config {
   // Number of code blocks handled in one encode event
   size_t encode_block_size_;
 
+  // If true, Agora searches the demul, beam, FFT and encode block sizes over
+  // the first frames, from the configured sizes down, and keeps the ones
+  // with the lowest frame latency
+  bool block_size_tuning_;
+  // Frames measured for each block size the tuner tries
+  size_t block_size_tuning_frames_;
+
+  // If true, equalization and precoding issue one batched cgemm per
+  // subcarrier block instead of one (JIT) cgemm per subcarrier
+  bool batched_gemm_;
+
+  // Number of subcarriers ahead of the current one whose beam matrices and
+  // input samples the equalizer and precoder prefetch. 0 disables prefetch.
+  size_t prefetch_distance_;
+
   // Whether to enable frequency orthogonal pilot
   bool freq_orthogonal_pilot_;
 
   // Frequency orthogonal pilot subcarrier group size
   size_t pilot_sc_group_size_;
 
+  // If true, the FFT output and CSI buffers are stored in blocks of
+  // transpose_block_size_ subcarriers with every antenna of a block next to
+  // each other, so that the consumers gather a subcarrier from few
+  // cachelines. Otherwise every antenna is stored contiguously.
+  bool partial_transpose_;
+
+  // Number of subcarriers in a partial transpose block of the FFT output
+  // and CSI buffers, one of kTransposeBlockSizes. 0 selects it at startup
+  // with Agora_transpose::ResolveBlockSize().
+  size_t transpose_block_size_;
+
   // The number of zero IQ samples prepended to a time-domain symbol (i.e.,
   // before the cyclic prefix) before transmission. Its value depends on
   // over-the-air and RF delays, and is currently calculated by manual tuning.
@@ -943,6 +1070,42 @@ class Config {
   size_t dl_num_padding_bytes_per_cb_;
 
   bool fft_in_rru_;  // If true, the RRU does FFT instead of Agora
+
+  // If true, the uplink stores FFT output and beam matrices as block floating
+  // point int16 and equalizes with integer complex MACs
+  bool ul_fixed_point_;
+
+  // If true, FFT output, CSI and beam matrices are stored as float16 in the
+  // first half of their buffers and converted back inside the consumers
+  bool half_precision_storage_;
+
+  // If true, downlink precoding and IFFT run as one task per antenna block
+  // and skip the subcarrier-major to antenna-major transpose through memory
+  bool fused_precode_ifft_;
+
+  // If true, the uplink decoder iteration cap of each codeblock follows the
+  // latest post-equalization SNR of its UE
+  bool adaptive_decoder_iter_;
+  // Gap (dB) between the SNR a codeblock needs and the Shannon bound of its
+  // spectral efficiency
+  float decoder_snr_gap_db_;
+  // Codeblocks whose UE is this far (dB) below the needed SNR are abandoned
+  // after one iteration
+  float decoder_abandon_margin_db_;
+  // Decoder time per frame (us) after which the remaining codeblocks of the
+  // frame are abandoned, 0 for no limit. UEs are decoded by decreasing SNR,
+  // so the lowest-SNR UEs are the ones abandoned.
+  float decode_frame_budget_us_;
+  // Only every ber_sample_interval_-th decoded codeblock of a UE is checked
+  // against the transmitted bits for the BER/BLER statistics
+  size_t ber_sample_interval_;
+  // If true, subcarrier and antenna ranges of the big buffers are placed on
+  // the NUMA nodes of the workers that process them
+  bool numa_aware_;
+  // Page size backing the large buffers, see Agora_memory::SetHugePageSize
+  Agora_memory::HugePageSize huge_page_size_;
+  // Number of frames buffered at a time, a power of two
+  size_t frame_wnd_;
   const std::string config_filename_;
   std::string trace_file_;
   std::string timestamp_;
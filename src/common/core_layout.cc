@@ -0,0 +1,244 @@
+/**
+ * @file core_layout.cc
+ * @brief Implementation file for the CpuTopology and CoreLayoutPlan classes
+ */
+#include "core_layout.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <utility>
+
+#include "logger.h"
+#include "utils.h"
+
+/// First line of the file at [path], empty if it cannot be read
+static std::string ReadLine(const std::string& path) {
+  std::ifstream file(path);
+  std::string line;
+  std::getline(file, line);
+  return line;
+}
+
+CpuTopology::CpuTopology(std::vector<Cpu> cpus) : cpus_(std::move(cpus)) {
+  std::sort(cpus_.begin(), cpus_.end(),
+            [](const Cpu& a, const Cpu& b) { return a.id_ < b.id_; });
+}
+
+CpuTopology CpuTopology::FromSysfs(const std::string& sysfs_root) {
+  const std::string cpu_dir = sysfs_root + "/devices/system/cpu";
+  const std::string online = ReadLine(cpu_dir + "/online");
+  if (online.empty()) {
+    throw std::runtime_error("CpuTopology: cannot read " + cpu_dir +
+                             "/online");
+  }
+
+  // Without node directories every CPU is on node 0
+  std::map<size_t, size_t> cpu_nodes;
+  const std::filesystem::path node_dir(sysfs_root + "/devices/system/node");
+  std::error_code ec;
+  for (const auto& entry : std::filesystem::directory_iterator(node_dir, ec)) {
+    const std::string name = entry.path().filename().string();
+    if ((name.rfind("node", 0) != 0) || (name.size() == 4) ||
+        (name.find_first_not_of("0123456789", 4) != std::string::npos)) {
+      continue;
+    }
+    const size_t node = std::stoul(name.substr(4));
+    for (const size_t cpu :
+         ParseCpuList(ReadLine(entry.path().string() + "/cpulist"))) {
+      cpu_nodes[cpu] = node;
+    }
+  }
+
+  std::vector<Cpu> cpus;
+  for (const size_t id : ParseCpuList(online)) {
+    const std::string topology =
+        cpu_dir + "/cpu" + std::to_string(id) + "/topology/";
+    const std::string package = ReadLine(topology + "physical_package_id");
+    const std::string core = ReadLine(topology + "core_id");
+    // A CPU without topology information is a core of its own
+    cpus.push_back(
+        {id, (cpu_nodes.count(id) > 0) ? cpu_nodes.at(id) : 0,
+         package.empty() ? 0 : std::stoul(package),
+         core.empty() ? (SIZE_MAX - id) : std::stoul(core)});
+  }
+  return CpuTopology(std::move(cpus));
+}
+
+int CpuTopology::DeviceNumaNode(const std::string& device,
+                                const std::string& sysfs_root) {
+  // PCI addresses, as used by DPDK, contain a colon
+  const std::string path =
+      (device.find(':') != std::string::npos)
+          ? sysfs_root + "/bus/pci/devices/" + device + "/numa_node"
+          : sysfs_root + "/class/net/" + device + "/device/numa_node";
+  const std::string node = ReadLine(path);
+  return node.empty() ? -1 : std::stoi(node);
+}
+
+std::vector<size_t> CpuTopology::ParseCpuList(const std::string& list) {
+  std::vector<size_t> cpus;
+  size_t pos = 0;
+  while (pos < list.size()) {
+    size_t end = list.find(',', pos);
+    if (end == std::string::npos) {
+      end = list.size();
+    }
+    const std::string range = list.substr(pos, end - pos);
+    const size_t dash = range.find('-');
+    if (range.find_first_of("0123456789") != std::string::npos) {
+      const size_t first = std::stoul(range.substr(0, dash));
+      const size_t last = (dash == std::string::npos)
+                              ? first
+                              : std::stoul(range.substr(dash + 1));
+      for (size_t cpu = first; cpu <= last; cpu++) {
+        cpus.push_back(cpu);
+      }
+    }
+    pos = end + 1;
+  }
+  return cpus;
+}
+
+CoreLayoutPlan::CoreLayoutPlan(const CpuTopology& topology,
+                               const std::vector<size_t>& excluded_cpus,
+                               int nic_node, size_t core_offset,
+                               size_t num_txrx, size_t num_workers,
+                               size_t num_mac) {
+  auto excluded = [&excluded_cpus](size_t cpu) {
+    return std::find(excluded_cpus.begin(), excluded_cpus.end(), cpu) !=
+           excluded_cpus.end();
+  };
+
+  // Group the CPUs by physical core
+  std::map<std::pair<size_t, size_t>, std::vector<CpuTopology::Cpu>> cores;
+  for (const auto& cpu : topology.Cpus()) {
+    cores[{cpu.package_, cpu.core_}].push_back(cpu);
+  }
+
+  // One CPU of each physical core is a primary, the other SMT siblings are
+  // secondaries. A core with an excluded CPU shares it with the OS, so its
+  // usable CPUs are all secondaries.
+  std::map<size_t, std::deque<size_t>> primaries;
+  std::map<size_t, std::deque<size_t>> secondaries;
+  std::vector<size_t> usable;
+  for (const auto& [key, cpus] : cores) {
+    const bool has_excluded =
+        std::any_of(cpus.begin(), cpus.end(),
+                    [&excluded](const auto& cpu) { return excluded(cpu.id_); });
+    bool primary = (has_excluded == false);
+    for (const auto& cpu : cpus) {
+      if (excluded(cpu.id_)) {
+        continue;
+      }
+      (primary ? primaries : secondaries)[cpu.node_].push_back(cpu.id_);
+      primary = false;
+      usable.push_back(cpu.id_);
+    }
+  }
+  RtAssert(usable.empty() == false, "CoreLayoutPlan: no usable CPU");
+  std::sort(usable.begin(), usable.end());
+  for (auto* pool : {&primaries, &secondaries}) {
+    for (auto& [node, cpus] : *pool) {
+      std::sort(cpus.begin(), cpus.end());
+    }
+  }
+
+  // The NIC node first, then the others in order
+  std::vector<size_t> nodes;
+  for (const auto& cpu : topology.Cpus()) {
+    if (excluded(cpu.id_) == false) {
+      nodes.push_back(cpu.node_);
+    }
+  }
+  nic_node_ = nodes.front();
+  std::sort(nodes.begin(), nodes.end());
+  nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+  if ((nic_node >= 0) && (std::find(nodes.begin(), nodes.end(),
+                                    static_cast<size_t>(nic_node)) !=
+                          nodes.end())) {
+    nic_node_ = static_cast<size_t>(nic_node);
+  }
+  std::stable_partition(nodes.begin(), nodes.end(),
+                        [this](size_t node) { return node == nic_node_; });
+
+  std::map<size_t, size_t> cpu_nodes;
+  for (const auto& cpu : topology.Cpus()) {
+    cpu_nodes[cpu.id_] = cpu.node_;
+  }
+  size_t num_reused = 0;
+  auto assign = [&](ThreadType type, size_t thread_id) {
+    for (auto* pool : {&primaries, &secondaries}) {
+      for (const size_t node : nodes) {
+        auto& cpus = (*pool)[node];
+        if (cpus.empty() == false) {
+          assignments_.push_back(
+              {type, thread_id, cpus.front(), node, pool == &secondaries});
+          cpus.pop_front();
+          return;
+        }
+      }
+    }
+    // More threads than CPUs
+    const size_t cpu = usable.at(num_reused % usable.size());
+    assignments_.push_back({type, thread_id, cpu, cpu_nodes.at(cpu), true});
+    num_reused++;
+  };
+  assign(ThreadType::kMaster, 0);
+  for (size_t i = 0; i < num_txrx; i++) {
+    assign(ThreadType::kWorkerTXRX, i);
+  }
+  for (size_t i = 0; i < num_workers; i++) {
+    assign(ThreadType::kWorker, i);
+  }
+  for (size_t i = 0; i < num_mac; i++) {
+    assign(ThreadType::kWorkerMacTXRX, i);
+  }
+  if (num_reused > 0) {
+    AGORA_LOG_WARN(
+        "CoreLayoutPlan: %zu threads do not fit on the %zu usable CPUs\n",
+        num_reused, usable.size());
+  }
+
+  // The unplanned CPUs, primaries first. Core indices below core_offset
+  // take them from the back, so the ones after the plan (e.g., the
+  // recorder) get the best of them.
+  std::vector<size_t> unplanned;
+  for (auto* pool : {&primaries, &secondaries}) {
+    for (const size_t node : nodes) {
+      const auto& cpus = (*pool)[node];
+      unplanned.insert(unplanned.end(), cpus.begin(), cpus.end());
+    }
+  }
+  for (size_t i = 0; i < core_offset; i++) {
+    if (unplanned.empty() == false) {
+      layout_.push_back(unplanned.back());
+      unplanned.pop_back();
+    } else {
+      layout_.push_back(usable.at(i % usable.size()));
+    }
+  }
+  for (const auto& assignment : assignments_) {
+    layout_.push_back(assignment.cpu_);
+  }
+  layout_.insert(layout_.end(), unplanned.begin(), unplanned.end());
+}
+
+void CoreLayoutPlan::Print() const {
+  std::printf("=================================\n");
+  std::printf("         CORE LAYOUT PLAN        \n");
+  std::printf("=================================\n");
+  std::printf("NIC NUMA node: %zu\n", nic_node_);
+  for (const auto& assignment : assignments_) {
+    std::printf("|| ThreadType: %-16s || ThreadId: %2zu || CPU: %3zu || "
+                "Node: %zu%s\n",
+                ThreadTypeStr(assignment.type_).c_str(), assignment.thread_id_,
+                assignment.cpu_, assignment.node_,
+                assignment.shared_ ? " || SMT shared" : "");
+  }
+  std::printf("=================================\n");
+}
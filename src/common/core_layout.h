@@ -0,0 +1,84 @@
+/**
+ * @file core_layout.h
+ * @brief Declaration file for the CpuTopology and CoreLayoutPlan classes,
+ * which place the base station threads on the CPUs so that they avoid SMT
+ * siblings and keep the I/O threads near the NIC
+ */
+#ifndef CORE_LAYOUT_H_
+#define CORE_LAYOUT_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "symbols.h"
+
+class CpuTopology {
+ public:
+  /// One online logical CPU
+  struct Cpu {
+    size_t id_;
+    size_t node_;
+    size_t package_;
+    // Core id within the package. SMT siblings share it.
+    size_t core_;
+  };
+
+  explicit CpuTopology(std::vector<Cpu> cpus);
+
+  /// Read the online CPUs from the sysfs tree under [sysfs_root]
+  static CpuTopology FromSysfs(const std::string& sysfs_root = "/sys");
+
+  /// NUMA node of the network device [device], an interface name or a PCI
+  /// address. -1 if sysfs does not know it.
+  static int DeviceNumaNode(const std::string& device,
+                            const std::string& sysfs_root = "/sys");
+
+  /// Parse a sysfs CPU list such as "0-3,8,10-11"
+  static std::vector<size_t> ParseCpuList(const std::string& list);
+
+  inline const std::vector<Cpu>& Cpus() const { return this->cpus_; }
+
+ private:
+  std::vector<Cpu> cpus_;
+};
+
+class CoreLayoutPlan {
+ public:
+  /// The CPU planned for one thread
+  struct Assignment {
+    ThreadType type_;
+    size_t thread_id_;
+    size_t cpu_;
+    size_t node_;
+    // True if an SMT sibling of the CPU is busy, or the CPU is reused
+    bool shared_;
+  };
+
+  /// Plan the master, [num_txrx] TX/RX, [num_workers] worker and [num_mac]
+  /// MAC threads, in the order Agora offsets them from [core_offset].
+  /// Each thread gets a physical core of its own while there are enough,
+  /// the master and TX/RX threads on [nic_node] first. [nic_node] < 0 uses
+  /// the node of the first usable CPU.
+  CoreLayoutPlan(const CpuTopology& topology,
+                 const std::vector<size_t>& excluded_cpus, int nic_node,
+                 size_t core_offset, size_t num_txrx, size_t num_workers,
+                 size_t num_mac);
+
+  inline const std::vector<Assignment>& Assignments() const {
+    return this->assignments_;
+  }
+  /// CPU of each core index, for SetCpuLayout(). Core index core_offset + i
+  /// is the CPU of Assignments()[i].
+  inline const std::vector<size_t>& Layout() const { return this->layout_; }
+  inline size_t NicNode() const { return this->nic_node_; }
+
+  void Print() const;
+
+ private:
+  size_t nic_node_;
+  std::vector<Assignment> assignments_;
+  std::vector<size_t> layout_;
+};
+
+#endif  // CORE_LAYOUT_H_
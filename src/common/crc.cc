@@ -36,6 +36,49 @@
 
 #include "crc.h"
 
+#if defined(__PCLMUL__) && defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+// The CRC24 of a message is the 32-bit CRC over G_CRC_24A * x^8, shifted
+// down by 8 bits. The carry-less folding works on that 32-bit CRC.
+static constexpr uint64_t kCrc32Poly = 0x1864CFBull << 8;
+
+/// x^[n] mod kCrc32Poly
+static constexpr uint64_t XPowMod(size_t n) {
+  uint64_t rem = 1;
+  for (size_t i = 0; i < n; i++) {
+    rem <<= 1;
+    if ((rem & (1ull << 32)) != 0) {
+      rem ^= kCrc32Poly;
+    }
+  }
+  return rem;
+}
+
+/// floor(x^64 / kCrc32Poly), the Barrett reduction constant
+static constexpr uint64_t BarrettMu() {
+  uint64_t quot = 0;
+  uint64_t rem = 0;
+  for (int i = 64; i >= 0; i--) {
+    rem = (rem << 1) | ((i == 64) ? 1 : 0);
+    if ((rem & (1ull << 32)) != 0) {
+      rem ^= kCrc32Poly;
+      quot |= 1ull << i;
+    }
+  }
+  return quot;
+}
+
+// Fold one 128-bit block over the next one, or over the block 4 ahead
+static constexpr uint64_t kFold1Hi = XPowMod(128 + 64);
+static constexpr uint64_t kFold1Lo = XPowMod(128);
+static constexpr uint64_t kFold4Hi = XPowMod(512 + 64);
+static constexpr uint64_t kFold4Lo = XPowMod(512);
+static constexpr uint64_t kReduce96 = XPowMod(96);
+static constexpr uint64_t kReduce64 = XPowMod(64);
+static constexpr uint64_t kBarrettMu = BarrettMu();
+
 #ifdef REBUILD_TABLE
 static void DoCRC::init_crc24(uint32_t table[256]) {
   /*
@@ -85,6 +128,88 @@ void DoCRC::AddCrc24(MacPacketPacked* p) {
 }
 
 uint32_t DoCRC::CalculateCrc24(const unsigned char* data, int len) {
+  if (len <= 0) {
+    return 0;
+  }
+  const auto num_bytes = static_cast<size_t>(len);
+  size_t pos = 0;
+  uint32_t crc = 0;
+
+#if defined(__PCLMUL__) && defined(__SSE4_1__)
+  if (num_bytes >= 16) {
+    // Byte reverse, so the first message bit is the highest coefficient
+    const __m128i bswap =
+        _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const auto load = [&](size_t offset) {
+      return _mm_shuffle_epi8(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + offset)),
+          bswap);
+    };
+    // x * x^d mod P for the constants of distance d, with 96-bit results
+    const auto fold = [](__m128i x, __m128i k) {
+      return _mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x11),
+                           _mm_clmulepi64_si128(x, k, 0x00));
+    };
+    const __m128i k_fold1 = _mm_set_epi64x(static_cast<int64_t>(kFold1Hi),
+                                           static_cast<int64_t>(kFold1Lo));
+
+    __m128i x;
+    if (num_bytes >= 128) {
+      // Four independent chains hide the multiplier latency
+      const __m128i k_fold4 = _mm_set_epi64x(static_cast<int64_t>(kFold4Hi),
+                                             static_cast<int64_t>(kFold4Lo));
+      __m128i x0 = load(0);
+      __m128i x1 = load(16);
+      __m128i x2 = load(32);
+      __m128i x3 = load(48);
+      for (pos = 64; pos + 64 <= num_bytes; pos += 64) {
+        x0 = _mm_xor_si128(fold(x0, k_fold4), load(pos));
+        x1 = _mm_xor_si128(fold(x1, k_fold4), load(pos + 16));
+        x2 = _mm_xor_si128(fold(x2, k_fold4), load(pos + 32));
+        x3 = _mm_xor_si128(fold(x3, k_fold4), load(pos + 48));
+      }
+      x = _mm_xor_si128(fold(x0, k_fold1), x1);
+      x = _mm_xor_si128(fold(x, k_fold1), x2);
+      x = _mm_xor_si128(fold(x, k_fold1), x3);
+    } else {
+      x = load(0);
+      pos = 16;
+    }
+    for (; pos + 16 <= num_bytes; pos += 16) {
+      x = _mm_xor_si128(fold(x, k_fold1), load(pos));
+    }
+
+    // x * x^32 mod P: first to 96 bits, then to 64 bits
+    const __m128i k_reduce = _mm_set_epi64x(static_cast<int64_t>(kReduce64),
+                                            static_cast<int64_t>(kReduce96));
+    __m128i t = _mm_xor_si128(_mm_clmulepi64_si128(x, k_reduce, 0x01),
+                              _mm_slli_si128(_mm_move_epi64(x), 4));
+    t = _mm_xor_si128(_mm_clmulepi64_si128(t, k_reduce, 0x11),
+                      _mm_move_epi64(t));
+    // Barrett reduction of the 64-bit remainder to 32 bits
+    const __m128i k_barrett = _mm_set_epi64x(static_cast<int64_t>(kCrc32Poly),
+                                             static_cast<int64_t>(kBarrettMu));
+    __m128i quot =
+        _mm_clmulepi64_si128(_mm_srli_epi64(t, 32), k_barrett, 0x00);
+    quot = _mm_srli_si128(quot, 4);
+    t = _mm_xor_si128(t, _mm_clmulepi64_si128(quot, k_barrett, 0x10));
+    crc = static_cast<uint32_t>(_mm_cvtsi128_si32(t)) >> 8;
+  }
+#endif
+
+  crc = UpdateCrc24(crc, data + pos, num_bytes - pos);
+  return (crc & 0x00ffffff);
+}
+
+uint32_t DoCRC::UpdateCrc24(uint32_t crc, const unsigned char* data,
+                            size_t len) const {
+  for (size_t i = 0; i < len; i++) {
+    crc = (crc << 8) ^ crc24_table_[data[i] ^ (unsigned char)(crc >> 16)];
+  }
+  return crc;
+}
+
+uint32_t DoCRC::CalculateCrc24Reference(const unsigned char* data, int len) {
   /*
    *
    */
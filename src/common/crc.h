@@ -13,6 +13,7 @@
 #ifndef CRC_H_
 #define CRC_H_
 
+#include <cstddef>
 #include <cstdint>
 
 #include "message.h"
@@ -97,9 +98,18 @@ class DoCRC {
 
   /**
    * Compute CRC
+   * Folds 16-byte blocks with carry-less multiplication (PCLMULQDQ) and
+   * finishes the tail with the table. Falls back to the table alone when
+   * PCLMULQDQ is not available.
    */
   uint32_t CalculateCrc24(const unsigned char* data, int len);
 
+  /**
+   * Compute CRC one byte at a time with the table. Reference for
+   * CalculateCrc24
+   */
+  uint32_t CalculateCrc24Reference(const unsigned char* data, int len);
+
   /*
    * Compute and add CRC to packet
    */
@@ -109,6 +119,11 @@ class DoCRC {
    * Verify CRC
    */
   bool CheckCrc24(unsigned char* data, int len, uint32_t ref_crc);
+
+ private:
+  // Continue the table CRC [crc] over [len] more bytes
+  uint32_t UpdateCrc24(uint32_t crc, const unsigned char* data,
+                       size_t len) const;
 };
 
 #endif  // CRC_H_
@@ -275,6 +275,123 @@ static inline void SimdConvertFloatToShort(const float* in_buf, short* out_buf,
 #endif
 }
 
+// SimdConvertFloatToShortAVX512 that also tracks the signal peak in the same
+// pass. Returns max(|in_buf[i]|) / scale_down_factor and adds the number of
+// inputs clipped by the conversion (|in_buf[i]| / scale_down_factor >= 1) to
+// [num_clipped]
+static inline float SimdConvertFloatToShortPeakAVX512(
+    const float* in_buf, short* out_buf, size_t n_elems, size_t n_prefix,
+    float scale_down_factor, size_t& num_clipped) {
+#if defined(__AVX512F__)
+  const __m512 scale_factor =
+      _mm512_set1_ps(kShrtFltConvFactor / scale_down_factor);
+  const __m512 clip_level = _mm512_set1_ps(scale_down_factor);
+  const __m512i permute_index = _mm512_setr_epi64(0, 2, 4, 6, 1, 3, 5, 7);
+  __m512 peak = _mm512_setzero_ps();
+  size_t clipped = 0;
+  for (size_t i = 0; i < n_elems; i += kAvx512FloatsPerLoop) {
+    const __m512 in1 = _mm512_load_ps(&in_buf[i]);
+    const __m512 in2 = _mm512_load_ps(&in_buf[i + kAvx512FloatsPerInstr]);
+    const __m512 abs1 = _mm512_abs_ps(in1);
+    const __m512 abs2 = _mm512_abs_ps(in2);
+    peak = _mm512_max_ps(peak, _mm512_max_ps(abs1, abs2));
+    clipped += _mm_popcnt_u32(
+        _mm512_cmp_ps_mask(abs1, clip_level, _CMP_GE_OQ) |
+        (_mm512_cmp_ps_mask(abs2, clip_level, _CMP_GE_OQ) << 16));
+    const __m512i int32_1 =
+        _mm512_cvtps_epi32(_mm512_mul_ps(in1, scale_factor));
+    const __m512i int32_2 =
+        _mm512_cvtps_epi32(_mm512_mul_ps(in2, scale_factor));
+    const __m512i shuffled = _mm512_permutexvar_epi64(
+        permute_index, _mm512_packs_epi32(int32_1, int32_2));
+    _mm512_stream_si512(reinterpret_cast<__m512i*>(&out_buf[i + n_prefix]),
+                        shuffled);
+    // Prepend / Set cyclic prefix
+    const size_t repeat_idx = n_elems - n_prefix;
+    if (i >= repeat_idx) {
+      _mm512_stream_si512(reinterpret_cast<__m512i*>(&out_buf[i - repeat_idx]),
+                          shuffled);
+    }
+  }
+  num_clipped += clipped;
+  return _mm512_reduce_max_ps(peak) / scale_down_factor;
+#else
+  unused(in_buf);
+  unused(out_buf);
+  unused(n_elems);
+  unused(n_prefix);
+  unused(scale_down_factor);
+  unused(num_clipped);
+  throw std::runtime_error("AVX512 is not supported");
+#endif
+}
+
+// SimdConvertFloatToShortAVX2 that also tracks the signal peak in the same
+// pass, see SimdConvertFloatToShortPeakAVX512
+static inline float SimdConvertFloatToShortPeakAVX2(const float* in_buf,
+                                                    short* out_buf,
+                                                    size_t n_elems,
+                                                    size_t n_prefix,
+                                                    float scale_down_factor,
+                                                    size_t& num_clipped) {
+  const __m256 scale_factor =
+      _mm256_set1_ps(kShrtFltConvFactor / scale_down_factor);
+  const __m256 clip_level = _mm256_set1_ps(scale_down_factor);
+  const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+  __m256 peak = _mm256_setzero_ps();
+  size_t clipped = 0;
+  for (size_t i = 0; i < n_elems; i += kAvx2FloatsPerLoop) {
+    const __m256 in1 = _mm256_load_ps(&in_buf[i]);
+    const __m256 in2 = _mm256_load_ps(&in_buf[i + kAvx2FloatsPerInstr]);
+    const __m256 abs1 = _mm256_andnot_ps(sign_mask, in1);
+    const __m256 abs2 = _mm256_andnot_ps(sign_mask, in2);
+    peak = _mm256_max_ps(peak, _mm256_max_ps(abs1, abs2));
+    clipped += _mm_popcnt_u32(
+        _mm256_movemask_ps(_mm256_cmp_ps(abs1, clip_level, _CMP_GE_OQ)) |
+        (_mm256_movemask_ps(_mm256_cmp_ps(abs2, clip_level, _CMP_GE_OQ))
+         << 8));
+    const __m256i integer1 =
+        _mm256_cvtps_epi32(_mm256_mul_ps(in1, scale_factor));
+    const __m256i integer2 =
+        _mm256_cvtps_epi32(_mm256_mul_ps(in2, scale_factor));
+    const __m256i slice = _mm256_permute4x64_epi64(
+        _mm256_packs_epi32(integer1, integer2), 0xD8);
+    _mm256_stream_si256(reinterpret_cast<__m256i*>(&out_buf[i + n_prefix]),
+                        slice);
+    // Prepend / Set cyclic prefix
+    const size_t repeat_idx = n_elems - n_prefix;
+    if (i >= repeat_idx) {
+      _mm256_stream_si256(reinterpret_cast<__m256i*>(&out_buf[i - repeat_idx]),
+                          slice);
+    }
+  }
+  // Horizontal max of the 8 lanes
+  __m128 peak128 =
+      _mm_max_ps(_mm256_castps256_ps128(peak), _mm256_extractf128_ps(peak, 1));
+  peak128 = _mm_max_ps(peak128, _mm_movehl_ps(peak128, peak128));
+  peak128 = _mm_max_ss(peak128, _mm_shuffle_ps(peak128, peak128, 0x1));
+  num_clipped += clipped;
+  return _mm_cvtss_f32(peak128) / scale_down_factor;
+}
+
+// Single pass IFFT post-processing: scales and converts [in_buf] to int16 with
+// cyclic prefix like SimdConvertFloatToShort, returns the peak magnitude of
+// the scaled input and adds the number of clipped inputs to [num_clipped].
+// Same size and alignment requirements as SimdConvertFloatToShort.
+static inline float SimdConvertFloatToShortPeak(const float* in_buf,
+                                                short* out_buf, size_t n_elems,
+                                                size_t n_prefix,
+                                                float scale_down_factor,
+                                                size_t& num_clipped) {
+#if defined(__AVX512F__)
+  return SimdConvertFloatToShortPeakAVX512(in_buf, out_buf, n_elems, n_prefix,
+                                           scale_down_factor, num_clipped);
+#else
+  return SimdConvertFloatToShortPeakAVX2(in_buf, out_buf, n_elems, n_prefix,
+                                         scale_down_factor, num_clipped);
+#endif
+}
+
 //Assumes complex float == float float
 static inline void SimdConvertCxFloatToCxShort(
     const std::complex<float>* in_buf, std::complex<short>* out_buf,
@@ -598,4 +715,77 @@ static inline void SimdConvertFloat32ToFloat16(float* out_buf,
   }
 #endif
 }
+
+// Convert a float32 array [in_buf] to a float16 array [out_buf] of [n_elems]
+// elements. No alignment or length restriction. Converting in place into the
+// same memory is allowed since every store lands behind the loads.
+static inline void SimdConvertFloatToHalf(const float* in_buf,
+                                          uint16_t* out_buf, size_t n_elems) {
+  size_t i = 0;
+#ifdef __AVX512F__
+  for (; i + 16 <= n_elems; i += 16) {
+    const __m512 val = _mm512_loadu_ps(in_buf + i);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out_buf + i),
+                        _mm512_cvtps_ph(val, _MM_FROUND_TO_NEAREST_INT));
+  }
+#endif
+  for (; i + 8 <= n_elems; i += 8) {
+    const __m256 val = _mm256_loadu_ps(in_buf + i);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out_buf + i),
+                     _mm256_cvtps_ph(val, _MM_FROUND_TO_NEAREST_INT));
+  }
+  for (; i < n_elems; i++) {
+    out_buf[i] = _cvtss_sh(in_buf[i], _MM_FROUND_TO_NEAREST_INT);
+  }
+}
+
+// Convert a float16 array [in_buf] to a float32 array [out_buf] of [n_elems]
+// elements. No alignment or length restriction.
+static inline void SimdConvertHalfToFloat(const uint16_t* in_buf,
+                                          float* out_buf, size_t n_elems) {
+  size_t i = 0;
+#ifdef __AVX512F__
+  for (; i + 16 <= n_elems; i += 16) {
+    const __m256i val =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in_buf + i));
+    _mm512_storeu_ps(out_buf + i, _mm512_cvtph_ps(val));
+  }
+#endif
+  for (; i + 8 <= n_elems; i += 8) {
+    const __m128i val =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(in_buf + i));
+    _mm256_storeu_ps(out_buf + i, _mm256_cvtph_ps(val));
+  }
+  for (; i < n_elems; i++) {
+    out_buf[i] = _cvtsh_ss(in_buf[i]);
+  }
+}
+
+// Gather [n_cx] complex float16 values spaced [stride] complex values apart,
+// starting at [in_buf], into [n_cx] contiguous complex float32 values
+static inline void SimdGatherCxHalfToCxFloat(const uint16_t* in_buf,
+                                             size_t stride, float* out_buf,
+                                             size_t n_cx) {
+  // A complex float16 is exactly one 32-bit word
+  const auto* src = reinterpret_cast<const int*>(in_buf);
+  const __m256i index = _mm256_mullo_epi32(
+      _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+      _mm256_set1_epi32(static_cast<int>(stride)));
+  size_t i = 0;
+  for (; i + 8 <= n_cx; i += 8) {
+    const __m256i val = _mm256_i32gather_epi32(src + i * stride, index, 4);
+#ifdef __AVX512F__
+    _mm512_storeu_ps(out_buf + 2 * i, _mm512_cvtph_ps(val));
+#else
+    _mm256_storeu_ps(out_buf + 2 * i,
+                     _mm256_cvtph_ps(_mm256_castsi256_si128(val)));
+    _mm256_storeu_ps(out_buf + 2 * i + 8,
+                     _mm256_cvtph_ps(_mm256_extracti128_si256(val, 1)));
+#endif
+  }
+  for (; i < n_cx; i++) {
+    out_buf[2 * i] = _cvtsh_ss(in_buf[2 * i * stride]);
+    out_buf[2 * i + 1] = _cvtsh_ss(in_buf[2 * i * stride + 1]);
+  }
+}
 #endif  // DATATYPE_CONVERSION_H_
\ No newline at end of file
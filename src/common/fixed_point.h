@@ -0,0 +1,167 @@
+/**
+ * @file fixed_point.h
+ * @brief Block floating point helpers for the fixed-point uplink datapath.
+ * Samples are stored as interleaved int16 I/Q with one power-of-two exponent
+ * per block, so a quantized value q represents q * 2^(exp - frac_bits).
+ */
+#ifndef FIXED_POINT_H_
+#define FIXED_POINT_H_
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+/// Fractional bits of quantized FFT output. Two bits of headroom keep the
+/// per-lane int32 accumulators of the equalizer from overflowing for up to
+/// kFixedPointMaxAntennas antennas.
+static constexpr int kFixedPointDataFracBits = 13;
+/// Largest array supported by the int32 accumulators of FixedPointEqualize
+static constexpr size_t kFixedPointMaxAntennas = 64;
+/// Fractional bits of quantized uplink beam matrices
+static constexpr int kFixedPointBeamFracBits = 14;
+
+/// Smallest exponent such that every |in_buf[i]| / 2^exp < 1
+static inline int8_t FixedPointBlockExponent(const float* in_buf,
+                                             size_t n_elems) {
+  float max_abs = 0;
+  size_t i = 0;
+#if defined(__AVX512F__)
+  __m512 max_vec = _mm512_setzero_ps();
+  for (; i + 16 <= n_elems; i += 16) {
+    max_vec = _mm512_max_ps(max_vec, _mm512_abs_ps(_mm512_loadu_ps(in_buf + i)));
+  }
+  max_abs = _mm512_reduce_max_ps(max_vec);
+#endif
+  for (; i < n_elems; i++) {
+    max_abs = std::max(max_abs, std::fabs(in_buf[i]));
+  }
+  if (max_abs == 0.0f) {
+    return 0;
+  }
+  int exp;
+  std::frexp(max_abs, &exp);
+  return static_cast<int8_t>(
+      std::clamp(exp, static_cast<int>(INT8_MIN), static_cast<int>(INT8_MAX)));
+}
+
+/// Quantize [n_elems] floats: out_buf[i] = round(in_buf[i] * 2^(frac_bits -
+/// exp)), saturated to int16
+static inline void FixedPointQuantize(const float* in_buf, short* out_buf,
+                                      size_t n_elems, int exp, int frac_bits) {
+  const float scale = std::ldexp(1.0f, frac_bits - exp);
+  size_t i = 0;
+#if defined(__AVX512F__)
+  const __m512 scale_vec = _mm512_set1_ps(scale);
+  for (; i + 16 <= n_elems; i += 16) {
+    const __m512i val = _mm512_cvtps_epi32(
+        _mm512_mul_ps(_mm512_loadu_ps(in_buf + i), scale_vec));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out_buf + i),
+                        _mm512_cvtsepi32_epi16(val));
+  }
+#endif
+  const __m256 scale_vec256 = _mm256_set1_ps(scale);
+  for (; i + 8 <= n_elems; i += 8) {
+    const __m256i val = _mm256_cvtps_epi32(
+        _mm256_mul_ps(_mm256_loadu_ps(in_buf + i), scale_vec256));
+    const __m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(val),
+                                           _mm256_extracti128_si256(val, 1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out_buf + i), packed);
+  }
+  for (; i < n_elems; i++) {
+    const long val = std::lrintf(in_buf[i] * scale);
+    out_buf[i] = static_cast<short>(
+        std::clamp(val, static_cast<long>(INT16_MIN),
+                   static_cast<long>(INT16_MAX)));
+  }
+}
+
+/// Quantize a ue_num x bs_ant_num column-major complex beam matrix into the
+/// layout expected by FixedPointEqualize. Each UE row is stored twice:
+/// (re, -im) pairs producing the real output and (im, re) pairs producing
+/// the imaginary output, so out_buf needs 4 * ue_num * bs_ant_num shorts.
+/// [tmp_buf] is scratch space for 2 * bs_ant_num floats.
+static inline int8_t FixedPointPackBeam(const float* beam, size_t ue_num,
+                                        size_t bs_ant_num, short* out_buf,
+                                        float* tmp_buf) {
+  const int8_t exp = FixedPointBlockExponent(beam, 2 * ue_num * bs_ant_num);
+  for (size_t ue_id = 0; ue_id < ue_num; ue_id++) {
+    short* re_row = out_buf + (4 * bs_ant_num * ue_id);
+    short* im_row = re_row + (2 * bs_ant_num);
+    for (size_t ant = 0; ant < bs_ant_num; ant++) {
+      tmp_buf[2 * ant] = beam[2 * (ant * ue_num + ue_id)];
+      tmp_buf[2 * ant + 1] = -beam[2 * (ant * ue_num + ue_id) + 1];
+    }
+    FixedPointQuantize(tmp_buf, re_row, 2 * bs_ant_num, exp,
+                       kFixedPointBeamFracBits);
+    for (size_t ant = 0; ant < bs_ant_num; ant++) {
+      im_row[2 * ant] = static_cast<short>(-re_row[2 * ant + 1]);
+      im_row[2 * ant + 1] = re_row[2 * ant];
+    }
+  }
+  return exp;
+}
+
+/// Complex int16 matrix-vector product y = W * x for one subcarrier, where W
+/// is packed by FixedPointPackBeam and x holds bs_ant_num interleaved int16
+/// samples. The int32 sums are scaled by [scale] into interleaved float
+/// outputs of ue_num complex values.
+static inline void FixedPointEqualize(const short* beam_q, const short* data_q,
+                                      size_t ue_num, size_t bs_ant_num,
+                                      float scale, float* out_buf) {
+  for (size_t ue_id = 0; ue_id < ue_num; ue_id++) {
+    const short* re_row = beam_q + (4 * bs_ant_num * ue_id);
+    const short* im_row = re_row + (2 * bs_ant_num);
+    float sum_re = 0;
+    float sum_im = 0;
+    size_t ant = 0;
+#if defined(__AVX512BW__)
+    __m512i acc_re512 = _mm512_setzero_si512();
+    __m512i acc_im512 = _mm512_setzero_si512();
+    for (; ant + 16 <= bs_ant_num; ant += 16) {
+      const __m512i x = _mm512_loadu_si512(data_q + 2 * ant);
+      acc_re512 = _mm512_add_epi32(
+          acc_re512, _mm512_madd_epi16(x, _mm512_loadu_si512(re_row + 2 * ant)));
+      acc_im512 = _mm512_add_epi32(
+          acc_im512, _mm512_madd_epi16(x, _mm512_loadu_si512(im_row + 2 * ant)));
+    }
+    // Reduce in float since the sum of all lanes can exceed int32
+    sum_re += _mm512_reduce_add_ps(_mm512_cvtepi32_ps(acc_re512));
+    sum_im += _mm512_reduce_add_ps(_mm512_cvtepi32_ps(acc_im512));
+#endif
+    __m256i acc_re = _mm256_setzero_si256();
+    __m256i acc_im = _mm256_setzero_si256();
+    for (; ant + 8 <= bs_ant_num; ant += 8) {
+      const __m256i x =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data_q + 2 * ant));
+      acc_re = _mm256_add_epi32(
+          acc_re, _mm256_madd_epi16(x, _mm256_loadu_si256(
+                                           reinterpret_cast<const __m256i*>(
+                                               re_row + 2 * ant))));
+      acc_im = _mm256_add_epi32(
+          acc_im, _mm256_madd_epi16(x, _mm256_loadu_si256(
+                                           reinterpret_cast<const __m256i*>(
+                                               im_row + 2 * ant))));
+    }
+    alignas(32) float lanes_re[8];
+    alignas(32) float lanes_im[8];
+    _mm256_store_ps(lanes_re, _mm256_cvtepi32_ps(acc_re));
+    _mm256_store_ps(lanes_im, _mm256_cvtepi32_ps(acc_im));
+    for (size_t lane = 0; lane < 8; lane++) {
+      sum_re += lanes_re[lane];
+      sum_im += lanes_im[lane];
+    }
+    for (; ant < bs_ant_num; ant++) {
+      sum_re += static_cast<float>(data_q[2 * ant] * re_row[2 * ant] +
+                                   data_q[2 * ant + 1] * re_row[2 * ant + 1]);
+      sum_im += static_cast<float>(data_q[2 * ant] * im_row[2 * ant] +
+                                   data_q[2 * ant + 1] * im_row[2 * ant + 1]);
+    }
+    out_buf[2 * ue_id] = sum_re * scale;
+    out_buf[2 * ue_id + 1] = sum_im * scale;
+  }
+}
+
+#endif  // FIXED_POINT_H_
@@ -0,0 +1,55 @@
+/**
+ * @file frame_block_sizes.h
+ * @brief Declaration file for the FrameBlockSizes class, which holds the Doer
+ * block sizes each frame in the frame window runs with
+ */
+#ifndef FRAME_BLOCK_SIZES_H_
+#define FRAME_BLOCK_SIZES_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "config.h"
+
+/// Doer block sizes of one frame
+struct BlockSizes {
+  size_t demul_;
+  size_t beam_;
+  size_t fft_;
+  size_t encode_;
+
+  /// The sizes in [cfg], which are also the largest the Doers support
+  static BlockSizes Configured(const Config* cfg) {
+    return {cfg->DemulBlockSize(), cfg->BeamBlockSize(), cfg->FftBlockSize(),
+            cfg->EncodeBlockSize()};
+  }
+};
+
+/**
+ * @brief The master thread stamps the block sizes of a frame before it
+ * schedules the frame's first task. The frame's tasks, in the master and in
+ * the Doers, read them from here, so the sizes can change between frames
+ * while other frames are in flight. A slot is only restamped once the frame
+ * window has moved past its previous frame.
+ */
+class FrameBlockSizes {
+ public:
+  /// Every frame runs with the configured sizes until stamped
+  explicit FrameBlockSizes(const Config* cfg)
+      : frame_wnd_mask_(cfg->FrameWnd() - 1),
+        sizes_(cfg->FrameWnd(), BlockSizes::Configured(cfg)) {}
+
+  void Stamp(size_t frame_id, const BlockSizes& sizes) {
+    this->sizes_.at(frame_id & this->frame_wnd_mask_) = sizes;
+  }
+
+  inline const BlockSizes& Get(size_t frame_id) const {
+    return this->sizes_.at(frame_id & this->frame_wnd_mask_);
+  }
+
+ private:
+  const size_t frame_wnd_mask_;
+  std::vector<BlockSizes> sizes_;
+};
+
+#endif  // FRAME_BLOCK_SIZES_H_
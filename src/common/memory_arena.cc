@@ -0,0 +1,75 @@
+/**
+ * @file memory_arena.cc
+ * @brief Implementation file for the MemoryArena class
+ */
+#include "memory_arena.h"
+
+#include <cstdlib>
+
+#include "memory_manage.h"
+#include "utils.h"
+
+// Overflow blocks a task can hold before their list itself reallocates
+static constexpr size_t kMaxOverflowBlocks = 64;
+
+static inline size_t AlignUp(size_t size) {
+  return (size + MemoryArena::kAlignment - 1) & ~(MemoryArena::kAlignment - 1);
+}
+
+MemoryArena::MemoryArena(size_t capacity) : capacity_(AlignUp(capacity)) {
+  overflow_.reserve(kMaxOverflowBlocks);
+}
+
+MemoryArena::~MemoryArena() {
+  Reset();
+  std::free(base_);
+}
+
+MemoryArena& MemoryArena::ThreadLocal() {
+  static thread_local MemoryArena arena;
+  return arena;
+}
+
+void* MemoryArena::AllocBytes(size_t size) {
+  size = AlignUp(size);
+  task_bytes_ += size;
+  if (base_ == nullptr) {
+    base_ = static_cast<char*>(Agora_memory::PaddedAlignedAlloc(
+        Agora_memory::Alignment_t::kAlign64, capacity_));
+    RtAssert(base_ != nullptr, "MemoryArena: failed to allocate");
+    heap_allocs_++;
+  }
+  if (offset_ + size <= capacity_) {
+    void* ptr = base_ + offset_;
+    offset_ += size;
+    return ptr;
+  }
+
+  void* ptr = Agora_memory::PaddedAlignedAlloc(
+      Agora_memory::Alignment_t::kAlign64, size);
+  RtAssert(ptr != nullptr, "MemoryArena: failed to allocate");
+  overflow_.push_back(ptr);
+  heap_allocs_++;
+  return ptr;
+}
+
+size_t MemoryArena::Reset() {
+  for (void* ptr : overflow_) {
+    std::free(ptr);
+  }
+  if (overflow_.empty() == false) {
+    // Grow to the peak now so that the next task of this size fits
+    overflow_.clear();
+    std::free(base_);
+    base_ = nullptr;
+    capacity_ = AlignUp(task_bytes_);
+  }
+  if (task_bytes_ > peak_bytes_) {
+    peak_bytes_ = task_bytes_;
+  }
+  offset_ = 0;
+  task_bytes_ = 0;
+  const size_t heap_allocs = heap_allocs_;
+  heap_allocs_ = 0;
+  return heap_allocs;
+}
@@ -0,0 +1,59 @@
+/**
+ * @file memory_arena.h
+ * @brief Declaration file for the MemoryArena class, a per-thread bump
+ * allocator for the scratch memory of one task
+ */
+#ifndef MEMORY_ARENA_H_
+#define MEMORY_ARENA_H_
+
+#include <cstddef>
+#include <vector>
+
+class MemoryArena {
+ public:
+  // Backing memory of a thread's arena before it first overflows
+  static constexpr size_t kDefaultCapacity = (1ul << 18);
+  // Every allocation starts on a cache line
+  static constexpr size_t kAlignment = 64;
+
+  /// [capacity] bytes of backing memory are reserved by the first Alloc
+  explicit MemoryArena(size_t capacity = kDefaultCapacity);
+  ~MemoryArena();
+
+  /// The arena of the calling thread, shared by all Doers of that thread
+  static MemoryArena& ThreadLocal();
+
+  /// Memory for [count] objects of type T that stays valid until Reset().
+  /// The memory is not initialized.
+  template <class T>
+  inline T* Alloc(size_t count) {
+    return static_cast<T*>(AllocBytes(count * sizeof(T)));
+  }
+  void* AllocBytes(size_t size);
+
+  /// End of a task: release everything allocated since the last Reset().
+  /// If the task overflowed the backing memory, it grows to the task's peak
+  /// so that the next tasks fit. Returns the number of heap allocations
+  /// made since the last Reset(), zero once the arena has warmed up.
+  size_t Reset();
+
+  inline size_t Capacity() const { return capacity_; }
+  /// Largest number of bytes a single task has used
+  inline size_t PeakBytes() const { return peak_bytes_; }
+
+  MemoryArena(MemoryArena const&) = delete;
+  MemoryArena& operator=(MemoryArena const&) = delete;
+
+ private:
+  char* base_{nullptr};
+  size_t capacity_;
+  size_t offset_{0};
+  // Bytes used by the current task, including the overflow blocks
+  size_t task_bytes_{0};
+  size_t peak_bytes_{0};
+  size_t heap_allocs_{0};
+  // Heap blocks of the allocations that did not fit, freed by Reset()
+  std::vector<void*> overflow_;
+};
+
+#endif  // MEMORY_ARENA_H_
@@ -1,6 +1,28 @@
 #include "memory_manage.h"
 
+#include <linux/mman.h>
+#include <numaif.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+
 namespace Agora_memory {
+// Explicit hugepage mappings, which are released with munmap
+struct HugePageMapping {
+  size_t size_;
+  size_t page_size_;
+};
+
+static std::atomic<HugePageSize> huge_page_size{HugePageSize::kNone};
+static std::mutex huge_page_mutex;
+static std::map<uintptr_t, HugePageMapping> huge_page_mappings;
+static HugePageCounters huge_page_counters;
+
 inline size_t PaddedAllocSize(Alignment_t alignment, size_t size) {
   auto align = static_cast<size_t>(alignment);
   size_t padded_size = size;
@@ -16,4 +38,135 @@ void* PaddedAlignedAlloc(Alignment_t alignment, size_t size) {
   return std::aligned_alloc(static_cast<size_t>(alignment),
                             PaddedAllocSize(alignment, size));
 }
-};  // namespace Agora_memory
\ No newline at end of file
+
+void SetHugePageSize(HugePageSize page_size) { huge_page_size = page_size; }
+
+HugePageSize HugePageSizeFor(HugePageSize page_size, size_t size) {
+  // A 1 GiB page would mostly stay empty, smaller buffers use 2 MiB pages
+  if ((page_size == HugePageSize::k1G) &&
+      (size < static_cast<size_t>(HugePageSize::k1G) / 2)) {
+    page_size = HugePageSize::k2M;
+  }
+  if (size < static_cast<size_t>(page_size) / 2) {
+    return HugePageSize::kNone;
+  }
+  return page_size;
+}
+
+void* BufferAlloc(Alignment_t alignment, size_t size) {
+  const auto page_size =
+      static_cast<size_t>(HugePageSizeFor(huge_page_size.load(), size));
+  if (page_size == 0) {
+    std::scoped_lock lock(huge_page_mutex);
+    huge_page_counters.normal_allocs_++;
+    huge_page_counters.normal_bytes_ += size;
+    return PaddedAlignedAlloc(alignment, size);
+  }
+
+  // Hugepages are aligned well beyond any Alignment_t
+  const size_t huge_size = (size + page_size - 1) & ~(page_size - 1);
+  const int page_flag = (page_size == static_cast<size_t>(HugePageSize::k1G))
+                            ? MAP_HUGE_1GB
+                            : MAP_HUGE_2MB;
+  void* ptr =
+      mmap(nullptr, huge_size, PROT_READ | PROT_WRITE,
+           MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | page_flag, -1, 0);
+  std::scoped_lock lock(huge_page_mutex);
+  if (ptr != MAP_FAILED) {
+    huge_page_mappings.emplace(reinterpret_cast<uintptr_t>(ptr),
+                               HugePageMapping{huge_size, page_size});
+    huge_page_counters.huge_allocs_++;
+    huge_page_counters.huge_bytes_ += huge_size;
+    return ptr;
+  }
+
+  // No free hugetlbfs pages, ask for transparent 2 MiB pages instead
+  const auto thp_size = static_cast<size_t>(HugePageSize::k2M);
+  ptr = std::aligned_alloc(thp_size, (size + thp_size - 1) & ~(thp_size - 1));
+  if (ptr != nullptr) {
+    madvise(ptr, size, MADV_HUGEPAGE);
+    huge_page_counters.thp_allocs_++;
+    huge_page_counters.thp_bytes_ += size;
+  }
+  return ptr;
+}
+
+void BufferFree(void* ptr) {
+  if (ptr == nullptr) {
+    return;
+  }
+  std::unique_lock lock(huge_page_mutex);
+  const auto mapping =
+      huge_page_mappings.find(reinterpret_cast<uintptr_t>(ptr));
+  if (mapping == huge_page_mappings.end()) {
+    lock.unlock();
+    std::free(ptr);
+  } else {
+    munmap(ptr, mapping->second.size_);
+    huge_page_mappings.erase(mapping);
+  }
+}
+
+HugePageCounters GetHugePageCounters() {
+  std::scoped_lock lock(huge_page_mutex);
+  return huge_page_counters;
+}
+
+std::string HugePageSummary() {
+  const HugePageCounters counters = GetHugePageCounters();
+  // Transparent hugepages are only a hint, the kernel reports what it gave
+  std::string anon_huge_pages = "unknown";
+  std::ifstream smaps("/proc/self/smaps_rollup");
+  for (std::string line; std::getline(smaps, line);) {
+    if (line.rfind("AnonHugePages:", 0) == 0) {
+      std::istringstream fields(line);
+      std::string key;
+      size_t kb = 0;
+      fields >> key >> kb;
+      anon_huge_pages = std::to_string(kb >> 10) + " MiB";
+    }
+  }
+
+  std::ostringstream ss;
+  ss << "Hugepages: " << counters.huge_allocs_ << " buffers ("
+     << (counters.huge_bytes_ >> 20) << " MiB) on explicit hugepages, "
+     << counters.thp_allocs_ << " buffers (" << (counters.thp_bytes_ >> 20)
+     << " MiB) on transparent hugepages, " << counters.normal_allocs_
+     << " buffers (" << (counters.normal_bytes_ >> 20)
+     << " MiB) on normal pages, AnonHugePages " << anon_huge_pages;
+  return ss.str();
+}
+
+int BindToNumaNode(void* addr, size_t size, size_t node) {
+  static const auto kPageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+  uintptr_t page_size = kPageSize;
+  {
+    // Ranges inside hugetlbfs mappings move in whole hugepages
+    std::scoped_lock lock(huge_page_mutex);
+    auto mapping =
+        huge_page_mappings.upper_bound(reinterpret_cast<uintptr_t>(addr));
+    if (mapping != huge_page_mappings.begin()) {
+      mapping--;
+      if (reinterpret_cast<uintptr_t>(addr) <
+          mapping->first + mapping->second.size_) {
+        page_size = mapping->second.page_size_;
+      }
+    }
+  }
+  // Partial pages at the edges may hold data of another node's range
+  const uintptr_t start =
+      (reinterpret_cast<uintptr_t>(addr) + page_size - 1) & ~(page_size - 1);
+  const uintptr_t end =
+      (reinterpret_cast<uintptr_t>(addr) + size) & ~(page_size - 1);
+  unsigned long node_mask = 0;
+  if (node >= sizeof(node_mask) * 8) {
+    return -1;
+  } else if (end <= start) {
+    return 0;
+  }
+  node_mask = 1ul << node;
+  return static_cast<int>(mbind(reinterpret_cast<void*>(start), end - start,
+                                MPOL_BIND, &node_mask, sizeof(node_mask) * 8,
+                                MPOL_MF_MOVE));
+}
+};  // namespace Agora_memory
@@ -10,9 +10,13 @@
 #include <cassert>
 #include <complex>
 #include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <random>
+#include <string>
+
+#include <xmmintrin.h>
 
 namespace Agora_memory {
 enum class Alignment_t : size_t {
@@ -21,7 +25,62 @@ enum class Alignment_t : size_t {
   kAlign4096 = 4096
 };
 
+enum class HugePageSize : size_t {
+  kNone = 0,
+  k2M = (1ul << 21),
+  k1G = (1ul << 30)
+};
+
+// Buffers at least this large, half a 2 MiB page, are candidates for
+// hugepages
+static constexpr size_t kMinHugePageAllocSize =
+    static_cast<size_t>(HugePageSize::k2M) / 2;
+
+/// Hugepage size for a buffer of [size] bytes when [page_size] pages are
+/// configured. A buffer takes the largest page it fills at least half of,
+/// so rounding up at most doubles it. kNone means normal pages.
+HugePageSize HugePageSizeFor(HugePageSize page_size, size_t size);
+
 void* PaddedAlignedAlloc(Alignment_t alignment, size_t size);
+
+/// Back the following large Table / PtrGrid / PtrCube / 1D buffer
+/// allocations with explicit hugepages of [page_size]. If none are free, the
+/// buffers fall back to transparent hugepages and then to normal pages.
+void SetHugePageSize(HugePageSize page_size);
+
+/// Allocate the storage of a Table / PtrGrid / PtrCube / 1D buffer. Release
+/// it with BufferFree.
+void* BufferAlloc(Alignment_t alignment, size_t size);
+void BufferFree(void* ptr);
+
+// What the buffer allocations got, for comparing TLB behavior of runs
+struct HugePageCounters {
+  size_t huge_allocs_;  // Backed by explicit (hugetlbfs) hugepages
+  size_t huge_bytes_;
+  size_t thp_allocs_;  // Fell back to transparent hugepages
+  size_t thp_bytes_;
+  size_t normal_allocs_;  // Small buffers or hugepages disabled
+  size_t normal_bytes_;
+};
+HugePageCounters GetHugePageCounters();
+
+/// One line summary of the counters and of the transparent hugepages the
+/// kernel actually gave this process
+std::string HugePageSummary();
+
+/// Move the whole pages inside [addr, addr + size) to NUMA node [node] and
+/// keep them there. Returns 0 on success and -1 on failure.
+int BindToNumaNode(void* addr, size_t size, size_t node);
+
+/// Hint every cacheline of [addr, addr + size) into the L1 cache
+static inline void Prefetch(const void* addr, size_t size) {
+  static constexpr uintptr_t kLineSize = 64;
+  const auto end = reinterpret_cast<uintptr_t>(addr) + size;
+  for (auto line = reinterpret_cast<uintptr_t>(addr) & ~(kLineSize - 1);
+       line < end; line += kLineSize) {
+    _mm_prefetch(reinterpret_cast<const char*>(line), _MM_HINT_T0);
+  }
+}
 }  // namespace Agora_memory
 
 template <typename T>
@@ -39,8 +98,8 @@ class Table {
     this->dim1_ = dim1;
     // RtAssert(((dim1 > 0) && (dim2 == 0)), "Table: Malloc one dimension = 0");
     size_t alloc_size = (this->dim1_ * this->dim2_ * sizeof(T));
-    this->data_ = static_cast<T*>(
-        Agora_memory::PaddedAlignedAlloc(alignment, alloc_size));
+    this->data_ =
+        static_cast<T*>(Agora_memory::BufferAlloc(alignment, alloc_size));
   }
   void Calloc(size_t dim1, size_t dim2, Agora_memory::Alignment_t alignment) {
     // RtAssert(((dim1 > 0) && (dim2 == 0)), "Table: Calloc one dimension = 0");
@@ -83,7 +142,7 @@ class Table {
 
   void Free() {
     if (this->data_ != nullptr) {
-      std::free(this->data_);
+      Agora_memory::BufferFree(this->data_);
     }
     this->dim2_ = 0u;
     this->dim1_ = 0u;
@@ -97,8 +156,8 @@ class Table {
     return (this->data_ + (dim1 * this->dim2_));
   }
 
-  size_t Dim1() { return (this->dim1_); }
-  size_t Dim2() { return (this->dim2_); }
+  size_t Dim1() const { return (this->dim1_); }
+  size_t Dim2() const { return (this->dim2_); }
 };
 
 template <typename T, typename U>
@@ -106,7 +165,7 @@ static void AllocBuffer1d(T** buffer, U dim,
                           Agora_memory::Alignment_t alignment, int init_zero) {
   size_t size = dim * sizeof(T);
   // RtAssert(((dim > 0)), "AllocBuffer1d: size = 0");
-  *buffer = static_cast<T*>(Agora_memory::PaddedAlignedAlloc(alignment, size));
+  *buffer = static_cast<T*>(Agora_memory::BufferAlloc(alignment, size));
   if (init_zero) {
     std::memset(static_cast<void*>(*buffer), 0u, size);
   }
@@ -114,74 +173,90 @@ static void AllocBuffer1d(T** buffer, U dim,
 
 template <typename T>
 static void FreeBuffer1d(T** buffer) {
-  std::free(*buffer);
+  Agora_memory::BufferFree(*buffer);
 };
 
-// PtrGrid is a 2D grid of pointers with [ROWS] rows and [COLS] columns. Each
-// entry of the grid is a pointer to an array of [T].
-template <size_t ROWS, size_t COLS, class T>
+// PtrGrid is a dense 2D grid with [n_rows] rows and [n_cols] columns, sized
+// at runtime. Each cell of the grid is an array of [n_entries] T, and
+// grid[row][col] points to the cell. Cells are contiguous in row-major order.
+template <class T>
 class PtrGrid {
  public:
-  PtrGrid() : backing_buf_(nullptr) {}
+  /// One row of the grid, a strided view over [n_cols] cells
+  class Row {
+   public:
+    Row(T* base, size_t n_cols, size_t n_entries)
+        : base_(base), n_cols_(n_cols), n_entries_(n_entries) {}
+    inline T* operator[](size_t col_idx) const {
+      assert(col_idx < n_cols_);
+      return base_ + (col_idx * n_entries_);
+    }
 
-  /// Create a grid of pointers where each grid cell points to an array of
-  /// [n_entries]
-  explicit PtrGrid(size_t num_entries) { this->Alloc(ROWS, COLS, num_entries); }
+   private:
+    T* base_;
+    size_t n_cols_;
+    size_t n_entries_;
+  };
 
-  /// Create a grid of pointers with dimensions [ROWS, COLS], where
-  /// only the grid with dimensions [n_rows, n_cols] has cells pointing to an
-  /// array of [n_entries]. This can use less memory than a fully-allocated
-  /// grid.
+  PtrGrid() = default;
+
+  /// Create a grid with dimensions [n_rows, n_cols], where each grid cell is
+  /// an array of [n_entries]
   PtrGrid(size_t n_rows, size_t n_cols, size_t n_entries) {
-    assert(n_rows <= ROWS && n_cols <= COLS);
     this->Alloc(n_rows, n_cols, n_entries);
   }
 
-  ~PtrGrid() {
-    if (this->backing_buf_ != nullptr) {
-      std::free(this->backing_buf_);
-      this->backing_buf_ = nullptr;
-    }
-  }
+  ~PtrGrid() { this->Free(); }
 
-  /// Allocate [n_entries] entries per pointer cell
+  /// Allocate [n_entries] zeroed entries per cell
   void Alloc(size_t n_rows, size_t n_cols, size_t n_entries) {
-    const size_t alloc_sz = n_rows * n_cols * n_entries * sizeof(T);
-    this->backing_buf_ = static_cast<T*>(Agora_memory::PaddedAlignedAlloc(
-        Agora_memory::Alignment_t::kAlign64, alloc_sz));
-    std::memset(static_cast<void*>(this->backing_buf_), 0, alloc_sz);
-
-    // Fill-in the grid with pointers into backing_buf
-    size_t offset = 0;
-    for (size_t i = 0; i < n_rows; i++) {
-      for (size_t j = 0; j < n_cols; j++) {
-        mat_[i][j] = &this->backing_buf_[offset];
-        offset += n_entries;
-      }
-    }
+    this->Free();
+    this->n_rows_ = n_rows;
+    this->n_cols_ = n_cols;
+    this->n_entries_ = n_entries;
+    this->backing_buf_ = static_cast<T*>(Agora_memory::BufferAlloc(
+        Agora_memory::Alignment_t::kAlign64, this->Bytes()));
+    std::memset(static_cast<void*>(this->backing_buf_), 0, this->Bytes());
   }
 
-  /// Allocate [n_entries] entries per pointer cell.
+  /// Allocate [n_entries] entries per cell.
   /// Each entry is a random float between -1.0 and 1.0.
-  void RandAllocCxFloat(size_t n_entries) {
+  void RandAllocCxFloat(size_t n_rows, size_t n_cols, size_t n_entries) {
     static_assert(sizeof(T) == 2 * sizeof(float), "T must be complex_float");
-    Alloc(ROWS, COLS, n_entries);
+    Alloc(n_rows, n_cols, n_entries);
 
     std::default_random_engine generator;
     std::uniform_real_distribution<float> distribution(-1.0, 1.0);
 
-    for (auto& row : mat_) {
-      for (auto& entry : row) {
-        auto* base = reinterpret_cast<float*>(entry);
-        for (size_t i = 0; i < n_entries * 2; i++) {
-          base[i] = distribution(generator);
-        }
-      }
+    auto* base = reinterpret_cast<float*>(this->backing_buf_);
+    for (size_t i = 0; i < n_rows * n_cols * n_entries * 2; i++) {
+      base[i] = distribution(generator);
+    }
+  }
+
+  void Free() {
+    if (this->backing_buf_ != nullptr) {
+      Agora_memory::BufferFree(this->backing_buf_);
+      this->backing_buf_ = nullptr;
     }
+    this->n_rows_ = 0;
+    this->n_cols_ = 0;
+    this->n_entries_ = 0;
   }
 
-  std::array<T*, COLS>& operator[](size_t row_idx) {
-    return this->mat_[row_idx];
+  inline Row operator[](size_t row_idx) {
+    assert(row_idx < this->n_rows_);
+    const size_t row_size = this->n_cols_ * this->n_entries_;
+    return Row(this->backing_buf_ + (row_idx * row_size), this->n_cols_,
+               this->n_entries_);
+  }
+
+  inline size_t NumRows() const { return this->n_rows_; }
+  inline size_t NumCols() const { return this->n_cols_; }
+  inline size_t NumEntries() const { return this->n_entries_; }
+  /// Size of the backing buffer in bytes
+  inline size_t Bytes() const {
+    return this->n_rows_ * this->n_cols_ * this->n_entries_ * sizeof(T);
   }
 
   // Delete copy constructor and copy assignment
@@ -189,71 +264,87 @@ class PtrGrid {
   PtrGrid& operator=(PtrGrid const&) = delete;
 
  private:
-  std::array<std::array<T*, COLS>, ROWS> mat_;  /// The pointer cells
+  size_t n_rows_{0};
+  size_t n_cols_{0};
+  size_t n_entries_{0};
 
   /// The backing buffer for the per-cell arrays. Having a common buffer
   /// reduces the number of memory allocations.
-  T* backing_buf_;
+  T* backing_buf_{nullptr};
 };
 
-// PtrCube is a 3D cube of pointers. Each entry of the cube is a pointer to an
-// array of [T].
-template <size_t DIM1, size_t DIM2, size_t DIM3, class T>
+// PtrCube is a dense 3D cube with dimensions [dim_1, dim_2, dim_3], sized at
+// runtime. Each cell of the cube is an array of [n_entries] T, and
+// cube[i][j][k] points to the cell.
+template <class T>
 class PtrCube {
  public:
-  PtrCube() : backing_buf_(nullptr) {}
+  /// One [dim_2, dim_3] plane of the cube
+  class Plane {
+   public:
+    Plane(T* base, size_t dim_2, size_t dim_3, size_t n_entries)
+        : base_(base), dim_2_(dim_2), dim_3_(dim_3), n_entries_(n_entries) {}
+    inline typename PtrGrid<T>::Row operator[](size_t idx_2) const {
+      assert(idx_2 < dim_2_);
+      return typename PtrGrid<T>::Row(base_ + (idx_2 * dim_3_ * n_entries_),
+                                      dim_3_, n_entries_);
+    }
 
-  /// Create a cube of pointers with dimensions [DIM1, DIM2, DIM3], where each
-  /// cube cell points to an array of [n_entries]
-  explicit PtrCube(size_t num_entries) {
-    this->Alloc(DIM1, DIM2, DIM3, num_entries);
-  }
+   private:
+    T* base_;
+    size_t dim_2_;
+    size_t dim_3_;
+    size_t n_entries_;
+  };
+
+  PtrCube() = default;
 
-  /// Create a cube of pointers with dimensions [DIM1, DIM2, DIM3], where
-  /// only the cube with dimensions [dim_1, dim_2, dim_3] has cells
-  /// pointing to an array of [n_entries]. This can use less memory than a
-  /// fully-allocated cube.
+  /// Create a cube with dimensions [dim_1, dim_2, dim_3], where each cube
+  /// cell is an array of [n_entries]
   PtrCube(size_t dim_1, size_t dim_2, size_t dim_3, size_t n_entries) {
-    assert(dim_1 <= DIM1 && dim_2 <= DIM2 && dim_3 <= DIM3);
     this->Alloc(dim_1, dim_2, dim_3, n_entries);
   }
 
-  ~PtrCube() {
+  ~PtrCube() { this->Free(); }
+
+  /// Allocate [n_entries] zeroed entries per cell
+  void Alloc(size_t dim_1, size_t dim_2, size_t dim_3, size_t n_entries) {
+    this->Free();
+    this->dim_1_ = dim_1;
+    this->dim_2_ = dim_2;
+    this->dim_3_ = dim_3;
+    this->n_entries_ = n_entries;
+    this->backing_buf_ = static_cast<T*>(Agora_memory::BufferAlloc(
+        Agora_memory::Alignment_t::kAlign64, this->Bytes()));
+    std::memset(static_cast<void*>(this->backing_buf_), 0, this->Bytes());
+  }
+
+  void Free() {
     if (this->backing_buf_ != nullptr) {
-      std::free(this->backing_buf_);
+      Agora_memory::BufferFree(this->backing_buf_);
       this->backing_buf_ = nullptr;
     }
+    this->dim_1_ = 0;
+    this->dim_2_ = 0;
+    this->dim_3_ = 0;
+    this->n_entries_ = 0;
   }
 
-  /// Allocate [n_entries] entries per pointer cell
-  void Alloc(size_t dim_1, size_t dim_2, size_t dim_3, size_t n_entries) {
-    const size_t alloc_sz = dim_1 * dim_2 * dim_3 * n_entries * sizeof(T);
-    this->backing_buf_ = static_cast<T*>(Agora_memory::PaddedAlignedAlloc(
-        Agora_memory::Alignment_t::kAlign64, alloc_sz));
-    std::memset(static_cast<void*>(this->backing_buf_), 0, alloc_sz);
-
-    // Fill-in the grid with pointers into backing_buf
-    for (auto& mat : this->cube_) {
-      for (auto& row : mat) {
-        for (auto& entry : row) {
-          entry = nullptr;
-        }
-      }
-    }
-
-    size_t offset = 0;
-    for (size_t i = 0; i < dim_1; i++) {
-      for (size_t j = 0; j < dim_2; j++) {
-        for (size_t k = 0; k < dim_3; k++) {
-          this->cube_[i][j][k] = &this->backing_buf_[offset];
-          offset += n_entries;
-        }
-      }
-    }
+  inline Plane operator[](size_t idx_1) {
+    assert(idx_1 < this->dim_1_);
+    const size_t plane_size = this->dim_2_ * this->dim_3_ * this->n_entries_;
+    return Plane(this->backing_buf_ + (idx_1 * plane_size), this->dim_2_,
+                 this->dim_3_, this->n_entries_);
   }
 
-  std::array<std::array<T*, DIM3>, DIM2>& operator[](size_t row_idx) {
-    return this->cube_[row_idx];
+  inline size_t Dim1() const { return this->dim_1_; }
+  inline size_t Dim2() const { return this->dim_2_; }
+  inline size_t Dim3() const { return this->dim_3_; }
+  inline size_t NumEntries() const { return this->n_entries_; }
+  /// Size of the backing buffer in bytes
+  inline size_t Bytes() const {
+    return this->dim_1_ * this->dim_2_ * this->dim_3_ * this->n_entries_ *
+           sizeof(T);
   }
 
   // Delete copy constructor and copy assignment
@@ -261,12 +352,14 @@ class PtrCube {
   PtrCube& operator=(PtrCube const&) = delete;
 
  private:
-  /// The pointer cells
-  std::array<std::array<std::array<T*, DIM3>, DIM2>, DIM1> cube_;
+  size_t dim_1_{0};
+  size_t dim_2_{0};
+  size_t dim_3_{0};
+  size_t n_entries_{0};
 
   /// The backing buffer for the per-cell arrays. Having a common buffer
   /// reduces the number of memory allocations.
-  T* backing_buf_;
+  T* backing_buf_{nullptr};
 };
 
 #endif  // MEMORY_MANAGE_H_
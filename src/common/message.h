@@ -5,6 +5,7 @@
 #ifndef MESSAGE_H_
 #define MESSAGE_H_
 
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <cassert>
@@ -13,6 +14,8 @@
 #include <cstring>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "ran_config.h"
 #include "symbols.h"
@@ -22,8 +25,6 @@
 union gen_tag_t {
   static constexpr size_t kInvalidSymbolId = (1ull << 13) - 1;
   static_assert(kMaxSymbols < ((1ull << 13) - 1));
-  static_assert(kMaxUEs < UINT16_MAX);
-  static_assert(kMaxAntennas < UINT16_MAX);
   static_assert(kMaxDataSCs < UINT16_MAX);
 
   enum TagType { kCodeblocks, kUsers, kAntennas, kSubcarriers, kNone };
@@ -326,15 +327,15 @@ static_assert(sizeof(rx_mac_tag_t) == sizeof(size_t));
 class RxCounters {
  public:
   // num_pkt[i] is the total number of packets we've received for frame i
-  std::array<size_t, kFrameWnd> num_pkts_;
+  std::vector<size_t> num_pkts_;
 
   // num_pilot_pkts[i] is the total number of pilot packets we've received
   // for frame i
-  std::array<size_t, kFrameWnd> num_pilot_pkts_;
+  std::vector<size_t> num_pilot_pkts_;
 
   // num_rc_pkts[i] is the total number of reciprocity pilot packets we've
   // received for frame i
-  std::array<size_t, kFrameWnd> num_reciprocity_pkts_;
+  std::vector<size_t> num_reciprocity_pkts_;
 
   // Number of packets we'll receive per frame on the uplink
   size_t num_rx_pkts_per_frame_;
@@ -345,10 +346,11 @@ class RxCounters {
   // Number of reciprocity pilot packets we'll receive per frame
   size_t num_reciprocity_pkts_per_frame_;
 
-  RxCounters() {
-    num_pkts_.fill(0);
-    num_pilot_pkts_.fill(0);
-    num_reciprocity_pkts_.fill(0);
+  /// Zero the counters of a [frame_wnd] frame window
+  void Init(size_t frame_wnd) {
+    num_pkts_.assign(frame_wnd, 0);
+    num_pilot_pkts_.assign(frame_wnd, 0);
+    num_reciprocity_pkts_.assign(frame_wnd, 0);
   }
 };
 
@@ -359,21 +361,34 @@ class RxCounters {
  */
 class FrameCounters {
  public:
-  FrameCounters() : task_count_(), symbol_count_() {}
+  FrameCounters() = default;
 
-  void Init(size_t max_symbol_count, size_t max_task_count = 0) {
+  /**
+   * @param frame_wnd Frames tracked at a time, a power of two
+   * @param num_symbols Symbols per frame, symbol ids are below this
+   */
+  void Init(size_t frame_wnd, size_t num_symbols, size_t max_symbol_count,
+            size_t max_task_count = 0) {
+    if ((frame_wnd == 0) || ((frame_wnd & (frame_wnd - 1)) != 0)) {
+      throw std::runtime_error("Frame window must be a power of two");
+    }
+    this->frame_wnd_mask_ = frame_wnd - 1;
+    this->num_symbols_ = num_symbols;
     this->max_symbol_count_ = max_symbol_count;
     this->max_task_count_ = max_task_count;
-    this->symbol_count_.fill(0);
-    for (auto &frame : task_count_) {
-      frame.fill(0);
-    }
+    this->symbol_count_.assign(frame_wnd, 0);
+    this->task_count_.assign(frame_wnd * num_symbols, 0);
   }
 
   void Reset(size_t frame_id) {
-    const size_t frame_slot = (frame_id % kFrameWnd);
+    // Counters of a direction without symbols are never initialized
+    if (this->symbol_count_.empty()) {
+      return;
+    }
+    const size_t frame_slot = (frame_id & this->frame_wnd_mask_);
     this->symbol_count_.at(frame_slot) = 0;
-    this->task_count_.at(frame_slot).fill(0);
+    std::fill_n(this->task_count_.begin() + (frame_slot * this->num_symbols_),
+                this->num_symbols_, 0);
   }
 
   /**
@@ -381,7 +396,7 @@ class FrameCounters {
    * @param frame_id The frame id of the symbol to increment
    */
   bool CompleteSymbol(size_t frame_id) {
-    const size_t frame_slot = (frame_id % kFrameWnd);
+    const size_t frame_slot = (frame_id & this->frame_wnd_mask_);
     this->symbol_count_.at(frame_slot)++;
     return this->IsLastSymbol(frame_slot);
   }
@@ -392,8 +407,7 @@ class FrameCounters {
    * @param symbol_id The symbol id of the task to increment
    */
   bool CompleteTask(size_t frame_id, size_t symbol_id) {
-    const size_t frame_slot = (frame_id % kFrameWnd);
-    this->task_count_.at(frame_slot).at(symbol_id)++;
+    this->TaskCount(frame_id, symbol_id)++;
     return this->IsLastTask(frame_id, symbol_id);
   }
 
@@ -408,7 +422,7 @@ class FrameCounters {
    * @param frame id The frame id of the symbol to check
    */
   bool IsLastSymbol(size_t frame_id) const {
-    const size_t frame_slot = (frame_id % kFrameWnd);
+    const size_t frame_slot = (frame_id & this->frame_wnd_mask_);
     const size_t symbol_count = symbol_count_.at(frame_slot);
     bool is_last;
     if (symbol_count == max_symbol_count_) {
@@ -442,8 +456,7 @@ class FrameCounters {
    * @param symbol_id The symbol id to check
    */
   bool IsLastTask(size_t frame_id, size_t symbol_id) const {
-    const size_t frame_slot = frame_id % kFrameWnd;
-    const size_t task_count = this->task_count_.at(frame_slot).at(symbol_id);
+    const size_t task_count = this->GetTaskCount(frame_id, symbol_id);
     bool is_last;
     if (task_count == this->max_task_count_) {
       is_last = true;
@@ -463,7 +476,7 @@ class FrameCounters {
   }
 
   size_t GetSymbolCount(size_t frame_id) const {
-    return this->symbol_count_.at(frame_id % kFrameWnd);
+    return this->symbol_count_.at(frame_id & this->frame_wnd_mask_);
   }
 
   size_t GetTaskCount(size_t frame_id) const {
@@ -471,19 +484,29 @@ class FrameCounters {
   }
 
   size_t GetTaskCount(size_t frame_id, size_t symbol_id) const {
-    return this->task_count_.at(frame_id % kFrameWnd).at(symbol_id);
+    assert(symbol_id < this->num_symbols_);
+    return this->task_count_.at(
+        ((frame_id & this->frame_wnd_mask_) * this->num_symbols_) + symbol_id);
   }
 
   inline size_t MaxSymbolCount() const { return this->max_symbol_count_; }
   inline size_t MaxTaskCount() const { return this->max_task_count_; }
 
  private:
-  // task_count[i][j] is the number of tasks completed for
-  // frame (i % kFrameWnd) and symbol j
-  std::array<std::array<size_t, kMaxSymbols>, kFrameWnd> task_count_;
-  // symbol_count[i] is the number of symbols completed for
-  // frame (i % kFrameWnd)
-  std::array<size_t, kFrameWnd> symbol_count_;
+  size_t &TaskCount(size_t frame_id, size_t symbol_id) {
+    assert(symbol_id < this->num_symbols_);
+    return this->task_count_.at(
+        ((frame_id & this->frame_wnd_mask_) * this->num_symbols_) + symbol_id);
+  }
+
+  // task_count[i * num_symbols + j] is the number of tasks completed for
+  // frame slot i and symbol j
+  std::vector<size_t> task_count_;
+  // symbol_count[i] is the number of symbols completed for frame slot i
+  std::vector<size_t> symbol_count_;
+  // Frame window size minus one, the frame slot mask
+  size_t frame_wnd_mask_{0};
+  size_t num_symbols_{0};
 
   // Maximum number of symbols in a frame
   size_t max_symbol_count_{0};
@@ -491,4 +514,215 @@ class FrameCounters {
   size_t max_task_count_{0};
 };
 
+/**
+ * @brief This class tracks, per frame and symbol, how many of the subcarrier
+ * blocks read by each codeblock are complete. An uplink codeblock can then be
+ * decoded as soon as its LLRs are demodulated instead of after the whole
+ * symbol.
+ */
+class CodeblockCounters {
+ public:
+  /**
+   * @param frame_wnd Frames tracked at a time, a power of two
+   * @param num_symbols Symbols per frame, symbol ids are below this
+   * @param num_sc_blocks Number of subcarrier blocks (tasks) per symbol
+   * @param sc_block_size Number of subcarriers per block
+   * @param cb_sc_ranges The [first, last) subcarriers read by each codeblock
+   */
+  void Init(size_t frame_wnd, size_t num_symbols, size_t num_sc_blocks,
+            size_t sc_block_size,
+            const std::vector<std::pair<size_t, size_t>> &cb_sc_ranges) {
+    this->frame_wnd_mask_ = frame_wnd - 1;
+    this->num_symbols_ = num_symbols;
+    this->num_cbs_ = cb_sc_ranges.size();
+    this->sc_block_size_ = sc_block_size;
+    this->cb_num_blocks_.resize(this->num_cbs_);
+    this->block_cbs_.assign(num_sc_blocks, std::vector<size_t>());
+    for (size_t cb_id = 0; cb_id < this->num_cbs_; cb_id++) {
+      const size_t first_block = cb_sc_ranges.at(cb_id).first / sc_block_size;
+      const size_t last_block =
+          std::min((cb_sc_ranges.at(cb_id).second - 1) / sc_block_size,
+                   num_sc_blocks - 1);
+      this->cb_num_blocks_.at(cb_id) = last_block - first_block + 1;
+      for (size_t block = first_block; block <= last_block; block++) {
+        this->block_cbs_.at(block).push_back(cb_id);
+      }
+    }
+    // The last codeblock also waits for the blocks no codeblock reads, so
+    // a frame's demul tasks are all done once its last decode is scheduled
+    for (auto &cbs : this->block_cbs_) {
+      if (cbs.empty() && (this->num_cbs_ > 0)) {
+        cbs.push_back(this->num_cbs_ - 1);
+        this->cb_num_blocks_.at(this->num_cbs_ - 1)++;
+      }
+    }
+    this->block_count_.assign(frame_wnd * num_symbols * this->num_cbs_, 0);
+  }
+
+  /**
+   * @brief Marks the subcarrier block starting at base_sc_id complete
+   * @param ready_cbs Appended with the codeblocks whose subcarriers are now
+   * all complete. Their counts restart at zero for the next frame.
+   */
+  void CompleteScBlock(size_t frame_id, size_t symbol_id, size_t base_sc_id,
+                       std::vector<size_t> &ready_cbs) {
+    const size_t slot =
+        ((frame_id & this->frame_wnd_mask_) * this->num_symbols_) + symbol_id;
+    size_t *counts = &this->block_count_.at(slot * this->num_cbs_);
+    for (const size_t cb_id :
+         this->block_cbs_.at(base_sc_id / this->sc_block_size_)) {
+      counts[cb_id]++;
+      if (counts[cb_id] == this->cb_num_blocks_.at(cb_id)) {
+        counts[cb_id] = 0;
+        ready_cbs.push_back(cb_id);
+      }
+    }
+  }
+
+ private:
+  // Frame window size minus one, the frame slot mask
+  size_t frame_wnd_mask_{0};
+  size_t num_symbols_{0};
+  size_t num_cbs_{0};
+  size_t sc_block_size_{1};
+  // Number of subcarrier blocks each codeblock reads
+  std::vector<size_t> cb_num_blocks_;
+  // Codeblocks reading each subcarrier block
+  std::vector<std::vector<size_t>> block_cbs_;
+  // Completed blocks per frame slot, symbol and codeblock
+  std::vector<size_t> block_count_;
+};
+
+/**
+ * @brief The downlink counterpart of CodeblockCounters. This class tracks,
+ * per frame and symbol, how many of the codeblocks read by each subcarrier
+ * block are encoded for all UEs, so a subcarrier block can be precoded
+ * without waiting for the whole symbol.
+ */
+class ScBlockCounters {
+ public:
+  /**
+   * @param frame_wnd Frames tracked at a time, a power of two
+   * @param num_symbols Symbols per frame, symbol ids are below this
+   * @param block_cbs The codeblocks (per UE) read by each subcarrier block
+   * @param num_cbs Number of codeblocks per UE and symbol
+   * @param num_ues Number of UEs encoding each codeblock
+   */
+  void Init(size_t frame_wnd, size_t num_symbols,
+            const std::vector<std::vector<size_t>> &block_cbs, size_t num_cbs,
+            size_t num_ues) {
+    this->frame_wnd_mask_ = frame_wnd - 1;
+    this->num_symbols_ = num_symbols;
+    this->num_blocks_ = block_cbs.size();
+    this->num_cbs_ = num_cbs;
+    this->num_ues_ = num_ues;
+    this->block_num_cbs_.resize(this->num_blocks_);
+    this->cb_blocks_.assign(num_cbs, std::vector<size_t>());
+    for (size_t block = 0; block < this->num_blocks_; block++) {
+      this->block_num_cbs_.at(block) = block_cbs.at(block).size();
+      for (const size_t cb_id : block_cbs.at(block)) {
+        this->cb_blocks_.at(cb_id).push_back(block);
+      }
+    }
+    const size_t num_slots = frame_wnd * num_symbols;
+    this->ue_count_.assign(num_slots * this->num_cbs_, 0);
+    this->cb_count_.assign(num_slots * this->num_blocks_, 0);
+    this->ready_.assign(num_slots * this->num_blocks_, false);
+  }
+
+  /**
+   * @brief Marks codeblock cb_in_symbol of one UE encoded
+   * @param ready_blocks Appended with the subcarrier blocks whose codeblocks
+   * are now all encoded
+   */
+  void CompleteCodeblock(size_t frame_id, size_t symbol_id,
+                         size_t cb_in_symbol,
+                         std::vector<size_t> &ready_blocks) {
+    const size_t slot =
+        ((frame_id & this->frame_wnd_mask_) * this->num_symbols_) + symbol_id;
+    size_t &ue_count = this->ue_count_.at(slot * this->num_cbs_ + cb_in_symbol);
+    ue_count++;
+    if (ue_count < this->num_ues_) {
+      return;
+    }
+    ue_count = 0;
+    for (const size_t block : this->cb_blocks_.at(cb_in_symbol)) {
+      size_t &cb_count = this->cb_count_.at(slot * this->num_blocks_ + block);
+      cb_count++;
+      if (cb_count == this->block_num_cbs_.at(block)) {
+        cb_count = 0;
+        this->ready_.at(slot * this->num_blocks_ + block) = true;
+        ready_blocks.push_back(block);
+      }
+    }
+  }
+
+  bool IsReady(size_t frame_id, size_t symbol_id, size_t block) const {
+    const size_t slot =
+        ((frame_id & this->frame_wnd_mask_) * this->num_symbols_) + symbol_id;
+    return this->ready_.at(slot * this->num_blocks_ + block);
+  }
+
+  /// Clear the ready flags of a symbol once it has been precoded
+  void Reset(size_t frame_id, size_t symbol_id) {
+    const size_t slot =
+        ((frame_id & this->frame_wnd_mask_) * this->num_symbols_) + symbol_id;
+    std::fill_n(this->ready_.begin() + (slot * this->num_blocks_),
+                this->num_blocks_, false);
+  }
+
+  inline size_t NumBlocks() const { return this->num_blocks_; }
+
+ private:
+  // Frame window size minus one, the frame slot mask
+  size_t frame_wnd_mask_{0};
+  size_t num_symbols_{0};
+  size_t num_blocks_{0};
+  size_t num_cbs_{0};
+  size_t num_ues_{0};
+  // Number of codeblocks each subcarrier block reads
+  std::vector<size_t> block_num_cbs_;
+  // Subcarrier blocks reading each codeblock
+  std::vector<std::vector<size_t>> cb_blocks_;
+  // Encoded UEs per frame slot, symbol and codeblock
+  std::vector<size_t> ue_count_;
+  // Encoded codeblocks per frame slot, symbol and subcarrier block
+  std::vector<size_t> cb_count_;
+  std::vector<bool> ready_;
+};
+
+/**
+ * @brief Marks, per frame slot, the last frame whose stage completed. The
+ * master publishes a frame after its last task, so workers of a later frame
+ * can read that frame's output without racing its writers.
+ */
+class FrameCompletion {
+ public:
+  /// @param frame_wnd Frames tracked at a time, a power of two
+  void Init(size_t frame_wnd) {
+    if ((frame_wnd == 0) || ((frame_wnd & (frame_wnd - 1)) != 0)) {
+      throw std::runtime_error("Frame window must be a power of two");
+    }
+    this->frame_wnd_mask_ = frame_wnd - 1;
+    // Zero is no frame, slots hold frame_id + 1
+    this->done_ = std::vector<std::atomic<size_t>>(frame_wnd);
+  }
+
+  void MarkComplete(size_t frame_id) {
+    this->done_.at(frame_id & this->frame_wnd_mask_)
+        .store(frame_id + 1, std::memory_order_release);
+  }
+
+  /// True once frame_id completed and its slot was not reused
+  bool IsComplete(size_t frame_id) const {
+    return this->done_.empty() == false &&
+           this->done_.at(frame_id & this->frame_wnd_mask_)
+                   .load(std::memory_order_acquire) == frame_id + 1;
+  }
+
+ private:
+  size_t frame_wnd_mask_{0};
+  std::vector<std::atomic<size_t>> done_;
+};
+
 #endif  // MESSAGE_H_
@@ -4,9 +4,16 @@
  */
 #include "phy_stats.h"
 
+#include <immintrin.h>
+
+#include <algorithm>
 #include <cfloat>
 #include <cmath>
+#include <limits>
+#include <vector>
 
+#include "bit_errors.h"
+#include "datatype_conversion.h"
 #include "logger.h"
 
 PhyStats::PhyStats(Config* const cfg, Direction dir)
@@ -36,34 +43,22 @@ PhyStats::PhyStats(Config* const cfg, Direction dir)
     num_rx_symbols_ = cfg->Frame().NumULSyms();
     num_rxdata_symbols_ = cfg->Frame().NumUlDataSyms();
   }
-  const size_t task_buffer_symbol_num = num_rx_symbols_ * kFrameWnd;
-
-  decoded_bits_count_.Calloc(cfg->UeAntNum(), task_buffer_symbol_num,
-                             Agora_memory::Alignment_t::kAlign64);
-  bit_error_count_.Calloc(cfg->UeAntNum(), task_buffer_symbol_num,
-                          Agora_memory::Alignment_t::kAlign64);
-  frame_decoded_bits_.Calloc(cfg->UeAntNum(), kFrameWnd,
-                             Agora_memory::Alignment_t::kAlign64);
-  frame_bit_errors_.Calloc(cfg->UeAntNum(), kFrameWnd,
-                           Agora_memory::Alignment_t::kAlign64);
-
-  decoded_blocks_count_.Calloc(cfg->UeAntNum(), task_buffer_symbol_num,
-                               Agora_memory::Alignment_t::kAlign64);
-  block_error_count_.Calloc(cfg->UeAntNum(), task_buffer_symbol_num,
-                            Agora_memory::Alignment_t::kAlign64);
-  frame_symbol_errors_.Calloc(cfg->UeAntNum(), kFrameWnd,
-                              Agora_memory::Alignment_t::kAlign64);
-  frame_decoded_symbols_.Calloc(cfg->UeAntNum(), kFrameWnd,
-                                Agora_memory::Alignment_t::kAlign64);
-
-  uncoded_bits_count_.Calloc(cfg->UeAntNum(), task_buffer_symbol_num,
-                             Agora_memory::Alignment_t::kAlign64);
-  uncoded_bit_error_count_.Calloc(cfg->UeAntNum(), task_buffer_symbol_num,
-                                  Agora_memory::Alignment_t::kAlign64);
-
-  evm_buffer_.Calloc(kFrameWnd, cfg->UeAntNum(),
-                     Agora_memory::Alignment_t::kAlign64);
-  evm_sc_buffer_.Calloc(kFrameWnd, cfg->UeAntNum() * cfg->OfdmDataNum(),
+  // Base station and UE workers share the tid range
+  num_workers_ = std::max(cfg->WorkerThreadNum(), cfg->UeWorkerThreadNum());
+  worker_errors_.Calloc(
+      num_workers_,
+      Roundup<64 / sizeof(size_t)>(cfg->FrameWnd() * cfg->UeAntNum() *
+                                   kNumErrorCounts),
+      Agora_memory::Alignment_t::kAlign64);
+  frame_errors_.Calloc(cfg->UeAntNum(), kNumErrorCounts,
+                       Agora_memory::Alignment_t::kAlign64);
+  total_errors_.Calloc(cfg->UeAntNum(), kNumErrorCounts,
+                       Agora_memory::Alignment_t::kAlign64);
+  worker_evm_.Calloc(
+      num_workers_,
+      Roundup<64 / sizeof(float)>(cfg->FrameWnd() * cfg->UeAntNum()),
+      Agora_memory::Alignment_t::kAlign64);
+  evm_sc_buffer_.Calloc(cfg->FrameWnd(), cfg->UeAntNum() * cfg->OfdmDataNum(),
                         Agora_memory::Alignment_t::kAlign64);
 
   if (num_rxdata_symbols_ > 0) {
@@ -79,44 +74,57 @@ PhyStats::PhyStats(Config* const cfg, Direction dir)
       gt_cube_.slice(i) = iq_f_mat.st();
     }
   }
-  dl_pilot_snr_.Calloc(kFrameWnd,
+  dl_pilot_snr_.Calloc(cfg->FrameWnd(),
                        cfg->UeAntNum() * cfg->Frame().ClientDlPilotSymbols(),
                        Agora_memory::Alignment_t::kAlign64);
-  dl_pilot_rssi_.Calloc(kFrameWnd,
+  dl_pilot_rssi_.Calloc(cfg->FrameWnd(),
                         cfg->UeAntNum() * cfg->Frame().ClientDlPilotSymbols(),
                         Agora_memory::Alignment_t::kAlign64);
-  dl_pilot_noise_.Calloc(kFrameWnd,
+  dl_pilot_noise_.Calloc(cfg->FrameWnd(),
                          cfg->UeAntNum() * cfg->Frame().ClientDlPilotSymbols(),
                          Agora_memory::Alignment_t::kAlign64);
-  pilot_snr_.Calloc(kFrameWnd, cfg->UeAntNum() * cfg->BsAntNum(),
+  pilot_snr_.Calloc(cfg->FrameWnd(), cfg->UeAntNum() * cfg->BsAntNum(),
                     Agora_memory::Alignment_t::kAlign64);
-  pilot_rssi_.Calloc(kFrameWnd, cfg->UeAntNum() * cfg->BsAntNum(),
+  pilot_rssi_.Calloc(cfg->FrameWnd(), cfg->UeAntNum() * cfg->BsAntNum(),
                      Agora_memory::Alignment_t::kAlign64);
-  pilot_noise_.Calloc(kFrameWnd, cfg->UeAntNum() * cfg->BsAntNum(),
+  pilot_noise_.Calloc(cfg->FrameWnd(), cfg->UeAntNum() * cfg->BsAntNum(),
                       Agora_memory::Alignment_t::kAlign64);
-  calib_pilot_snr_.Calloc(kFrameWnd, 2 * cfg->BsAntNum(),
+  calib_pilot_snr_.Calloc(cfg->FrameWnd(), 2 * cfg->BsAntNum(),
                           Agora_memory::Alignment_t::kAlign64);
-  csi_cond_.Calloc(kFrameWnd, cfg->OfdmDataNum(),
+  csi_cond_.Calloc(cfg->FrameWnd(), cfg->OfdmDataNum(),
                    Agora_memory::Alignment_t::kAlign64);
+  if (cfg->HalfPrecisionStorage()) {
+    half_data_err_.Calloc(cfg->FrameWnd(),
+                          2 * num_rx_symbols_ * cfg->BsAntNum(),
+                          Agora_memory::Alignment_t::kAlign64);
+    half_beam_err_.Calloc(cfg->FrameWnd(), 2 * cfg->OfdmDataNum(),
+                          Agora_memory::Alignment_t::kAlign64);
+  }
+  ifft_clip_count_.Calloc(cfg->WorkerThreadNum(), cfg->FrameWnd(),
+                          Agora_memory::Alignment_t::kAlign64);
+  ifft_peak_.Calloc(cfg->WorkerThreadNum(), cfg->FrameWnd(),
+                    Agora_memory::Alignment_t::kAlign64);
+  decoder_iter_hist_.Calloc(cfg->WorkerThreadNum(),
+                            cfg->LdpcConfig(dir).MaxDecoderIter() + 1,
+                            Agora_memory::Alignment_t::kAlign64);
+  decoder_abandoned_.Calloc(cfg->WorkerThreadNum(), 1,
+                            Agora_memory::Alignment_t::kAlign64);
+  decode_cycles_ = std::vector<std::atomic<size_t>>(cfg->FrameWnd());
+  for (auto& cycles : decode_cycles_) {
+    cycles.store(0);
+  }
+  latest_evm_snr_ = std::vector<std::atomic<float>>(cfg->UeAntNum());
+  for (auto& snr : latest_evm_snr_) {
+    snr.store(std::numeric_limits<float>::infinity());
+  }
 }
 
 PhyStats::~PhyStats() {
-  decoded_bits_count_.Free();
-  bit_error_count_.Free();
-
-  frame_decoded_bits_.Free();
-  frame_bit_errors_.Free();
-
-  decoded_blocks_count_.Free();
-  block_error_count_.Free();
-
-  frame_symbol_errors_.Free();
-  frame_decoded_symbols_.Free();
-
-  uncoded_bits_count_.Free();
-  uncoded_bit_error_count_.Free();
+  worker_errors_.Free();
+  frame_errors_.Free();
+  total_errors_.Free();
 
-  evm_buffer_.Free();
+  worker_evm_.Free();
   evm_sc_buffer_.Free();
   csi_cond_.Free();
 
@@ -127,10 +135,15 @@ PhyStats::~PhyStats() {
   dl_pilot_snr_.Free();
   dl_pilot_rssi_.Free();
   dl_pilot_noise_.Free();
+  half_data_err_.Free();
+  half_beam_err_.Free();
+  ifft_clip_count_.Free();
+  ifft_peak_.Free();
+  decoder_iter_hist_.Free();
+  decoder_abandoned_.Free();
 }
 
 void PhyStats::PrintPhyStats() {
-  const size_t task_buffer_symbol_num = num_rx_symbols_ * kFrameWnd;
   std::string tx_type;
   if (dir_ == Direction::kDownlink) {
     tx_type = "Downlink";
@@ -140,17 +153,15 @@ void PhyStats::PrintPhyStats() {
 
   if (num_rx_symbols_ > 0) {
     for (size_t ue_id = 0; ue_id < this->config_->UeAntNum(); ue_id++) {
-      size_t total_decoded_bits(0);
-      size_t total_bit_errors(0);
-      size_t total_decoded_blocks(0);
-      size_t total_block_errors(0);
-
-      for (size_t i = 0u; i < task_buffer_symbol_num; i++) {
-        total_decoded_bits += decoded_bits_count_[ue_id][i];
-        total_bit_errors += bit_error_count_[ue_id][i];
-        total_decoded_blocks += decoded_blocks_count_[ue_id][i];
-        total_block_errors += block_error_count_[ue_id][i];
-      }
+      const size_t* totals = total_errors_[ue_id];
+      const size_t total_decoded_bits =
+          totals[static_cast<size_t>(ErrorCount::kDecodedBits)];
+      const size_t total_bit_errors =
+          totals[static_cast<size_t>(ErrorCount::kBitErrors)];
+      const size_t total_decoded_blocks =
+          totals[static_cast<size_t>(ErrorCount::kDecodedBlocks)];
+      const size_t total_block_errors =
+          totals[static_cast<size_t>(ErrorCount::kBlockErrors)];
 
       AGORA_LOG_INFO(
           "UE %zu: %s bit errors (BER) %zu/%zu (%f), block errors (BLER) "
@@ -162,32 +173,88 @@ void PhyStats::PrintPhyStats() {
           static_cast<float>(total_block_errors) /
               static_cast<float>(total_decoded_blocks));
     }
+    PrintDecoderIterations();
   }
 }
 
 void PhyStats::PrintEvmStats(size_t frame_id) {
-  arma::fmat evm_buf(evm_buffer_[frame_id % kFrameWnd], config_->UeAntNum(), 1,
-                     false);
+  arma::fmat evm_buf(1, config_->UeAntNum());
+  for (size_t ue_id = 0; ue_id < config_->UeAntNum(); ue_id++) {
+    evm_buf(0, ue_id) = FrameEvm(config_->FrameSlot(frame_id), ue_id);
+  }
   arma::fmat evm_mat =
-      evm_buf.st() / (config_->OfdmDataNum() * num_rxdata_symbols_);
+      evm_buf / (config_->OfdmDataNum() * num_rxdata_symbols_);
 
   [[maybe_unused]] std::stringstream ss;
   ss << "Frame " << frame_id << " Constellation:\n"
      << "  EVM " << (100.0f * evm_mat) << ", SNR "
      << (-10.0f * arma::log10(evm_mat));
+  if (config_->HalfPrecisionStorage()) {
+    ss << "\n  FP16 storage EVM delta "
+       << (100.0f * GetHalfPrecisionEvm(frame_id)) << "%";
+  }
   AGORA_LOG_INFO("%s\n", ss.str().c_str());
 }
 
 float PhyStats::GetEvmSnr(size_t frame_id, size_t ue_id) {
-  float evm = evm_buffer_[frame_id % kFrameWnd][ue_id];
+  float evm = FrameEvm(config_->FrameSlot(frame_id), ue_id);
   evm = evm / config_->OfdmDataNum();
   return (-10.0f * std::log10(evm));
 }
 
+/// Accumulate the error power and signal power of rounding [n_elems] floats
+/// to float16
+static inline void HalfPrecisionError(const float* in_buf, size_t n_elems,
+                                      float& err, float& sig) {
+  static constexpr size_t kChunk = 64;
+  uint16_t half_buf[kChunk];
+  float round_trip[kChunk];
+  for (size_t i = 0; i < n_elems; i += kChunk) {
+    const size_t n = std::min(kChunk, n_elems - i);
+    SimdConvertFloatToHalf(in_buf + i, half_buf, n);
+    SimdConvertHalfToFloat(half_buf, round_trip, n);
+    for (size_t j = 0; j < n; j++) {
+      const float diff = in_buf[i + j] - round_trip[j];
+      err += diff * diff;
+      sig += in_buf[i + j] * in_buf[i + j];
+    }
+  }
+}
+
+/// Sum of the error-to-signal power ratios introduced by float16 storage of
+/// the uplink data and of the uplink beam matrices. To first order these add
+/// directly to the EVM of the equalized symbols.
+float PhyStats::GetHalfPrecisionEvm(size_t frame_id) {
+  const size_t frame_slot = config_->FrameSlot(frame_id);
+  float evm = 0.0f;
+  for (Table<float>* table : {&half_data_err_, &half_beam_err_}) {
+    float err = 0.0f;
+    float sig = 0.0f;
+    for (size_t i = 0; i < table->Dim2(); i += 2) {
+      err += (*table)[frame_slot][i];
+      sig += (*table)[frame_slot][i + 1];
+    }
+    if (sig > 0.0f) {
+      evm += err / sig;
+    }
+  }
+  return evm;
+}
+
 void PhyStats::ClearEvmBuffer(size_t frame_id) {
-  for (size_t i = 0; i < config_->UeAntNum(); i++) {
-    evm_buffer_[frame_id % kFrameWnd][i] = 0.0f;
+  const size_t offset = config_->FrameSlot(frame_id) * config_->UeAntNum();
+  for (size_t tid = 0; tid < num_workers_; tid++) {
+    std::fill_n(&worker_evm_[tid][offset], config_->UeAntNum(), 0.0f);
+  }
+}
+
+float PhyStats::FrameEvm(size_t frame_slot, size_t ue_id) const {
+  const size_t offset = frame_slot * config_->UeAntNum() + ue_id;
+  float evm = 0.0f;
+  for (size_t tid = 0; tid < num_workers_; tid++) {
+    evm += worker_evm_.At(tid)[offset];
   }
+  return evm;
 }
 
 void PhyStats::PrintDlSnrStats(size_t frame_id) {
@@ -199,7 +266,7 @@ void PhyStats::PrintDlSnrStats(size_t frame_id) {
     ss << "UE Antenna " << i << ": [ ";
     for (size_t j = 0; j < dl_pilots_num; j++) {
       float frame_snr =
-          dl_pilot_snr_[frame_id % kFrameWnd][i * dl_pilots_num + j];
+          dl_pilot_snr_[config_->FrameSlot(frame_id)][i * dl_pilots_num + j];
       ss << frame_snr << " ";
     }
     ss << "] ";
@@ -218,7 +285,7 @@ void PhyStats::PrintUlSnrStats(size_t frame_id) {
     float min_snr = FLT_MAX;
     size_t min_snr_id = 0;
     const float* frame_snr =
-        &pilot_snr_[frame_id % kFrameWnd][i * config_->BsAntNum()];
+        &pilot_snr_[config_->FrameSlot(frame_id)][i * config_->BsAntNum()];
     for (size_t j = 0; j < config_->BsAntNum(); j++) {
       const size_t radio_id = j / config_->NumChannels();
       const size_t cell_id = config_->CellId().at(radio_id);
@@ -258,8 +325,8 @@ void PhyStats::PrintCalibSnrStats(size_t frame_id) {
   for (size_t i = 0; i < 2; i++) {
     float max_snr = FLT_MIN;
     float min_snr = FLT_MAX;
-    const float* frame_snr =
-        &calib_pilot_snr_[frame_id % kFrameWnd][i * config_->BsAntNum()];
+    const float* frame_snr = &calib_pilot_snr_[config_->FrameSlot(frame_id)]
+                                              [i * config_->BsAntNum()];
     for (size_t j = 0; j < config_->BsAntNum(); j++) {
       const size_t radio_id = j / config_->NumChannels();
       const size_t cell_id = config_->CellId().at(radio_id);
@@ -299,7 +366,7 @@ void PhyStats::RecordPilotSnr(size_t frame_id) {
     ss_snr << frame_id;
     ss_rssi << frame_id;
     ss_noise << frame_id;
-    const size_t frame_slot = frame_id % kFrameWnd;
+    const size_t frame_slot = config_->FrameSlot(frame_id);
     for (size_t i = 0; i < config_->UeAntNum(); i++) {
       for (size_t j = 0; j < config_->BsAntNum(); j++) {
         const size_t idx_offset = i * config_->BsAntNum() + j;
@@ -322,7 +389,7 @@ void PhyStats::RecordCsiCond(size_t frame_id, size_t num_rec_sc) {
     const size_t sc_offset = sc_step / 2;
     for (size_t sc_rec = 0; sc_rec < num_rec_sc; sc_rec++) {
       const size_t sc_id = sc_rec * sc_step + sc_offset;
-      ss << "," << (csi_cond_[frame_id % kFrameWnd][sc_id]);
+      ss << "," << (csi_cond_[config_->FrameSlot(frame_id)][sc_id]);
     }
     logger_csi_.Write(ss.str());
   }
@@ -337,7 +404,8 @@ void PhyStats::RecordEvm(size_t frame_id, size_t num_rec_sc) {
     const size_t num_frame_data = config_->OfdmDataNum() * num_rxdata_symbols_;
     for (size_t ue_id = 0; ue_id < config_->UeAntNum(); ue_id++) {
       ss_evm << ","
-             << ((evm_buffer_[frame_id % kFrameWnd][ue_id] / num_frame_data) *
+             << ((FrameEvm(config_->FrameSlot(frame_id), ue_id) /
+                  num_frame_data) *
                  100.0f);
     }
     const size_t sc_step = config_->OfdmDataNum() / num_rec_sc;
@@ -347,7 +415,8 @@ void PhyStats::RecordEvm(size_t frame_id, size_t num_rec_sc) {
         const size_t sc_id = sc_rec * sc_step + sc_offset;
         const size_t ue_offset = ue_id * config_->OfdmDataNum();
         ss_evm_sc << ","
-                  << (evm_sc_buffer_[frame_id % kFrameWnd][ue_offset + sc_id] *
+                  << (evm_sc_buffer_[config_->FrameSlot(frame_id)]
+                                    [ue_offset + sc_id] *
                       100.0f);
       }
     }
@@ -357,14 +426,18 @@ void PhyStats::RecordEvm(size_t frame_id, size_t num_rec_sc) {
 }
 
 void PhyStats::RecordEvmSnr(size_t frame_id) {
+  const size_t num_frame_data = config_->OfdmDataNum() * num_rxdata_symbols_;
+  for (size_t i = 0; i < config_->UeAntNum(); i++) {
+    latest_evm_snr_.at(i).store(
+        -10.0f * std::log10(FrameEvm(config_->FrameSlot(frame_id), i) /
+                            num_frame_data),
+        std::memory_order_relaxed);
+  }
   if (kEnableCsvLog) {
     std::stringstream ss;
     ss << frame_id;
-    const size_t num_frame_data = config_->OfdmDataNum() * num_rxdata_symbols_;
     for (size_t i = 0; i < config_->UeAntNum(); i++) {
-      ss << ","
-         << (-10.0f *
-             std::log10(evm_buffer_[frame_id % kFrameWnd][i] / num_frame_data));
+      ss << "," << latest_evm_snr_.at(i).load(std::memory_order_relaxed);
     }
     logger_evm_snr_.Write(ss.str());
   }
@@ -380,7 +453,7 @@ void PhyStats::RecordDlPilotSnr(size_t frame_id) {
       ss_snr << frame_id;
       ss_rssi << frame_id;
       ss_noise << frame_id;
-      const size_t frame_slot = frame_id % kFrameWnd;
+      const size_t frame_slot = config_->FrameSlot(frame_id);
       for (size_t i = 0; i < config_->UeAntNum(); i++) {
         for (size_t j = 0; j < dl_pilots_num; j++) {
           const size_t idx_offset = i * dl_pilots_num + j;
@@ -399,7 +472,8 @@ void PhyStats::RecordDlPilotSnr(size_t frame_id) {
 void PhyStats::RecordDlCsi(size_t frame_id, size_t num_rec_sc,
                            const Table<complex_float>& csi_buffer) {
   if (kEnableCsvLog) {
-    const size_t csi_offset_base = (frame_id % kFrameWnd) * config_->UeAntNum();
+    const size_t csi_offset_base =
+        config_->FrameSlot(frame_id) * config_->UeAntNum();
     std::stringstream ss;
     ss << frame_id;
     for (size_t ue_id = 0; ue_id < config_->UeAntNum(); ue_id++) {
@@ -416,87 +490,247 @@ void PhyStats::RecordDlCsi(size_t frame_id, size_t num_rec_sc,
   }
 }
 
+void PhyStats::MergeErrors(size_t frame_slot, ErrorCount first,
+                           ErrorCount last) {
+  for (size_t ue_id = 0; ue_id < config_->UeAntNum(); ue_id++) {
+    for (auto count = static_cast<size_t>(first);
+         count < static_cast<size_t>(last); count++) {
+      size_t frame_count = 0;
+      for (size_t tid = 0; tid < num_workers_; tid++) {
+        size_t& worker_count = WorkerErrors(tid, frame_slot, ue_id,
+                                            static_cast<ErrorCount>(count));
+        frame_count += worker_count;
+        worker_count = 0;
+      }
+      frame_errors_[ue_id][count] = frame_count;
+      total_errors_[ue_id][count] += frame_count;
+    }
+  }
+}
+
 void PhyStats::RecordBer(size_t frame_id) {
+  MergeErrors(config_->FrameSlot(frame_id), ErrorCount::kDecodedBits,
+              ErrorCount::kDecodedSymbols);
   if (kEnableCsvLog) {
     std::stringstream ss;
     ss << frame_id;
-    const size_t frame_slot = frame_id % kFrameWnd;
     for (size_t i = 0; i < config_->UeAntNum(); i++) {
-      size_t& error_bits = frame_bit_errors_[i][frame_slot];
-      size_t& total_bits = frame_decoded_bits_[i][frame_slot];
+      const size_t error_bits =
+          frame_errors_[i][static_cast<size_t>(ErrorCount::kBitErrors)];
+      const size_t total_bits =
+          frame_errors_[i][static_cast<size_t>(ErrorCount::kDecodedBits)];
       ss << ","
          << (static_cast<float>(error_bits) / static_cast<float>(total_bits));
-      error_bits = 0;
-      total_bits = 0;
     }
     logger_ber_.Write(ss.str());
   }
 }
 
 void PhyStats::RecordSer(size_t frame_id) {
+  MergeErrors(config_->FrameSlot(frame_id), ErrorCount::kDecodedSymbols,
+              ErrorCount::kNum);
   if (kEnableCsvLog) {
     std::stringstream ss;
     ss << frame_id;
-    const size_t frame_slot = frame_id % kFrameWnd;
     for (size_t i = 0; i < config_->UeAntNum(); i++) {
-      size_t& error_symbols = frame_symbol_errors_[i][frame_slot];
-      size_t& total_symbols = frame_decoded_symbols_[i][frame_slot];
+      const size_t error_symbols =
+          frame_errors_[i][static_cast<size_t>(ErrorCount::kSymbolErrors)];
+      const size_t total_symbols =
+          frame_errors_[i][static_cast<size_t>(ErrorCount::kDecodedSymbols)];
       ss << ","
          << (static_cast<float>(error_symbols) /
              static_cast<float>(total_symbols));
-      error_symbols = 0;
-      total_symbols = 0;
     }
     logger_ser_.Write(ss.str());
   }
 }
 
+/// Sum of the power of [num] complex samples
+static inline float SumPower(const complex_float* data, size_t num) {
+  const auto* in = reinterpret_cast<const float*>(data);
+  const size_t num_floats = 2 * num;
+  size_t i = 0;
+  float sum = 0.0f;
+#if defined(__AVX512F__)
+  __m512 acc = _mm512_setzero_ps();
+  for (; i + 16 <= num_floats; i += 16) {
+    const __m512 val = _mm512_loadu_ps(in + i);
+    acc = _mm512_fmadd_ps(val, val, acc);
+  }
+  sum = _mm512_reduce_add_ps(acc);
+#elif defined(__AVX2__) && defined(__FMA__)
+  __m256 acc = _mm256_setzero_ps();
+  for (; i + 8 <= num_floats; i += 8) {
+    const __m256 val = _mm256_loadu_ps(in + i);
+    acc = _mm256_fmadd_ps(val, val, acc);
+  }
+  alignas(32) float lanes[8];
+  _mm256_store_ps(lanes, acc);
+  for (float lane : lanes) {
+    sum += lane;
+  }
+#endif
+  for (; i < num_floats; i++) {
+    sum += in[i] * in[i];
+  }
+  return sum;
+}
+
+/// Mean power of the guard band subcarriers outside [data_start, data_stop)
+static inline float GuardBandPower(const complex_float* fft_data,
+                                   size_t ca_num, size_t data_start,
+                                   size_t data_stop) {
+  return (SumPower(fft_data, data_start) +
+          SumPower(fft_data + data_stop, ca_num - data_stop)) /
+         static_cast<float>(ca_num - (data_stop - data_start));
+}
+
 void PhyStats::UpdateCalibPilotSnr(size_t frame_id, size_t calib_sym_id,
                                    size_t ant_id, complex_float* fft_data) {
-  const arma::cx_fmat fft_mat(reinterpret_cast<arma::cx_float*>(fft_data),
-                              config_->OfdmCaNum(), 1, false);
-  arma::fmat fft_abs_mat = arma::abs(fft_mat);
-  arma::fmat fft_abs_mag = fft_abs_mat % fft_abs_mat;
-  const float rssi = arma::as_scalar(arma::sum(fft_abs_mag));
-  const float noise_per_sc1 = arma::as_scalar(
-      arma::mean(fft_abs_mag.rows(0, config_->OfdmDataStart() - 1)));
-  const float noise_per_sc2 = arma::as_scalar(arma::mean(
-      fft_abs_mag.rows(config_->OfdmDataStop(), config_->OfdmCaNum() - 1)));
+  const size_t data_start = config_->OfdmDataStart();
+  const size_t data_stop = config_->OfdmDataStop();
+  const size_t ca_num = config_->OfdmCaNum();
+  const float rssi = SumPower(fft_data, ca_num);
+  const float noise_per_sc1 = SumPower(fft_data, data_start) / data_start;
+  const float noise_per_sc2 =
+      SumPower(fft_data + data_stop, ca_num - data_stop) /
+      (ca_num - data_stop);
   const float noise =
       config_->OfdmCaNum() * (noise_per_sc1 + noise_per_sc2) / 2;
   const float snr = (rssi - noise) / noise;
-  calib_pilot_snr_[frame_id % kFrameWnd][calib_sym_id * config_->BsAntNum() +
-                                         ant_id] = (10.0f * std::log10(snr));
+  calib_pilot_snr_[config_->FrameSlot(frame_id)]
+                  [calib_sym_id * config_->BsAntNum() + ant_id] =
+                      (10.0f * std::log10(snr));
 }
 
 void PhyStats::UpdatePilotSnr(size_t frame_id, size_t ue_id, size_t ant_id,
                               complex_float* fft_data) {
-  const arma::cx_fvec fft_vec(reinterpret_cast<arma::cx_float*>(fft_data),
-                              config_->OfdmCaNum(), false);
-  arma::fvec fft_abs_vec = arma::abs(fft_vec);
-  arma::fvec fft_abs_mag = fft_abs_vec % fft_abs_vec;
-  const float rssi_per_sc = arma::mean(fft_abs_mag(config_->PilotUeSc(ue_id)));
-  fft_abs_mag.shed_rows(config_->OfdmDataStart(), config_->OfdmDataStop() - 1);
-  const float noise_per_sc = arma::mean(fft_abs_mag);
+  const arma::uvec& pilot_sc = config_->PilotUeSc(ue_id);
+  float pilot_power = 0.0f;
+  for (const auto sc_id : pilot_sc) {
+    pilot_power += (fft_data[sc_id].re * fft_data[sc_id].re) +
+                   (fft_data[sc_id].im * fft_data[sc_id].im);
+  }
+  const float rssi_per_sc = pilot_power / pilot_sc.n_elem;
+  const float noise_per_sc =
+      GuardBandPower(fft_data, config_->OfdmCaNum(), config_->OfdmDataStart(),
+                     config_->OfdmDataStop());
   const float snr = (rssi_per_sc - noise_per_sc) / noise_per_sc;
-  const size_t frame_slot = frame_id % kFrameWnd;
+  const size_t frame_slot = config_->FrameSlot(frame_id);
   const size_t idx_offset = ue_id * config_->BsAntNum() + ant_id;
   pilot_snr_[frame_slot][idx_offset] = 10.0f * std::log10(snr);
   pilot_rssi_[frame_slot][idx_offset] = rssi_per_sc;
   pilot_noise_[frame_slot][idx_offset] = noise_per_sc;
 }
 
+void PhyStats::UpdateHalfPrecisionDataError(size_t frame_id,
+                                            size_t symbol_id, size_t ant_id,
+                                            const complex_float* fft_data) {
+  float err = 0.0f;
+  float sig = 0.0f;
+  HalfPrecisionError(
+      reinterpret_cast<const float*>(&fft_data[config_->OfdmDataStart()]),
+      2 * config_->OfdmDataNum(), err, sig);
+  const size_t idx_offset = 2 * (symbol_id * config_->BsAntNum() + ant_id);
+  half_data_err_[config_->FrameSlot(frame_id)][idx_offset] = err;
+  half_data_err_[config_->FrameSlot(frame_id)][idx_offset + 1] = sig;
+}
+
+void PhyStats::UpdateHalfPrecisionBeamError(size_t frame_id, size_t sc_id,
+                                            const complex_float* beam,
+                                            size_t num_elems) {
+  float err = 0.0f;
+  float sig = 0.0f;
+  HalfPrecisionError(reinterpret_cast<const float*>(beam), 2 * num_elems, err,
+                     sig);
+  half_beam_err_[config_->FrameSlot(frame_id)][2 * sc_id] = err;
+  half_beam_err_[config_->FrameSlot(frame_id)][2 * sc_id + 1] = sig;
+}
+
+void PhyStats::UpdateIfftClipping(size_t tid, size_t frame_id,
+                                  size_t num_clipped, float peak) {
+  const size_t frame_slot = config_->FrameSlot(frame_id);
+  ifft_clip_count_[tid][frame_slot] += num_clipped;
+  ifft_peak_[tid][frame_slot] = std::max(ifft_peak_[tid][frame_slot], peak);
+}
+
+void PhyStats::PrintIfftClipping(size_t frame_id) {
+  const size_t frame_slot = config_->FrameSlot(frame_id);
+  size_t num_clipped = 0;
+  float peak = 0.0f;
+  for (size_t tid = 0; tid < ifft_clip_count_.Dim1(); tid++) {
+    num_clipped += ifft_clip_count_[tid][frame_slot];
+    peak = std::max(peak, ifft_peak_[tid][frame_slot]);
+    ifft_clip_count_[tid][frame_slot] = 0;
+    ifft_peak_[tid][frame_slot] = 0.0f;
+  }
+  if (num_clipped > 0) {
+    AGORA_LOG_WARN(
+        "Clipping occured in Frame %zu: %zu IFFT samples, peak %.3f\n",
+        frame_id, num_clipped, peak);
+  }
+}
+
+float PhyStats::GetLatestEvmSnr(size_t ue_id) const {
+  return latest_evm_snr_.at(ue_id).load(std::memory_order_relaxed);
+}
+
+void PhyStats::UpdateDecoderIterations(size_t tid, size_t frame_id,
+                                       size_t iterations, size_t cycles,
+                                       bool abandoned) {
+  const size_t max_bin = decoder_iter_hist_.Dim2() - 1;
+  decoder_iter_hist_[tid][std::min(iterations, max_bin)]++;
+  if (abandoned) {
+    decoder_abandoned_[tid][0]++;
+  }
+  decode_cycles_.at(config_->FrameSlot(frame_id))
+      .fetch_add(cycles, std::memory_order_relaxed);
+}
+
+size_t PhyStats::GetDecodeCycles(size_t frame_id) const {
+  return decode_cycles_.at(config_->FrameSlot(frame_id))
+      .load(std::memory_order_relaxed);
+}
+
+void PhyStats::ClearDecodeCycles(size_t frame_id) {
+  decode_cycles_.at(config_->FrameSlot(frame_id))
+      .store(0, std::memory_order_relaxed);
+}
+
+void PhyStats::PrintDecoderIterations() {
+  std::vector<size_t> hist(decoder_iter_hist_.Dim2(), 0);
+  size_t num_decoded = 0;
+  size_t num_abandoned = 0;
+  for (size_t tid = 0; tid < decoder_iter_hist_.Dim1(); tid++) {
+    for (size_t i = 0; i < hist.size(); i++) {
+      hist.at(i) += decoder_iter_hist_[tid][i];
+      num_decoded += decoder_iter_hist_[tid][i];
+    }
+    num_abandoned += decoder_abandoned_[tid][0];
+  }
+  if (num_decoded == 0) {
+    return;
+  }
+  [[maybe_unused]] std::stringstream ss;
+  ss << "Decoder iterations per codeblock (iterations:codeblocks)";
+  for (size_t i = 0; i < hist.size(); i++) {
+    if (hist.at(i) > 0) {
+      ss << " " << i << ":" << hist.at(i);
+    }
+  }
+  ss << ", abandoned " << num_abandoned << "/" << num_decoded;
+  AGORA_LOG_INFO("%s\n", ss.str().c_str());
+}
+
 void PhyStats::UpdateDlPilotSnr(size_t frame_id, size_t symbol_id,
                                 size_t ant_id, complex_float* fft_data) {
-  const arma::cx_fvec fft_vec(reinterpret_cast<arma::cx_float*>(fft_data),
-                              config_->OfdmCaNum(), false);
-  arma::fvec fft_abs_vec = arma::abs(fft_vec);
-  arma::fvec fft_abs_mag = fft_abs_vec % fft_abs_vec;
-  const float rssi_per_sc = arma::mean(fft_abs_mag);
-  fft_abs_mag.shed_rows(config_->OfdmDataStart(), config_->OfdmDataStop() - 1);
-  const float noise_per_sc = arma::mean(fft_abs_mag);
+  const float rssi_per_sc =
+      SumPower(fft_data, config_->OfdmCaNum()) / config_->OfdmCaNum();
+  const float noise_per_sc =
+      GuardBandPower(fft_data, config_->OfdmCaNum(), config_->OfdmDataStart(),
+                     config_->OfdmDataStop());
   const float snr = (rssi_per_sc - noise_per_sc) / noise_per_sc;
-  const size_t frame_slot = frame_id % kFrameWnd;
+  const size_t frame_slot = config_->FrameSlot(frame_id);
   const size_t idx_offset =
       ant_id * config_->Frame().ClientDlPilotSymbols() + symbol_id;
   dl_pilot_snr_[frame_slot][idx_offset] = 10.0f * std::log10(snr);
@@ -505,7 +739,7 @@ void PhyStats::UpdateDlPilotSnr(size_t frame_id, size_t symbol_id,
 }
 
 void PhyStats::PrintBeamStats(size_t frame_id) {
-  const size_t frame_slot = frame_id % kFrameWnd;
+  const size_t frame_slot = config_->FrameSlot(frame_id);
   [[maybe_unused]] std::stringstream ss;
   ss << "Frame " << frame_id
      << " Beamweight matrix inverse condition number range: " << std::fixed
@@ -528,80 +762,83 @@ void PhyStats::PrintBeamStats(size_t frame_id) {
 }
 
 void PhyStats::UpdateCsiCond(size_t frame_id, size_t sc_id, float cond) {
-  csi_cond_[frame_id % kFrameWnd][sc_id] = cond;
+  csi_cond_[config_->FrameSlot(frame_id)][sc_id] = cond;
 }
 
-void PhyStats::UpdateEvm(size_t frame_id, size_t data_symbol_id, size_t sc_id,
-                         const arma::cx_fvec& eq_vec) {
-  const arma::fvec evm_vec = arma::square(
-      arma::abs(eq_vec - gt_cube_.slice(data_symbol_id).col(sc_id)));
+void PhyStats::UpdateEvm(size_t tid, size_t frame_id, size_t data_symbol_id,
+                         size_t sc_id, const arma::cx_fvec& eq_vec) {
+  const size_t frame_slot = config_->FrameSlot(frame_id);
+  const arma::cx_float* gt = gt_cube_.slice(data_symbol_id).colptr(sc_id);
+  float* evm_buf = &worker_evm_[tid][frame_slot * config_->UeAntNum()];
   for (size_t ue_id = 0; ue_id < config_->UeAntNum(); ue_id++) {
-    evm_sc_buffer_[frame_id % kFrameWnd]
-                  [ue_id * config_->OfdmDataNum() + sc_id] = evm_vec(ue_id);
+    const float evm = std::norm(eq_vec[ue_id] - gt[ue_id]);
+    evm_sc_buffer_[frame_slot][ue_id * config_->OfdmDataNum() + sc_id] = evm;
+    evm_buf[ue_id] += evm;
   }
-  arma::fvec evm_buf(evm_buffer_[frame_id % kFrameWnd], config_->UeAntNum(),
-                     false);
-  evm_buf += evm_vec;
 }
 
-void PhyStats::UpdateEvm(size_t frame_id, size_t data_symbol_id, size_t sc_id,
-                         size_t tx_ue_id, size_t rx_ue_id, arma::cx_float eq) {
+void PhyStats::UpdateEvm(size_t tid, size_t frame_id, size_t data_symbol_id,
+                         size_t sc_id, size_t tx_ue_id, size_t rx_ue_id,
+                         arma::cx_float eq) {
+  const size_t frame_slot = config_->FrameSlot(frame_id);
   const float evm =
       std::norm(eq - gt_cube_.slice(data_symbol_id)(tx_ue_id, sc_id));
-  evm_buffer_[frame_id % kFrameWnd][rx_ue_id] += evm;
-  evm_sc_buffer_[frame_id % kFrameWnd]
-                [rx_ue_id * config_->OfdmDataNum() + sc_id] = evm;
+  worker_evm_[tid][frame_slot * config_->UeAntNum() + rx_ue_id] += evm;
+  evm_sc_buffer_[frame_slot][rx_ue_id * config_->OfdmDataNum() + sc_id] = evm;
 }
 
-void PhyStats::UpdateBitErrors(size_t ue_id, size_t offset, size_t frame_slot,
+void PhyStats::UpdateBitErrors(size_t tid, size_t ue_id, size_t frame_slot,
                                uint8_t tx_byte, uint8_t rx_byte) {
-  static constexpr size_t kBitsInByte = 8;
-  AGORA_LOG_TRACE("Updating bit errors: User %zu Offset  %zu Tx %d Rx %d\n",
-                  ue_id, offset, tx_byte, rx_byte);
-  uint8_t xor_byte(tx_byte ^ rx_byte);
-  size_t bit_errors = 0;
-  for (size_t j = 0; j < kBitsInByte; j++) {
-    bit_errors += (xor_byte & 1);
-    xor_byte >>= 1;
-  }
-  bit_error_count_[ue_id][offset] += bit_errors;
-  frame_bit_errors_[ue_id][frame_slot] += bit_errors;
+  AGORA_LOG_TRACE("Updating bit errors: User %zu Slot %zu Tx %d Rx %d\n",
+                  ue_id, frame_slot, tx_byte, rx_byte);
+  WorkerErrors(tid, frame_slot, ue_id, ErrorCount::kBitErrors) +=
+      __builtin_popcount(tx_byte ^ rx_byte);
 }
 
-void PhyStats::UpdateDecodedBits(size_t ue_id, size_t offset, size_t frame_slot,
+size_t PhyStats::UpdateBlockBitErrors(size_t tid, size_t ue_id,
+                                      size_t frame_slot,
+                                      const uint8_t* tx_bytes,
+                                      const uint8_t* rx_bytes,
+                                      size_t num_bytes) {
+  size_t byte_errors;
+  WorkerErrors(tid, frame_slot, ue_id, ErrorCount::kBitErrors) +=
+      CountBitErrors(tx_bytes, rx_bytes, num_bytes, byte_errors);
+  UpdateBlockErrors(tid, ue_id, frame_slot, byte_errors);
+  return byte_errors;
+}
+
+void PhyStats::UpdateDecodedBits(size_t tid, size_t ue_id, size_t frame_slot,
                                  size_t new_bits_num) {
-  decoded_bits_count_[ue_id][offset] += new_bits_num;
-  frame_decoded_bits_[ue_id][frame_slot] += new_bits_num;
+  WorkerErrors(tid, frame_slot, ue_id, ErrorCount::kDecodedBits) +=
+      new_bits_num;
 }
 
-void PhyStats::UpdateBlockErrors(size_t ue_id, size_t offset, size_t frame_slot,
+void PhyStats::UpdateBlockErrors(size_t tid, size_t ue_id, size_t frame_slot,
                                  size_t block_error_count) {
-  block_error_count_[ue_id][offset] +=
-      static_cast<unsigned long>(block_error_count > 0);
-  frame_symbol_errors_[ue_id][frame_slot] += block_error_count;
+  WorkerErrors(tid, frame_slot, ue_id, ErrorCount::kBlockErrors) +=
+      static_cast<size_t>(block_error_count > 0);
+  WorkerErrors(tid, frame_slot, ue_id, ErrorCount::kSymbolErrors) +=
+      block_error_count;
 }
 
-void PhyStats::IncrementDecodedBlocks(size_t ue_id, size_t offset,
+void PhyStats::IncrementDecodedBlocks(size_t tid, size_t ue_id,
                                       size_t frame_slot) {
-  decoded_blocks_count_[ue_id][offset]++;
-  frame_decoded_symbols_[ue_id][frame_slot] += config_->GetOFDMDataNum();
+  WorkerErrors(tid, frame_slot, ue_id, ErrorCount::kDecodedBlocks)++;
+  WorkerErrors(tid, frame_slot, ue_id, ErrorCount::kDecodedSymbols) +=
+      config_->GetOFDMDataNum();
 }
 
-void PhyStats::UpdateUncodedBitErrors(size_t ue_id, size_t offset,
-                                      size_t mod_bit_size, uint8_t tx_byte,
-                                      uint8_t rx_byte) {
-  uint8_t xor_byte(tx_byte ^ rx_byte);
-  size_t bit_errors = 0;
-  for (size_t j = 0; j < mod_bit_size; j++) {
-    bit_errors += xor_byte & 1;
-    xor_byte >>= 1;
-  }
-  uncoded_bit_error_count_[ue_id][offset] += bit_errors;
+void PhyStats::UpdateUncodedBitErrors(size_t tid, size_t ue_id,
+                                      size_t frame_slot, size_t mod_bit_size,
+                                      uint8_t tx_byte, uint8_t rx_byte) {
+  const unsigned bit_mask = (1u << mod_bit_size) - 1;
+  WorkerErrors(tid, frame_slot, ue_id, ErrorCount::kBitErrors) +=
+      __builtin_popcount((tx_byte ^ rx_byte) & bit_mask);
 }
 
-void PhyStats::UpdateUncodedBits(size_t ue_id, size_t offset,
+void PhyStats::UpdateUncodedBits(size_t tid, size_t ue_id, size_t frame_slot,
                                  size_t new_bits_num) {
-  uncoded_bits_count_[ue_id][offset] += new_bits_num;
+  UpdateDecodedBits(tid, ue_id, frame_slot, new_bits_num);
 }
 
 void PhyStats::UpdateUlCsi(size_t frame_id, size_t sc_id,
@@ -630,7 +867,7 @@ void PhyStats::UpdateCalibMat(size_t frame_id, size_t sc_id,
 }
 
 float PhyStats::GetNoise(size_t frame_id) {
-  arma::fvec noise_vec(pilot_noise_[frame_id % kFrameWnd],
+  arma::fvec noise_vec(pilot_noise_[config_->FrameSlot(frame_id)],
                        config_->BsAntNum() * config_->UeAntNum(), false);
 
   return (arma::mean(noise_vec));
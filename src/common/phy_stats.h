@@ -5,6 +5,10 @@
 #ifndef PHY_STATS_H_
 #define PHY_STATS_H_
 
+#include <array>
+#include <atomic>
+#include <vector>
+
 #include "armadillo"
 #include "common_typedef_sdk.h"
 #include "config.h"
@@ -17,22 +21,39 @@ class PhyStats {
   explicit PhyStats(Config* const cfg, Direction dir);
   ~PhyStats();
   void PrintPhyStats();
-  void UpdateBitErrors(size_t ue_id, size_t offset, size_t frame_slot,
+  // The error and EVM updates are called by worker [tid] and only touch its
+  // own accumulators. The master merges them in RecordBer, RecordSer and
+  // the EVM readers.
+  void UpdateBitErrors(size_t tid, size_t ue_id, size_t frame_slot,
                        uint8_t tx_byte, uint8_t rx_byte);
-  void UpdateDecodedBits(size_t ue_id, size_t offset, size_t frame_slot,
+  void UpdateDecodedBits(size_t tid, size_t ue_id, size_t frame_slot,
                          size_t new_bits_num);
-  void UpdateBlockErrors(size_t ue_id, size_t offset, size_t frame_slot,
+  void UpdateBlockErrors(size_t tid, size_t ue_id, size_t frame_slot,
                          size_t block_error_count);
-  void IncrementDecodedBlocks(size_t ue_id, size_t offset, size_t frame_slot);
+  /// Bit and block errors of a whole received block of [num_bytes] bytes
+  /// against [tx_bytes], in place of UpdateBitErrors per byte and
+  /// UpdateBlockErrors. Returns the number of differing bytes.
+  size_t UpdateBlockBitErrors(size_t tid, size_t ue_id, size_t frame_slot,
+                              const uint8_t* tx_bytes, const uint8_t* rx_bytes,
+                              size_t num_bytes);
+  void IncrementDecodedBlocks(size_t tid, size_t ue_id, size_t frame_slot);
+  /// Bit errors of one hard demodulated symbol, in its low [mod_bit_size]
+  /// bits. Counted with the decoded bit errors of [frame_slot].
+  void UpdateUncodedBitErrors(size_t tid, size_t ue_id, size_t frame_slot,
+                              size_t mod_bit_size, uint8_t tx_byte,
+                              uint8_t rx_byte);
+  void UpdateUncodedBits(size_t tid, size_t ue_id, size_t frame_slot,
+                         size_t new_bits_num);
+  /// Called by the master thread once a frame is decoded (or hard
+  /// demodulated): merges the workers' bit and block error counts
   void RecordBer(size_t frame_id);
+  /// Same as RecordBer for the symbol error counts, after RecordBer
   void RecordSer(size_t frame_id);
-  void UpdateUncodedBitErrors(size_t ue_id, size_t offset, size_t mod_bit_size,
-                              uint8_t tx_byte, uint8_t rx_byte);
-  void UpdateUncodedBits(size_t ue_id, size_t offset, size_t new_bits_num);
-  void UpdateEvm(size_t frame_id, size_t data_symbol_id, size_t sc_id,
-                 const arma::cx_fvec& eq_vec);
-  void UpdateEvm(size_t frame_id, size_t data_symbol_id, size_t sc_id,
-                 size_t tx_ue_id, size_t rx_ue_id, arma::cx_float eq);
+  void UpdateEvm(size_t tid, size_t frame_id, size_t data_symbol_id,
+                 size_t sc_id, const arma::cx_fvec& eq_vec);
+  void UpdateEvm(size_t tid, size_t frame_id, size_t data_symbol_id,
+                 size_t sc_id, size_t tx_ue_id, size_t rx_ue_id,
+                 arma::cx_float eq);
   void PrintEvmStats(size_t frame_id);
   void RecordCsiCond(size_t frame_id, size_t num_rec_sc);
   void RecordEvm(size_t frame_id, size_t num_rec_sc);
@@ -61,21 +82,67 @@ class PhyStats {
   void UpdateDlBeam(size_t frame_id, size_t sc_id, const arma::cx_fmat& mat_in);
   void UpdateCalibMat(size_t frame_id, size_t sc_id,
                       const arma::cx_fvec& vec_in);
+  void UpdateHalfPrecisionDataError(size_t frame_id, size_t symbol_id,
+                                    size_t ant_id,
+                                    const complex_float* fft_data);
+  void UpdateHalfPrecisionBeamError(size_t frame_id, size_t sc_id,
+                                    const complex_float* beam,
+                                    size_t num_elems);
+  float GetHalfPrecisionEvm(size_t frame_id);
+  /// Called by worker [tid] after each IFFT task, only touches its own row
+  void UpdateIfftClipping(size_t tid, size_t frame_id, size_t num_clipped,
+                          float peak);
+  /// Called by the master thread once all IFFTs of a frame are done
+  void PrintIfftClipping(size_t frame_id);
+  /// Post-equalization SNR (dB) of [ue_id] in the last frame whose
+  /// demodulation completed, +inf before the first one
+  float GetLatestEvmSnr(size_t ue_id) const;
+  /// Called by worker [tid] after each decode: counts the iterations the
+  /// codeblock used and adds [cycles] to the decoder time of the frame
+  void UpdateDecoderIterations(size_t tid, size_t frame_id, size_t iterations,
+                               size_t cycles, bool abandoned);
+  size_t GetDecodeCycles(size_t frame_id) const;
+  /// Called by the master thread once all codeblocks of a frame are decoded
+  void ClearDecodeCycles(size_t frame_id);
+  void PrintDecoderIterations();
 
  private:
+  // Error counts accumulated per frame slot and UE
+  enum class ErrorCount : size_t {
+    kDecodedBits,
+    kBitErrors,
+    kDecodedBlocks,
+    kBlockErrors,
+    kDecodedSymbols,
+    kSymbolErrors,
+    kNum
+  };
+  static constexpr size_t kNumErrorCounts =
+      static_cast<size_t>(ErrorCount::kNum);
+
+  inline size_t& WorkerErrors(size_t tid, size_t frame_slot, size_t ue_id,
+                              ErrorCount count) {
+    return worker_errors_[tid][(frame_slot * config_->UeAntNum() + ue_id) *
+                                   kNumErrorCounts +
+                               static_cast<size_t>(count)];
+  }
+  /// Sum the workers' counts in [first, last) of [frame_slot] into
+  /// frame_errors_ and total_errors_, and clear them for the next frame
+  void MergeErrors(size_t frame_slot, ErrorCount first, ErrorCount last);
+  /// Sum of the workers' EVM accumulators of [ue_id] in [frame_slot]
+  float FrameEvm(size_t frame_slot, size_t ue_id) const;
+
   Config const* const config_;
   Direction dir_;
-  Table<size_t> decoded_bits_count_;
-  Table<size_t> bit_error_count_;
-  Table<size_t> frame_decoded_bits_;
-  Table<size_t> frame_bit_errors_;
-  Table<size_t> decoded_blocks_count_;
-  Table<size_t> block_error_count_;
-  Table<size_t> frame_symbol_errors_;
-  Table<size_t> frame_decoded_symbols_;
-  Table<size_t> uncoded_bits_count_;
-  Table<size_t> uncoded_bit_error_count_;
-  Table<float> evm_buffer_;
+  size_t num_workers_;
+  // Per worker, (frame slot, UE, ErrorCount) counts, each row padded to
+  // whole cache lines
+  Table<size_t> worker_errors_;
+  // Merged counts of the last frame and of the whole run, (UE, ErrorCount)
+  Table<size_t> frame_errors_;
+  Table<size_t> total_errors_;
+  // Per worker, (frame slot, UE) sums of the squared EVM
+  Table<float> worker_evm_;
   Table<float> evm_sc_buffer_;
   Table<float> pilot_snr_;
   Table<float> pilot_rssi_;
@@ -86,6 +153,21 @@ class PhyStats {
   Table<float> calib_pilot_snr_;
   Table<float> csi_cond_;
   Table<float> calib_;
+  // (error power, signal power) pairs of the float16 rounding of stored data
+  // per (symbol, antenna) and of beam matrices per subcarrier
+  Table<float> half_data_err_;
+  Table<float> half_beam_err_;
+  // Clipped IFFT output samples and peak magnitude per worker and frame
+  Table<size_t> ifft_clip_count_;
+  Table<float> ifft_peak_;
+  // Codeblocks per decoder iteration count, and abandoned codeblocks, per
+  // worker
+  Table<size_t> decoder_iter_hist_;
+  Table<size_t> decoder_abandoned_;
+  // Decoder cycles spent per frame, shared by all workers
+  std::vector<std::atomic<size_t>> decode_cycles_;
+  // Latest post-equalization SNR per UE
+  std::vector<std::atomic<float>> latest_evm_snr_;
 
   arma::cx_fcube gt_cube_;
   size_t num_rx_symbols_;
@@ -0,0 +1,70 @@
+/**
+ * @file precode_ifft.h
+ * @brief Kernels of the fused downlink precode + IFFT task. Precoded samples
+ * of a block of antennas are written antenna-major straight into FFT-shifted
+ * IFFT input rows, so the IFFT runs while they are still cache resident.
+ */
+#ifndef PRECODE_IFFT_H_
+#define PRECODE_IFFT_H_
+
+#include <immintrin.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "common_typedef_sdk.h"
+
+/// Position of subcarrier [sc_id] in an IFFT input of [fft_size] samples
+/// after the FFT shift (swap of the two halves)
+static inline size_t PrecodeIfftShiftedIndex(size_t sc_id, size_t fft_size) {
+  const size_t half = fft_size / 2;
+  return (sc_id < half) ? (sc_id + half) : (sc_id - half);
+}
+
+/// Precode one subcarrier for [ant_num] consecutive antennas:
+/// out[a * out_stride] = sum_u beam[u * bs_ant_num + a] * data[u]
+/// [beam] points to the first antenna of the block in the column-major
+/// bs_ant_num x ue_num precoder of the subcarrier.
+static inline void PrecodeAntennaBlock(const complex_float* beam,
+                                       const complex_float* data,
+                                       size_t bs_ant_num, size_t ue_num,
+                                       size_t ant_num, complex_float* out,
+                                       size_t out_stride) {
+  size_t ant = 0;
+#if defined(__AVX512F__)
+  // One complex float is scattered as one 64-bit lane
+  const auto stride = static_cast<int64_t>(out_stride);
+  const __m512i ant_index =
+      _mm512_set_epi64(7 * stride, 6 * stride, 5 * stride, 4 * stride,
+                       3 * stride, 2 * stride, stride, 0);
+  const __m512 ones = _mm512_set1_ps(1.0f);
+  for (; ant + 8 <= ant_num; ant += 8) {
+    // w * x.re and swap(w) * x.im, combined as a complex product at the end
+    __m512 acc_re = _mm512_setzero_ps();
+    __m512 acc_im = _mm512_setzero_ps();
+    for (size_t ue = 0; ue < ue_num; ue++) {
+      const __m512 w = _mm512_loadu_ps(
+          reinterpret_cast<const float*>(beam + (ue * bs_ant_num) + ant));
+      acc_re = _mm512_fmadd_ps(w, _mm512_set1_ps(data[ue].re), acc_re);
+      acc_im = _mm512_fmadd_ps(_mm512_permute_ps(w, 0xB1),
+                               _mm512_set1_ps(data[ue].im), acc_im);
+    }
+    _mm512_i64scatter_pd(reinterpret_cast<double*>(out + (ant * out_stride)),
+                         ant_index,
+                         _mm512_castps_pd(_mm512_fmaddsub_ps(acc_re, ones,
+                                                             acc_im)),
+                         8);
+  }
+#endif
+  for (; ant < ant_num; ant++) {
+    complex_float sum = {0, 0};
+    for (size_t ue = 0; ue < ue_num; ue++) {
+      const complex_float w = beam[(ue * bs_ant_num) + ant];
+      sum.re += (w.re * data[ue].re) - (w.im * data[ue].im);
+      sum.im += (w.re * data[ue].im) + (w.im * data[ue].re);
+    }
+    out[ant * out_stride] = sum;
+  }
+}
+
+#endif  // PRECODE_IFFT_H_
@@ -0,0 +1,91 @@
+/**
+ * @file recip_calib.h
+ * @brief SIMD kernels of the per-frame reciprocity calibration stage. The
+ * DoFFT workers write the calibration pilots antenna-major (all subcarriers
+ * of one antenna are contiguous), beamweights read one vector of all
+ * antennas per subcarrier.
+ */
+#ifndef RECIP_CALIB_H_
+#define RECIP_CALIB_H_
+
+#include <immintrin.h>
+
+#include <cstddef>
+
+#include "common_typedef_sdk.h"
+
+/// msum[i] = prev_msum[i] + (cur[i] - old[i]) for [n_cx] complex values.
+/// [msum] may alias [prev_msum].
+static inline void RecipCalibMovingSum(const complex_float* prev_msum,
+                                       const complex_float* cur,
+                                       const complex_float* old,
+                                       complex_float* msum, size_t n_cx) {
+  const auto* prev_f = reinterpret_cast<const float*>(prev_msum);
+  const auto* cur_f = reinterpret_cast<const float*>(cur);
+  const auto* old_f = reinterpret_cast<const float*>(old);
+  auto* msum_f = reinterpret_cast<float*>(msum);
+  const size_t n_floats = 2 * n_cx;
+  size_t i = 0;
+#if defined(__AVX512F__)
+  for (; i + 16 <= n_floats; i += 16) {
+    const __m512 diff = _mm512_sub_ps(_mm512_loadu_ps(cur_f + i),
+                                      _mm512_loadu_ps(old_f + i));
+    _mm512_storeu_ps(msum_f + i,
+                     _mm512_add_ps(_mm512_loadu_ps(prev_f + i), diff));
+  }
+#endif
+  for (; i < n_floats; i++) {
+    msum_f[i] = prev_f[i] + (cur_f[i] - old_f[i]);
+  }
+}
+
+/// Element-wise ratio ul / dl of two antenna-major buffers of [ant_num] rows
+/// of [sc_num] subcarriers, written subcarrier-major:
+/// calib[sc * ant_num + ant] = ul[ant * sc_num + sc] / dl[ant * sc_num + sc]
+static inline void RecipCalibDivideTranspose(const complex_float* ul,
+                                             const complex_float* dl,
+                                             complex_float* calib,
+                                             size_t sc_num, size_t ant_num) {
+#if defined(__AVX512F__)
+  // One complex float is scattered as one 64-bit lane
+  const auto stride = static_cast<int64_t>(ant_num);
+  const __m512i sc_index =
+      _mm512_set_epi64(7 * stride, 6 * stride, 5 * stride, 4 * stride,
+                       3 * stride, 2 * stride, stride, 0);
+#endif
+  for (size_t ant = 0; ant < ant_num; ant++) {
+    const complex_float* ul_row = ul + (ant * sc_num);
+    const complex_float* dl_row = dl + (ant * sc_num);
+    size_t sc = 0;
+#if defined(__AVX512F__)
+    for (; sc + 8 <= sc_num; sc += 8) {
+      const __m512 num =
+          _mm512_loadu_ps(reinterpret_cast<const float*>(ul_row + sc));
+      const __m512 den =
+          _mm512_loadu_ps(reinterpret_cast<const float*>(dl_row + sc));
+      // |den|^2 in both lanes of each complex value
+      const __m512 den_sq = _mm512_mul_ps(den, den);
+      const __m512 norm =
+          _mm512_add_ps(den_sq, _mm512_permute_ps(den_sq, 0xB1));
+      // num * conj(den): re = a*c + b*d, im = b*c - a*d
+      const __m512 prod = _mm512_fmsubadd_ps(
+          num, _mm512_moveldup_ps(den),
+          _mm512_mul_ps(_mm512_permute_ps(num, 0xB1),
+                        _mm512_movehdup_ps(den)));
+      _mm512_i64scatter_pd(
+          reinterpret_cast<double*>(calib + (sc * ant_num) + ant), sc_index,
+          _mm512_castps_pd(_mm512_div_ps(prod, norm)), 8);
+    }
+#endif
+    for (; sc < sc_num; sc++) {
+      const complex_float num = ul_row[sc];
+      const complex_float den = dl_row[sc];
+      const float norm = den.re * den.re + den.im * den.im;
+      calib[sc * ant_num + ant] = {
+          (num.re * den.re + num.im * den.im) / norm,
+          (num.im * den.re - num.re * den.im) / norm};
+    }
+  }
+}
+
+#endif  // RECIP_CALIB_H_
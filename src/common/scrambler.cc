@@ -4,8 +4,11 @@
  */
 #include "scrambler.h"
 
+#include <immintrin.h>
+
 #include <array>
 #include <bitset>
+#include <cstring>
 
 #include "logger.h"
 
@@ -14,6 +17,31 @@ namespace AgoraScrambler {
 static constexpr size_t kBitsInByte = 8u;
 static constexpr size_t kBitsInitArraySize = 7u;
 static constexpr size_t kStartingVectorSize = (64 * 125);
+// The 127-bit scrambling sequence packed MSB first repeats every 127 bytes.
+// The cached bytes run one load past the period so a load at any phase fits.
+static constexpr size_t kSequenceLoadBytes = 32u;
+using SequenceBytes =
+    std::array<uint8_t, kScramblerlength + kSequenceLoadBytes>;
+
+static SequenceBytes GenerateSequenceBytes() {
+  std::bitset<kBitsInitArraySize> scrambler_init_bits{kScramblerInitState};
+  std::bitset<kScramblerlength> sequence;
+  for (size_t i = 0; i < kScramblerlength; i++) {
+    //  x7 xor x4
+    const bool res_xor = scrambler_init_bits[0] ^ scrambler_init_bits[3];
+    sequence[i] = res_xor;
+    scrambler_init_bits = scrambler_init_bits >> 1;
+    scrambler_init_bits[6] = res_xor;
+  }
+
+  SequenceBytes sequence_bytes{};
+  for (size_t i = 0; i < sequence_bytes.size() * kBitsInByte; i++) {
+    if (sequence[i % kScramblerlength]) {
+      sequence_bytes[i / kBitsInByte] |= 0x80u >> (i % kBitsInByte);
+    }
+  }
+  return sequence_bytes;
+}
 
 Scrambler::Scrambler()
     : scram_buffer_(kScramblerlength), bit_buffer_(kStartingVectorSize) {}
@@ -117,24 +145,71 @@ void Scrambler::WlanScrambler(void* output_buffer, const void* input_buffer,
   ConvertBitsToBytes(bit_buffer.data(), num_bytes, output_buffer_ptr);
 }
 
+void Scrambler::WlanScramblerWords(void* output_buffer,
+                                   const void* input_buffer,
+                                   size_t num_bytes) {
+  static const SequenceBytes kSequenceBytes = GenerateSequenceBytes();
+  const auto* input_ptr = reinterpret_cast<const uint8_t*>(input_buffer);
+  auto* output_ptr = reinterpret_cast<uint8_t*>(output_buffer);
+
+  size_t phase = 0;
+  size_t i = 0;
+#if defined(__AVX2__)
+  for (; i + kSequenceLoadBytes <= num_bytes; i += kSequenceLoadBytes) {
+    const __m256i data =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input_ptr + i));
+    const __m256i mask = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(&kSequenceBytes[phase]));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(output_ptr + i),
+                        _mm256_xor_si256(data, mask));
+    phase += kSequenceLoadBytes;
+    if (phase >= kScramblerlength) {
+      phase -= kScramblerlength;
+    }
+  }
+#else
+  for (; i + sizeof(uint64_t) <= num_bytes; i += sizeof(uint64_t)) {
+    uint64_t data;
+    uint64_t mask;
+    std::memcpy(&data, input_ptr + i, sizeof(uint64_t));
+    std::memcpy(&mask, &kSequenceBytes[phase], sizeof(uint64_t));
+    data ^= mask;
+    std::memcpy(output_ptr + i, &data, sizeof(uint64_t));
+    phase += sizeof(uint64_t);
+    if (phase >= kScramblerlength) {
+      phase -= kScramblerlength;
+    }
+  }
+#endif
+  for (; i < num_bytes; i++) {
+    output_ptr[i] = input_ptr[i] ^ kSequenceBytes[phase];
+    phase++;
+    if (phase == kScramblerlength) {
+      phase = 0;
+    }
+  }
+}
+
 void Scrambler::Scramble(void* scrambled, const void* to_scramble,
                          size_t bytes_to_scramble) {
-  WlanScrambler(scrambled, to_scramble, bytes_to_scramble, scram_buffer_,
-                bit_buffer_);
+  WlanScramblerWords(scrambled, to_scramble, bytes_to_scramble);
 }
 
 void Scrambler::Scramble(void* inout_bytes, size_t bytes_to_scramble) {
-  WlanScrambler(inout_bytes, inout_bytes, bytes_to_scramble, scram_buffer_,
-                bit_buffer_);
+  WlanScramblerWords(inout_bytes, inout_bytes, bytes_to_scramble);
 }
 
 void Scrambler::Descramble(void* descrambled, const void* scrambled,
                            size_t bytes_to_descramble) {
-  WlanScrambler(descrambled, scrambled, bytes_to_descramble, scram_buffer_,
-                bit_buffer_);
+  WlanScramblerWords(descrambled, scrambled, bytes_to_descramble);
 }
 void Scrambler::Descramble(void* inout_bytes, size_t bytes_to_descramble) {
-  WlanScrambler(inout_bytes, inout_bytes, bytes_to_descramble, scram_buffer_,
+  WlanScramblerWords(inout_bytes, inout_bytes, bytes_to_descramble);
+}
+
+void Scrambler::ScrambleReference(void* scrambled, const void* to_scramble,
+                                  size_t bytes_to_scramble) {
+  WlanScrambler(scrambled, to_scramble, bytes_to_scramble, scram_buffer_,
                 bit_buffer_);
 }
 
@@ -27,7 +27,25 @@ class Scrambler {
                   size_t bytes_to_descramble);
   void Descramble(void* inout_bytes, size_t bytes_to_descramble);
 
+  /// Bit-by-bit scrambler, reference for Scramble and Descramble
+  void ScrambleReference(void* scrambled, const void* to_scramble,
+                         size_t bytes_to_scramble);
+
  private:
+  /**
+   * @brief                        Word-parallel WLAN scrambler
+   *
+   * Same output as WlanScrambler. The scrambling sequence has a period of
+   * 127 bits, so its MSB-first byte packing repeats every 127 bytes. The
+   * input is XORed with that cached byte sequence, 32 bytes at a time.
+   *
+   * @param  output_buffer         Byte array for output scrambled data (can the the same as input)
+   * @param  input_buffer          Byte array for input to be scrambled
+   * @param  num_bytes             Byte array size - number of bytes to scramble / descramble
+   */
+  static void WlanScramblerWords(void* output_buffer, const void* input_buffer,
+                                 size_t num_bytes);
+
   /**
    * @brief                        WLAN Scrambler of IEEE 802.11-2012
    *
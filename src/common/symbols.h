@@ -13,9 +13,12 @@
 #define STRINGIFY(x) #x
 #define TOSTRING(x) STRINGIFY(x)
 
-// Number of frames received that we allocate space for in worker threads. This
-// is the frame window that we track in Agora.
-static constexpr size_t kFrameWnd = 40;
+// Default number of frames received that we allocate space for in worker
+// threads. This is the frame window that we track in Agora. It is a power of
+// two so frame slots are a mask, Config rounds other "frame_window" settings
+// up to one.
+static constexpr size_t kDefaultFrameWnd = 32;
+static_assert((kDefaultFrameWnd & (kDefaultFrameWnd - 1)) == 0);
 
 #define TX_FRAME_DELTA (4)
 #define SETTLE_TIME_MS (1)
@@ -58,6 +61,7 @@ enum class EventType : int {
   kSNRReport,    // Signal new SNR measurement from PHY to MAC
   kRANUpdate,    // Signal new RAN config to Agora
   kRBIndicator,  // Signal RB schedule to UEs
+  kRC,           // Reciprocity calibration vectors of one frame
   kThreadTermination
 };
 
@@ -187,8 +191,6 @@ static constexpr bool kDebug12BitIQ = false;
 static constexpr bool kDebugDownlink = false;
 static constexpr bool kDebugUplink = false;
 
-static constexpr bool kUsePartialTrans = true;
-
 // Enable hard demodulation and disable LDPC decoding
 // Useful for evaluating constellation quality
 static constexpr bool kDownlinkHardDemod = false;
@@ -286,12 +288,6 @@ static constexpr size_t kMaxSymbols = 70;
 // Maximum number of OFDM data subcarriers in the 5G spec
 static constexpr size_t kMaxDataSCs = 3300;
 
-// Maximum number of antennas supported by Agora
-static constexpr size_t kMaxAntennas = 64;
-
-// Maximum number of UEs supported by Agora
-static constexpr size_t kMaxUEs = 64;
-
 // Maximum number of transceiver channels per radio
 static constexpr size_t kMaxChannels = 2;
 
@@ -340,11 +336,15 @@ static constexpr size_t kMacBaseLocalPort = 8180;
 /// \todo need to generalize for hostname, port pairs for each client
 static constexpr size_t kMacBaseClientPort = 7070;
 
-// Number of subcarriers in a partial transpose block
+// Default number of subcarriers in a partial transpose block
 static constexpr size_t kTransposeBlockSize = 8;
 static_assert(IsPowerOfTwo(kTransposeBlockSize));  // For cheap modulo
 static_assert(kTransposeBlockSize % kSCsPerCacheline == 0);
 
+// Partial transpose block sizes the Doers are specialized for, selectable
+// with "transpose_block_size"
+static constexpr std::array<size_t, 4> kTransposeBlockSizes = {8, 16, 32, 64};
+
 static constexpr size_t kCalibScGroupSize = 8;
 static_assert(kCalibScGroupSize % kSCsPerCacheline == 0);
 
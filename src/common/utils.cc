@@ -84,6 +84,11 @@ static void PrintBitmask(const struct bitmask* bm) {
 
 void PrintCoreAssignmentSummary() { PrintCoreList(core_list); }
 
+void ClearCoreAssignments() {
+  std::scoped_lock lock(pin_core_mutex);
+  core_list.clear();
+}
+
 void SetCpuLayoutOnNumaNodes(bool verbose,
                              const std::vector<size_t>& cores_to_exclude) {
   if (cpu_layout_initialized == false) {
@@ -125,6 +130,13 @@ void SetCpuLayoutOnNumaNodes(bool verbose,
   }
 }
 
+void SetCpuLayout(const std::vector<size_t>& layout) {
+  std::scoped_lock lock(pin_core_mutex);
+  RtAssert(layout.empty() == false, "CPU layout must not be empty");
+  cpu_layout = layout;
+  cpu_layout_initialized = true;
+}
+
 size_t GetPhysicalCoreId(size_t core_id) {
   size_t core;
   if (cpu_layout_initialized) {
@@ -204,6 +216,15 @@ void PinToCoreWithOffset(ThreadType thread_type, size_t core_offset,
   }
 }
 
+size_t GetCoreNumaNode(size_t base_core_offset, size_t thread_id) {
+  if ((kEnableThreadPinning == false) || (numa_available() == -1)) {
+    return 0;
+  }
+  const int node = numa_node_of_cpu(
+      static_cast<int>(GetCoreId(base_core_offset + thread_id)));
+  return (node < 0) ? 0 : static_cast<size_t>(node);
+}
+
 std::vector<size_t> Utils::StrToChannels(const std::string& channel) {
   std::vector<size_t> channels;
   if (channel == "A") {
@@ -31,6 +31,10 @@ void SetCpuLayoutOnNumaNodes(
     bool verbose = false,
     const std::vector<size_t>& cores_to_exclude = std::vector<size_t>(1, 0));
 
+/* Replace the CPU layout by [layout], the CPU of each core index. Call
+ * before any thread is pinned. */
+void SetCpuLayout(const std::vector<size_t>& layout);
+
 size_t GetPhysicalCoreId(size_t core_id);
 
 /* Pin this thread to core with global index = core_id */
@@ -43,6 +47,14 @@ void PinToCoreWithOffset(ThreadType thread, size_t base_core_offset,
 
 void PrintCoreAssignmentSummary();
 
+/* Forget every core assignment. Call after the pinned threads exit, so that
+ * new threads can be pinned to the same cores. */
+void ClearCoreAssignments();
+
+/* NUMA node of the core PinToCoreWithOffset pins thread_id to, 0 when
+ * threads are not pinned or libnuma is unavailable */
+size_t GetCoreNumaNode(size_t base_core_offset, size_t thread_id);
+
 template <class T>
 struct EventHandlerContext {
   T* obj_ptr_;
@@ -1,7 +1,10 @@
 #ifndef UTILS_LDPC_H_
 #define UTILS_LDPC_H_
 
+#include <algorithm>
+#include <cmath>
 #include <cstdlib> /* for std::aligned_alloc */
+#include <vector>
 
 #include "encoder.h"
 #include "iobuffer.h"
@@ -183,6 +186,53 @@ static inline size_t LdpcEncodingEncodedBufSize(size_t base_graph, size_t zc) {
   return BitsToBytes(LdpcMaxNumEncodedBits(base_graph, zc)) + kMaxProcBytes;
 }
 
+// SNR (dB) a codeblock of [code_rate] with [mod_order_bits] bits per symbol
+// needs to decode: the Shannon bound of its spectral efficiency plus [gap_db]
+static inline float LdpcRequiredSnrDb(float code_rate, size_t mod_order_bits,
+                                      float gap_db) {
+  const float spectral_efficiency = code_rate * mod_order_bits;
+  return 10.0f * std::log10(std::exp2(spectral_efficiency) - 1.0f) + gap_db;
+}
+
+// Decoder iteration cap for a UE [margin_db] above the SNR its codeblocks
+// need. Codeblocks at or above the needed SNR get [max_iter], those below it
+// get proportionally fewer, and 0 (abandon) is returned at
+// [abandon_margin_db] below it.
+static inline size_t LdpcIterationCap(float margin_db, size_t max_iter,
+                                      float abandon_margin_db) {
+  if (margin_db >= 0.0f) {
+    return max_iter;
+  } else if (margin_db <= -abandon_margin_db) {
+    return 0;
+  }
+  const float fraction = 1.0f + (margin_db / abandon_margin_db);
+  const auto iter_cap = static_cast<size_t>(std::ceil(fraction * max_iter));
+  return std::max<size_t>(1, iter_cap);
+}
+
+// Iteration cap of a codeblock once the frame's decode budget may be spent.
+// The budget abandons whatever is left, so UEs are decoded in
+// LdpcDecodeOrder() to leave the codeblocks least likely to converge last.
+static inline size_t LdpcFrameIterationCap(float margin_db, size_t max_iter,
+                                           float abandon_margin_db,
+                                           bool budget_spent) {
+  if (budget_spent) {
+    return 0;
+  }
+  return LdpcIterationCap(margin_db, max_iter, abandon_margin_db);
+}
+
+// Order [ue_order] by decreasing [snr_db](ue), so the UEs most likely to
+// decode get the frame's decode budget first. Ties keep their order.
+template <typename SnrFunc>
+static inline void LdpcDecodeOrder(std::vector<size_t>& ue_order,
+                                   SnrFunc snr_db) {
+  std::stable_sort(ue_order.begin(), ue_order.end(),
+                   [&snr_db](size_t a, size_t b) {
+                     return snr_db(a) > snr_db(b);
+                   });
+}
+
 // Return the minimum LDPC expansion factor supported
 static inline size_t LdpcGetMinZc() { return kUseAVX2Encoder ? 2 : 6; }
 
@@ -191,29 +241,18 @@ static inline size_t LdpcGetMaxZc() {
   return kUseAVX2Encoder ? avx2enc::kZcMax : ZC_MAX;
 }
 
-// Generate the codeword output and parity buffer for this input buffer
-static inline void LdpcEncodeHelper(size_t base_graph, size_t zc, size_t nRows,
-                                    int8_t* encoded_buffer,
-                                    int8_t* parity_buffer,
-                                    const int8_t* input_buffer) {
+// Maximum number of codeblocks passed to the encoder in one request. FlexRAN's
+// encoder interleaves up to WAYS_2to16 codeblocks per pass.
+static constexpr size_t kLdpcEncodeMaxBatch = WAYS_2to16;
+
+// Copy punctured input bits from the encoding request, and parity bits from
+// the encoding response into encoded_buffer
+static inline void LdpcAssembleEncoded(size_t base_graph, size_t zc,
+                                       size_t nRows, int8_t* encoded_buffer,
+                                       const int8_t* parity_buffer,
+                                       const int8_t* input_buffer) {
   const size_t num_input_bits = LdpcNumInputBits(base_graph, zc);
   const size_t num_parity_bits = nRows * zc;
-
-  bblib_ldpc_encoder_5gnr_request req;
-  bblib_ldpc_encoder_5gnr_response resp;
-  req.baseGraph = base_graph;
-  req.nRows = kUseAVX2Encoder ? LdpcMaxNumRows(base_graph) : nRows;
-  req.Zc = zc;
-  req.nRows = nRows;
-  req.numberCodeblocks = 1;
-  req.input[0] = const_cast<int8_t*>(input_buffer);
-  resp.output[0] = parity_buffer;
-
-  kUseAVX2Encoder ? avx2enc::BblibLdpcEncoder5gnr(&req, &resp)
-                  : bblib_ldpc_encoder_5gnr(&req, &resp);
-
-  // Copy punctured input bits from the encoding request, and parity bits from
-  // the encoding response into encoded_buffer
   static size_t k_num_punctured_cols = 2;
   if (zc % 4 == 0) {
     // In this case, the start and end of punctured input bits is
@@ -252,7 +291,8 @@ static inline void LdpcEncodeHelper(size_t base_graph, size_t zc, size_t nRows,
     // Scatter input and parity into zc-bit chunks
     adapter_func((int8_t*)input_buffer, internal_buffer0, zc, num_input_bits,
                  1);
-    adapter_func(parity_buffer, internal_buffer1, zc, num_parity_bits, 1);
+    adapter_func(const_cast<int8_t*>(parity_buffer), internal_buffer1, zc,
+                 num_parity_bits, 1);
 
     // Concactenate the chunks for input and parity
     std::memcpy(internal_buffer2,
@@ -271,4 +311,56 @@ static inline void LdpcEncodeHelper(size_t base_graph, size_t zc, size_t nRows,
   }
 }
 
+// Generate the codeword output and parity buffer for this input buffer
+static inline void LdpcEncodeHelper(size_t base_graph, size_t zc, size_t nRows,
+                                    int8_t* encoded_buffer,
+                                    int8_t* parity_buffer,
+                                    const int8_t* input_buffer) {
+  bblib_ldpc_encoder_5gnr_request req;
+  bblib_ldpc_encoder_5gnr_response resp;
+  req.baseGraph = base_graph;
+  req.nRows = kUseAVX2Encoder ? LdpcMaxNumRows(base_graph) : nRows;
+  req.Zc = zc;
+  req.nRows = nRows;
+  req.numberCodeblocks = 1;
+  req.input[0] = const_cast<int8_t*>(input_buffer);
+  resp.output[0] = parity_buffer;
+
+  kUseAVX2Encoder ? avx2enc::BblibLdpcEncoder5gnr(&req, &resp)
+                  : bblib_ldpc_encoder_5gnr(&req, &resp);
+  LdpcAssembleEncoded(base_graph, zc, nRows, encoded_buffer, parity_buffer,
+                      input_buffer);
+}
+
+// Generate the codeword outputs and parity buffers for [num_cbs] input buffers
+// with the same LDPC configuration. Agora's encoder handles them
+// avx512enc::kNumWays at a time.
+static inline void LdpcEncodeBatchHelper(size_t base_graph, size_t zc,
+                                         size_t nRows,
+                                         int8_t* const* encoded_buffers,
+                                         int8_t* const* parity_buffers,
+                                         const int8_t* const* input_buffers,
+                                         size_t num_cbs) {
+  for (size_t start = 0; start < num_cbs; start += kLdpcEncodeMaxBatch) {
+    const size_t batch = std::min(kLdpcEncodeMaxBatch, num_cbs - start);
+    bblib_ldpc_encoder_5gnr_request req;
+    bblib_ldpc_encoder_5gnr_response resp;
+    req.baseGraph = base_graph;
+    req.Zc = zc;
+    req.nRows = nRows;
+    req.numberCodeblocks = batch;
+    for (size_t i = 0; i < batch; i++) {
+      req.input[i] = const_cast<int8_t*>(input_buffers[start + i]);
+      resp.output[i] = parity_buffers[start + i];
+    }
+
+    kUseAVX2Encoder ? avx512enc::BblibLdpcEncoder5gnr(&req, &resp)
+                    : bblib_ldpc_encoder_5gnr(&req, &resp);
+    for (size_t i = 0; i < batch; i++) {
+      LdpcAssembleEncoded(base_graph, zc, nRows, encoded_buffers[start + i],
+                          parity_buffers[start + i], input_buffers[start + i]);
+    }
+  }
+}
+
 #endif  // UTILS_LDPC_H_
@@ -1,6 +1,7 @@
 /**
  * @file encoder.h
- * @brief Definitions for Agora's AVX2-based LDPC encoder.
+ * @brief Definitions for Agora's AVX2-based LDPC encoder and its batched
+ * AVX-512 variant.
  *
  * We need an AVX2-based LDPC encoder because FlexRAN's LDPC encoder requires
  * AVX-512.
@@ -24,6 +25,19 @@ int32_t BblibLdpcEncoder5gnr(struct bblib_ldpc_encoder_5gnr_request* request,
                              struct bblib_ldpc_encoder_5gnr_response* response);
 };  // namespace avx2enc
 
+namespace avx512enc {
+// Codeblocks encoded per pass, one in each 256-bit half of a register
+static constexpr size_t kNumWays = 2;
+
+// Bytes per Zc-bit chunk of one codeblock, as in avx2enc
+static constexpr size_t kProcBytes = avx2enc::kProcBytes;
+
+/// Encode request->numberCodeblocks codeblocks, kNumWays at a time. Supports
+/// the same Zc values as avx2enc, and falls back to it without AVX-512.
+int32_t BblibLdpcEncoder5gnr(struct bblib_ldpc_encoder_5gnr_request* request,
+                             struct bblib_ldpc_encoder_5gnr_response* response);
+};  // namespace avx512enc
+
 // PROC_BYTES (maximum bytes processed as an LDPC chunk) is 64 bytes in
 // FlexRAN's LDPC encoder and 32 bytes in Agora's derived LDPC encoder.
 // Using the larger of the two works for padding buffers.
@@ -0,0 +1,336 @@
+/**
+ * @file encoder_avx512.cc
+ * @brief Implementations for Agora's batched AVX-512 LDPC encoder.
+ *
+ * Two codeblocks with the same base graph and Zc are encoded at once, one in
+ * each 256-bit half of a 512-bit register. Both halves use the same cyclic
+ * shifts, so the XOR tree over the base matrix is walked once per pair.
+ */
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "common_typedef_sdk.h"
+#include "encoder.h"
+#include "iobuffer.h"
+
+namespace avx512enc {
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+// Bytes between consecutive Zc-bit chunks of a codeblock pair
+static constexpr size_t kPairProcBytes = kNumWays * kProcBytes;
+
+using CYCLIC_BIT_SHIFT_X2 = __m512i (*)(__m512i, int16_t, int16_t);
+
+// Zc <= 64: each codeblock chunk is the lowest 64-bit lane of its half
+static __m512i CycleBitShiftX2to64(__m512i data, int16_t cyc_shift,
+                                   int16_t zc) {
+  cyc_shift = cyc_shift % zc;
+  const int64_t e0 = (zc >= 64) ? -1 : static_cast<int64_t>((1UL << zc) - 1);
+  const __m512i bit_mask = _mm512_set_epi64(0, 0, 0, e0, 0, 0, 0, e0);
+  data = _mm512_and_si512(data, bit_mask);
+
+  const __m512i x1 = _mm512_srli_epi64(data, cyc_shift);
+  const __m512i x2 = _mm512_slli_epi64(data, zc - cyc_shift);
+  return _mm512_and_si512(_mm512_or_si512(x1, x2), bit_mask);
+}
+
+// Zc a multiple of 16 (up to 256): rotate 16-bit words within each half,
+// then shift the remaining bits in from the next word
+static __m512i CycleBitShiftX2Words(__m512i data, int16_t cyc_shift,
+                                    int16_t zc) {
+  cyc_shift = cyc_shift % zc;
+  const int packed_shift = cyc_shift >> 4;
+  const int bit_shift = cyc_shift & 0xf;
+  const auto zc_in_shorts = static_cast<int16_t>(zc >> 4);
+
+  // Word index within the half, and offset of the half
+  const __m512i word = _mm512_set_epi16(
+      15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11,
+      10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+  const __m512i half = _mm512_set_epi16(
+      16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 0, 0, 0,
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m512i zcs = _mm512_set1_epi16(zc_in_shorts);
+  const __mmask32 valid = _mm512_cmplt_epu16_mask(word, zcs);
+
+  // (word + packed_shift) mod zc_in_shorts, and the word after it
+  __m512i idx = _mm512_add_epi16(word, _mm512_set1_epi16(packed_shift));
+  idx = _mm512_mask_sub_epi16(idx, _mm512_cmpge_epu16_mask(idx, zcs), idx,
+                              zcs);
+  __m512i idx_next = _mm512_add_epi16(idx, _mm512_set1_epi16(1));
+  idx_next = _mm512_mask_sub_epi16(
+      idx_next, _mm512_cmpge_epu16_mask(idx_next, zcs), idx_next, zcs);
+
+  const __m512i x0 =
+      _mm512_maskz_permutexvar_epi16(valid, _mm512_add_epi16(idx, half), data);
+  const __m512i x1 = _mm512_maskz_permutexvar_epi16(
+      valid, _mm512_add_epi16(idx_next, half), data);
+
+  // A shift count of 16 clears the word, as needed when bit_shift is zero
+  return _mm512_or_si512(
+      _mm512_srl_epi16(x0, _mm_cvtsi32_si128(bit_shift)),
+      _mm512_sll_epi16(x1, _mm_cvtsi32_si128(16 - bit_shift)));
+}
+
+// Shift the low 128 bits of each half right (or left) by n < 128 bits. Each
+// output lane combines the two input lanes the shift moves bits from.
+static inline __m512i Shift128X2(__m512i data, int n, bool right) {
+  const int q = n >> 6;
+  const int r = n & 63;
+  int64_t idx0[8] = {};
+  int64_t idx1[8] = {};
+  __mmask8 mask0 = 0;
+  __mmask8 mask1 = 0;
+  for (int lane = 0; lane < 8; lane += 4) {
+    for (int k = 0; k < 2; k++) {
+      const int src0 = right ? (k + q) : (k - q);
+      const int src1 = right ? (src0 + 1) : (src0 - 1);
+      if (src0 >= 0 && src0 < 2) {
+        idx0[lane + k] = lane + src0;
+        mask0 |= 1u << (lane + k);
+      }
+      if (src1 >= 0 && src1 < 2) {
+        idx1[lane + k] = lane + src1;
+        mask1 |= 1u << (lane + k);
+      }
+    }
+  }
+  const __m512i x0 =
+      _mm512_maskz_permutexvar_epi64(mask0, _mm512_loadu_si512(idx0), data);
+  const __m512i x1 =
+      _mm512_maskz_permutexvar_epi64(mask1, _mm512_loadu_si512(idx1), data);
+  // A shift count of 64 clears the lane, as needed when r is zero
+  const __m128i count0 = _mm_cvtsi32_si128(r);
+  const __m128i count1 = _mm_cvtsi32_si128(64 - r);
+  return right ? _mm512_or_si512(_mm512_srl_epi64(x0, count0),
+                                 _mm512_sll_epi64(x1, count1))
+               : _mm512_or_si512(_mm512_sll_epi64(x0, count0),
+                                 _mm512_srl_epi64(x1, count1));
+}
+
+// Other Zc up to 128 (72, 88, 104, 120): rotate the low 128 bits of each
+// half as the OR of a right and a left shift
+static __m512i CycleBitShiftX2to128(__m512i data, int16_t cyc_shift,
+                                    int16_t zc) {
+  cyc_shift = cyc_shift % zc;
+  const int64_t e1 =
+      (zc >= 128) ? -1 : static_cast<int64_t>((1UL << (zc - 64)) - 1);
+  const __m512i bit_mask = _mm512_set_epi64(0, 0, e1, -1, 0, 0, e1, -1);
+  data = _mm512_and_si512(data, bit_mask);
+  const __m512i x1 = Shift128X2(data, cyc_shift, true);
+  const __m512i x2 = Shift128X2(data, zc - cyc_shift, false);
+  return _mm512_and_si512(_mm512_or_si512(x1, x2), bit_mask);
+}
+
+static CYCLIC_BIT_SHIFT_X2 LdpcSelectShiftFuncX2(int16_t zc) {
+  if (zc <= 64) {
+    return CycleBitShiftX2to64;
+  } else if ((zc % 16) == 0 && zc <= 256) {
+    return CycleBitShiftX2Words;
+  } else if (zc <= 128) {
+    return CycleBitShiftX2to128;
+  } else {
+    throw std::invalid_argument(
+        "cyclic shifter for zc larger than 256 has not been implemented");
+  }
+}
+
+static inline __m512i Load(const int8_t* ptr) {
+  return _mm512_loadu_si512(reinterpret_cast<const void*>(ptr));
+}
+
+static inline void Store(int8_t* ptr, __m512i data) {
+  _mm512_storeu_si512(reinterpret_cast<void*>(ptr), data);
+}
+
+// Encode a codeblock pair. pDataIn and pDataOut hold one kPairProcBytes chunk
+// per information column and parity row. The base matrix addresses are in
+// units of 64 bytes, which is also the stride of the pair chunks.
+static void LdpcEncoderX2(int8_t* pDataIn, int8_t* pDataOut,
+                          const int16_t* pMatrixNumPerCol, const int16_t* pAddr,
+                          const int16_t* pShiftMatrix, int16_t zcSize,
+                          uint8_t i_LS, uint16_t bg) {
+  static_assert(kPairProcBytes == PROC_BYTES);
+  const size_t num_rows = (bg == 1) ? BG1_ROW_TOTAL : BG2_ROW_TOTAL;
+  const size_t num_inf_cols = (bg == 1) ? BG1_COL_INF_NUM : BG2_COL_INF_NUM;
+  const CYCLIC_BIT_SHIFT_X2 cycle_bit_shift_p = LdpcSelectShiftFuncX2(zcSize);
+  const int16_t* p_temp_addr = pAddr;
+  const int16_t* p_temp_matrix = pShiftMatrix;
+
+  for (size_t j = 0; j < num_rows; j++) {
+    Store(pDataOut + j * kPairProcBytes, _mm512_setzero_si512());
+  }
+
+  // getting lambdas
+  size_t i = 0;
+  __m512i x1 = Load(pDataIn);
+  for (int32_t j = 0; j < pMatrixNumPerCol[i]; j++) {
+    Store(pDataOut + *p_temp_addr++,
+          cycle_bit_shift_p(x1, *p_temp_matrix++, zcSize));
+  }
+  for (i = 1; i < num_inf_cols; i++) {
+    x1 = Load(pDataIn + i * kPairProcBytes);
+    for (int32_t j = 0; j < pMatrixNumPerCol[i]; j++) {
+      int8_t* p_out = pDataOut + *p_temp_addr++;
+      Store(p_out, _mm512_xor_si512(
+                       cycle_bit_shift_p(x1, *p_temp_matrix++, zcSize),
+                       Load(p_out)));
+    }
+  }
+
+  // Row Transform to resolve the small 4x4 parity matrix
+  x1 = Load(pDataOut);
+  const __m512i x2 = Load(pDataOut + kPairProcBytes);
+  const __m512i x3 = Load(pDataOut + 2 * kPairProcBytes);
+  const __m512i x4 = Load(pDataOut + 3 * kPairProcBytes);
+
+  // x5 is p_a1
+  __m512i x5 = _mm512_xor_si512(_mm512_xor_si512(x1, x2),
+                                _mm512_xor_si512(x3, x4));
+  __m512i x6;
+  if (bg == 1) {
+    // Special case for the circulant
+    if (i_LS == 6) {
+      x5 = cycle_bit_shift_p(x5, 103, zcSize);
+      x6 = x5;
+    } else {
+      x6 = cycle_bit_shift_p(x5, 1, zcSize);
+    }
+    const __m512i x8 = _mm512_xor_si512(x4, x6);
+    Store(pDataOut, x5);
+    Store(pDataOut + kPairProcBytes, _mm512_xor_si512(x1, x6));
+    Store(pDataOut + 2 * kPairProcBytes, _mm512_xor_si512(x3, x8));
+    Store(pDataOut + 3 * kPairProcBytes, x8);
+  } else {
+    if ((i_LS == 3) || (i_LS == 7)) {
+      x6 = cycle_bit_shift_p(x5, 1, zcSize);
+    } else {
+      x5 = cycle_bit_shift_p(x5, (zcSize - 1), zcSize);
+      x6 = x5;
+    }
+    const __m512i x7 = _mm512_xor_si512(x1, x6);
+    Store(pDataOut, x5);
+    Store(pDataOut + kPairProcBytes, x7);
+    Store(pDataOut + 2 * kPairProcBytes, _mm512_xor_si512(x2, x7));
+    Store(pDataOut + 3 * kPairProcBytes, _mm512_xor_si512(x4, x6));
+  }
+
+  // Rest of parity based on identity matrix
+  for (; i < 4 + num_inf_cols; i++) {
+    x1 = Load(pDataOut + (i - num_inf_cols) * kPairProcBytes);
+    for (int32_t j = 0; j < pMatrixNumPerCol[i]; j++) {
+      int8_t* p_out = pDataOut + *p_temp_addr++;
+      Store(p_out, _mm512_xor_si512(
+                       cycle_bit_shift_p(x1, *p_temp_matrix++, zcSize),
+                       Load(p_out)));
+    }
+  }
+}
+
+int32_t BblibLdpcEncoder5gnr(
+    struct bblib_ldpc_encoder_5gnr_request* request,
+    struct bblib_ldpc_encoder_5gnr_response* response) {
+  const uint16_t zc = request->Zc;
+  if (zc > avx2enc::kZcMax) {
+    std::fprintf(stderr,
+                 "Error: This AVX-512 encoder supports only Zc <= %zu\n",
+                 avx2enc::kZcMax);
+    throw std::runtime_error("Encoder: This AVX-512 encoder supports only Zc");
+  }
+
+  const int number_codeblocks = request->numberCodeblocks;
+  const uint16_t bg = request->baseGraph;
+  const uint32_t cb_enc_len = request->nRows * zc;
+  const uint32_t cb_len =
+      (bg == 1) ? zc * BG1_COL_INF_NUM : zc * BG2_COL_INF_NUM;
+  const size_t num_inf_cols = (bg == 1) ? BG1_COL_INF_NUM : BG2_COL_INF_NUM;
+  const size_t num_rows = (bg == 1) ? BG1_ROW_TOTAL : BG2_ROW_TOTAL;
+
+  // i_Ls decides the base matrix entries
+  uint8_t i_ls;
+  if ((zc % 15) == 0) {
+    i_ls = 7;
+  } else if ((zc % 13) == 0) {
+    i_ls = 6;
+  } else if ((zc % 11) == 0) {
+    i_ls = 5;
+  } else if ((zc % 9) == 0) {
+    i_ls = 4;
+  } else if ((zc % 7) == 0) {
+    i_ls = 3;
+  } else if ((zc % 5) == 0) {
+    i_ls = 2;
+  } else if ((zc % 3) == 0) {
+    i_ls = 1;
+  } else {
+    i_ls = 0;
+  }
+
+  const int16_t* p_shift_matrix;
+  const int16_t* p_matrix_num_per_col;
+  const int16_t* p_addr;
+  if (bg == 1) {
+    p_shift_matrix = kBg1HShiftMatrix + i_ls * BG1_NONZERO_NUM;
+    p_matrix_num_per_col = kBg1MatrixNumPerCol;
+    p_addr = kBg1Address;
+  } else {
+    p_shift_matrix = kBg2HShiftMatrix + i_ls * BG2_NONZERO_NUM;
+    p_matrix_num_per_col = kBg2MatrixNumPerCol;
+    p_addr = kBg2Address;
+  }
+
+  // Per-codeblock chunks as produced and consumed by the AVX2 adapters
+  __attribute__((aligned(64)))
+  int8_t input_internal_buffer[kNumWays][BG1_COL_TOTAL * kProcBytes] = {};
+  __attribute__((aligned(64)))
+  int8_t parity_internal_buffer[kNumWays][BG1_ROW_TOTAL * kProcBytes] = {};
+  // Chunks of both codeblocks interleaved, one kPairProcBytes chunk each
+  __attribute__((aligned(64)))
+  int8_t input_pair_buffer[BG1_COL_TOTAL * kPairProcBytes] = {};
+  __attribute__((aligned(64)))
+  int8_t parity_pair_buffer[BG1_ROW_TOTAL * kPairProcBytes] = {};
+
+  avx2enc::LDPC_ADAPTER_P ldpc_adapter_func =
+      avx2enc::LdpcSelectAdapterFunc(zc);
+
+  for (int n = 0; n < number_codeblocks; n += kNumWays) {
+    // An odd last codeblock is paired with zero input
+    const size_t num_ways =
+        std::min(kNumWays, static_cast<size_t>(number_codeblocks - n));
+    for (size_t w = 0; w < kNumWays; w++) {
+      if (w < num_ways) {
+        ldpc_adapter_func(request->input[n + w], input_internal_buffer[w], zc,
+                          cb_len, 1);
+      } else {
+        std::memset(input_internal_buffer[w], 0, num_inf_cols * kProcBytes);
+      }
+      for (size_t i = 0; i < num_inf_cols; i++) {
+        std::memcpy(input_pair_buffer + i * kPairProcBytes + w * kProcBytes,
+                    input_internal_buffer[w] + i * kProcBytes, kProcBytes);
+      }
+    }
+
+    LdpcEncoderX2(input_pair_buffer, parity_pair_buffer, p_matrix_num_per_col,
+                  p_addr, p_shift_matrix, static_cast<int16_t>(zc), i_ls, bg);
+
+    for (size_t w = 0; w < num_ways; w++) {
+      for (size_t i = 0; i < num_rows; i++) {
+        std::memcpy(parity_internal_buffer[w] + i * kProcBytes,
+                    parity_pair_buffer + i * kPairProcBytes + w * kProcBytes,
+                    kProcBytes);
+      }
+      ldpc_adapter_func(response->output[n + w], parity_internal_buffer[w], zc,
+                        cb_enc_len, 0);
+    }
+  }
+  return 0;
+}
+#else
+// Without AVX-512 the codeblocks are encoded one by one
+int32_t BblibLdpcEncoder5gnr(
+    struct bblib_ldpc_encoder_5gnr_request* request,
+    struct bblib_ldpc_encoder_5gnr_response* response) {
+  return avx2enc::BblibLdpcEncoder5gnr(request, response);
+}
+#endif
+}  // namespace avx512enc
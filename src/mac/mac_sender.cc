@@ -25,8 +25,6 @@ static constexpr size_t kFrameLoadAdvance = 10;
 static constexpr size_t kBufferInit = 10;
 static constexpr size_t kTxBufferElementAlignment = 64;
 
-static constexpr size_t kSlowStartThresh1 = kFrameWnd;
-static constexpr size_t kSlowStartThresh2 = (kFrameWnd * 4);
 static constexpr size_t kSlowStartMulStage1 = 32;
 static constexpr size_t kSlowStartMulStage2 = 8;
 static constexpr size_t kMasterThreadId = 0;
@@ -48,7 +46,7 @@ void DelayTicks(uint64_t start, uint64_t ticks) {
 }
 
 inline size_t MacSender::TagToTxBuffersIndex(gen_tag_t tag) const {
-  const size_t frame_slot = (tag.frame_id_ % kFrameWnd);
+  const size_t frame_slot = cfg_->FrameSlot(tag.frame_id_);
 
   return (frame_slot * cfg_->UeAntNum()) + tag.ue_id_;
 }
@@ -108,14 +106,14 @@ MacSender::MacSender(Config* cfg, std::string& data_filename,
 
   const size_t tx_packet_storage = (packets_per_frame_ * tx_buffer_pkt_offset_);
   // tx buffers will be an array of
-  tx_buffers_.Malloc(kFrameWnd * cfg_->UeAntNum(), tx_packet_storage,
+  tx_buffers_.Malloc(cfg_->FrameWnd() * cfg_->UeAntNum(), tx_packet_storage,
                      Agora_memory::Alignment_t::kAlign64);
   AGORA_LOG_TRACE(
       "Tx buffer size: dim1 %zu, dim2 %zu, total %zu, start %zu, end: %zu\n",
-      (kFrameWnd * cfg_->UeAntNum()), tx_packet_storage,
-      (kFrameWnd * cfg_->UeAntNum()) * tx_packet_storage,
+      (cfg_->FrameWnd() * cfg_->UeAntNum()), tx_packet_storage,
+      (cfg_->FrameWnd() * cfg_->UeAntNum()) * tx_packet_storage,
       (size_t)tx_buffers_[0],
-      (size_t)tx_buffers_[(kFrameWnd * cfg_->UeAntNum()) - 1]);
+      (size_t)tx_buffers_[(cfg_->FrameWnd() * cfg_->UeAntNum()) - 1]);
 
   AGORA_LOG_INFO(
       "Initializing MacSender, sending to mac thread at %s:%zu, frame "
@@ -219,8 +217,7 @@ void* MacSender::MasterThread(size_t tid) {
   const bool allow_core_sharing = has_master_thread_;
   PinToCoreWithOffset(ThreadType::kMasterTX, core_offset_, tid,
                       allow_core_sharing);
-  std::array<size_t, kFrameWnd> frame_data_count;
-  frame_data_count.fill(0);
+  std::vector<size_t> frame_data_count(cfg_->FrameWnd(), 0);
 
   // Wait for all worker threads to be ready (+1 for Master)
   for (size_t i = 0; i < kFrameLoadAdvance; i++) {
@@ -251,7 +248,7 @@ void* MacSender::MasterThread(size_t tid) {
     gen_tag_t ctag(0);  // The completion tag
     int ret = static_cast<int>(completion_queue_.try_dequeue(ctag.tag_));
     if (ret > 0) {
-      const size_t comp_frame_slot = (ctag.frame_id_ % kFrameWnd);
+      const size_t comp_frame_slot = cfg_->FrameSlot(ctag.frame_id_);
       frame_data_count.at(comp_frame_slot)++;
 
       if (kDebugPrintSender) {
@@ -432,11 +429,12 @@ void* MacSender::WorkerThread(size_t tid) {
 }
 
 uint64_t MacSender::GetTicksForFrame(size_t frame_id) const {
+  // The slow start stages end after one and four frame windows
   if (enable_slow_start_ == 0) {
     return ticks_all_;
-  } else if (frame_id < kSlowStartThresh1) {
+  } else if (frame_id < cfg_->FrameWnd()) {
     return ticks_wnd1_;
-  } else if (frame_id < kSlowStartThresh2) {
+  } else if (frame_id < (cfg_->FrameWnd() * 4)) {
     return ticks_wnd2_;
   } else {
     return ticks_all_;
@@ -11,7 +11,7 @@ static constexpr size_t kUdpRxBufferPadding = 2048u;
 
 MacThreadBaseStation::MacThreadBaseStation(
     Config* cfg, size_t core_offset,
-    PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& decoded_buffer,
+    PtrCube<int8_t>& decoded_buffer,
     Table<int8_t>* dl_bits_buffer, Table<int8_t>* dl_bits_buffer_status,
     moodycamel::ConcurrentQueue<EventData>* rx_queue,
     moodycamel::ConcurrentQueue<EventData>* tx_queue,
@@ -37,17 +37,19 @@ MacThreadBaseStation::MacThreadBaseStation(
       cfg_->GetFrameDurationSec() * 1000, tsc_delta_);
 
   // Set up buffers
-  client_.dl_bits_buffer_id_.fill(0);
+  client_.dl_bits_buffer_id_.assign(cfg_->UeAntTotal(), 0);
   client_.dl_bits_buffer_ = dl_bits_buffer;
   client_.dl_bits_buffer_status_ = dl_bits_buffer_status;
 
-  server_.n_filled_in_frame_.fill(0);
+  server_.n_filled_in_frame_.assign(cfg_->UeAntTotal(), 0);
+  server_.snr_.resize(cfg_->UeAntTotal());
   for (size_t ue_ant = 0; ue_ant < cfg_->UeAntTotal(); ue_ant++) {
     server_.data_size_.emplace_back(
         std::vector<size_t>(cfg->Frame().NumUlDataSyms()));
   }
 
   // The frame data will hold the data comming from the Phy (Received)
+  server_.frame_data_.resize(cfg_->UeAntTotal());
   for (auto& v : server_.frame_data_) {
     v.resize(cfg_->MacDataBytesNumPerframe(Direction::kUplink));
   }
@@ -62,9 +64,9 @@ MacThreadBaseStation::MacThreadBaseStation(
   AGORA_LOG_INFO(
       "MacThreadBaseStation: setting up udp server for mac data at port %zu\n",
       udp_server_port);
-  udp_comm_ =
-      std::make_unique<UDPComm>(cfg_->BsServerAddr(), udp_server_port,
-                                udp_pkt_len * kMaxUEs * kMaxPktsPerUE, 0);
+  udp_comm_ = std::make_unique<UDPComm>(
+      cfg_->BsServerAddr(), udp_server_port,
+      udp_pkt_len * cfg_->UeAntTotal() * kMaxPktsPerUE, 0);
   crc_obj_ = std::make_unique<DoCRC>();
 }
 
@@ -138,7 +140,7 @@ void MacThreadBaseStation::ProcessCodeblocksFromPhy(EventData event) {
   const size_t mac_payload_max_length =
       cfg_->MacPayloadMaxLength(Direction::kUplink);
   const int8_t* src_data =
-      decoded_buffer_[(frame_id % kFrameWnd)][symbol_array_index][ue_id];
+      decoded_buffer_[cfg_->FrameSlot(frame_id)][symbol_array_index][ue_id];
 
   std::stringstream ss;  // Debug formatting
 
@@ -515,7 +517,7 @@ void MacThreadBaseStation::ProcessUdpPacketsFromAppsBs(const char* payload) {
   RtAssert(tx_queue_->enqueue(msg),
            "MacThreadBasestation: Failed to enqueue downlink packet");
 
-  radio_buf_id = (radio_buf_id + 1) % kFrameWnd;
+  radio_buf_id = cfg_->FrameSlot(radio_buf_id + 1);
   // Might be unnecessary now.
   next_radio_id_ = (next_radio_id_ + 1) % cfg_->UeAntNum();
   if (next_radio_id_ == 0) {
@@ -13,7 +13,7 @@ static constexpr size_t kUdpRxBufferPadding = 2048u;
 
 MacThreadClient::MacThreadClient(
     Config* cfg, size_t core_offset,
-    PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& decoded_buffer,
+    PtrCube<int8_t>& decoded_buffer,
     Table<int8_t>* ul_bits_buffer, Table<int8_t>* ul_bits_buffer_status,
     moodycamel::ConcurrentQueue<EventData>* rx_queue,
     moodycamel::ConcurrentQueue<EventData>* tx_queue,
@@ -38,17 +38,19 @@ MacThreadClient::MacThreadClient(
                  cfg_->GetFrameDurationSec() * 1000, tsc_delta_);
 
   // Set up buffers
-  client_.ul_bits_buffer_id_.fill(0);
+  client_.ul_bits_buffer_id_.assign(cfg_->UeAntTotal(), 0);
   client_.ul_bits_buffer_ = ul_bits_buffer;
   client_.ul_bits_buffer_status_ = ul_bits_buffer_status;
 
-  server_.n_filled_in_frame_.fill(0);
+  server_.n_filled_in_frame_.assign(cfg_->UeAntTotal(), 0);
+  server_.snr_.resize(cfg_->UeAntTotal());
   for (size_t ue_ant = 0; ue_ant < cfg_->UeAntTotal(); ue_ant++) {
     server_.data_size_.emplace_back(
         std::vector<size_t>(cfg->Frame().NumDlDataSyms()));
   }
 
   // The frame data will hold the data comming from the Phy (Received)
+  server_.frame_data_.resize(cfg_->UeAntTotal());
   for (auto& v : server_.frame_data_) {
     v.resize(cfg_->MacDataBytesNumPerframe(Direction::kDownlink));
   }
@@ -62,9 +64,9 @@ MacThreadClient::MacThreadClient(
   AGORA_LOG_INFO(
       "MacThreadClient: setting up udp server for mac data at port %zu\n",
       udp_server_port);
-  udp_comm_ =
-      std::make_unique<UDPComm>(cfg_->UeServerAddr(), udp_server_port,
-                                udp_pkt_len * kMaxUEs * kMaxPktsPerUE, 0);
+  udp_comm_ = std::make_unique<UDPComm>(
+      cfg_->UeServerAddr(), udp_server_port,
+      udp_pkt_len * cfg_->UeAntTotal() * kMaxPktsPerUE, 0);
 
   const size_t udp_control_len = sizeof(RBIndicator);
   udp_control_buf_.resize(udp_control_len);
@@ -73,9 +75,9 @@ MacThreadClient::MacThreadClient(
       "MacThreadClient: setting up udp server for mac control channel at port "
       "%zu\n",
       kMacBaseClientPort);
-  udp_control_channel_ =
-      std::make_unique<UDPServer>(cfg_->UeServerAddr(), kMacBaseClientPort,
-                                  udp_control_len * kMaxUEs * kMaxPktsPerUE);
+  udp_control_channel_ = std::make_unique<UDPServer>(
+      cfg_->UeServerAddr(), kMacBaseClientPort,
+      udp_control_len * cfg_->UeAntTotal() * kMaxPktsPerUE);
   crc_obj_ = std::make_unique<DoCRC>();
 }
 
@@ -131,7 +133,7 @@ void MacThreadClient::ProcessCodeblocksFromPhy(EventData event) {
       cfg_->MacPayloadMaxLength(Direction::kDownlink);
 
   const int8_t* src_data =
-      decoded_buffer_[(frame_id % kFrameWnd)][symbol_array_index][ue_id];
+      decoded_buffer_[cfg_->FrameSlot(frame_id)][symbol_array_index][ue_id];
 
   std::stringstream ss;  // Debug-only
 
@@ -513,7 +515,7 @@ void MacThreadClient::ProcessUdpPacketsFromAppsClient(const char* payload,
   RtAssert(tx_queue_->enqueue(msg),
            "MacThreadClient: Failed to enqueue uplink packet");
 
-  radio_buf_id = (radio_buf_id + 1) % kFrameWnd;
+  radio_buf_id = cfg_->FrameSlot(radio_buf_id + 1);
   // Might be unnecessary now.
   next_radio_id_ = (next_radio_id_ + 1) % cfg_->UeAntNum();
   if (next_radio_id_ == 0) {
@@ -40,7 +40,7 @@ class MacThreadClient {
 
   MacThreadClient(
       Config* const cfg, size_t core_offset,
-      PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& decoded_buffer,
+      PtrCube<int8_t>& decoded_buffer,
       Table<int8_t>* ul_bits_buffer, Table<int8_t>* ul_bits_buffer_status,
       moodycamel::ConcurrentQueue<EventData>* rx_queue,
       moodycamel::ConcurrentQueue<EventData>* tx_queue,
@@ -121,14 +121,14 @@ class MacThreadClient {
   // Server-only members
   struct {
     // Staging buffers to accumulate decoded uplink code blocks for each UE
-    std::array<std::vector<std::byte>, kMaxUEs> frame_data_;
+    std::vector<std::vector<std::byte>> frame_data_;
 
     // n_filled_in_frame_[i] is the number of bytes received in the current
     // frame for UE #i
-    std::array<size_t, kMaxUEs> n_filled_in_frame_;
+    std::vector<size_t> n_filled_in_frame_;
 
     // snr_[i] contains a moving window of SNR measurement for UE #i
-    std::array<std::queue<float>, kMaxUEs> snr_;
+    std::vector<std::queue<float>> snr_;
 
     // Placing at the end because it is variable size based on configuration
     std::vector<std::vector<size_t>> data_size_;
@@ -136,12 +136,12 @@ class MacThreadClient {
 
   // TODO: decoded_buffer_ is used by only the server, so it should be moved
   // to server_ for clarity.
-  PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& decoded_buffer_;
+  PtrCube<int8_t>& decoded_buffer_;
 
   struct {
     // ul_bits_buffer_id_[i] is the index of the uplink data bits buffer to
     // next use for radio #i
-    std::array<size_t, kMaxUEs> ul_bits_buffer_id_;
+    std::vector<size_t> ul_bits_buffer_id_;
 
     Table<int8_t>* ul_bits_buffer_;
     Table<int8_t>* ul_bits_buffer_status_;
@@ -4,7 +4,9 @@
  * @brief Accuracy and performance test for LDPC. The encoder is Agora's
  * avx2enc - unlike FlexRAN's encoder, avx2enc works with AVX2 (i.e., unlike
  * FlexRAN's encoder, avx2enc does not require AVX-512). The decoder is
- * FlexRAN's decoder, which supports AVX2.
+ * FlexRAN's decoder, which supports AVX2. The batched avx512enc encoder is
+ * checked against, and timed with, the single-codeblock encoder of the build
+ * (FlexRAN's with AVX-512).
  */
 
 #include <algorithm>
@@ -19,7 +21,7 @@
 #include "symbols.h"
 #include "utils_ldpc.h"
 
-static constexpr size_t kNumCodeBlocks = 2;
+static constexpr size_t kNumCodeBlocks = 8;
 static constexpr size_t kBaseGraph = 1;
 static constexpr bool kEnableEarlyTermination = false;
 static constexpr size_t kNumFillerBits = 0;
@@ -27,6 +29,59 @@ static constexpr size_t kMaxDecoderIters = 8;
 static constexpr size_t kK5GnrNumPunctured = 2;
 static constexpr size_t kNumRows = 46;
 
+// Time kNumCodeBlocks codeblocks through the build's encoder and avx512enc,
+// and return the number of parity bits that differ between the two
+static size_t CompareBatchEncoder(size_t zc, int8_t* const* input,
+                                  double freq_ghz) {
+  const size_t num_parity_bits = kNumRows * zc;
+  int8_t* ref_parity[kNumCodeBlocks];
+  int8_t* batch_parity[kNumCodeBlocks];
+  bblib_ldpc_encoder_5gnr_request req = {};
+  bblib_ldpc_encoder_5gnr_response ref_resp = {};
+  bblib_ldpc_encoder_5gnr_response batch_resp = {};
+  req.baseGraph = kBaseGraph;
+  req.Zc = zc;
+  req.nRows = kNumRows;
+  req.numberCodeblocks = kNumCodeBlocks;
+  for (size_t n = 0; n < kNumCodeBlocks; n++) {
+    ref_parity[n] = new int8_t[LdpcEncodingParityBufSize(kBaseGraph, zc)]();
+    batch_parity[n] = new int8_t[LdpcEncodingParityBufSize(kBaseGraph, zc)]();
+    req.input[n] = input[n];
+    ref_resp.output[n] = ref_parity[n];
+    batch_resp.output[n] = batch_parity[n];
+  }
+
+  const size_t ref_start_tsc = GetTime::Rdtsc();
+  kUseAVX2Encoder ? avx2enc::BblibLdpcEncoder5gnr(&req, &ref_resp)
+                  : bblib_ldpc_encoder_5gnr(&req, &ref_resp);
+  const double ref_us =
+      GetTime::CyclesToUs(GetTime::Rdtsc() - ref_start_tsc, freq_ghz);
+
+  const size_t batch_start_tsc = GetTime::Rdtsc();
+  avx512enc::BblibLdpcEncoder5gnr(&req, &batch_resp);
+  const double batch_us =
+      GetTime::CyclesToUs(GetTime::Rdtsc() - batch_start_tsc, freq_ghz);
+
+  size_t err_cnt = 0;
+  for (size_t n = 0; n < kNumCodeBlocks; n++) {
+    for (size_t i = 0; i < num_parity_bits; i++) {
+      err_cnt += ((ref_parity[n][i / 8] ^ batch_parity[n][i / 8]) >> (i % 8)) &
+                 1;
+    }
+    delete[] ref_parity[n];
+    delete[] batch_parity[n];
+  }
+
+  const size_t num_input_bits = LdpcNumInputBits(kBaseGraph, zc);
+  std::printf(
+      "Zc = %zu, encoding per core {%s, avx512enc}: {%.2f, %.2f} Mbps. "
+      "Parity bit mismatches = %zu\n",
+      zc, kUseAVX2Encoder ? "avx2enc" : "FlexRAN",
+      num_input_bits * kNumCodeBlocks / ref_us,
+      num_input_bits * kNumCodeBlocks / batch_us, err_cnt);
+  return err_cnt;
+}
+
 int main() {
   double freq_ghz = GetTime::MeasureRdtscFreq();
   std::printf("Spinning for one second for Turbo Boost\n");
@@ -45,6 +100,7 @@ int main() {
       56,  112, 224, 9,  18, 36,  72,  144, 288, 11,  22,  44, 88,
       176, 352, 13,  26, 52, 104, 208, 15,  30,  60,  120, 240};
   std::sort(zc_vec.begin(), zc_vec.end());
+  size_t batch_err_cnt = 0;
   for (const size_t& zc : zc_vec) {
     if (zc < LdpcGetMinZc() || zc > LdpcGetMaxZc()) {
       std::fprintf(stderr, "Zc value %zu not supported. Skipping.\n", zc);
@@ -77,6 +133,9 @@ int main() {
 
     const double encoding_us =
         GetTime::CyclesToUs(GetTime::Rdtsc() - encoding_start_tsc, freq_ghz);
+    if (zc <= avx2enc::kZcMax) {
+      batch_err_cnt += CompareBatchEncoder(zc, input, freq_ghz);
+    }
 
     // For decoding, generate log-likelihood ratios, one byte per input bit
     int8_t* llrs[kNumCodeBlocks];
@@ -156,5 +215,9 @@ int main() {
     std::free(ldpc_decoder_5gnr_response.varNodes);
   }
 
+  if (batch_err_cnt > 0) {
+    std::fprintf(stderr, "avx512enc parity differs from the reference\n");
+    return 1;
+  }
   return 0;
 }
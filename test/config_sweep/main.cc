@@ -0,0 +1,401 @@
+/**
+ * @file main.cc
+ * @brief Offline sweep of the compute configuration. Runs Agora's Doers on
+ * synthetic packets, without sockets, for every combination of the swept
+ * parameters and writes the fastest configuration as a config file.
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "agora_buffer.h"
+#include "agora_worker.h"
+#include "concurrent_queue_wrapper.h"
+#include "config.h"
+#include "gettime.h"
+#include "gflags/gflags.h"
+#include "logger.h"
+#include "message.h"
+#include "partial_transpose.h"
+#include "phy_stats.h"
+#include "stats.h"
+#include "utils.h"
+
+using json = nlohmann::json;
+
+DEFINE_string(
+    conf_file,
+    TOSTRING(PROJECT_DIRECTORY) "/files/config/ci/tddconfig-sim-ul.json",
+    "Base config filename");
+DEFINE_string(out_file,
+              TOSTRING(PROJECT_DIRECTORY) "/files/config/sweep-tuned.json",
+              "The fastest configuration is written to this file");
+DEFINE_string(worker_thread_num, "",
+              "Comma-separated worker thread counts to sweep");
+DEFINE_string(core_offset, "",
+              "Comma-separated core offsets (core layouts) to sweep");
+DEFINE_string(demul_block_size, "",
+              "Comma-separated demul and precode block sizes to sweep");
+DEFINE_string(beam_block_size, "",
+              "Comma-separated beamweight block sizes to sweep");
+DEFINE_string(fft_block_size, "", "Comma-separated FFT block sizes to sweep");
+DEFINE_string(beamforming, "",
+              "Comma-separated beamforming algorithms to sweep, e.g. ZF,MMSE");
+DEFINE_uint64(frames, 100, "Frames measured at each point");
+DEFINE_uint64(warmup_frames, 10, "Frames run before measuring each point");
+DEFINE_double(max_p99_us, 0,
+              "If positive, only points with a lower p99 frame latency are "
+              "eligible for the output");
+
+/// One swept config key, with the values to try
+struct SweepParam {
+  std::string key_;
+  std::vector<json> values_;
+};
+
+struct SweepResult {
+  double frames_per_sec_;
+  double mean_us_;
+  double p99_us_;
+};
+
+/// A task and the NUMA node whose queue it is scheduled to
+struct SweepTask {
+  EventData event_;
+  size_t node_;
+};
+
+static std::vector<json> ParseValues(const std::string& list, bool numeric) {
+  std::vector<json> values;
+  std::stringstream ss(list);
+  std::string value;
+  while (std::getline(ss, value, ',')) {
+    if (value.empty()) {
+      continue;
+    }
+    if (numeric) {
+      values.emplace_back(std::stoul(value));
+    } else {
+      values.emplace_back(value);
+    }
+  }
+  return values;
+}
+
+/// Tasks of [event_type] over the antennas of one symbol, in blocks of
+/// FftBlockSize() as Agora schedules them. FFT tags are the received packets
+/// of the symbol, in antenna order.
+static void AddAntennaTasks(const Config* cfg, const NumaPlan& numa_plan,
+                            EventType event_type, size_t frame_id,
+                            size_t symbol_id, RxPacket* rx_packets,
+                            std::vector<SweepTask>& tasks) {
+  for (size_t ant = 0; ant < cfg->BsAntNum(); ant += cfg->FftBlockSize()) {
+    SweepTask task;
+    task.event_.event_type_ = event_type;
+    task.event_.num_tags_ =
+        std::min(cfg->FftBlockSize(), cfg->BsAntNum() - ant);
+    task.node_ = numa_plan.AntNode(ant);
+    for (size_t i = 0; i < task.event_.num_tags_; i++) {
+      if (event_type == EventType::kFFT) {
+        rx_packets[ant + i].Use();
+        task.event_.tags_.at(i) = rx_tag_t(rx_packets[ant + i]).tag_;
+      } else {
+        task.event_.tags_.at(i) =
+            gen_tag_t::FrmSymAnt(frame_id, symbol_id, ant + i).tag_;
+      }
+    }
+    tasks.push_back(task);
+  }
+}
+
+/// Tasks of [event_type] over the subcarrier blocks of one symbol
+static void AddSubcarrierTasks(const Config* cfg, const NumaPlan& numa_plan,
+                               EventType event_type, size_t frame_id,
+                               size_t symbol_id,
+                               std::vector<SweepTask>& tasks) {
+  const bool beam = (event_type == EventType::kBeam);
+  const size_t block_size =
+      beam ? cfg->BeamBlockSize() : cfg->DemulBlockSize();
+  for (size_t sc = 0; sc < cfg->OfdmDataNum(); sc += block_size) {
+    const size_t tag = beam ? gen_tag_t::FrmSc(frame_id, sc).tag_
+                            : gen_tag_t::FrmSymSc(frame_id, symbol_id, sc).tag_;
+    tasks.push_back({EventData(event_type, tag), numa_plan.ScNode(sc)});
+  }
+}
+
+/// Tasks of [event_type] over the codeblocks of every UE in one symbol, in
+/// batches of EncodeBlockSize()
+static void AddCodeblockTasks(const Config* cfg, EventType event_type,
+                              Direction dir, size_t frame_id, size_t symbol_id,
+                              std::vector<SweepTask>& tasks) {
+  const size_t num_cbs =
+      cfg->UeAntNum() * cfg->LdpcConfig(dir).NumBlocksInSymbol();
+  for (size_t cb = 0; cb < num_cbs; cb += cfg->EncodeBlockSize()) {
+    SweepTask task;
+    task.event_.event_type_ = event_type;
+    task.event_.num_tags_ = std::min(cfg->EncodeBlockSize(), num_cbs - cb);
+    task.node_ = 0;
+    for (size_t i = 0; i < task.event_.num_tags_; i++) {
+      task.event_.tags_.at(i) =
+          gen_tag_t::FrmSymCb(frame_id, symbol_id, cb + i).tag_;
+    }
+    tasks.push_back(task);
+  }
+}
+
+/// Schedule [tasks] and wait until the workers complete all of them
+static void RunStage(MessageInfo* message, AgoraWorker* workers, size_t qid,
+                     const std::vector<SweepTask>& tasks) {
+  for (const auto& task : tasks) {
+    const EventType event_type = task.event_.event_type_;
+    TryEnqueueFallback(message->GetConq(event_type, qid, task.node_),
+                       message->GetPtok(event_type, qid, task.node_),
+                       task.event_);
+  }
+  workers->Notify();
+  size_t num_done = 0;
+  EventData event;
+  while (num_done < tasks.size()) {
+    if (message->GetCompQueue(qid).try_dequeue(event)) {
+      num_done++;
+    }
+  }
+}
+
+/// Run one frame as four stages: FFT and encoding, beamweights, demul and
+/// precoding, then decoding and IFFT. Each stage waits for the previous one,
+/// so the frame latency is the compute critical path.
+static void RunFrame(const Config* cfg, AgoraBuffer* buffer,
+                     MessageInfo* message, AgoraWorker* workers,
+                     size_t frame_id, std::vector<Packet*>& packets,
+                     std::vector<RxPacket>& rx_packets) {
+  const auto& frame = cfg->Frame();
+  const auto& numa_plan = buffer->GetNumaPlan();
+  const size_t qid = frame_id & 0x1;
+  std::vector<SweepTask> tasks;
+
+  for (auto* packet : packets) {
+    packet->frame_id_ = frame_id;
+  }
+  const size_t num_fft_syms = frame.NumPilotSyms() + frame.NumULSyms();
+  for (size_t i = 0; i < num_fft_syms; i++) {
+    AddAntennaTasks(cfg, numa_plan, EventType::kFFT, frame_id, 0,
+                    &rx_packets.at(i * cfg->BsAntNum()), tasks);
+  }
+  for (size_t i = frame.ClientDlPilotSymbols(); i < frame.NumDLSyms(); i++) {
+    AddCodeblockTasks(cfg, EventType::kEncode, Direction::kDownlink, frame_id,
+                      frame.GetDLSymbol(i), tasks);
+  }
+  RunStage(message, workers, qid, tasks);
+
+  tasks.clear();
+  AddSubcarrierTasks(cfg, numa_plan, EventType::kBeam, frame_id, 0, tasks);
+  RunStage(message, workers, qid, tasks);
+  buffer->GetBeamCompletion().MarkComplete(frame_id);
+
+  tasks.clear();
+  for (size_t i = 0; i < frame.NumULSyms(); i++) {
+    AddSubcarrierTasks(cfg, numa_plan, EventType::kDemul, frame_id,
+                       frame.GetULSymbol(i), tasks);
+  }
+  for (size_t i = 0; i < frame.NumDLSyms(); i++) {
+    if (cfg->FusedPrecodeIfft()) {
+      AddAntennaTasks(cfg, numa_plan, EventType::kIFFT, frame_id,
+                      frame.GetDLSymbol(i), nullptr, tasks);
+    } else {
+      AddSubcarrierTasks(cfg, numa_plan, EventType::kPrecode, frame_id,
+                         frame.GetDLSymbol(i), tasks);
+    }
+  }
+  RunStage(message, workers, qid, tasks);
+
+  tasks.clear();
+  for (size_t i = 0; (i < frame.NumULSyms()) && !kUplinkHardDemod; i++) {
+    AddCodeblockTasks(cfg, EventType::kDecode, Direction::kUplink, frame_id,
+                      frame.GetULSymbol(i), tasks);
+  }
+  for (size_t i = 0; (i < frame.NumDLSyms()) && !cfg->FusedPrecodeIfft();
+       i++) {
+    AddAntennaTasks(cfg, numa_plan, EventType::kIFFT, frame_id,
+                    frame.GetDLSymbol(i), nullptr, tasks);
+  }
+  if (!tasks.empty()) {
+    RunStage(message, workers, qid, tasks);
+  }
+}
+
+/// Measure the configuration in [point_file]
+static SweepResult RunPoint(const std::string& point_file) {
+  auto cfg = std::make_unique<Config>(point_file);
+  cfg->GenData();
+  // As in Agora, before the workers create their Doers
+  Agora_transpose::ResolveBlockSize(cfg.get());
+  const auto& frame = cfg->Frame();
+  auto stats = std::make_unique<Stats>(cfg.get());
+  auto phy_stats = std::make_unique<PhyStats>(cfg.get(), Direction::kUplink);
+  auto buffer = std::make_unique<AgoraBuffer>(cfg.get());
+  auto message = std::make_unique<MessageInfo>(
+      kDefaultWorkerQueueSize * frame.NumDataSyms(),
+      buffer->GetNumaPlan().NumNodes());
+  FrameInfo frame_info{0, 0};
+
+  // Random samples for every antenna of the pilot and uplink symbols
+  const size_t num_fft_syms = frame.NumPilotSyms() + frame.NumULSyms();
+  const size_t num_samples =
+      (cfg->PacketLength() - Packet::kOffsetOfData) / sizeof(short);
+  Table<char> packet_buffer;
+  packet_buffer.Calloc(num_fft_syms * cfg->BsAntNum(), cfg->PacketLength(),
+                       Agora_memory::Alignment_t::kAlign64);
+  std::vector<Packet*> packets;
+  std::vector<RxPacket> rx_packets(num_fft_syms * cfg->BsAntNum());
+  for (size_t i = 0; i < num_fft_syms; i++) {
+    const size_t symbol_id = (i < frame.NumPilotSyms())
+                                 ? frame.GetPilotSymbol(i)
+                                 : frame.GetULSymbol(i - frame.NumPilotSyms());
+    for (size_t ant = 0; ant < cfg->BsAntNum(); ant++) {
+      auto* packet = new (packet_buffer[packets.size()])
+          Packet(0, symbol_id, 0, ant);
+      for (size_t j = 0; j < num_samples; j++) {
+        packet->data_[j] = static_cast<short>((std::rand() % 4096) - 2048);
+      }
+      rx_packets.at(packets.size()).Set(packet);
+      packets.push_back(packet);
+    }
+  }
+
+  PinToCoreWithOffset(ThreadType::kMaster, cfg->CoreOffset(), 0,
+                      kEnableCoreReuse);
+  auto workers = std::make_unique<AgoraWorker>(cfg.get(), stats.get(),
+                                               phy_stats.get(), message.get(),
+                                               buffer.get(), &frame_info);
+  std::vector<double> latencies_us;
+  const size_t start_tsc = GetTime::Rdtsc();
+  size_t measure_tsc = start_tsc;
+  for (size_t frame_id = 0; frame_id < FLAGS_warmup_frames + FLAGS_frames;
+       frame_id++) {
+    frame_info.cur_sche_frame_id_ = frame_id;
+    frame_info.cur_proc_frame_id_ = frame_id;
+    if (frame_id == FLAGS_warmup_frames) {
+      measure_tsc = GetTime::Rdtsc();
+    }
+    const size_t frame_tsc = GetTime::Rdtsc();
+    RunFrame(cfg.get(), buffer.get(), message.get(), workers.get(), frame_id,
+             packets, rx_packets);
+    if (frame_id >= FLAGS_warmup_frames) {
+      latencies_us.push_back(
+          GetTime::CyclesToUs(GetTime::Rdtsc() - frame_tsc, cfg->FreqGhz()));
+    }
+  }
+  const double total_us =
+      GetTime::CyclesToUs(GetTime::Rdtsc() - measure_tsc, cfg->FreqGhz());
+  cfg->Running(false);
+  workers.reset();
+  ClearCoreAssignments();
+  packet_buffer.Free();
+
+  SweepResult result;
+  std::sort(latencies_us.begin(), latencies_us.end());
+  result.frames_per_sec_ = latencies_us.size() * 1e6 / total_us;
+  result.mean_us_ = 0;
+  for (const double latency_us : latencies_us) {
+    result.mean_us_ += latency_us / latencies_us.size();
+  }
+  const size_t p99_idx = static_cast<size_t>(
+      std::ceil(0.99 * static_cast<double>(latencies_us.size())));
+  result.p99_us_ = latencies_us.at(std::max<size_t>(p99_idx, 1) - 1);
+  return result;
+}
+
+int main(int argc, char* argv[]) {
+  gflags::SetUsageMessage(
+      "conf_file : base configuration, out_file : tuned configuration, "
+      "and comma-separated lists of the parameters to sweep");
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  AGORA_LOG_INIT();
+  RtAssert(FLAGS_frames > 0, "At least one frame must be measured");
+
+  std::string conf;
+  Utils::LoadTddConfig(FLAGS_conf_file, conf);
+  // Allow json comments
+  const json base_conf = json::parse(conf, nullptr, true, true);
+
+  // Parameters without values keep the base configuration's
+  std::vector<SweepParam> params = {
+      {"worker_thread_num", ParseValues(FLAGS_worker_thread_num, true)},
+      {"core_offset", ParseValues(FLAGS_core_offset, true)},
+      {"demul_block_size", ParseValues(FLAGS_demul_block_size, true)},
+      {"beam_block_size", ParseValues(FLAGS_beam_block_size, true)},
+      {"fft_block_size", ParseValues(FLAGS_fft_block_size, true)},
+      {"beamforming", ParseValues(FLAGS_beamforming, false)}};
+  params.erase(std::remove_if(params.begin(), params.end(),
+                              [](const SweepParam& param) {
+                                return param.values_.empty();
+                              }),
+               params.end());
+
+  // The Config is built from a file, so every point is written next to the
+  // output first
+  const std::string point_file = FLAGS_out_file + ".point";
+  json best_conf;
+  double best_frames_per_sec = 0;
+  std::vector<size_t> value_idx(params.size(), 0);
+  bool done = false;
+  while (done == false) {
+    json point_conf = base_conf;
+    std::string label;
+    for (size_t i = 0; i < params.size(); i++) {
+      const json& value = params.at(i).values_.at(value_idx.at(i));
+      point_conf[params.at(i).key_] = value;
+      label += params.at(i).key_ + "=" + value.dump() + " ";
+    }
+    std::ofstream(point_file) << point_conf.dump(2) << std::endl;
+
+    try {
+      const SweepResult result = RunPoint(point_file);
+      std::printf(
+          "Sweep: %s: %.1f frames/s, mean %.1f us, p99 %.1f us frame "
+          "latency\n",
+          label.c_str(), result.frames_per_sec_, result.mean_us_,
+          result.p99_us_);
+      if ((result.frames_per_sec_ > best_frames_per_sec) &&
+          ((FLAGS_max_p99_us <= 0) || (result.p99_us_ < FLAGS_max_p99_us))) {
+        best_frames_per_sec = result.frames_per_sec_;
+        best_conf = point_conf;
+      }
+    } catch (const std::runtime_error& e) {
+      std::printf("Sweep: %s: skipped, %s\n", label.c_str(), e.what());
+    }
+
+    // Next combination, the last parameter changing fastest
+    done = true;
+    for (size_t i = params.size(); (i > 0) && done; i--) {
+      value_idx.at(i - 1)++;
+      if (value_idx.at(i - 1) < params.at(i - 1).values_.size()) {
+        done = false;
+      } else {
+        value_idx.at(i - 1) = 0;
+      }
+    }
+  }
+  std::remove(point_file.c_str());
+
+  int ret = EXIT_SUCCESS;
+  if (best_conf.is_null()) {
+    std::printf("Sweep: no point met the requirements\n");
+    ret = EXIT_FAILURE;
+  } else {
+    std::ofstream(FLAGS_out_file) << best_conf.dump(2) << std::endl;
+    std::printf("Sweep: wrote %s (%.1f frames/s)\n", FLAGS_out_file.c_str(),
+                best_frames_per_sec);
+  }
+  gflags::ShutDownCommandLineFlags();
+  AGORA_LOG_SHUTDOWN();
+  return ret;
+}
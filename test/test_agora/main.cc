@@ -1,3 +1,4 @@
+#include <fstream>
 #include <string>
 
 #include "agora.h"
@@ -54,7 +55,8 @@ static void ReadFromFileDl(const std::string& filename, Table<short>& data,
                (ofdm_size * 2), sizeof(short));
 }
 
-static unsigned int CheckCorrectnessUl(Config const* const cfg) {
+/// Returns the byte error count, and the bit error rate in [ber]
+static unsigned int CheckCorrectnessUl(Config const* const cfg, double& ber) {
   int ue_num = cfg->UeAntNum();
   int num_uplink_syms = cfg->Frame().NumULSyms();
   int ofdm_data_num = cfg->OfdmDataNum();
@@ -84,6 +86,7 @@ static unsigned int CheckCorrectnessUl(Config const* const cfg) {
 
   unsigned int error_cnt = 0;
   unsigned int total_count = 0;
+  size_t bit_error_cnt = 0;
   for (int i = 0; i < num_uplink_syms; i++) {
     if (i >= ul_pilot_syms) {
       for (int ue = 0; ue < ue_num; ue++) {
@@ -93,6 +96,8 @@ static unsigned int CheckCorrectnessUl(Config const* const cfg) {
           int offset_in_output = num_bytes_per_ue * ue + j;
           if (raw_data[i][offset_in_raw] != output_data[i][offset_in_output]) {
             error_cnt++;
+            bit_error_cnt += __builtin_popcount(
+                raw_data[i][offset_in_raw] ^ output_data[i][offset_in_output]);
             if (kDebugPrintUlCorr) {
               std::printf("(%d, %d, %u, %u)\n", i, j,
                           raw_data[i][offset_in_raw],
@@ -103,6 +108,11 @@ static unsigned int CheckCorrectnessUl(Config const* const cfg) {
       }  //  for (int ue = 0; ue < ue_num; ue++)
     }    // if (i >= ul_pilot_syms)
   }      // for (int i = 0; i < num_uplink_syms; i++)
+  ber = (total_count == 0)
+            ? 0.0
+            : static_cast<double>(bit_error_cnt) / (8.0 * total_count);
+  std::printf("check_correctness_ul: %zu bit errors, BER %.3e\n",
+              bit_error_cnt, ber);
 
   raw_data.Free();
   output_data.Free();
@@ -166,10 +176,11 @@ unsigned int CheckCorrectnessDl(Config const* const cfg) {
   return error_cnt;
 }
 
-static unsigned int CheckCorrectness(Config const* const cfg) {
+static unsigned int CheckCorrectness(Config const* const cfg,
+                                     double& ul_ber) {
   unsigned int ul_error_count = 0;
   unsigned int dl_error_count = 0;
-  ul_error_count = CheckCorrectnessUl(cfg);
+  ul_error_count = CheckCorrectnessUl(cfg, ul_ber);
   std::printf("Uplink error count: %d\n", ul_error_count);
   dl_error_count = CheckCorrectnessDl(cfg);
   std::printf("Downlink error count: %d\n", dl_error_count);
@@ -180,6 +191,27 @@ DEFINE_string(
     conf_file,
     TOSTRING(PROJECT_DIRECTORY) "/files/config/ci/tddconfig-sim-both.json",
     "Config filename");
+DEFINE_string(ul_ber_out, "",
+              "Write the uplink BER of this run to this file");
+DEFINE_string(ul_ber_ref, "",
+              "Compare the uplink BER against the one in this file, written "
+              "by a float run with --ul_ber_out");
+DEFINE_double(ul_ber_margin, 1e-3,
+              "Uplink BER above the --ul_ber_ref BER that still passes");
+
+/// Compare [ul_ber] against the reference BER in --ul_ber_ref
+static bool CheckUlBerAgainstReference(double ul_ber) {
+  std::ifstream ref_file(FLAGS_ul_ber_ref);
+  double ref_ber;
+  if (!(ref_file >> ref_ber)) {
+    AGORA_LOG_ERROR("Read reference BER failed: %s\n",
+                    FLAGS_ul_ber_ref.c_str());
+    return false;
+  }
+  std::printf("Uplink BER %.3e, reference BER %.3e, margin %.3e\n", ul_ber,
+              ref_ber, FLAGS_ul_ber_margin);
+  return ul_ber <= ref_ber + FLAGS_ul_ber_margin;
+}
 
 int main(int argc, char* argv[]) {
   std::string conf_file;
@@ -210,17 +242,18 @@ int main(int argc, char* argv[]) {
 
     std::printf("Start correctness check\n");
     unsigned int error_count = 0;
+    double ul_ber = 0;
     std::string test_name;
 
     if ((cfg->Frame().NumDLSyms() > 0) && (cfg->Frame().NumULSyms() > 0)) {
       test_name = "combined";
-      error_count = CheckCorrectness(cfg.get());
+      error_count = CheckCorrectness(cfg.get(), ul_ber);
     } else if (cfg->Frame().NumDLSyms() > 0) {
       test_name = "downlink";
       error_count = CheckCorrectnessDl(cfg.get());
     } else if (cfg->Frame().NumULSyms() > 0) {
       test_name = "uplink";
-      error_count = CheckCorrectnessUl(cfg.get());
+      error_count = CheckCorrectnessUl(cfg.get(), ul_ber);
     } else {
       // Should never happen
       assert(false);
@@ -236,6 +269,19 @@ int main(int argc, char* argv[]) {
     }
     std::printf("======================\n\n");
 
+    if (cfg->Frame().NumULSyms() > 0) {
+      if (!FLAGS_ul_ber_out.empty()) {
+        std::ofstream(FLAGS_ul_ber_out) << ul_ber << std::endl;
+      }
+      if (!FLAGS_ul_ber_ref.empty()) {
+        if (CheckUlBerAgainstReference(ul_ber)) {
+          std::printf("Passed uplink BER comparison test!\n");
+        } else {
+          std::printf("Failed uplink BER comparison test!\n");
+        }
+      }
+    }
+
     ret = EXIT_SUCCESS;
   } catch (SignalException& e) {
     std::cerr << "SignalException: " << e.what() << std::endl;
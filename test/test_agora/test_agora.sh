@@ -18,6 +18,7 @@ for exe in ${exe_list}; do
 done
 
 num_iters=1
+ul_ber_file=/tmp/agora_ul_float_ber.txt
 out_file=/dev/stdout
 
 # Check if the user supplied a number-of-iterations argument
@@ -43,11 +44,14 @@ analyse_out() {
   n_downlink_failed=`cat ${out_file} | grep -i "Failed downlink test" | wc -l`
   n_combined_passed=`cat ${out_file} | grep -i "Passed combined test" | wc -l`
   n_combined_failed=`cat ${out_file} | grep -i "Failed combined test" | wc -l`
+  n_ber_passed=`cat ${out_file} | grep -i "Passed uplink BER comparison test" | wc -l`
+  n_ber_failed=`cat ${out_file} | grep -i "Failed uplink BER comparison test" | wc -l`
 
   >&2 echo "Iteration $i/${num_iters}: Uplink: ${n_uplink_passed} passed,"\
     "${n_uplink_failed} failed. Downlink: ${n_downlink_passed} passed,"\
     "${n_downlink_failed} failed. Combined: ${n_combined_passed} passed,"\
-    "${n_combined_failed} failed. Listing up to ${max_errs} errors:"
+    "${n_combined_failed} failed. Fixed-point BER: ${n_ber_passed} passed,"\
+    "${n_ber_failed} failed. Listing up to ${max_errs} errors:"
 
   # Print any errors or warnings
   cat ${out_file} | grep "WARNG" | head -${max_errs}
@@ -69,10 +73,19 @@ for i in `seq 1 $num_iters`; do
     echo "Running uplink correctness test $i......"
     echo -e "===========================================\n"
     # We sleep before starting the sender to allow the Agora server to start
-    ./build/test_agora --conf_file ${input_filepath}/tddconfig-correctness-test-ul.json &
+    ./build/test_agora --conf_file ${input_filepath}/tddconfig-correctness-test-ul.json --ul_ber_out ${ul_ber_file} &
     sleep 1; ./build/sender --num_threads 1 --core_offset 10 --conf_file ${input_filepath}/tddconfig-correctness-test-ul.json
     wait
 
+    echo "==========================================="
+    echo "Running fixed-point uplink correctness test $i......"
+    echo -e "===========================================\n"
+    # The fixed-point BER must stay within the margin of the float run's BER
+    ./build/test_agora --conf_file ${input_filepath}/tddconfig-correctness-test-ul-fixed.json --ul_ber_ref ${ul_ber_file} &
+    sleep 1; ./build/sender --num_threads 1 --core_offset 10 --conf_file ${input_filepath}/tddconfig-correctness-test-ul-fixed.json
+    echo -e "-------------------------------------------------------\n\n\n"
+    wait
+
     echo "==========================================="
     echo "Generating data for downlink correctness test $i......"
     echo -e "===========================================\n"
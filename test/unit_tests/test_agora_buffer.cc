@@ -0,0 +1,75 @@
+/**
+ * @file test_agora_buffer.cc
+ * @brief Unit tests for the runtime sized frame window of AgoraBuffer
+ */
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "agora_buffer.h"
+#include "config.h"
+#include "nlohmann/json.hpp"
+
+static const std::string kBaseConfig = "files/config/ci/tddconfig-sim-ul.json";
+
+/// Write the base config with "frame_window" set to [frame_window]
+static std::string WriteConfig(size_t frame_window) {
+  std::ifstream base(kBaseConfig);
+  std::stringstream conf;
+  conf << base.rdbuf();
+  auto tdd_conf = nlohmann::json::parse(conf.str(), nullptr, true, true);
+  tdd_conf["frame_window"] = frame_window;
+
+  const std::string filename = testing::TempDir() + "frame_window_" +
+                               std::to_string(frame_window) + ".json";
+  std::ofstream(filename) << tdd_conf.dump();
+  return filename;
+}
+
+/// The default window is used as is, without rounding
+TEST(AgoraBuffer, DefaultFrameWindow) {
+  auto cfg = std::make_unique<Config>(kBaseConfig);
+  ASSERT_EQ(cfg->FrameWnd(), kDefaultFrameWnd);
+}
+
+TEST(AgoraBuffer, FrameWindowRoundsToPowerOfTwo) {
+  auto cfg = std::make_unique<Config>(WriteConfig(20));
+  ASSERT_EQ(cfg->FrameWnd(), 32u);
+  ASSERT_EQ(cfg->FrameSlot(31), 31u);
+  ASSERT_EQ(cfg->FrameSlot(32), 0u);
+  ASSERT_EQ(cfg->FrameSlot(100), 100u % 32);
+}
+
+/// Every frame-indexed buffer scales with the window, so the footprint of a
+/// 32 frame window is exactly 4x that of an 8 frame window
+TEST(AgoraBuffer, MemoryScalesWithFrameWindow) {
+  auto cfg_small = std::make_unique<Config>(WriteConfig(8));
+  auto cfg_large = std::make_unique<Config>(WriteConfig(32));
+  ASSERT_EQ(cfg_small->FrameWnd(), 8u);
+  ASSERT_EQ(cfg_large->FrameWnd(), 32u);
+
+  size_t small_bytes;
+  size_t large_bytes;
+  {
+    auto buffer = std::make_unique<AgoraBuffer>(cfg_small.get());
+    small_bytes = buffer->MemoryBytes();
+  }
+  {
+    auto buffer = std::make_unique<AgoraBuffer>(cfg_large.get());
+    large_bytes = buffer->MemoryBytes();
+  }
+  std::printf("AgoraBuffer: %.1f MiB (8 frames) vs %.1f MiB (32 frames)\n",
+              static_cast<double>(small_bytes) / (1 << 20),
+              static_cast<double>(large_bytes) / (1 << 20));
+  ASSERT_GT(small_bytes, 0u);
+  ASSERT_EQ(large_bytes, 4 * small_bytes);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
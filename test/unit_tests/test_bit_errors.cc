@@ -0,0 +1,102 @@
+/**
+ * @file test_bit_errors.cc
+ * @brief Unit tests for the block bit and byte error counting
+ */
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "bit_errors.h"
+#include "gettime.h"
+
+static constexpr size_t kMaxNumBytes = 300;
+// Bytes of one maximum size (8448-bit) codeblock
+static constexpr size_t kNumTimedBytes = 8448 / 8;
+static constexpr size_t kNumTimedRuns = 10000;
+
+/// The per-byte, per-bit loop that CountBitErrors replaces
+static size_t CountBitErrorsByByte(const uint8_t* tx_bytes,
+                                   const uint8_t* rx_bytes, size_t num_bytes,
+                                   size_t& byte_errors) {
+  size_t bit_errors = 0;
+  byte_errors = 0;
+  for (size_t i = 0; i < num_bytes; i++) {
+    uint8_t xor_byte = tx_bytes[i] ^ rx_bytes[i];
+    if (xor_byte != 0) {
+      byte_errors++;
+    }
+    for (size_t j = 0; j < 8; j++) {
+      bit_errors += (xor_byte & 1);
+      xor_byte >>= 1;
+    }
+  }
+  return bit_errors;
+}
+
+TEST(BitErrors, matches_byte_loop) {
+  std::mt19937 gen(0);
+  std::vector<uint8_t> tx(kMaxNumBytes);
+  std::vector<uint8_t> rx(kMaxNumBytes);
+  for (auto& byte : tx) {
+    byte = static_cast<uint8_t>(gen());
+  }
+  // Sparse and dense errors
+  for (const double error_prob : {0.0, 0.01, 0.2, 1.0}) {
+    std::bernoulli_distribution flip(error_prob);
+    for (size_t i = 0; i < kMaxNumBytes; i++) {
+      rx[i] = tx[i];
+      for (size_t j = 0; j < 8; j++) {
+        if (flip(gen)) {
+          rx[i] ^= (1u << j);
+        }
+      }
+    }
+    for (size_t len = 0; len <= kMaxNumBytes; len++) {
+      size_t byte_errors;
+      size_t expect_byte_errors;
+      const size_t bit_errors =
+          CountBitErrors(tx.data(), rx.data(), len, byte_errors);
+      ASSERT_EQ(bit_errors, CountBitErrorsByByte(tx.data(), rx.data(), len,
+                                                 expect_byte_errors))
+          << "Bit errors differ for " << len << " bytes";
+      ASSERT_EQ(byte_errors, expect_byte_errors)
+          << "Byte errors differ for " << len << " bytes";
+    }
+  }
+}
+
+TEST(BitErrors, cycles_per_codeblock) {
+  std::mt19937 gen(1);
+  std::vector<uint8_t> tx(kNumTimedBytes);
+  std::vector<uint8_t> rx(kNumTimedBytes);
+  for (size_t i = 0; i < kNumTimedBytes; i++) {
+    tx[i] = static_cast<uint8_t>(gen());
+    rx[i] = static_cast<uint8_t>(gen());
+  }
+
+  size_t byte_errors;
+  size_t sum = 0;
+  size_t start_tsc = GetTime::Rdtsc();
+  for (size_t i = 0; i < kNumTimedRuns; i++) {
+    sum += CountBitErrorsByByte(tx.data(), rx.data(), kNumTimedBytes,
+                                byte_errors);
+  }
+  const size_t byte_loop_cycles = GetTime::Rdtsc() - start_tsc;
+  start_tsc = GetTime::Rdtsc();
+  for (size_t i = 0; i < kNumTimedRuns; i++) {
+    sum -= CountBitErrors(tx.data(), rx.data(), kNumTimedBytes, byte_errors);
+  }
+  const size_t popcount_cycles = GetTime::Rdtsc() - start_tsc;
+
+  std::printf("Bit errors of %zu bytes: %.1f cycles (byte loop %.1f)\n",
+              kNumTimedBytes, static_cast<double>(popcount_cycles) / kNumTimedRuns,
+              static_cast<double>(byte_loop_cycles) / kNumTimedRuns);
+  ASSERT_EQ(sum, 0u);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
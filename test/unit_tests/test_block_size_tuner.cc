@@ -0,0 +1,127 @@
+/**
+ * @file test_block_size_tuner.cc
+ * @brief Unit tests for the online block size tuner
+ */
+
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <memory>
+#include <thread>
+
+#include "block_size_tuner.h"
+#include "config.h"
+#include "stats.h"
+
+static constexpr size_t kFramesPerTrial = 4;
+static constexpr size_t kMaxFrames = 1000;
+
+/// Complete frames with the latency [latency_us] gives for the running
+/// block sizes, applying every change right away, until the tuner is done
+static BlockSizes RunTuner(
+    Config* cfg, const std::function<double(const BlockSizes&)>& latency_us) {
+  auto stats = std::make_unique<Stats>(cfg);
+  BlockSizeTuner tuner(cfg, stats.get(), kFramesPerTrial);
+  BlockSizes running = tuner.Pending();
+  for (size_t frame_id = 0; frame_id < kMaxFrames; frame_id++) {
+    if (tuner.FrameDone(frame_id, latency_us(running))) {
+      running = tuner.Pending();
+      tuner.Applied(frame_id + 1);
+    }
+    if (tuner.Done()) {
+      break;
+    }
+  }
+  EXPECT_TRUE(tuner.Done());
+
+  // Every knob is measured at each of its candidates
+  size_t num_trials = 1;
+  for (size_t knob = 0; knob < BlockSizeTuner::kNumKnobs; knob++) {
+    const auto& candidates =
+        tuner.Candidates(static_cast<BlockSizeTuner::Knob>(knob));
+    EXPECT_FALSE(candidates.empty());
+    num_trials += candidates.size() - 1;
+  }
+  EXPECT_EQ(tuner.Trace().size(), num_trials);
+  return running;
+}
+
+TEST(BlockSizeTuner, ConvergesToFastestSizes) {
+  auto cfg = std::make_unique<Config>("files/config/ci/tddconfig-sim-ul.json");
+  const BlockSizes configured = {cfg->DemulBlockSize(), cfg->BeamBlockSize(),
+                                 cfg->FftBlockSize(), cfg->EncodeBlockSize()};
+
+  // Smaller blocks are always faster here
+  const BlockSizes best = RunTuner(cfg.get(), [](const BlockSizes& sizes) {
+    return 1000.0 + sizes.demul_ + sizes.beam_ + sizes.fft_ + sizes.encode_;
+  });
+  auto stats = std::make_unique<Stats>(cfg.get());
+  const BlockSizeTuner tuner(cfg.get(), stats.get(), kFramesPerTrial);
+  ASSERT_EQ(best.demul_,
+            tuner.Candidates(BlockSizeTuner::Knob::kDemul).back());
+  ASSERT_EQ(best.beam_, tuner.Candidates(BlockSizeTuner::Knob::kBeam).back());
+  ASSERT_EQ(best.fft_, tuner.Candidates(BlockSizeTuner::Knob::kFft).back());
+  ASSERT_EQ(best.encode_,
+            tuner.Candidates(BlockSizeTuner::Knob::kEncode).back());
+  ASSERT_LE(best.demul_, configured.demul_);
+  ASSERT_EQ(best.demul_ % kSCsPerCacheline, 0u);
+  ASSERT_EQ(cfg->BsAntNum() % best.fft_, 0u);
+}
+
+TEST(BlockSizeTuner, KeepsConfiguredSizesWhenFastest) {
+  auto cfg = std::make_unique<Config>("files/config/ci/tddconfig-sim-ul.json");
+  const BlockSizes configured = {cfg->DemulBlockSize(), cfg->BeamBlockSize(),
+                                 cfg->FftBlockSize(), cfg->EncodeBlockSize()};
+
+  const BlockSizes best =
+      RunTuner(cfg.get(), [&configured](const BlockSizes& sizes) {
+        return 1000.0 + (configured.demul_ - sizes.demul_) +
+               (configured.beam_ - sizes.beam_) +
+               (configured.fft_ - sizes.fft_) +
+               (configured.encode_ - sizes.encode_);
+      });
+  ASSERT_EQ(best.demul_, configured.demul_);
+  ASSERT_EQ(best.beam_, configured.beam_);
+  ASSERT_EQ(best.fft_, configured.fft_);
+  ASSERT_EQ(best.encode_, configured.encode_);
+}
+
+/// The tuner and the elastic worker count read the task totals of running
+/// workers through the published copy, which only moves forward and ends
+/// at the worker's own totals
+TEST(BlockSizeTuner, ReadsPublishedTaskStats) {
+  static constexpr size_t kNumTasks = 100000;
+  static constexpr size_t kTid = 1;
+  auto cfg = std::make_unique<Config>("files/config/ci/tddconfig-sim-ul.json");
+  auto stats = std::make_unique<Stats>(cfg.get());
+
+  std::thread worker([&stats]() {
+    DurationStat* stat = stats->GetDurationStat(DoerType::kDemul, kTid);
+    for (size_t i = 0; i < kNumTasks; i++) {
+      stat->task_count_++;
+      stat->task_duration_[0] += 2;
+      stats->PublishTaskStats(kTid);
+    }
+  });
+  size_t count = 0;
+  size_t cycles = 0;
+  bool monotonic = true;
+  while (monotonic && (count < kNumTasks)) {
+    size_t new_count;
+    size_t new_cycles;
+    stats->PublishedTaskStats(DoerType::kDemul, kTid, new_count, new_cycles);
+    monotonic = (new_count >= count) && (new_cycles >= cycles);
+    count = new_count;
+    cycles = new_cycles;
+  }
+  worker.join();
+  ASSERT_TRUE(monotonic);
+  stats->PublishedTaskStats(DoerType::kDemul, kTid, count, cycles);
+  ASSERT_EQ(count, kNumTasks);
+  ASSERT_EQ(cycles, 2 * kNumTasks);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,181 @@
+/**
+ * @file test_core_layout.cc
+ * @brief Unit tests for the core layout planner on fake sysfs trees
+ */
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "core_layout.h"
+
+/// A sysfs tree in a temporary directory, removed with the object
+class FakeSysfs {
+ public:
+  FakeSysfs()
+      : root_(std::filesystem::temp_directory_path() /
+              ("agora_sysfs_" + std::to_string(getpid()) + "_" +
+               std::to_string(num_trees_++))) {}
+  ~FakeSysfs() { std::filesystem::remove_all(root_); }
+
+  void Write(const std::string& path, const std::string& value) {
+    const auto file = root_ / path;
+    std::filesystem::create_directories(file.parent_path());
+    std::ofstream(file) << value << "\n";
+  }
+
+  /// [num_nodes] nodes of [cores_per_node] cores with [smt] threads each,
+  /// numbered like Linux: the first threads of all cores, then the second
+  void AddCpus(size_t num_nodes, size_t cores_per_node, size_t smt) {
+    const size_t num_cores = num_nodes * cores_per_node;
+    std::map<size_t, std::string> node_lists;
+    for (size_t cpu = 0; cpu < num_cores * smt; cpu++) {
+      const size_t core = cpu % num_cores;
+      const size_t node = core / cores_per_node;
+      const std::string dir =
+          "devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+      Write(dir + "physical_package_id", std::to_string(node));
+      Write(dir + "core_id", std::to_string(core % cores_per_node));
+      node_lists[node] += (node_lists[node].empty() ? "" : ",") +
+                          std::to_string(cpu);
+    }
+    Write("devices/system/cpu/online",
+          "0-" + std::to_string(num_cores * smt - 1));
+    for (const auto& [node, list] : node_lists) {
+      Write("devices/system/node/node" + std::to_string(node) + "/cpulist",
+            list);
+    }
+  }
+
+  inline std::string Root() const { return root_.string(); }
+
+ private:
+  static size_t num_trees_;
+  std::filesystem::path root_;
+};
+size_t FakeSysfs::num_trees_ = 0;
+
+/// Every planned CPU sits at its core index, and no two threads without
+/// the shared flag share a physical core
+static void CheckPlan(const CpuTopology& topology, const CoreLayoutPlan& plan,
+                      size_t core_offset) {
+  std::map<size_t, std::pair<size_t, size_t>> cores;
+  for (const auto& cpu : topology.Cpus()) {
+    cores[cpu.id_] = {cpu.package_, cpu.core_};
+  }
+  std::set<std::pair<size_t, size_t>> exclusive;
+  for (size_t i = 0; i < plan.Assignments().size(); i++) {
+    const auto& assignment = plan.Assignments().at(i);
+    ASSERT_EQ(plan.Layout().at(core_offset + i), assignment.cpu_);
+    if (assignment.shared_ == false) {
+      ASSERT_TRUE(exclusive.insert(cores.at(assignment.cpu_)).second);
+    }
+  }
+}
+
+TEST(CoreLayout, ParseCpuList) {
+  ASSERT_EQ(CpuTopology::ParseCpuList("0-3,8,10-11"),
+            std::vector<size_t>({0, 1, 2, 3, 8, 10, 11}));
+  ASSERT_EQ(CpuTopology::ParseCpuList("5"), std::vector<size_t>({5}));
+  ASSERT_TRUE(CpuTopology::ParseCpuList("").empty());
+}
+
+TEST(CoreLayout, ReadsSysfs) {
+  FakeSysfs sysfs;
+  sysfs.AddCpus(2, 4, 2);
+  sysfs.Write("class/net/eth1/device/numa_node", "1");
+  sysfs.Write("bus/pci/devices/0000:3b:00.0/numa_node", "0");
+
+  const auto topology = CpuTopology::FromSysfs(sysfs.Root());
+  ASSERT_EQ(topology.Cpus().size(), 16u);
+  // cpu 13 is the second thread of core 1 on node 1
+  const auto& cpu = topology.Cpus().at(13);
+  ASSERT_EQ(cpu.id_, 13u);
+  ASSERT_EQ(cpu.node_, 1u);
+  ASSERT_EQ(cpu.package_, 1u);
+  ASSERT_EQ(cpu.core_, 1u);
+
+  ASSERT_EQ(CpuTopology::DeviceNumaNode("eth1", sysfs.Root()), 1);
+  ASSERT_EQ(CpuTopology::DeviceNumaNode("0000:3b:00.0", sysfs.Root()), 0);
+  ASSERT_EQ(CpuTopology::DeviceNumaNode("eth7", sysfs.Root()), -1);
+  ASSERT_THROW(CpuTopology::FromSysfs(sysfs.Root() + "/missing"),
+               std::runtime_error);
+}
+
+/// I/O threads go to the NIC node and nobody shares a core while there are
+/// free physical cores
+TEST(CoreLayout, AvoidsSiblingsNearNic) {
+  FakeSysfs sysfs;
+  sysfs.AddCpus(2, 4, 2);
+  const auto topology = CpuTopology::FromSysfs(sysfs.Root());
+  // Node 0: cores 0-3 (siblings 8-11), node 1: cores 4-7 (siblings 12-15)
+  const CoreLayoutPlan plan(topology, {0}, 1, 0, 2, 4, 1);
+  plan.Print();
+  CheckPlan(topology, plan, 0);
+  ASSERT_EQ(plan.NicNode(), 1u);
+
+  const auto& assignments = plan.Assignments();
+  ASSERT_EQ(assignments.size(), 8u);
+  ASSERT_EQ(assignments.at(0).type_, ThreadType::kMaster);
+  ASSERT_EQ(assignments.at(0).cpu_, 4u);
+  ASSERT_EQ(assignments.at(1).cpu_, 5u);
+  ASSERT_EQ(assignments.at(2).cpu_, 6u);
+  // Workers fill the NIC node, then the other node. cpu 8 shares core 0
+  // with the excluded cpu 0.
+  ASSERT_EQ(assignments.at(3).cpu_, 7u);
+  ASSERT_EQ(assignments.at(4).cpu_, 1u);
+  ASSERT_EQ(assignments.at(6).cpu_, 3u);
+  for (size_t i = 0; i < 7; i++) {
+    ASSERT_FALSE(assignments.at(i).shared_);
+  }
+  // Out of physical cores, the MAC thread takes a sibling on the NIC node
+  ASSERT_EQ(assignments.at(7).type_, ThreadType::kWorkerMacTXRX);
+  ASSERT_EQ(assignments.at(7).cpu_, 12u);
+  ASSERT_EQ(assignments.at(7).node_, 1u);
+  ASSERT_TRUE(assignments.at(7).shared_);
+
+  // The other usable CPUs follow the plan
+  ASSERT_EQ(plan.Layout().size(), 15u);
+}
+
+/// Core indices below the offset hold unplanned CPUs
+TEST(CoreLayout, CoreOffset) {
+  FakeSysfs sysfs;
+  sysfs.AddCpus(1, 8, 1);
+  const auto topology = CpuTopology::FromSysfs(sysfs.Root());
+  const CoreLayoutPlan plan(topology, {}, -1, 2, 1, 3, 0);
+  CheckPlan(topology, plan, 2);
+  ASSERT_EQ(plan.NicNode(), 0u);
+  ASSERT_EQ(plan.Layout().size(), 8u);
+  ASSERT_EQ(plan.Layout().at(0), 7u);
+  ASSERT_EQ(plan.Layout().at(1), 6u);
+  ASSERT_EQ(plan.Layout().at(2), 0u);
+  ASSERT_EQ(plan.Layout().at(7), 5u);
+}
+
+/// More threads than CPUs reuse CPUs, marked as shared
+TEST(CoreLayout, Oversubscribed) {
+  FakeSysfs sysfs;
+  sysfs.AddCpus(1, 2, 2);
+  const auto topology = CpuTopology::FromSysfs(sysfs.Root());
+  const CoreLayoutPlan plan(topology, {}, 3, 0, 1, 4, 0);
+  CheckPlan(topology, plan, 0);
+  ASSERT_EQ(plan.Assignments().size(), 6u);
+  ASSERT_FALSE(plan.Assignments().at(1).shared_);
+  ASSERT_TRUE(plan.Assignments().at(2).shared_);
+  ASSERT_TRUE(plan.Assignments().at(5).shared_);
+  for (const auto& assignment : plan.Assignments()) {
+    ASSERT_LT(assignment.cpu_, 4u);
+  }
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
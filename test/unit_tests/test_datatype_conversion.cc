@@ -4,7 +4,11 @@
  */
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <bitset>
+#include <cstring>
+#include <utility>
+#include <vector>
 
 #include "comms-lib.h"
 #include "datatype_conversion.h"
@@ -110,6 +114,52 @@ TEST(SIMD, float_32_to_16) {
   std::free(out_buf);
 }
 
+TEST(SIMD, float_to_half_unaligned) {
+  constexpr float kAllowedError = 1e-3;
+  // Odd lengths and offsets exercise the unaligned and scalar tail paths
+  constexpr size_t kOffset = 3;
+  constexpr size_t kNumElems = kSIMDTestNum - 7;
+  std::vector<float> in_buf(kSIMDTestNum);
+  for (size_t i = 0; i < kSIMDTestNum; i++) {
+    in_buf[i] = static_cast<float>(rand()) / (RAND_MAX * 1.0);
+  }
+  std::vector<uint16_t> medium(kSIMDTestNum);
+  std::vector<float> out_buf(kSIMDTestNum);
+  SimdConvertFloatToHalf(&in_buf[kOffset], &medium[kOffset], kNumElems);
+  SimdConvertHalfToFloat(&medium[kOffset], &out_buf[kOffset], kNumElems);
+  for (size_t i = kOffset; i < kOffset + kNumElems; i++) {
+    ASSERT_LE(std::abs(in_buf[i] - out_buf[i]), kAllowedError);
+  }
+
+  // Converting in place must give the same float16 values
+  std::vector<float> in_place(in_buf);
+  SimdConvertFloatToHalf(&in_place[kOffset],
+                         reinterpret_cast<uint16_t*>(&in_place[kOffset]),
+                         kNumElems);
+  ASSERT_EQ(std::memcmp(&in_place[kOffset], &medium[kOffset],
+                        kNumElems * sizeof(uint16_t)),
+            0);
+}
+
+TEST(SIMD, gather_cx_half_to_cx_float) {
+  constexpr size_t kStride = 8;
+  constexpr size_t kNumCx = 21;
+  std::vector<float> in_buf(2 * kStride * kNumCx);
+  for (float& val : in_buf) {
+    val = static_cast<float>(rand()) / (RAND_MAX * 1.0);
+  }
+  std::vector<uint16_t> half_buf(in_buf.size());
+  SimdConvertFloatToHalf(in_buf.data(), half_buf.data(), in_buf.size());
+
+  std::vector<float> out_buf(2 * kNumCx);
+  SimdGatherCxHalfToCxFloat(&half_buf[2], kStride, out_buf.data(), kNumCx);
+  for (size_t i = 0; i < kNumCx; i++) {
+    ASSERT_EQ(out_buf[2 * i], _cvtsh_ss(half_buf[2 * (i * kStride + 1)]));
+    ASSERT_EQ(out_buf[2 * i + 1],
+              _cvtsh_ss(half_buf[2 * (i * kStride + 1) + 1]));
+  }
+}
+
 TEST(SIMD, int16_to_float) {
   //For avx512 the arrays must be multiples of 512bits
   const size_t array_size_bytes = 64;
@@ -321,6 +371,59 @@ TEST(SIMD, float_to_int_saturate) {
   std::free(check);
 }
 
+/// The single pass IFFT post-processing must match SimdConvertFloatToShort
+/// followed by a separate peak and clipping scan
+TEST(SIMD, float_to_short_peak) {
+  constexpr size_t kNumElems = 2 * 2048;
+  constexpr size_t kCpLen = 2 * 144;
+  constexpr float kScale = 2048.0f;
+  auto* in_buf = static_cast<float*>(Agora_memory::PaddedAlignedAlloc(
+      Agora_memory::Alignment_t::kAlign64, kNumElems * sizeof(float)));
+  auto* two_pass = static_cast<short*>(Agora_memory::PaddedAlignedAlloc(
+      Agora_memory::Alignment_t::kAlign64,
+      (kNumElems + kCpLen) * sizeof(short)));
+  auto* one_pass = static_cast<short*>(Agora_memory::PaddedAlignedAlloc(
+      Agora_memory::Alignment_t::kAlign64,
+      (kNumElems + kCpLen) * sizeof(short)));
+
+  // Samples up to 1.2x full scale so that some of them clip
+  for (size_t i = 0; i < kNumElems; i++) {
+    in_buf[i] =
+        (2.4f * static_cast<float>(rand()) / RAND_MAX - 1.2f) * kScale;
+  }
+  SimdConvertFloatToShort(in_buf, two_pass, kNumElems, kCpLen, kScale);
+  float ref_peak = 0;
+  size_t ref_clipped = 0;
+  for (size_t i = 0; i < kNumElems; i++) {
+    const float sample_val = std::abs(in_buf[i] / kScale);
+    ref_peak = std::max(ref_peak, sample_val);
+    ref_clipped += (sample_val >= 1) ? 1 : 0;
+  }
+  ASSERT_GT(ref_clipped, 0u);
+
+  std::vector<std::pair<const char*, decltype(&SimdConvertFloatToShortPeak)>>
+      kernels = {{"AVX2", &SimdConvertFloatToShortPeakAVX2}};
+#if defined(__AVX512F__)
+  kernels.emplace_back("AVX512", &SimdConvertFloatToShortPeakAVX512);
+#endif
+  for (const auto& kernel : kernels) {
+    std::memset(one_pass, 0, (kNumElems + kCpLen) * sizeof(short));
+    size_t num_clipped = 0;
+    const float peak =
+        kernel.second(in_buf, one_pass, kNumElems, kCpLen, kScale, num_clipped);
+    ASSERT_EQ(std::memcmp(one_pass, two_pass,
+                          (kNumElems + kCpLen) * sizeof(short)),
+              0)
+        << kernel.first;
+    ASSERT_FLOAT_EQ(peak, ref_peak) << kernel.first;
+    ASSERT_EQ(num_clipped, ref_clipped) << kernel.first;
+  }
+
+  std::free(in_buf);
+  std::free(two_pass);
+  std::free(one_pass);
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
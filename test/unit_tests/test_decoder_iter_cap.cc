@@ -0,0 +1,106 @@
+/**
+ * @file test_decoder_iter_cap.cc
+ * @brief Unit tests for the SNR-adaptive LDPC decoder iteration cap
+ */
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include "utils_ldpc.h"
+
+static constexpr size_t kMaxIter = 8;
+static constexpr float kAbandonMarginDb = 6.0f;
+
+/// A rate 1/2 QPSK codeblock carries one bit per symbol, for which the
+/// Shannon bound is 0 dB
+TEST(DecoderIterCap, RequiredSnr) {
+  ASSERT_NEAR(LdpcRequiredSnrDb(0.5f, 2, 0.0f), 0.0f, 1e-5);
+  ASSERT_NEAR(LdpcRequiredSnrDb(0.5f, 2, 3.0f), 3.0f, 1e-5);
+  // Higher spectral efficiency needs more SNR
+  ASSERT_GT(LdpcRequiredSnrDb(0.75f, 6, 0.0f),
+            LdpcRequiredSnrDb(0.5f, 6, 0.0f));
+  ASSERT_GT(LdpcRequiredSnrDb(0.5f, 8, 0.0f),
+            LdpcRequiredSnrDb(0.5f, 4, 0.0f));
+}
+
+TEST(DecoderIterCap, IterationCap) {
+  // Full budget at or above the required SNR, and before any SNR is known
+  ASSERT_EQ(LdpcIterationCap(0.0f, kMaxIter, kAbandonMarginDb), kMaxIter);
+  ASSERT_EQ(LdpcIterationCap(20.0f, kMaxIter, kAbandonMarginDb), kMaxIter);
+  ASSERT_EQ(LdpcIterationCap(std::numeric_limits<float>::infinity(), kMaxIter,
+                             kAbandonMarginDb),
+            kMaxIter);
+  // Abandoned at and beyond the abandon margin
+  ASSERT_EQ(LdpcIterationCap(-kAbandonMarginDb, kMaxIter, kAbandonMarginDb),
+            0u);
+  ASSERT_EQ(LdpcIterationCap(-30.0f, kMaxIter, kAbandonMarginDb), 0u);
+  // Half way to the abandon margin gets half of the iterations
+  ASSERT_EQ(LdpcIterationCap(-kAbandonMarginDb / 2, kMaxIter, kAbandonMarginDb),
+            kMaxIter / 2);
+  // Never fewer than one iteration above the abandon margin, and the cap
+  // does not grow as the margin shrinks
+  size_t prev_cap = kMaxIter;
+  for (float margin = 0.0f; margin > -kAbandonMarginDb; margin -= 0.25f) {
+    const size_t cap = LdpcIterationCap(margin, kMaxIter, kAbandonMarginDb);
+    ASSERT_GE(cap, 1u);
+    ASSERT_LE(cap, prev_cap);
+    prev_cap = cap;
+  }
+}
+
+/// UEs are decoded by decreasing SNR margin under a frame budget that fits
+/// the codeblocks of two UEs. The budget must abandon the lowest-margin UE
+/// that still gets iterations, not the UEs most likely to converge.
+TEST(DecoderIterCap, BudgetAbandonsLowestMargins) {
+  // Margins (dB) above the SNR the codeblocks need, the last UE has no SNR
+  // measurement yet
+  const std::vector<float> margins_db = {
+      -8.0f, -2.0f, 10.0f, 1.0f, std::numeric_limits<float>::infinity()};
+  static constexpr size_t kCbsPerUe = 4;
+  static constexpr size_t kBudgetIter = 2 * kCbsPerUe * kMaxIter;
+
+  std::vector<size_t> ue_order(margins_db.size());
+  std::iota(ue_order.begin(), ue_order.end(), 0);
+  LdpcDecodeOrder(ue_order,
+                  [&margins_db](size_t ue_id) { return margins_db.at(ue_id); });
+  ASSERT_EQ(ue_order, std::vector<size_t>({4, 2, 3, 1, 0}));
+
+  // Decode in that order, each codeblock using all of its iterations
+  std::vector<size_t> ue_iter(margins_db.size(), 0);
+  size_t spent_iter = 0;
+  for (const size_t ue_id : ue_order) {
+    for (size_t cb = 0; cb < kCbsPerUe; cb++) {
+      const size_t cap =
+          LdpcFrameIterationCap(margins_db.at(ue_id), kMaxIter,
+                                kAbandonMarginDb, spent_iter >= kBudgetIter);
+      ue_iter.at(ue_id) += cap;
+      spent_iter += cap;
+    }
+  }
+  // The two UEs most likely to converge use the budget, the positive margin
+  // UE after them and every lower margin UE are abandoned
+  ASSERT_EQ(ue_iter.at(4), kCbsPerUe * kMaxIter);
+  ASSERT_EQ(ue_iter.at(2), kCbsPerUe * kMaxIter);
+  ASSERT_EQ(ue_iter.at(3), 0u);
+  ASSERT_EQ(ue_iter.at(1), 0u);
+  ASSERT_EQ(ue_iter.at(0), 0u);
+
+  // Without a budget, only the UE beyond the abandon margin is abandoned
+  std::fill(ue_iter.begin(), ue_iter.end(), 0);
+  for (const size_t ue_id : ue_order) {
+    ue_iter.at(ue_id) = LdpcFrameIterationCap(margins_db.at(ue_id), kMaxIter,
+                                              kAbandonMarginDb, false);
+  }
+  ASSERT_EQ(ue_iter.at(0), 0u);
+  ASSERT_GT(ue_iter.at(1), 0u);
+  ASSERT_LT(ue_iter.at(1), kMaxIter);
+  ASSERT_EQ(ue_iter.at(3), kMaxIter);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -4,7 +4,9 @@
 
 #include "concurrentqueue.h"
 #include "config.h"
+#include "datatype_conversion.h"
 #include "dodemul.h"
+#include "fixed_point.h"
 #include "gettime.h"
 #include "modulation.h"
 #include "phy_stats.h"
@@ -20,6 +22,163 @@ static constexpr size_t kFrameOffsets[kModTestNum] = {0, 20, 30};
 // A spinning barrier to synchronize the start of worker threads
 static std::atomic<size_t> num_workers_ready_atomic;
 
+/// The buffers DoDemul reads and writes, sized from [cfg], with random
+/// FFT output and beam matrices. The fixed-point inputs stay empty until
+/// QuantizeForFixedPoint().
+struct DemulTestBuffers {
+  explicit DemulTestBuffers(Config* cfg)
+      : cfg_(cfg),
+        num_symbols_(cfg->Frame().NumULSyms() * cfg->FrameWnd()),
+        demod_ref_(cfg->FrameWnd(), cfg->Frame().NumTotalSyms(),
+                   cfg->UeAntNum(), kMaxModType * cfg->OfdmDataNum()),
+        demod_test_(cfg->FrameWnd(), cfg->Frame().NumTotalSyms(),
+                    cfg->UeAntNum(), kMaxModType * cfg->OfdmDataNum()),
+        stats_(std::make_unique<Stats>(cfg)),
+        phy_stats_(std::make_unique<PhyStats>(cfg, Direction::kUplink)) {
+    data_buffer_.RandAllocCxFloat(num_symbols_,
+                                  cfg->OfdmDataNum() * cfg->BsAntNum(),
+                                  Agora_memory::Alignment_t::kAlign64);
+    ul_beam_matrices_.RandAllocCxFloat(cfg->FrameWnd(), cfg->OfdmDataNum(),
+                                       cfg->BsAntNum() * cfg->UeAntNum());
+    equal_buffer_.Calloc(num_symbols_, cfg->OfdmDataNum() * cfg->UeAntNum(),
+                         Agora_memory::Alignment_t::kAlign64);
+    ue_spec_pilot_buffer_.Calloc(
+        cfg->FrameWnd(), cfg->Frame().ClientUlPilotSymbols() * cfg->UeAntNum(),
+        Agora_memory::Alignment_t::kAlign64);
+  }
+
+  ~DemulTestBuffers() {
+    data_buffer_.Free();
+    equal_buffer_.Free();
+    ue_spec_pilot_buffer_.Free();
+    data_buffer_fixed_.Free();
+    data_exp_buffer_.Free();
+    ul_beam_exp_buffer_.Free();
+  }
+
+  /// Quantize the float inputs for the fixed-point path. Every antenna of a
+  /// symbol shares one exponent here; DoFFT picks one per antenna.
+  void QuantizeForFixedPoint() {
+    const size_t num_samples = cfg_->OfdmDataNum() * cfg_->BsAntNum();
+    data_buffer_fixed_.Malloc(num_symbols_, 2 * num_samples,
+                              Agora_memory::Alignment_t::kAlign64);
+    data_exp_buffer_.Calloc(num_symbols_, cfg_->BsAntNum(),
+                            Agora_memory::Alignment_t::kAlign64);
+    for (size_t i = 0; i < num_symbols_; i++) {
+      const auto* src = reinterpret_cast<const float*>(data_buffer_[i]);
+      const int8_t exp = FixedPointBlockExponent(src, 2 * num_samples);
+      FixedPointQuantize(src, data_buffer_fixed_[i], 2 * num_samples, exp,
+                         kFixedPointDataFracBits);
+      std::memset(data_exp_buffer_[i], exp, cfg_->BsAntNum());
+    }
+    ul_beam_matrices_fixed_.Alloc(cfg_->FrameWnd(), cfg_->OfdmDataNum(),
+                                  4 * cfg_->BsAntNum() * cfg_->UeAntNum());
+    ul_beam_exp_buffer_.Calloc(cfg_->FrameWnd(), cfg_->OfdmDataNum(),
+                               Agora_memory::Alignment_t::kAlign64);
+    std::vector<float> quant_tmp(2 * cfg_->BsAntNum());
+    for (size_t frame_slot = 0; frame_slot < cfg_->FrameWnd(); frame_slot++) {
+      for (size_t sc_id = 0; sc_id < cfg_->OfdmDataNum(); sc_id++) {
+        ul_beam_exp_buffer_[frame_slot][sc_id] = FixedPointPackBeam(
+            reinterpret_cast<const float*>(
+                ul_beam_matrices_[frame_slot][sc_id]),
+            cfg_->UeAntNum(), cfg_->BsAntNum(),
+            ul_beam_matrices_fixed_[frame_slot][sc_id], quant_tmp.data());
+      }
+    }
+  }
+
+  /// Start the phase tracking from the same state for every run
+  void ResetPilots() {
+    std::memset(ue_spec_pilot_buffer_[0], 0,
+                cfg_->FrameWnd() * cfg_->Frame().ClientUlPilotSymbols() *
+                    cfg_->UeAntNum() * sizeof(complex_float));
+  }
+
+  /// A DoDemul over these buffers writing soft bits to [demod_buffers]
+  std::unique_ptr<DoDemul> NewDemul(const FrameBlockSizes& block_sizes,
+                                    PtrCube<int8_t>& demod_buffers) {
+    return NewDemul(block_sizes, data_buffer_, ul_beam_matrices_,
+                    demod_buffers);
+  }
+
+  /// As above, reading the FFT output and beam matrices from [data_buffer]
+  /// and [ul_beam_matrices] instead
+  std::unique_ptr<DoDemul> NewDemul(const FrameBlockSizes& block_sizes,
+                                    Table<complex_float>& data_buffer,
+                                    PtrGrid<complex_float>& ul_beam_matrices,
+                                    PtrCube<int8_t>& demod_buffers) {
+    return std::make_unique<DoDemul>(
+        cfg_, 0, data_buffer, ul_beam_matrices, data_buffer_fixed_,
+        data_exp_buffer_, ul_beam_matrices_fixed_, ul_beam_exp_buffer_,
+        ue_spec_pilot_buffer_, equal_buffer_, demod_buffers, block_sizes,
+        phy_stats_.get(), stats_.get());
+  }
+
+  /// Demodulate [num_frames] frames with [compute_demul] and return the time
+  /// it took in milliseconds
+  double RunFrames(DoDemul& compute_demul, size_t num_frames) {
+    const size_t start_tsc = GetTime::Rdtsc();
+    for (size_t frame_id = 0; frame_id < num_frames; frame_id++) {
+      for (size_t i = 0; i < cfg_->Frame().NumULSyms(); i++) {
+        for (size_t j = 0; j < cfg_->DemulEventsPerSymbol(); j++) {
+          compute_demul.Launch(
+              gen_tag_t::FrmSymSc(frame_id, cfg_->Frame().GetULSymbol(i),
+                                  j * cfg_->DemulBlockSize())
+                  .tag_);
+        }
+      }
+    }
+    return GetTime::CyclesToMs(GetTime::Rdtsc() - start_tsc,
+                               cfg_->FreqGhz());
+  }
+
+  /// Fraction of hard bits of the first [num_frames] frames where
+  /// demod_test_ disagrees with demod_ref_. Soft bits carry the hard
+  /// decision in their sign; values within one LSB of zero may legitimately
+  /// round either way, so they are not compared.
+  double HardBitMismatchRate(size_t num_frames) {
+    size_t num_bits = 0;
+    size_t num_mismatches = 0;
+    const size_t demod_bytes =
+        cfg_->ModOrderBits(Direction::kUplink) * cfg_->OfdmDataNum();
+    for (size_t frame_slot = 0; frame_slot < num_frames; frame_slot++) {
+      for (size_t i = 0; i < cfg_->Frame().NumULSyms(); i++) {
+        for (size_t ue_id = 0; ue_id < cfg_->UeAntNum(); ue_id++) {
+          const int8_t* llr_ref = demod_ref_[frame_slot][i][ue_id];
+          const int8_t* llr_test = demod_test_[frame_slot][i][ue_id];
+          for (size_t k = 0; k < demod_bytes; k++) {
+            if (std::abs(llr_ref[k]) <= 1) {
+              continue;
+            }
+            num_bits++;
+            if ((llr_ref[k] < 0) != (llr_test[k] < 0)) {
+              num_mismatches++;
+            }
+          }
+        }
+      }
+    }
+    return static_cast<double>(num_mismatches) / num_bits;
+  }
+
+  Config* cfg_;
+  const size_t num_symbols_;
+  Table<complex_float> data_buffer_;
+  PtrGrid<complex_float> ul_beam_matrices_;
+  // Only used by the fixed-point uplink
+  Table<short> data_buffer_fixed_;
+  Table<int8_t> data_exp_buffer_;
+  PtrGrid<short> ul_beam_matrices_fixed_;
+  Table<int8_t> ul_beam_exp_buffer_;
+  Table<complex_float> equal_buffer_;
+  Table<complex_float> ue_spec_pilot_buffer_;
+  // Soft bits of the reference run and of the run compared against it
+  PtrCube<int8_t> demod_ref_;
+  PtrCube<int8_t> demod_test_;
+  std::unique_ptr<Stats> stats_;
+  std::unique_ptr<PhyStats> phy_stats_;
+};
+
 void MasterToWorkerDynamicMaster(
     Config* cfg, moodycamel::ConcurrentQueue<EventData>& event_queue,
     moodycamel::ConcurrentQueue<EventData>& complete_task_queue) {
@@ -66,10 +225,13 @@ void MasterToWorkerDynamicWorker(
     moodycamel::ConcurrentQueue<EventData>& event_queue,
     moodycamel::ConcurrentQueue<EventData>& complete_task_queue,
     moodycamel::ProducerToken* ptok, Table<complex_float>& data_buffer,
-    PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& ul_beam_matrices,
+    PtrGrid<complex_float>& ul_beam_matrices,
+    Table<short>& data_buffer_fixed, Table<int8_t>& data_exp_buffer,
+    PtrGrid<short>& ul_beam_matrices_fixed,
+    Table<int8_t>& ul_beam_exp_buffer,
     Table<complex_float>& ue_spec_pilot_buffer,
     Table<complex_float>& equal_buffer,
-    PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t>& demod_buffers_,
+    PtrCube<int8_t>& demod_buffers_,
     PhyStats* phy_stats, Stats* stats) {
   PinToCoreWithOffset(ThreadType::kWorker, cfg->CoreOffset() + 1, worker_id);
 
@@ -79,9 +241,12 @@ void MasterToWorkerDynamicWorker(
     // Wait
   }
 
+  const FrameBlockSizes block_sizes(cfg);
   auto compute_demul = std::make_unique<DoDemul>(
-      cfg, worker_id, data_buffer, ul_beam_matrices, ue_spec_pilot_buffer,
-      equal_buffer, demod_buffers_, phy_stats, stats);
+      cfg, worker_id, data_buffer, ul_beam_matrices, data_buffer_fixed,
+      data_exp_buffer, ul_beam_matrices_fixed, ul_beam_exp_buffer,
+      ue_spec_pilot_buffer, equal_buffer, demod_buffers_, block_sizes,
+      phy_stats, stats);
 
   size_t start_tsc = GetTime::Rdtsc();
   size_t num_tasks = 0;
@@ -118,6 +283,7 @@ TEST(TestDemul, VaryingConfig) {
   static constexpr size_t kNumIters = 10000;
   auto cfg = std::make_unique<Config>("files/config/ci/tddconfig-sim-ul.json");
   cfg->GenData();
+  Agora_transpose::ResolveBlockSize(cfg.get());
 
   auto event_queue = moodycamel::ConcurrentQueue<EventData>(2 * kNumIters);
   moodycamel::ProducerToken* ptoks[kNumWorkers];
@@ -127,50 +293,23 @@ TEST(TestDemul, VaryingConfig) {
     ptok = new moodycamel::ProducerToken(complete_task_queue);
   }
 
-  Table<complex_float> data_buffer;
-  Table<complex_float> ue_spec_pilot_buffer;
-  Table<complex_float> equal_buffer;
-  data_buffer.RandAllocCxFloat(cfg->Frame().NumULSyms() * kFrameWnd,
-                               kMaxAntennas * kMaxDataSCs,
-                               Agora_memory::Alignment_t::kAlign64);
-  PtrGrid<kFrameWnd, kMaxDataSCs, complex_float> ul_beam_matrices(kMaxAntennas *
-                                                                  kMaxUEs);
-  equal_buffer.Calloc(cfg->Frame().NumULSyms() * kFrameWnd,
-                      kMaxDataSCs * kMaxUEs,
-                      Agora_memory::Alignment_t::kAlign64);
-  ue_spec_pilot_buffer.Calloc(kFrameWnd,
-                              cfg->Frame().ClientUlPilotSymbols() * kMaxUEs,
-                              Agora_memory::Alignment_t::kAlign64);
-  PtrCube<kFrameWnd, kMaxSymbols, kMaxUEs, int8_t> demod_buffers(
-      kFrameWnd, cfg->Frame().NumTotalSyms(), cfg->UeAntNum(),
-      kMaxModType * cfg->OfdmDataNum());
-  std::printf(
-      "Size of [data_buffer, ul_beam_matrices, equal_buffer, "
-      "ue_spec_pilot_buffer, demod_soft_buffer]: [%.1f %.1f %.1f %.1f %.1f] "
-      "MB\n",
-      cfg->Frame().NumULSyms() * kFrameWnd * kMaxAntennas * kMaxDataSCs * 4 *
-          1.0f / 1024 / 1024,
-      kMaxDataSCs * kFrameWnd * kMaxUEs * kMaxAntennas * 4 * 1.0f / 1024 / 1024,
-      cfg->Frame().NumULSyms() * kFrameWnd * kMaxDataSCs * kMaxUEs * 4 * 1.0f /
-          1024 / 1024,
-      kFrameWnd * cfg->Frame().ClientUlPilotSymbols() * kMaxUEs * 4 * 1.0f /
-          1024 / 1024,
-      cfg->Frame().NumULSyms() * kFrameWnd * kMaxModType * kMaxDataSCs *
-          kMaxUEs * 1.0f / 1024 / 1024);
-
-  auto stats = std::make_unique<Stats>(cfg.get());
-  auto phy_stats = std::make_unique<PhyStats>(cfg.get(), Direction::kUplink);
+  DemulTestBuffers buffers(cfg.get());
 
   std::vector<std::thread> threads;
   threads.emplace_back(MasterToWorkerDynamicMaster, cfg.get(),
                        std::ref(event_queue), std::ref(complete_task_queue));
   for (size_t i = 0; i < kNumWorkers; i++) {
-    threads.emplace_back(MasterToWorkerDynamicWorker, cfg.get(), i,
-                         std::ref(event_queue), std::ref(complete_task_queue),
-                         ptoks[i], std::ref(data_buffer),
-                         std::ref(ul_beam_matrices), std::ref(equal_buffer),
-                         std::ref(ue_spec_pilot_buffer),
-                         std::ref(demod_buffers), phy_stats.get(), stats.get());
+    threads.emplace_back(
+        MasterToWorkerDynamicWorker, cfg.get(), i, std::ref(event_queue),
+        std::ref(complete_task_queue), ptoks[i],
+        std::ref(buffers.data_buffer_), std::ref(buffers.ul_beam_matrices_),
+        std::ref(buffers.data_buffer_fixed_),
+        std::ref(buffers.data_exp_buffer_),
+        std::ref(buffers.ul_beam_matrices_fixed_),
+        std::ref(buffers.ul_beam_exp_buffer_),
+        std::ref(buffers.equal_buffer_),
+        std::ref(buffers.ue_spec_pilot_buffer_), std::ref(buffers.demod_ref_),
+        buffers.phy_stats_.get(), buffers.stats_.get());
   }
 
   for (auto& thread : threads) {
@@ -180,10 +319,203 @@ TEST(TestDemul, VaryingConfig) {
   for (auto& ptok : ptoks) {
     delete ptok;
   }
+}
+
+/// Compare the per-subcarrier (JIT) equalization path against the batched
+/// cgemm path for several demul block sizes
+TEST(TestDemul, BatchedGemmBlockSizes) {
+  static constexpr size_t kNumBlockSizes = 4;
+  static constexpr size_t kBlockSizes[kNumBlockSizes] = {16, 32, 48, 64};
+  static constexpr size_t kNumFrames = 20;
+  auto cfg = std::make_unique<Config>("files/config/ci/tddconfig-sim-ul.json");
+  cfg->GenData();
+  Agora_transpose::ResolveBlockSize(cfg.get());
+  DemulTestBuffers buffers(cfg.get());
+  const size_t demod_bytes =
+      cfg->ModOrderBits(Direction::kUplink) * cfg->OfdmDataNum();
+
+  for (size_t block_size : kBlockSizes) {
+    cfg->DemulBlockSize(block_size);
+    const FrameBlockSizes block_sizes(cfg.get());
+    double ms[2];
+    for (size_t batched = 0; batched < 2; batched++) {
+      cfg->BatchedGemm(batched == 1);
+      buffers.ResetPilots();
+      PtrCube<int8_t>& demod =
+          (batched == 1) ? buffers.demod_test_ : buffers.demod_ref_;
+      auto compute_demul = buffers.NewDemul(block_sizes, demod);
+      ms[batched] = buffers.RunFrames(*compute_demul, kNumFrames);
+    }
+    std::printf(
+        "Demul block size %zu: per-subcarrier %.3f ms/frame, batched %.3f "
+        "ms/frame\n",
+        block_size, ms[0] / kNumFrames, ms[1] / kNumFrames);
+
+    // Both paths must produce the same soft bits, up to rounding
+    const size_t frame_slot = cfg->FrameSlot(kNumFrames - 1);
+    for (size_t i = 0; i < cfg->Frame().NumULSyms(); i++) {
+      for (size_t ue_id = 0; ue_id < cfg->UeAntNum(); ue_id++) {
+        for (size_t k = 0; k < demod_bytes; k++) {
+          ASSERT_LE(std::abs(buffers.demod_ref_[frame_slot][i][ue_id][k] -
+                             buffers.demod_test_[frame_slot][i][ue_id][k]),
+                    1);
+        }
+      }
+    }
+  }
+}
+
+/// Sweep the prefetch distance of the per-subcarrier equalizer and report
+/// the time per frame of each. Prefetching is only a hint, so every distance
+/// must produce exactly the soft bits of the run without prefetch.
+TEST(TestDemul, PrefetchDistanceSweep) {
+  static constexpr size_t kNumDistances = 5;
+  static constexpr size_t kDistances[kNumDistances] = {0, 8, 16, 32, 64};
+  static constexpr size_t kNumFrames = 20;
+  auto cfg = std::make_unique<Config>("files/config/ci/tddconfig-sim-ul.json");
+  cfg->GenData();
+  Agora_transpose::ResolveBlockSize(cfg.get());
+  DemulTestBuffers buffers(cfg.get());
+  const size_t demod_bytes =
+      cfg->ModOrderBits(Direction::kUplink) * cfg->OfdmDataNum();
+
+  const FrameBlockSizes block_sizes(cfg.get());
+  for (size_t distance : kDistances) {
+    cfg->PrefetchDistance(distance);
+    buffers.ResetPilots();
+    PtrCube<int8_t>& demod =
+        (distance == 0) ? buffers.demod_ref_ : buffers.demod_test_;
+    auto compute_demul = buffers.NewDemul(block_sizes, demod);
+    const double ms = buffers.RunFrames(*compute_demul, kNumFrames);
+    std::printf("Demul prefetch distance %zu: %.3f ms/frame\n", distance,
+                ms / kNumFrames);
+
+    if (distance == 0) {
+      continue;
+    }
+    const size_t frame_slot = cfg->FrameSlot(kNumFrames - 1);
+    for (size_t i = 0; i < cfg->Frame().NumULSyms(); i++) {
+      for (size_t ue_id = 0; ue_id < cfg->UeAntNum(); ue_id++) {
+        ASSERT_EQ(std::memcmp(buffers.demod_ref_[frame_slot][i][ue_id],
+                              buffers.demod_test_[frame_slot][i][ue_id],
+                              demod_bytes),
+                  0);
+      }
+    }
+  }
+}
+
+/// Compare the fixed-point (int16) uplink equalizer against the float path on
+/// a 64x16 configuration: demodulated hard bits must agree, and the time per
+/// frame of both paths is reported
+TEST(TestDemul, FixedPointVsFloat) {
+  static constexpr size_t kNumFrames = 10;
+  static constexpr double kMaxBitMismatchRate = 1e-3;
+  auto cfg =
+      std::make_unique<Config>("files/config/ci/tddconfig-sim-ul-64x16.json");
+  cfg->GenData();
+  Agora_transpose::ResolveBlockSize(cfg.get());
+  DemulTestBuffers buffers(cfg.get());
+  buffers.QuantizeForFixedPoint();
+
+  const FrameBlockSizes block_sizes(cfg.get());
+  double ms[2];
+  for (size_t fixed = 0; fixed < 2; fixed++) {
+    cfg->UlFixedPoint(fixed == 1);
+    PtrCube<int8_t>& demod =
+        (fixed == 1) ? buffers.demod_test_ : buffers.demod_ref_;
+    auto compute_demul = buffers.NewDemul(block_sizes, demod);
+    ms[fixed] = buffers.RunFrames(*compute_demul, kNumFrames);
+  }
+  cfg->UlFixedPoint(false);
+  std::printf("%zux%zu demul: float %.3f ms/frame, fixed-point %.3f ms/frame\n",
+              cfg->BsAntNum(), cfg->UeAntNum(), ms[0] / kNumFrames,
+              ms[1] / kNumFrames);
+
+  const double mismatch_rate = buffers.HardBitMismatchRate(kNumFrames);
+  std::printf("Fixed-point vs float hard bit mismatch rate: %.2e\n",
+              mismatch_rate);
+  ASSERT_LE(mismatch_rate, kMaxBitMismatchRate);
+}
+
+/// Compare float16 storage of FFT output and beam matrices against float32
+/// storage: demodulated hard bits must agree and the EVM delta reported by
+/// PhyStats must match float16 rounding
+TEST(TestDemul, HalfPrecisionVsFloat) {
+  static constexpr size_t kNumFrames = 10;
+  static constexpr double kMaxBitMismatchRate = 1e-3;
+  static constexpr float kMaxHalfPrecisionEvm = 1e-6;
+  auto cfg = std::make_unique<Config>("files/config/ci/tddconfig-sim-ul.json");
+  cfg->GenData();
+  Agora_transpose::ResolveBlockSize(cfg.get());
+  // PhyStats only tracks the float16 rounding error when the option is set
+  cfg->HalfPrecisionStorage(true);
+  DemulTestBuffers buffers(cfg.get());
+  const size_t num_samples = cfg->OfdmDataNum() * cfg->BsAntNum();
+  const size_t beam_size = cfg->BsAntNum() * cfg->UeAntNum();
+
+  Table<complex_float> data_buffer_half;
+  data_buffer_half.Calloc(buffers.num_symbols_, num_samples,
+                          Agora_memory::Alignment_t::kAlign64);
+  for (size_t i = 0; i < buffers.num_symbols_; i++) {
+    SimdConvertFloatToHalf(
+        reinterpret_cast<const float*>(buffers.data_buffer_[i]),
+        reinterpret_cast<uint16_t*>(data_buffer_half[i]), 2 * num_samples);
+  }
+  PtrGrid<complex_float> ul_beam_matrices_half(
+      cfg->FrameWnd(), cfg->OfdmDataNum(), beam_size);
+  for (size_t frame_slot = 0; frame_slot < cfg->FrameWnd(); frame_slot++) {
+    for (size_t sc_id = 0; sc_id < cfg->OfdmDataNum(); sc_id++) {
+      SimdConvertFloatToHalf(
+          reinterpret_cast<const float*>(
+              buffers.ul_beam_matrices_[frame_slot][sc_id]),
+          reinterpret_cast<uint16_t*>(ul_beam_matrices_half[frame_slot][sc_id]),
+          2 * beam_size);
+    }
+  }
+
+  const FrameBlockSizes block_sizes(cfg.get());
+  double ms[2];
+  for (size_t half = 0; half < 2; half++) {
+    cfg->HalfPrecisionStorage(half == 1);
+    buffers.ResetPilots();
+    auto compute_demul =
+        (half == 1) ? buffers.NewDemul(block_sizes, data_buffer_half,
+                                       ul_beam_matrices_half,
+                                       buffers.demod_test_)
+                    : buffers.NewDemul(block_sizes, buffers.demod_ref_);
+    ms[half] = buffers.RunFrames(*compute_demul, kNumFrames);
+  }
+  std::printf("Demul: float32 storage %.3f ms/frame, float16 storage %.3f "
+              "ms/frame\n",
+              ms[0] / kNumFrames, ms[1] / kNumFrames);
+
+  const double mismatch_rate = buffers.HardBitMismatchRate(kNumFrames);
+  std::printf("Float16 vs float32 hard bit mismatch rate: %.2e\n",
+              mismatch_rate);
+  ASSERT_LE(mismatch_rate, kMaxBitMismatchRate);
+
+  // Feed the same data through the PhyStats EVM delta tracking
+  std::vector<complex_float> fft_data(cfg->OfdmCaNum());
+  for (size_t ant = 0; ant < cfg->BsAntNum(); ant++) {
+    for (size_t sc = 0; sc < cfg->OfdmDataNum(); sc++) {
+      fft_data[cfg->OfdmDataStart() + sc] =
+          buffers.data_buffer_[0][ant * cfg->OfdmDataNum() + sc];
+    }
+    buffers.phy_stats_->UpdateHalfPrecisionDataError(0, 0, ant,
+                                                     fft_data.data());
+  }
+  for (size_t sc_id = 0; sc_id < cfg->OfdmDataNum(); sc_id++) {
+    buffers.phy_stats_->UpdateHalfPrecisionBeamError(
+        0, sc_id, buffers.ul_beam_matrices_[0][sc_id], beam_size);
+  }
+  const float half_precision_evm = buffers.phy_stats_->GetHalfPrecisionEvm(0);
+  std::printf("Float16 storage EVM delta: %.3e\n", half_precision_evm);
+  ASSERT_GT(half_precision_evm, 0.0f);
+  ASSERT_LE(half_precision_evm, kMaxHalfPrecisionEvm);
+  cfg->HalfPrecisionStorage(false);
 
-  data_buffer.Free();
-  ue_spec_pilot_buffer.Free();
-  equal_buffer.Free();
+  data_buffer_half.Free();
 }
 
 int main(int argc, char** argv) {
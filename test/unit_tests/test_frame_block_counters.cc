@@ -0,0 +1,114 @@
+/**
+ * @file test_frame_block_counters.cc
+ * @brief Unit tests for the per-frame block sizes and task counters of the
+ * master thread
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+
+#include "config.h"
+#include "frame_block_counters.h"
+#include "frame_block_sizes.h"
+
+/// Demul tasks of a symbol for [block_size]
+static size_t NumDemulTasks(const Config* cfg, size_t block_size) {
+  return 1 + (cfg->OfdmDataNum() - 1) / block_size;
+}
+
+/// Two frames in flight with different demul block sizes complete their
+/// demul tasks interleaved, each at the task count of its own sizes
+TEST(FrameBlockCounters, OverlappingFramesKeepTheirSizes) {
+  auto cfg =
+      std::make_unique<Config>("files/config/ci/tddconfig-sim-both.json");
+  ASSERT_GT(cfg->Frame().NumULSyms(), 0u);
+  FrameBlockSizes block_sizes(cfg.get());
+  FrameBlockCounters block_counters(cfg.get(), block_sizes);
+
+  const BlockSizes configured = BlockSizes::Configured(cfg.get());
+  BlockSizes halved = configured;
+  halved.demul_ = configured.demul_ / 2;
+  ASSERT_GT(halved.demul_, 0u);
+
+  // Frame 0 starts, then the sizes change before it completes
+  block_counters.StartFrames(0);
+  block_counters.SetNext(halved);
+  block_counters.StartFrames(1);
+  ASSERT_EQ(block_counters.StartedEnd(), 2u);
+  ASSERT_EQ(block_counters.NumCounterSets(), 2u);
+  ASSERT_EQ(block_sizes.Get(0).demul_, configured.demul_);
+  ASSERT_EQ(block_sizes.Get(1).demul_, halved.demul_);
+  ASSERT_EQ(&block_sizes.Get(1), &block_counters.Sizes(1));
+
+  const size_t num_tasks[2] = {NumDemulTasks(cfg.get(), configured.demul_),
+                               NumDemulTasks(cfg.get(), halved.demul_)};
+  ASSERT_GT(num_tasks[1], num_tasks[0]);
+  for (size_t frame_id = 0; frame_id < 2; frame_id++) {
+    ASSERT_EQ(block_counters.Counters(frame_id).demul_.MaxTaskCount(),
+              num_tasks[frame_id]);
+  }
+
+  for (size_t ul_id = 0; ul_id < cfg->Frame().NumULSyms(); ul_id++) {
+    const size_t symbol_id = cfg->Frame().GetULSymbol(ul_id);
+    for (size_t task = 0; task < num_tasks[1]; task++) {
+      for (size_t frame_id = 0; frame_id < 2; frame_id++) {
+        if (task >= num_tasks[frame_id]) {
+          continue;
+        }
+        FrameCounters& demul = block_counters.Counters(frame_id).demul_;
+        const bool last = demul.CompleteTask(frame_id, symbol_id);
+        ASSERT_EQ(last, task + 1 == num_tasks[frame_id]);
+        if (last) {
+          demul.CompleteSymbol(frame_id);
+        }
+      }
+    }
+  }
+  for (size_t frame_id = 0; frame_id < 2; frame_id++) {
+    FrameCounters& demul = block_counters.Counters(frame_id).demul_;
+    ASSERT_TRUE(demul.IsLastSymbol(frame_id));
+    demul.Reset(frame_id);
+  }
+
+  // The slot of frame 0 takes the halved sizes once the window moves past
+  // it, and changing back reuses the configured counters
+  block_counters.StartFrames(cfg->FrameWnd());
+  ASSERT_EQ(block_counters.StartedEnd(), cfg->FrameWnd() + 1);
+  ASSERT_EQ(block_sizes.Get(cfg->FrameWnd()).demul_, halved.demul_);
+  ASSERT_EQ(&block_counters.Counters(cfg->FrameWnd()),
+            &block_counters.Counters(1));
+  block_counters.SetNext(configured);
+  block_counters.StartFrames(cfg->FrameWnd() + 1);
+  ASSERT_EQ(block_counters.NumCounterSets(), 2u);
+  ASSERT_EQ(block_sizes.Get(cfg->FrameWnd() + 1).demul_, configured.demul_);
+  ASSERT_EQ(
+      block_counters.Counters(cfg->FrameWnd() + 1).demul_.GetTaskCount(
+          cfg->FrameWnd() + 1, cfg->Frame().GetULSymbol(0)),
+      0u);
+}
+
+/// Starting a frame also starts the frames before it that sent no packet
+/// yet, with the same sizes
+TEST(FrameBlockCounters, StartsSkippedFrames) {
+  auto cfg = std::make_unique<Config>("files/config/ci/tddconfig-sim-ul.json");
+  FrameBlockSizes block_sizes(cfg.get());
+  FrameBlockCounters block_counters(cfg.get(), block_sizes);
+
+  BlockSizes halved = BlockSizes::Configured(cfg.get());
+  halved.beam_ = std::max<size_t>(halved.beam_ / 2, 1);
+  block_counters.SetNext(halved);
+  block_counters.StartFrames(2);
+  ASSERT_EQ(block_counters.StartedEnd(), 3u);
+  for (size_t frame_id = 0; frame_id < 3; frame_id++) {
+    ASSERT_EQ(block_sizes.Get(frame_id).beam_, halved.beam_);
+    ASSERT_EQ(block_counters.Counters(frame_id).beam_block_size_,
+              halved.beam_);
+  }
+  // A frame that already started keeps its sizes
+  block_counters.SetNext(BlockSizes::Configured(cfg.get()));
+  block_counters.StartFrames(1);
+  ASSERT_EQ(block_counters.StartedEnd(), 3u);
+  ASSERT_EQ(block_sizes.Get(1).beam_, halved.beam_);
+}
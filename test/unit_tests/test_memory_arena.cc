@@ -0,0 +1,112 @@
+/**
+ * @file test_memory_arena.cc
+ * @brief Unit tests for the per-thread scratch arena
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <thread>
+
+#include "alloc_counter.h"
+#include "armadillo"
+#include "memory_arena.h"
+
+static constexpr size_t kSmallCapacity = 1024;
+static constexpr size_t kNumTasks = 100;
+
+TEST(MemoryArena, AlignedAndReused) {
+  MemoryArena arena(kSmallCapacity);
+  auto* first = arena.Alloc<uint8_t>(1);
+  auto* second = arena.Alloc<float>(3);
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(first) % MemoryArena::kAlignment, 0u);
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(second) % MemoryArena::kAlignment,
+            0u);
+  ASSERT_NE(static_cast<void*>(first), static_cast<void*>(second));
+  // Only the backing memory came from the heap
+  ASSERT_EQ(arena.Reset(), 1u);
+
+  // The next task gets the same memory back without touching the heap
+  ASSERT_EQ(static_cast<void*>(arena.Alloc<uint8_t>(1)),
+            static_cast<void*>(first));
+  ASSERT_EQ(arena.Reset(), 0u);
+}
+
+TEST(MemoryArena, GrowsToLargestTask) {
+  MemoryArena arena(kSmallCapacity);
+  const size_t task_bytes = 4 * kSmallCapacity;
+
+  // The first large task overflows to the heap
+  arena.AllocBytes(kSmallCapacity);
+  arena.AllocBytes(task_bytes - kSmallCapacity);
+  ASSERT_EQ(arena.Reset(), 2u);
+  ASSERT_EQ(arena.Capacity(), task_bytes);
+  ASSERT_EQ(arena.PeakBytes(), task_bytes);
+
+  // Then one allocation refills the arena and the hot path is heap free
+  size_t heap_allocs = 0;
+  for (size_t i = 0; i < kNumTasks; i++) {
+    arena.AllocBytes(kSmallCapacity);
+    arena.AllocBytes(task_bytes - kSmallCapacity);
+    heap_allocs += arena.Reset();
+  }
+  ASSERT_EQ(heap_allocs, 1u);
+}
+
+TEST(MemoryArena, OnePerThread) {
+  MemoryArena* main_arena = &MemoryArena::ThreadLocal();
+  MemoryArena* other_arena = nullptr;
+  std::thread thread([&]() { other_arena = &MemoryArena::ThreadLocal(); });
+  thread.join();
+  ASSERT_EQ(main_arena, &MemoryArena::ThreadLocal());
+  ASSERT_NE(main_arena, other_arena);
+}
+
+/// Armadillo matrices over arena memory keep results of the same size in
+/// place
+TEST(MemoryArena, ArmadilloScratch) {
+  static constexpr size_t kDim = 8;
+  MemoryArena arena(kSmallCapacity);
+  arma::cx_fmat mat_a(kDim, kDim, arma::fill::randn);
+  arma::cx_fmat mat_b(kDim, kDim, arma::fill::randn);
+
+  arma::cx_float* scratch = arena.Alloc<arma::cx_float>(kDim * kDim);
+  arma::cx_fmat mat_out(scratch, kDim, kDim, false, false);
+  mat_out = mat_a.t() * mat_b;
+  ASSERT_EQ(mat_out.memptr(), scratch);
+  ASSERT_TRUE(arma::approx_equal(mat_out, arma::cx_fmat(mat_a.t() * mat_b),
+                                 "absdiff", 1e-5f));
+  ASSERT_EQ(arena.Reset(), 1u);
+}
+
+/// Counts every heap allocation, Armadillo's included: a warm arena task
+/// makes none, while an Armadillo temporary does
+TEST(MemoryArena, CountsHeapAllocations) {
+  if (AllocCounter::Enabled() == false) {
+    GTEST_SKIP() << "built without ALLOC_COUNTING";
+  }
+  static constexpr size_t kDim = 8;
+  MemoryArena arena(kSmallCapacity);
+  arma::cx_fmat mat_a(kDim, kDim, arma::fill::randn);
+  arma::cx_fmat mat_b(kDim, kDim, arma::fill::randn);
+
+  for (size_t i = 0; i < kNumTasks; i++) {
+    const size_t start_allocs = AllocCounter::ThreadAllocs();
+    arma::cx_fmat mat_out(arena.Alloc<arma::cx_float>(kDim * kDim), kDim,
+                          kDim, false, false);
+    mat_out = mat_a.t() * mat_b;
+    arena.Reset();
+    // The first task allocates the backing memory
+    ASSERT_EQ(AllocCounter::ThreadAllocs() - start_allocs, (i == 0) ? 1u : 0u);
+  }
+
+  const size_t start_allocs = AllocCounter::ThreadAllocs();
+  const arma::cx_fmat mat_tmp = mat_a * mat_b;
+  ASSERT_GT(AllocCounter::ThreadAllocs(), start_allocs);
+  ASSERT_EQ(mat_tmp.n_rows, kDim);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "numa_plan.h"
+
+/// Without NUMA awareness every worker reports node 0
+TEST(NumaPlan, SingleNode) {
+  const NumaPlan plan(std::vector<size_t>(8, 0), 1200, 48, 64, 2);
+  ASSERT_EQ(plan.NumNodes(), 1u);
+  ASSERT_EQ(plan.NodeId(0), 0u);
+  ASSERT_EQ(plan.ScStart(0), 0u);
+  ASSERT_EQ(plan.ScStop(0), 1200u);
+  ASSERT_EQ(plan.AntStop(0), 64u);
+  ASSERT_EQ(plan.ScNode(1199), 0u);
+  ASSERT_EQ(plan.AntNode(63), 0u);
+}
+
+/// Ranges follow the worker count of each node and stay block aligned
+TEST(NumaPlan, SplitByWorkers) {
+  // Three workers on node 1, one on node 3
+  const std::vector<size_t> worker_nodes = {1, 3, 1, 1};
+  const NumaPlan plan(worker_nodes, 1200, 48, 64, 4);
+  ASSERT_EQ(plan.NumNodes(), 2u);
+  ASSERT_EQ(plan.NodeId(0), 1u);
+  ASSERT_EQ(plan.NodeId(1), 3u);
+  ASSERT_EQ(plan.WorkerNode(1), 1u);
+  ASSERT_EQ(plan.WorkerNode(2), 0u);
+
+  // 25 subcarrier blocks: 19 on the first node
+  ASSERT_EQ(plan.ScStop(0), 19u * 48);
+  ASSERT_EQ(plan.ScStart(1), 19u * 48);
+  ASSERT_EQ(plan.ScStop(1), 1200u);
+  ASSERT_EQ(plan.ScNode(19 * 48 - 1), 0u);
+  ASSERT_EQ(plan.ScNode(19 * 48), 1u);
+
+  ASSERT_EQ(plan.AntStop(0), 48u);
+  ASSERT_EQ(plan.AntNode(47), 0u);
+  ASSERT_EQ(plan.AntNode(48), 1u);
+}
+
+/// A partial last block goes to the last node
+TEST(NumaPlan, PartialBlock) {
+  const NumaPlan plan({0, 1}, 100, 32, 6, 4);
+  ASSERT_EQ(plan.ScStop(0), 64u);
+  ASSERT_EQ(plan.ScStop(1), 100u);
+  ASSERT_EQ(plan.AntStop(0), 4u);
+  ASSERT_EQ(plan.AntStop(1), 6u);
+  ASSERT_EQ(plan.AntNode(5), 1u);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
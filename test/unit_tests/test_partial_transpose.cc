@@ -0,0 +1,110 @@
+/**
+ * @file test_partial_transpose.cc
+ * @brief Unit tests for the partial transpose gathers and block size tuner
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "config.h"
+#include "nlohmann/json.hpp"
+#include "partial_transpose.h"
+
+static constexpr size_t kNumSc = 128;
+
+/// Every specialization returns exactly the elements of the layout, also for
+/// antenna counts that leave a scalar tail after the SIMD gathers
+TEST(PartialTranspose, GatherMatchesLayout) {
+  for (const size_t bs_ant_num : {4ul, 12ul, 64ul}) {
+    std::vector<complex_float> symbol(bs_ant_num * kNumSc);
+    for (size_t i = 0; i < symbol.size(); i++) {
+      symbol[i] = {static_cast<float>(i), -static_cast<float>(i)};
+    }
+    std::vector<complex_float> gathered(bs_ant_num);
+    for (const size_t block_size : kTransposeBlockSizes) {
+      const Agora_transpose::GatherScFn gather_sc =
+          Agora_transpose::SelectGatherSc(block_size);
+      for (size_t sc = 0; sc < kNumSc; sc++) {
+        gather_sc(symbol.data(), sc, bs_ant_num, gathered.data());
+        for (size_t ant = 0; ant < bs_ant_num; ant++) {
+          const complex_float expected = symbol.at(
+              Agora_transpose::Offset(block_size, bs_ant_num, sc, ant));
+          ASSERT_EQ(gathered[ant].re, expected.re)
+              << "block " << block_size << " sc " << sc << " ant " << ant;
+          ASSERT_EQ(gathered[ant].im, expected.im);
+        }
+      }
+    }
+  }
+}
+
+TEST(PartialTranspose, RejectsUnsupportedBlockSize) {
+  ASSERT_THROW(Agora_transpose::SelectGatherSc(0), std::runtime_error);
+  ASSERT_THROW(Agora_transpose::SelectGatherSc(24), std::runtime_error);
+}
+
+/// The tuner only picks sizes the config can use
+TEST(PartialTranspose, TunerPicksValidBlockSize) {
+  auto cfg = std::make_unique<Config>("files/config/ci/tddconfig-sim-ul.json");
+  ASSERT_EQ(cfg->TransposeBlockSize(), kTransposeBlockSize);
+
+  const size_t block_size = Agora_transpose::TuneBlockSize(cfg.get());
+  ASSERT_NE(std::find(kTransposeBlockSizes.begin(), kTransposeBlockSizes.end(),
+                      block_size),
+            kTransposeBlockSizes.end());
+  ASSERT_EQ(cfg->OfdmDataNum() % block_size, 0u);
+  ASSERT_EQ(cfg->DemulBlockSize() % block_size, 0u);
+}
+
+/// Write the base config with [transpose_block_size] and
+/// [partial_transpose] and return its file name
+static std::string WriteConfig(size_t transpose_block_size,
+                               bool partial_transpose) {
+  std::ifstream base("files/config/ci/tddconfig-sim-ul.json");
+  std::stringstream conf;
+  conf << base.rdbuf();
+  auto tdd_conf = nlohmann::json::parse(conf.str(), nullptr, true, true);
+  tdd_conf["transpose_block_size"] = transpose_block_size;
+  tdd_conf["partial_transpose"] = partial_transpose;
+  tdd_conf["freq_orthogonal_pilot"] = false;
+  const std::string filename = testing::TempDir() + "transpose_auto.json";
+  std::ofstream(filename) << tdd_conf.dump();
+  return filename;
+}
+
+/// A configured 0 stays in Config until ResolveBlockSize() tunes it, which
+/// Agora, config_sweep and the Doer tests call before creating Doers
+TEST(PartialTranspose, ResolvesAutoBlockSize) {
+  auto cfg = std::make_unique<Config>(WriteConfig(0, true));
+  ASSERT_EQ(cfg->TransposeBlockSize(), 0u);
+  Agora_transpose::ResolveBlockSize(cfg.get());
+  const size_t block_size = cfg->TransposeBlockSize();
+  ASSERT_NE(std::find(kTransposeBlockSizes.begin(), kTransposeBlockSizes.end(),
+                      block_size),
+            kTransposeBlockSizes.end());
+  ASSERT_NO_THROW(Agora_transpose::SelectGatherSc(block_size));
+
+  // A configured size is kept
+  auto cfg_fixed = std::make_unique<Config>(WriteConfig(16, true));
+  Agora_transpose::ResolveBlockSize(cfg_fixed.get());
+  ASSERT_EQ(cfg_fixed->TransposeBlockSize(), 16u);
+}
+
+/// Without the partial transpose nothing is tuned
+TEST(PartialTranspose, AntennaMajorKeepsDefaultBlockSize) {
+  auto cfg = std::make_unique<Config>(WriteConfig(0, false));
+  ASSERT_FALSE(cfg->PartialTranspose());
+  Agora_transpose::ResolveBlockSize(cfg.get());
+  ASSERT_EQ(cfg->TransposeBlockSize(), kTransposeBlockSize);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,78 @@
+/**
+ * @file test_phy_stats.cc
+ * @brief Unit tests for the per-worker PhyStats accumulators
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include "config.h"
+#include "phy_stats.h"
+#include "utils.h"
+
+static constexpr size_t kFrameId = 3;
+
+/// Workers accumulate the EVM of disjoint subcarriers into their own
+/// accumulators, the master reads the merged sum
+TEST(PhyStats, PerWorkerEvmMerge) {
+  auto cfg = std::make_unique<Config>("files/config/ci/tddconfig-sim-ul.json");
+  cfg->GenData();
+  auto phy_stats = std::make_unique<PhyStats>(cfg.get(), Direction::kUplink);
+  ASSERT_GT(cfg->Frame().NumUlDataSyms(), 0u);
+
+  // Every equalized symbol is off by 0.1 from the ground truth: SNR 20 dB
+  const complex_float* gt_symbol =
+      cfg->UlIqF()[cfg->Frame().ClientUlPilotSymbols()];
+  const auto worker = [&](size_t tid) {
+    for (size_t sc_id = tid; sc_id < cfg->OfdmDataNum();
+         sc_id += cfg->WorkerThreadNum()) {
+      for (size_t ue_id = 0; ue_id < cfg->UeAntNum(); ue_id++) {
+        const complex_float gt =
+            gt_symbol[ue_id * cfg->OfdmDataNum() + sc_id];
+        phy_stats->UpdateEvm(tid, kFrameId, 0, sc_id, ue_id, ue_id,
+                             arma::cx_float(gt.re + 0.1f, gt.im));
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t tid = 0; tid < cfg->WorkerThreadNum(); tid++) {
+    threads.emplace_back(worker, tid);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (size_t ue_id = 0; ue_id < cfg->UeAntNum(); ue_id++) {
+    ASSERT_NEAR(phy_stats->GetEvmSnr(kFrameId, ue_id), 20.0f, 1e-3f);
+  }
+  phy_stats->ClearEvmBuffer(kFrameId);
+  for (size_t ue_id = 0; ue_id < cfg->UeAntNum(); ue_id++) {
+    ASSERT_TRUE(std::isinf(phy_stats->GetEvmSnr(kFrameId, ue_id)));
+  }
+}
+
+/// The pilot noise is the mean power of the guard band subcarriers
+TEST(PhyStats, PilotNoise) {
+  auto cfg = std::make_unique<Config>("files/config/ci/tddconfig-sim-ul.json");
+  cfg->GenData();
+  auto phy_stats = std::make_unique<PhyStats>(cfg.get(), Direction::kUplink);
+
+  std::vector<complex_float> fft_data(cfg->OfdmCaNum(), {1.0f, 1.0f});
+  for (size_t i = cfg->OfdmDataStart(); i < cfg->OfdmDataStop(); i++) {
+    fft_data.at(i) = {3.0f, 0.0f};
+  }
+  for (size_t ue_id = 0; ue_id < cfg->UeAntNum(); ue_id++) {
+    for (size_t ant_id = 0; ant_id < cfg->BsAntNum(); ant_id++) {
+      phy_stats->UpdatePilotSnr(kFrameId, ue_id, ant_id, fft_data.data());
+    }
+  }
+  ASSERT_NEAR(phy_stats->GetNoise(kFrameId), 2.0f, 1e-5f);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -1,5 +1,5 @@
 #include <gtest/gtest.h>
-#define private public
+
 #include "memory_manage.h"
 
 static constexpr size_t kRows = 4;
@@ -8,7 +8,8 @@ static constexpr size_t kCol2s = 64;
 const size_t kNEntries = 64;
 
 TEST(TestPtrGrid, Basic) {
-  PtrGrid<kRows, kCols, float> ptr_grid(kNEntries);
+  PtrGrid<float> ptr_grid(kRows, kCols, kNEntries);
+  ASSERT_EQ(ptr_grid.Bytes(), kRows * kCols * kNEntries * sizeof(float));
 
   // Test basic accesses and zero-initialization
   float sum = 0;
@@ -20,13 +21,32 @@ TEST(TestPtrGrid, Basic) {
 
   ASSERT_EQ(sum, 0.0);
 
-  // Test that [] operator returns a reference, not a copy
-  ptr_grid[0][0] = nullptr;
-  ASSERT_EQ(ptr_grid.mat_[0][0], nullptr);
+  // Test that cells are dense, row-major slices of one buffer
+  ASSERT_EQ(ptr_grid[0][1], ptr_grid[0][0] + kNEntries);
+  ASSERT_EQ(ptr_grid[1][0], ptr_grid[0][kCols - 1] + kNEntries);
+  ptr_grid[kRows - 1][kCols - 1][kNEntries - 1] = 1.0f;
+  ASSERT_EQ(ptr_grid[0][0][(kRows * kCols * kNEntries) - 1], 1.0f);
+}
+
+TEST(TestPtrGrid, Resize) {
+  PtrGrid<float> ptr_grid;
+  ASSERT_EQ(ptr_grid.Bytes(), 0u);
+  ptr_grid.Alloc(kRows, kCols, kNEntries);
+  ptr_grid[kRows - 1][0][0] = 1.0f;
+
+  // Reallocating drops the old contents and takes the new dimensions
+  ptr_grid.Alloc(2 * kRows, kCols, kNEntries);
+  ASSERT_EQ(ptr_grid.NumRows(), 2 * kRows);
+  ASSERT_EQ(ptr_grid.Bytes(), 2 * kRows * kCols * kNEntries * sizeof(float));
+  ASSERT_EQ(ptr_grid[kRows - 1][0][0], 0.0f);
+  ptr_grid.Free();
+  ASSERT_EQ(ptr_grid.Bytes(), 0u);
 }
 
 TEST(TestPtrCube, Basic) {
-  PtrCube<kRows, kCols, kCol2s, float> ptr_cube(kNEntries);
+  PtrCube<float> ptr_cube(kRows, kCols, kCol2s, kNEntries);
+  ASSERT_EQ(ptr_cube.Bytes(),
+            kRows * kCols * kCol2s * kNEntries * sizeof(float));
 
   // Test basic accesses and zero-initialization
   float sum = 0;
@@ -40,9 +60,55 @@ TEST(TestPtrCube, Basic) {
 
   ASSERT_EQ(sum, 0.0);
 
-  // Test that [] operator returns a reference, not a copy
-  ptr_cube[0][0][0] = nullptr;
-  ASSERT_EQ(ptr_cube.cube_[0][0][0], nullptr);
+  // Test that cells are dense, row-major slices of one buffer
+  ASSERT_EQ(ptr_cube[0][1][0], ptr_cube[0][0][kCol2s - 1] + kNEntries);
+  ASSERT_EQ(ptr_cube[1][0][0], ptr_cube[0][kCols - 1][kCol2s - 1] + kNEntries);
+}
+
+TEST(TestHugePages, TableAndGrid) {
+  Agora_memory::SetHugePageSize(Agora_memory::HugePageSize::k2M);
+  const Agora_memory::HugePageCounters before =
+      Agora_memory::GetHugePageCounters();
+
+  // Large enough for hugepages, backed by explicit or transparent ones
+  Table<float> table;
+  table.Calloc(kRows, Agora_memory::kMinHugePageAllocSize,
+               Agora_memory::Alignment_t::kAlign64);
+  PtrGrid<float> ptr_grid(kRows, kCols, Agora_memory::kMinHugePageAllocSize);
+  table[kRows - 1][Agora_memory::kMinHugePageAllocSize - 1] = 1.0f;
+  ptr_grid[kRows - 1][kCols - 1][0] = 1.0f;
+  ASSERT_EQ(table[0][0], 0.0f);
+  ASSERT_EQ(ptr_grid[0][0][0], 0.0f);
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(table[0]) % 64, 0u);
+
+  const Agora_memory::HugePageCounters after =
+      Agora_memory::GetHugePageCounters();
+  ASSERT_EQ((after.huge_allocs_ + after.thp_allocs_) -
+                (before.huge_allocs_ + before.thp_allocs_),
+            2u);
+  std::printf("%s\n", Agora_memory::HugePageSummary().c_str());
+
+  table.Free();
+  Agora_memory::SetHugePageSize(Agora_memory::HugePageSize::kNone);
+}
+
+/// Buffers use the largest hugepage they fill at least half of
+TEST(TestHugePages, PageSizeForBuffer) {
+  using Agora_memory::HugePageSize;
+  using Agora_memory::HugePageSizeFor;
+  constexpr size_t kMiB = (1ul << 20);
+  ASSERT_EQ(HugePageSizeFor(HugePageSize::kNone, 1024 * kMiB),
+            HugePageSize::kNone);
+  ASSERT_EQ(HugePageSizeFor(HugePageSize::k2M, kMiB - 1), HugePageSize::kNone);
+  ASSERT_EQ(HugePageSizeFor(HugePageSize::k2M, kMiB), HugePageSize::k2M);
+  ASSERT_EQ(HugePageSizeFor(HugePageSize::k2M, 2048 * kMiB),
+            HugePageSize::k2M);
+  ASSERT_EQ(HugePageSizeFor(HugePageSize::k1G, kMiB - 1), HugePageSize::kNone);
+  ASSERT_EQ(HugePageSizeFor(HugePageSize::k1G, 2 * kMiB), HugePageSize::k2M);
+  ASSERT_EQ(HugePageSizeFor(HugePageSize::k1G, 512 * kMiB - 1),
+            HugePageSize::k2M);
+  ASSERT_EQ(HugePageSizeFor(HugePageSize::k1G, 512 * kMiB),
+            HugePageSize::k1G);
 }
 
 int main(int argc, char** argv) {
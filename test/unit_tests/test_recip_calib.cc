@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+// For some reason, gtest include order matters
+#include <vector>
+
+#include "armadillo"
+#include "recip_calib.h"
+
+static constexpr size_t kNumScs = 1203;
+static constexpr size_t kNumAnts = 37;
+static constexpr float kMaxError = 1e-5;
+
+static arma::cx_fmat RandCalib() {
+  // Keep the DL calibration away from zero
+  return arma::randn<arma::cx_fmat>(kNumScs, kNumAnts) +
+         arma::cx_float(4.0f, 0.0f);
+}
+
+static arma::cx_fmat ToMat(std::vector<complex_float>& buf, size_t n_rows,
+                           size_t n_cols) {
+  return arma::cx_fmat(reinterpret_cast<arma::cx_float*>(buf.data()), n_rows,
+                       n_cols, false);
+}
+
+/// The per-frame smoothed calibration must match the per-subcarrier
+/// Armadillo computation previously done by DoBeamWeights
+TEST(TestRecipCalib, SmoothCalib) {
+  arma::arma_rng::set_seed(0);
+  const arma::cx_fmat cur_dl = RandCalib();
+  const arma::cx_fmat cur_ul = RandCalib();
+  const arma::cx_fmat old_dl = RandCalib();
+  const arma::cx_fmat old_ul = RandCalib();
+  // Moving sums were subcarrier-major in the per-subcarrier version
+  const arma::cx_fmat prev_dl_msum = 4 * RandCalib().st();
+  const arma::cx_fmat prev_ul_msum = 4 * RandCalib().st();
+
+  arma::cx_fmat ref_calib(kNumAnts, kNumScs);
+  for (size_t sc_id = 0; sc_id < kNumScs; sc_id++) {
+    const arma::cx_fvec dl_msum =
+        prev_dl_msum.col(sc_id) + (cur_dl.row(sc_id) - old_dl.row(sc_id)).st();
+    const arma::cx_fvec ul_msum =
+        prev_ul_msum.col(sc_id) + (cur_ul.row(sc_id) - old_ul.row(sc_id)).st();
+    ref_calib.col(sc_id) = ul_msum / dl_msum;
+  }
+
+  // Antenna-major moving sums of the per-frame stage
+  const arma::cx_fmat prev_dl_msum_t = prev_dl_msum.st();
+  const arma::cx_fmat prev_ul_msum_t = prev_ul_msum.st();
+  std::vector<complex_float> dl_msum(kNumScs * kNumAnts);
+  std::vector<complex_float> ul_msum(kNumScs * kNumAnts);
+  std::vector<complex_float> calib(kNumScs * kNumAnts);
+  RecipCalibMovingSum(
+      reinterpret_cast<const complex_float*>(prev_dl_msum_t.memptr()),
+      reinterpret_cast<const complex_float*>(cur_dl.memptr()),
+      reinterpret_cast<const complex_float*>(old_dl.memptr()), dl_msum.data(),
+      kNumScs * kNumAnts);
+  RecipCalibMovingSum(
+      reinterpret_cast<const complex_float*>(prev_ul_msum_t.memptr()),
+      reinterpret_cast<const complex_float*>(cur_ul.memptr()),
+      reinterpret_cast<const complex_float*>(old_ul.memptr()), ul_msum.data(),
+      kNumScs * kNumAnts);
+  ASSERT_LE(arma::abs(ToMat(dl_msum, kNumScs, kNumAnts) -
+                      (prev_dl_msum_t + cur_dl - old_dl))
+                .max(),
+            kMaxError);
+
+  RecipCalibDivideTranspose(ul_msum.data(), dl_msum.data(), calib.data(),
+                            kNumScs, kNumAnts);
+  const arma::cx_fmat calib_mat = ToMat(calib, kNumAnts, kNumScs);
+  ASSERT_LE(arma::abs(calib_mat - ref_calib).max() /
+                arma::abs(ref_calib).max(),
+            kMaxError);
+}
+
+/// Without smoothing the calibration is the ratio of the last window
+TEST(TestRecipCalib, InstantCalib) {
+  arma::arma_rng::set_seed(1);
+  const arma::cx_fmat cur_dl = RandCalib();
+  const arma::cx_fmat cur_ul = RandCalib();
+
+  arma::cx_fmat ref_calib(kNumAnts, kNumScs);
+  for (size_t sc_id = 0; sc_id < kNumScs; sc_id++) {
+    ref_calib.col(sc_id) = (cur_ul.row(sc_id) / cur_dl.row(sc_id)).st();
+  }
+
+  std::vector<complex_float> calib(kNumScs * kNumAnts);
+  RecipCalibDivideTranspose(
+      reinterpret_cast<const complex_float*>(cur_ul.memptr()),
+      reinterpret_cast<const complex_float*>(cur_dl.memptr()), calib.data(),
+      kNumScs, kNumAnts);
+  const arma::cx_fmat calib_mat = ToMat(calib, kNumAnts, kNumScs);
+  ASSERT_LE(arma::abs(calib_mat - ref_calib).max() /
+                arma::abs(ref_calib).max(),
+            kMaxError);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,115 @@
+/**
+ * @file test_task_counters.cc
+ * @brief Unit tests for the per-codeblock and per-subcarrier-block task
+ * counters of the master thread
+ */
+
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <vector>
+
+#include "message.h"
+
+static constexpr size_t kFrameWnd = 4;
+static constexpr size_t kNumSymbols = 2;
+
+/// Codeblocks become ready once every block they read is complete, in any
+/// order, and the counts restart for the next use of the frame slot
+TEST(CodeblockCounters, CompletesCodeblocks) {
+  // 4 blocks of 8 subcarriers, both codeblocks read block 1
+  CodeblockCounters counters;
+  counters.Init(kFrameWnd, kNumSymbols, 4, 8, {{0, 12}, {12, 32}});
+
+  for (size_t frame_id : {size_t{3}, 3 + kFrameWnd}) {
+    std::vector<size_t> ready;
+    counters.CompleteScBlock(frame_id, 1, 24, ready);
+    counters.CompleteScBlock(frame_id, 1, 16, ready);
+    ASSERT_TRUE(ready.empty());
+    counters.CompleteScBlock(frame_id, 1, 8, ready);
+    ASSERT_EQ(ready, std::vector<size_t>({1}));
+    ready.clear();
+    counters.CompleteScBlock(frame_id, 1, 0, ready);
+    ASSERT_EQ(ready, std::vector<size_t>({0}));
+  }
+}
+
+/// Blocks past the last codeblock's subcarriers hold back the last
+/// codeblock, so no demul task is still running when its frame completes
+TEST(CodeblockCounters, WaitsForUncoveredBlocks) {
+  // 4 blocks of 8 subcarriers, the codeblocks only read subcarriers 0-15
+  CodeblockCounters counters;
+  counters.Init(kFrameWnd, kNumSymbols, 4, 8, {{0, 8}, {8, 16}});
+
+  std::vector<size_t> ready;
+  counters.CompleteScBlock(0, 0, 0, ready);
+  counters.CompleteScBlock(0, 0, 8, ready);
+  ASSERT_EQ(ready, std::vector<size_t>({0}));
+  counters.CompleteScBlock(0, 0, 24, ready);
+  ASSERT_EQ(ready, std::vector<size_t>({0}));
+  counters.CompleteScBlock(0, 0, 16, ready);
+  ASSERT_EQ(ready, std::vector<size_t>({0, 1}));
+
+  // Another symbol of the same frame is counted separately
+  ready.clear();
+  counters.CompleteScBlock(0, 1, 8, ready);
+  counters.CompleteScBlock(0, 1, 16, ready);
+  ASSERT_TRUE(ready.empty());
+}
+
+/// A subcarrier block is ready once all UEs encoded all codeblocks it
+/// reads, and a reset clears only that symbol
+TEST(ScBlockCounters, CompletesBlocks) {
+  // 3 blocks over 2 codeblocks per UE, block 1 reads both
+  ScBlockCounters counters;
+  counters.Init(kFrameWnd, kNumSymbols, {{0}, {0, 1}, {1}}, 2, 2);
+  ASSERT_EQ(counters.NumBlocks(), 3u);
+
+  std::vector<size_t> ready;
+  counters.CompleteCodeblock(5, 1, 1, ready);
+  ASSERT_TRUE(ready.empty());
+  counters.CompleteCodeblock(5, 1, 1, ready);
+  ASSERT_EQ(ready, std::vector<size_t>({2}));
+  ASSERT_TRUE(counters.IsReady(5, 1, 2));
+  ASSERT_FALSE(counters.IsReady(5, 1, 1));
+  ASSERT_FALSE(counters.IsReady(5, 0, 2));
+
+  ready.clear();
+  counters.CompleteCodeblock(5, 0, 0, ready);
+  counters.CompleteCodeblock(5, 0, 0, ready);
+  ASSERT_EQ(ready, std::vector<size_t>({0}));
+  ready.clear();
+  counters.CompleteCodeblock(5, 1, 0, ready);
+  counters.CompleteCodeblock(5, 1, 0, ready);
+  ASSERT_EQ(ready, std::vector<size_t>({0, 1}));
+  for (size_t block = 0; block < counters.NumBlocks(); block++) {
+    ASSERT_TRUE(counters.IsReady(5, 1, block));
+  }
+
+  counters.Reset(5, 1);
+  for (size_t block = 0; block < counters.NumBlocks(); block++) {
+    ASSERT_FALSE(counters.IsReady(5, 1, block));
+  }
+  ASSERT_TRUE(counters.IsReady(5, 0, 0));
+}
+
+/// The counts restart once a block is ready, so the next frame in the slot
+/// completes the same way
+TEST(ScBlockCounters, ReusesFrameSlot) {
+  ScBlockCounters counters;
+  counters.Init(kFrameWnd, kNumSymbols, {{0}, {0, 1}, {1}}, 2, 1);
+  for (size_t frame_id : {size_t{2}, 2 + kFrameWnd}) {
+    std::vector<size_t> ready;
+    counters.CompleteCodeblock(frame_id, 0, 0, ready);
+    ASSERT_EQ(ready, std::vector<size_t>({0}));
+    counters.CompleteCodeblock(frame_id, 0, 1, ready);
+    ASSERT_EQ(ready, std::vector<size_t>({0, 1, 2}));
+    counters.Reset(frame_id, 0);
+    ASSERT_FALSE(counters.IsReady(frame_id, 0, 1));
+  }
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
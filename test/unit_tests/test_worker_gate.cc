@@ -0,0 +1,154 @@
+/**
+ * @file test_worker_gate.cc
+ * @brief Unit tests and a wake-up latency benchmark for the WorkerGate
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "concurrentqueue.h"
+#include "gettime.h"
+#include "worker_gate.h"
+
+static constexpr size_t kNumWorkers = 4;
+static constexpr size_t kNumBursts = 200;
+static constexpr size_t kTasksPerBurst = 16;
+// Quiet time between bursts, long enough for the workers to fall asleep
+static constexpr size_t kBurstGapUs = 200;
+static constexpr double kSpinUs = 20.0;
+
+/// Run bursts of tasks tagged with their enqueue time through workers that
+/// wait with [idle_wait]. Prints the wake-up latency and throughput.
+static void RunBursts(WorkerGate::IdleWait idle_wait) {
+  const double freq_ghz = GetTime::MeasureRdtscFreq();
+  // Leave a core to the scheduler, spinning workers would starve it
+  const size_t num_workers = std::clamp<size_t>(
+      std::thread::hardware_concurrency() - 1, 1, kNumWorkers);
+  WorkerGate gate(num_workers, idle_wait,
+                  GetTime::UsToCycles(kSpinUs, freq_ghz));
+  moodycamel::ConcurrentQueue<size_t> tasks;
+  std::atomic<bool> running(true);
+  std::atomic<size_t> num_done(0);
+  std::vector<std::vector<size_t>> latencies(num_workers);
+
+  std::vector<std::thread> workers;
+  for (size_t tid = 0; tid < num_workers; tid++) {
+    workers.emplace_back([&, tid]() {
+      WorkerGate::IdleState state;
+      size_t enqueue_tsc;
+      while (running.load()) {
+        if (tasks.try_dequeue(enqueue_tsc)) {
+          gate.Busy(state);
+          latencies.at(tid).push_back(GetTime::Rdtsc() - enqueue_tsc);
+          num_done.fetch_add(1);
+        } else {
+          gate.Idle(state);
+        }
+      }
+    });
+  }
+
+  size_t busy_cycles = 0;
+  for (size_t burst = 0; burst < kNumBursts; burst++) {
+    const size_t burst_tsc = GetTime::Rdtsc();
+    for (size_t i = 0; i < kTasksPerBurst; i++) {
+      tasks.enqueue(GetTime::Rdtsc());
+    }
+    gate.Notify();
+    while (num_done.load() < (burst + 1) * kTasksPerBurst) {
+    }
+    busy_cycles += GetTime::Rdtsc() - burst_tsc;
+    GetTime::NanoSleep(kBurstGapUs * 1000, freq_ghz);
+  }
+
+  running.store(false);
+  gate.Release();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  // No task is lost or run twice
+  std::vector<size_t> all;
+  for (const auto& worker_latencies : latencies) {
+    all.insert(all.end(), worker_latencies.begin(), worker_latencies.end());
+  }
+  ASSERT_EQ(all.size(), kNumBursts * kTasksPerBurst);
+  ASSERT_EQ(num_done.load(), kNumBursts * kTasksPerBurst);
+
+  std::sort(all.begin(), all.end());
+  std::printf(
+      "WorkerGate %s with %zu workers: wake-up p50 %.2f us, p99 %.2f us, "
+      "%.0f tasks/s during bursts\n",
+      idle_wait == WorkerGate::IdleWait::kSpin
+          ? "spin"
+          : (idle_wait == WorkerGate::IdleWait::kUmwait ? "umwait" : "futex"),
+      num_workers,
+      GetTime::CyclesToUs(all.at(all.size() / 2), freq_ghz),
+      GetTime::CyclesToUs(all.at(all.size() * 99 / 100), freq_ghz),
+      all.size() / GetTime::CyclesToSec(busy_cycles, freq_ghz));
+}
+
+TEST(WorkerGate, BurstsSpin) { RunBursts(WorkerGate::IdleWait::kSpin); }
+
+TEST(WorkerGate, BurstsFutex) { RunBursts(WorkerGate::IdleWait::kFutex); }
+
+TEST(WorkerGate, BurstsUmwait) {
+  if (WorkerGate::UmwaitSupported() == false) {
+    GTEST_SKIP() << "umwait is not supported";
+  }
+  RunBursts(WorkerGate::IdleWait::kUmwait);
+}
+
+TEST(WorkerGate, ParkedWorkersWaitUntilActive) {
+  WorkerGate gate(kNumWorkers, WorkerGate::IdleWait::kFutex, 0);
+  gate.SetActive(1);
+  ASSERT_EQ(gate.Active(), 1u);
+
+  std::vector<std::atomic<bool>> unparked(kNumWorkers);
+  std::vector<std::thread> workers;
+  for (size_t tid = 0; tid < kNumWorkers; tid++) {
+    unparked.at(tid).store(false);
+    workers.emplace_back([&, tid]() {
+      gate.WaitActive(tid);
+      unparked.at(tid).store(true);
+    });
+  }
+  while (unparked.at(0).load() == false) {
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  for (size_t tid = 1; tid < kNumWorkers; tid++) {
+    ASSERT_FALSE(unparked.at(tid).load());
+  }
+
+  // Growing the active set unparks the workers below the new count only
+  gate.SetActive(kNumWorkers - 1);
+  for (size_t tid = 1; tid < kNumWorkers - 1; tid++) {
+    while (unparked.at(tid).load() == false) {
+    }
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  ASSERT_FALSE(unparked.at(kNumWorkers - 1).load());
+
+  gate.Release();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  ASSERT_TRUE(unparked.at(kNumWorkers - 1).load());
+
+  // The active count stays within [1, number of workers]
+  gate.SetActive(0);
+  ASSERT_EQ(gate.Active(), 1u);
+  gate.SetActive(kNumWorkers + 1);
+  ASSERT_EQ(gate.Active(), kNumWorkers);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
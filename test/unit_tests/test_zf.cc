@@ -1,58 +1,59 @@
 #include <gtest/gtest.h>
 // For some reason, gtest include order matters
+#include "alloc_counter.h"
+#include "approx_zf.h"
+#include "comms-lib.h"
 #include "concurrentqueue.h"
 #include "config.h"
 #include "dobeamweights.h"
 #include "gettime.h"
 #include "utils.h"
 
+/// A DoBeamWeights over random CSI with the buffers it needs
+struct BeamWeightsHarness {
+  explicit BeamWeightsHarness(Config* cfg)
+      : ul_zf_matrices_(cfg->FrameWnd(), cfg->OfdmDataNum(),
+                        cfg->BsAntNum() * cfg->UeAntNum()),
+        dl_zf_matrices_(cfg->FrameWnd(), cfg->OfdmDataNum(),
+                        cfg->UeAntNum() * cfg->BsAntNum()),
+        block_sizes_(cfg),
+        phy_stats_(std::make_unique<PhyStats>(cfg, Direction::kUplink)),
+        stats_(std::make_unique<Stats>(cfg)) {
+    csi_buffers_.RandAllocCxFloat(cfg->FrameWnd(), cfg->UeAntNum(),
+                                  cfg->BsAntNum() * cfg->OfdmDataNum());
+    calib_buffer_.RandAllocCxFloat(cfg->FrameWnd(),
+                                   cfg->OfdmDataNum() * cfg->BsAntNum(),
+                                   Agora_memory::Alignment_t::kAlign64);
+    compute_zf_ = std::make_unique<DoBeamWeights>(
+        cfg, kTid, csi_buffers_, calib_buffer_, ul_zf_matrices_,
+        dl_zf_matrices_, ul_zf_matrices_fixed_, ul_zf_exp_buffer_,
+        beam_completion_, block_sizes_, phy_stats_.get(), stats_.get());
+  }
+  ~BeamWeightsHarness() { calib_buffer_.Free(); }
+
+  static constexpr int kTid = 0;
+  PtrGrid<complex_float> csi_buffers_;
+  PtrGrid<complex_float> ul_zf_matrices_;
+  PtrGrid<complex_float> dl_zf_matrices_;
+  // Only used by the fixed-point uplink
+  PtrGrid<short> ul_zf_matrices_fixed_;
+  Table<int8_t> ul_zf_exp_buffer_;
+  // No frame completes, so CG always starts cold
+  FrameCompletion beam_completion_;
+  const FrameBlockSizes block_sizes_;
+  Table<complex_float> calib_buffer_;
+  std::unique_ptr<PhyStats> phy_stats_;
+  std::unique_ptr<Stats> stats_;
+  std::unique_ptr<DoBeamWeights> compute_zf_;
+};
+
 /// Measure performance of zeroforcing
 TEST(TestZF, Perf) {
   static constexpr size_t kNumIters = 10000;
   auto cfg = std::make_unique<Config>("files/config/ci/tddconfig-sim-ul.json");
   cfg->GenData();
-
-  int tid = 0;
-
-  PtrGrid<kFrameWnd, kMaxUEs, complex_float> csi_buffers;
-  csi_buffers.RandAllocCxFloat(cfg->BsAntNum() * cfg->OfdmDataNum());
-
-  PtrGrid<kFrameWnd, kMaxDataSCs, complex_float> ul_zf_matrices(
-      cfg->BsAntNum() * cfg->UeAntNum());
-  PtrGrid<kFrameWnd, kMaxDataSCs, complex_float> dl_zf_matrices(
-      cfg->UeAntNum() * cfg->BsAntNum());
-
-  Table<complex_float> calib_dl_msum_buffer;
-  calib_dl_msum_buffer.RandAllocCxFloat(kFrameWnd,
-                                        cfg->OfdmDataNum() * cfg->BsAntNum(),
-                                        Agora_memory::Alignment_t::kAlign64);
-
-  Table<complex_float> calib_ul_msum_buffer;
-  calib_ul_msum_buffer.RandAllocCxFloat(kFrameWnd,
-                                        cfg->OfdmDataNum() * cfg->BsAntNum(),
-                                        Agora_memory::Alignment_t::kAlign64);
-
-  Table<complex_float> calib_dl_buffer;
-  calib_dl_buffer.RandAllocCxFloat(kFrameWnd,
-                                   cfg->OfdmDataNum() * cfg->BsAntNum(),
-                                   Agora_memory::Alignment_t::kAlign64);
-
-  Table<complex_float> calib_ul_buffer;
-  calib_ul_buffer.RandAllocCxFloat(kFrameWnd,
-                                   cfg->OfdmDataNum() * cfg->BsAntNum(),
-                                   Agora_memory::Alignment_t::kAlign64);
-
-  Table<complex_float> calib_buffer;
-  calib_buffer.RandAllocCxFloat(kFrameWnd, cfg->OfdmDataNum() * cfg->BsAntNum(),
-                                Agora_memory::Alignment_t::kAlign64);
-
-  auto phy_stats = std::make_unique<PhyStats>(cfg.get(), Direction::kUplink);
-  auto stats = std::make_unique<Stats>(cfg.get());
-
-  auto compute_zf = std::make_unique<DoBeamWeights>(
-      cfg.get(), tid, csi_buffers, calib_dl_buffer, calib_ul_buffer,
-      calib_dl_msum_buffer, calib_ul_msum_buffer, calib_buffer, ul_zf_matrices,
-      dl_zf_matrices, phy_stats.get(), stats.get());
+  Agora_transpose::ResolveBlockSize(cfg.get());
+  BeamWeightsHarness harness(cfg.get());
 
   FastRand fast_rand;
   size_t start_tsc = GetTime::Rdtsc();
@@ -61,17 +62,79 @@ TEST(TestZF, Perf) {
     size_t base_sc_id =
         (fast_rand.NextU32() % (cfg->OfdmDataNum() / cfg->BeamBlockSize())) *
         cfg->BeamBlockSize();
-    compute_zf->Launch(gen_tag_t::FrmSc(frame_id, base_sc_id).tag_);
+    harness.compute_zf_->Launch(gen_tag_t::FrmSc(frame_id, base_sc_id).tag_);
   }
   double ms = GetTime::CyclesToMs(GetTime::Rdtsc() - start_tsc, cfg->FreqGhz());
 
   std::printf("Time per zeroforcing iteration = %.4f ms\n", ms / kNumIters);
+}
+
+/// Once the scratch arena has warmed up, no beamforming mode allocates from
+/// the heap
+TEST(TestZF, NoHeapAllocations) {
+  if (AllocCounter::Enabled() == false) {
+    GTEST_SKIP() << "built without ALLOC_COUNTING";
+  }
+  auto cfg =
+      std::make_unique<Config>("files/config/ci/tddconfig-sim-both.json");
+  cfg->GenData();
+  Agora_transpose::ResolveBlockSize(cfg.get());
+  BeamWeightsHarness harness(cfg.get());
+  ScratchAllocStat* scratch_stat =
+      harness.stats_->GetScratchAllocStat(BeamWeightsHarness::kTid);
+
+  for (const auto& algo : kBeamformingStr) {
+    cfg->BeamformingAlgo(algo.second);
+    // The first task of a mode may grow the arena
+    harness.compute_zf_->Launch(gen_tag_t::FrmSc(0, 0).tag_);
+    const size_t start_allocs = scratch_stat->heap_allocs_;
+    for (size_t sc_id = 0; sc_id < cfg->OfdmDataNum();
+         sc_id += cfg->BeamBlockSize()) {
+      harness.compute_zf_->Launch(gen_tag_t::FrmSc(1, sc_id).tag_);
+    }
+    ASSERT_EQ(scratch_stat->heap_allocs_, start_allocs) << algo.first;
+  }
+}
 
-  calib_dl_msum_buffer.Free();
-  calib_ul_msum_buffer.Free();
-  calib_dl_buffer.Free();
-  calib_ul_buffer.Free();
-  calib_buffer.Free();
+/// The approximate zero-forcing beamformers must approach inv_sympd on
+/// channels with many more antennas than UEs
+TEST(TestZF, ApproxZf) {
+  static constexpr size_t kNumAnts = 64;
+  static constexpr size_t kNumTrials = 20;
+  static constexpr float kMaxNeumannError = 0.1;
+  static constexpr float kMaxCgError = 1e-3;
+  arma::arma_rng::set_seed(0);
+  MemoryArena arena;
+  for (size_t trial = 0; trial < kNumTrials; trial++) {
+    // The Neumann series needs strong channel hardening
+    const arma::cx_fmat csi_small = arma::randn<arma::cx_fmat>(kNumAnts, 4);
+    const arma::cx_fmat gram_small = csi_small.t() * csi_small;
+    const arma::cx_fmat exact_small = arma::inv_sympd(gram_small);
+    arma::cx_fmat neumann(arma::size(gram_small));
+    ApproxZf::NeumannInverse(arena, gram_small, 6, neumann);
+    ASSERT_LE(arma::norm(neumann - exact_small, "fro") /
+                  arma::norm(exact_small, "fro"),
+              kMaxNeumannError);
+
+    // Conjugate gradient converges for any Hermitian positive definite Gram
+    // matrix, exactly after as many steps as UEs
+    const arma::cx_fmat csi = arma::randn<arma::cx_fmat>(kNumAnts, 16);
+    const arma::cx_fmat gram = csi.t() * csi;
+    const arma::cx_fmat exact = arma::inv_sympd(gram) * csi.t();
+    const arma::cx_fmat csi_h = csi.t();
+    arma::cx_fmat cg(arma::size(csi_h));
+    ApproxZf::JacobiGuess(gram, csi_h, cg);
+    ApproxZf::ConjugateGradient(arena, gram, csi_h, cg, 16);
+    ASSERT_LE(arma::norm(cg - exact, "fro") / arma::norm(exact, "fro"),
+              kMaxCgError);
+
+    // Warm starting from the exact solution keeps it
+    arma::cx_fmat warm = exact;
+    ApproxZf::ConjugateGradient(arena, gram, csi_h, warm, 2);
+    ASSERT_LE(arma::norm(warm - exact, "fro") / arma::norm(exact, "fro"),
+              kMaxCgError);
+    arena.Reset();
+  }
 }
 
 int main(int argc, char** argv) {
@@ -14,6 +14,8 @@ static constexpr size_t kMaxItrNum = (1 << 30);
 static constexpr size_t kAntTestNum = 3;
 static constexpr size_t kBsAntNums[kAntTestNum] = {32, 16, 48};
 static constexpr size_t kFrameOffsets[kAntTestNum] = {0, 20, 30};
+// Antennas per subcarrier the test buffers are sized for
+static constexpr size_t kBufferAntNum = 64;
 // A spinning barrier to synchronize the start of worker threads
 std::atomic<size_t> num_workers_ready_atomic;
 
@@ -54,15 +56,12 @@ void MasterToWorkerDynamicWorker(
     moodycamel::ConcurrentQueue<EventData>& event_queue,
     moodycamel::ConcurrentQueue<EventData>& complete_task_queue,
     moodycamel::ProducerToken* ptok,
-    PtrGrid<kFrameWnd, kMaxUEs, complex_float>& csi_buffers,
-    Table<complex_float>& calib_dl_buffer,
-    Table<complex_float>& calib_ul_buffer,
-    Table<complex_float>& calib_dl_msum_buffer,
-    Table<complex_float>& calib_ul_msum_buffer,
+    PtrGrid<complex_float>& csi_buffers,
     Table<complex_float>& calib_buffer,
-    PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& ul_beam_matrices,
-    PtrGrid<kFrameWnd, kMaxDataSCs, complex_float>& dl_beam_matrices,
-    PhyStats* phy_stats, Stats* stats) {
+    PtrGrid<complex_float>& ul_beam_matrices,
+    PtrGrid<complex_float>& dl_beam_matrices,
+    PtrGrid<short>& ul_beam_matrices_fixed,
+    Table<int8_t>& ul_beam_exp_buffer, PhyStats* phy_stats, Stats* stats) {
   PinToCoreWithOffset(ThreadType::kWorker, cfg->CoreOffset() + 1, worker_id);
 
   // Wait for all threads (including master) to start runnung
@@ -71,10 +70,12 @@ void MasterToWorkerDynamicWorker(
     // Wait
   }
 
+  FrameCompletion beam_completion;
+  const FrameBlockSizes block_sizes(cfg);
   auto compute_beam = std::make_unique<DoBeamWeights>(
-      cfg, worker_id, csi_buffers, calib_dl_buffer, calib_ul_buffer,
-      calib_dl_msum_buffer, calib_ul_msum_buffer, calib_buffer,
-      ul_beam_matrices, dl_beam_matrices, phy_stats, stats);
+      cfg, worker_id, csi_buffers, calib_buffer, ul_beam_matrices,
+      dl_beam_matrices, ul_beam_matrices_fixed, ul_beam_exp_buffer,
+      beam_completion, block_sizes, phy_stats, stats);
 
   size_t start_tsc = GetTime::Rdtsc();
   size_t num_tasks = 0;
@@ -110,6 +111,7 @@ TEST(TestZF, VaryingConfig) {
   static constexpr size_t kNumIters = 10000;
   auto cfg = std::make_unique<Config>("files/config/ci/tddconfig-sim-ul.json");
   cfg->GenData();
+  Agora_transpose::ResolveBlockSize(cfg.get());
 
   auto event_queue = moodycamel::ConcurrentQueue<EventData>(2 * kNumIters);
   moodycamel::ProducerToken* ptoks[kNumWorkers];
@@ -119,28 +121,22 @@ TEST(TestZF, VaryingConfig) {
     ptok = new moodycamel::ProducerToken(complete_task_queue);
   }
 
-  Table<complex_float> calib_dl_msum_buffer;
-  Table<complex_float> calib_ul_msum_buffer;
-
-  Table<complex_float> calib_dl_buffer;
-  Table<complex_float> calib_ul_buffer;
-
   Table<complex_float> calib_buffer;
 
-  PtrGrid<kFrameWnd, kMaxUEs, complex_float> csi_buffers;
-  csi_buffers.RandAllocCxFloat(kMaxAntennas * kMaxDataSCs);
-
-  PtrGrid<kFrameWnd, kMaxDataSCs, complex_float> ul_beam_matrices(kMaxAntennas *
-                                                                  kMaxUEs);
-  PtrGrid<kFrameWnd, kMaxDataSCs, complex_float> dl_beam_matrices(kMaxUEs *
-                                                                  kMaxAntennas);
+  PtrGrid<complex_float> csi_buffers;
+  csi_buffers.RandAllocCxFloat(cfg->FrameWnd(), cfg->UeAntNum(),
+                               kBufferAntNum * cfg->OfdmDataNum());
 
-  calib_dl_buffer.RandAllocCxFloat(kFrameWnd, kMaxDataSCs * kMaxAntennas,
-                                   Agora_memory::Alignment_t::kAlign64);
-  calib_ul_buffer.RandAllocCxFloat(kFrameWnd, kMaxDataSCs * kMaxAntennas,
-                                   Agora_memory::Alignment_t::kAlign64);
+  PtrGrid<complex_float> ul_beam_matrices(
+      cfg->FrameWnd(), cfg->OfdmDataNum(), kBufferAntNum * cfg->UeAntNum());
+  PtrGrid<complex_float> dl_beam_matrices(
+      cfg->FrameWnd(), cfg->OfdmDataNum(), cfg->UeAntNum() * kBufferAntNum);
+  // Only used by the fixed-point uplink
+  PtrGrid<short> ul_beam_matrices_fixed;
+  Table<int8_t> ul_beam_exp_buffer;
 
-  calib_buffer.RandAllocCxFloat(kFrameWnd, kMaxDataSCs * kMaxAntennas,
+  calib_buffer.RandAllocCxFloat(cfg->FrameWnd(),
+                                cfg->OfdmDataNum() * kBufferAntNum,
                                 Agora_memory::Alignment_t::kAlign64);
   auto phy_stats = std::make_unique<PhyStats>(cfg.get(), Direction::kUplink);
   auto stats = std::make_unique<Stats>(cfg.get());
@@ -153,19 +149,14 @@ TEST(TestZF, VaryingConfig) {
     threads.emplace_back(
         MasterToWorkerDynamicWorker, cfg.get(), i, std::ref(event_queue),
         std::ref(complete_task_queue), ptoks[i], std::ref(csi_buffers),
-        std::ref(calib_dl_buffer), std::ref(calib_ul_buffer),
-        std::ref(calib_dl_msum_buffer), std::ref(calib_ul_msum_buffer),
         std::ref(calib_buffer), std::ref(ul_beam_matrices),
-        std::ref(dl_beam_matrices), phy_stats.get(), stats.get());
+        std::ref(dl_beam_matrices), std::ref(ul_beam_matrices_fixed),
+        std::ref(ul_beam_exp_buffer), phy_stats.get(), stats.get());
   }
   for (auto& thread : threads) {
     thread.join();
   }
 
-  calib_dl_msum_buffer.Free();
-  calib_ul_msum_buffer.Free();
-  calib_dl_buffer.Free();
-  calib_ul_buffer.Free();
   calib_buffer.Free();
   for (auto& ptok : ptoks) {
     delete ptok;